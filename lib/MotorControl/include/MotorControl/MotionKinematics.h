@@ -14,6 +14,20 @@ uint32_t estimateMoveTimeMsAsym(int64_t distance_steps,
                                 int64_t accel_up_sps2,
                                 int64_t decel_down_sps2);
 
+// Speed (steps/s) a symmetric trapezoidal move reaches done_steps after its
+// start and remaining_steps before its end. Depends on position only, so it
+// can be derived from any status sample.
+uint32_t profileSpeedSps(int64_t done_steps,
+                         int64_t remaining_steps,
+                         int64_t speed_sps,
+                         int64_t accel_sps2);
+// Time in milliseconds to finish such a move from current_sps with
+// remaining_steps to go. From rest it matches estimateMoveTimeMs().
+uint32_t remainingMoveTimeMs(int64_t remaining_steps,
+                             int64_t current_sps,
+                             int64_t speed_sps,
+                             int64_t accel_sps2);
+
 // Estimate HOME total time as two legs (overshoot + backoff), each
 // treated as an independent move. Returns total milliseconds.
 uint32_t estimateHomeTimeMs(int64_t overshoot_steps,
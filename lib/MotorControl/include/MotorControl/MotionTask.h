@@ -0,0 +1,174 @@
+#pragma once
+
+#include "MotorControl/MotorCommandProcessor.h"
+#include "MotorControl/MotorController.h"
+#include "MotorControl/command/CommandParser.h"
+#include "MotorControl/command/CommandResult.h"
+#include "transport/ResponseModel.h"
+#include "transport/SeqLock.h"
+#include "transport/SpscRing.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#if defined(ARDUINO) && defined(ESP32)
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#else
+#include <thread>
+#endif
+
+namespace motor {
+
+// Motor masks are 32 bits wide, so no controller drives more motors than this.
+constexpr size_t kMaxSnapshotMotors = 32;
+
+struct MotionSnapshot {
+  uint32_t taken_ms = 0;
+  uint8_t motor_count = 0;
+  std::array<MotorState, kMaxSnapshotMotors> motors{};
+  uint32_t change_seq = 0;
+  std::array<uint32_t, kMaxSnapshotMotors> motor_seq{};
+};
+
+// Read-only MotorController over a MotionSnapshot, so status and presence code
+// can keep using the controller interface from another task. Commands are refused.
+class SnapshotMotorController : public MotorController {
+public:
+  void update(const MotionSnapshot& snapshot) {
+    snapshot_ = snapshot;
+  }
+
+  size_t motorCount() const override {
+    return snapshot_.motor_count;
+  }
+  // Out-of-range indices read as a zeroed motor.
+  const MotorState& state(size_t idx) const override;
+  bool isAnyMovingForMask(uint32_t mask) const override;
+  uint32_t changeSeq() const override {
+    return snapshot_.change_seq;
+  }
+  uint32_t motorChangeSeq(size_t idx) const override {
+    return idx < snapshot_.motor_count ? snapshot_.motor_seq[idx] : 0;
+  }
+
+  void wakeMask(uint32_t /*mask*/) override {}
+  bool sleepMask(uint32_t /*mask*/) override {
+    return false;
+  }
+  bool moveAbsMask(uint32_t, long, int, int, uint32_t) override {
+    return false;
+  }
+  bool homeMask(uint32_t, long, long, int, int, long, uint32_t) override {
+    return false;
+  }
+  void tick(uint32_t /*now_ms*/) override {}
+  void setThermalLimitsEnabled(bool /*enabled*/) override {}
+
+private:
+  MotionSnapshot snapshot_;
+};
+
+// Owns a MotorCommandProcessor on a dedicated task: a FreeRTOS task pinned to
+// a core on ESP32, a std::thread on native. The task ticks the controller and
+// the CompletionTracker, then publishes a MotionSnapshot. Everything else talks
+// to it from a single other task through lock-free queues:
+//   - execute()/call() hand work to the motion task and wait for it;
+//   - dispatcher events raised on the motion task are queued and delivered to
+//     sinks on the caller by pumpEvents(), which call() and stop() also run
+//     while they wait so a full queue cannot stall both tasks;
+//   - snapshot() reads motor state without blocking the motion task.
+// Before start() (and in unit tests) everything runs inline on the caller.
+class MotionTask {
+public:
+  using Job = std::function<void(uint32_t now_ms)>;
+  using ClockFn = std::function<uint32_t()>;
+
+  struct Config {
+    uint32_t period_ms = 1;
+    size_t job_depth = 4;
+    size_t event_depth = 64;
+    int core = 1;
+    unsigned priority = 5;
+    uint32_t stack_bytes = 8192;
+    ClockFn clock;
+  };
+
+  struct Stats {
+    uint32_t steps = 0;
+    // INFO/DATA events lost to a full event queue. ACK, DONE, WARN and ERROR
+    // are never dropped: the motion task waits for the queue to drain instead.
+    uint32_t events_dropped = 0;
+    size_t event_high_water = 0;
+  };
+
+  explicit MotionTask(MotorCommandProcessor& processor);
+  MotionTask(MotorCommandProcessor& processor, Config cfg);
+  ~MotionTask();
+  MotionTask(const MotionTask&) = delete;
+  MotionTask& operator=(const MotionTask&) = delete;
+
+  bool start();
+  void stop();
+  bool running() const {
+    return running_.load(std::memory_order_acquire);
+  }
+
+  // Runs a command line where it is safe to: controller commands on the motion
+  // task, NET/MQTT configuration and SUB/UNSUB inline on the caller.
+  command::CommandResult execute(const std::string& line, uint32_t now_ms);
+  // Runs job on the motion task and waits; events it raised are pumped before returning.
+  void call(const Job& job);
+  // Delivers queued motion-task events to dispatcher sinks. Returns the count.
+  size_t pumpEvents();
+  bool snapshot(MotionSnapshot& out) const;
+  uint32_t snapshotSequence() const {
+    return snapshot_.sequence();
+  }
+  Stats stats() const;
+
+  // One motion-task iteration: run queued jobs, tick, publish the snapshot.
+  void step(uint32_t now_ms);
+
+private:
+  struct PendingJob {
+    const Job* job = nullptr;
+    std::atomic<bool>* done = nullptr;
+  };
+
+  bool onMotionTask() const;
+  bool needsController(const command::ParsedLine& parsed) const;
+  bool captureEvent(const transport::response::Event& event,
+                    const transport::command::ResponseLine* line);
+  void run();
+  void publishSnapshot(uint32_t now_ms);
+  uint32_t now() const;
+
+  MotorCommandProcessor& processor_;
+  Config cfg_;
+  transport::SpscRing<PendingJob> jobs_;
+  std::vector<std::atomic<bool>*> finished_;
+  transport::SpscRing<transport::response::Event> events_;
+  transport::SeqLock<MotionSnapshot> snapshot_;
+  // Built on the motion task; too large for its stack.
+  MotionSnapshot scratch_;
+  std::atomic<bool> running_{false};
+  std::atomic<bool> exited_{true};
+  std::atomic<uint32_t> steps_{0};
+  std::atomic<uint32_t> events_dropped_{0};
+  std::atomic<size_t> event_high_water_{0};
+#if defined(ARDUINO) && defined(ESP32)
+  static void TaskEntry(void* arg);
+  std::atomic<TaskHandle_t> task_{nullptr};
+#else
+  std::thread thread_;
+  std::atomic<std::thread::id> thread_id_{};
+#endif
+};
+
+}  // namespace motor
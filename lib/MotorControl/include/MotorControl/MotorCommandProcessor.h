@@ -1,5 +1,6 @@
 #pragma once
 #include "MotorControl/MotorController.h"
+#include "MotorControl/StatusSubscription.h"
 #include "MotorControl/command/CommandBatchExecutor.h"
 #include "MotorControl/command/CommandExecutionContext.h"
 #include "MotorControl/command/CommandParser.h"
@@ -23,12 +24,20 @@ public:
     controller_->tick(now_ms);
   }
   motor::command::CommandResult execute(const std::string& line, uint32_t now_ms);
+  // execute(line) split in two, for callers that inspect the commands first.
+  motor::command::ParsedLine parse(const std::string& line) const;
+  motor::command::CommandResult execute(const motor::command::ParsedLine& parsed,
+                                        uint32_t now_ms);
   MotorController& controller() {
     return *controller_;
   }
   const MotorController& controller() const {
     return *controller_;
   }
+  // Serial push-mode status; SUB/UNSUB configure it, the console polls it.
+  motor::StatusSubscription& statusSubscription() {
+    return status_subscription_;
+  }
 
 private:
   std::unique_ptr<MotorController> controller_;
@@ -38,6 +47,8 @@ private:
   int default_decel_sps2_;
   bool in_batch_ = false;
   bool batch_initially_idle_ = false;
+  transport::message_id::Id cmd_id_override_;
+  motor::StatusSubscription status_subscription_;
 
   motor::command::CommandParser parser_;
   std::unique_ptr<motor::command::CommandRouter> router_;
@@ -1,6 +1,9 @@
 #pragma once
 #include <cstddef>
+#include <functional>
 #include <stdint.h>
+#include <utility>
+#include <vector>
 
 struct MotorState {
   uint8_t id;
@@ -20,10 +23,15 @@ struct MotorState {
   uint32_t last_op_est_ms;      // estimated duration for last MOVE/HOME in ms
   uint8_t last_op_type;         // 0=none, 1=move, 2=home
   bool last_op_ongoing;         // true while MOVE/HOME is in progress
+  long last_op_start_pos;       // position when the last MOVE/HOME began
+  long last_op_target;          // destination of the last MOVE/HOME (0 for HOME)
 };
 
 class MotorController {
 public:
+  // Called once per motor when its MOVE/HOME stops (last_op_ongoing drops).
+  using CompletionObserver = std::function<void(const MotorState& state)>;
+
   virtual ~MotorController() {}
   virtual size_t motorCount() const = 0;
   virtual const MotorState& state(size_t idx) const = 0;
@@ -46,4 +54,50 @@ public:
 
   // Optional global deceleration hint for underlying adapter
   virtual void setDeceleration(int /*decel_sps2*/) {}
+
+  void setCompletionObserver(CompletionObserver observer) {
+    completion_observer_ = std::move(observer);
+  }
+
+  // Change sequence: bumped by tick() whenever a STATUS-visible field of any
+  // motor changed; each motor keeps the value of its latest change, so hosts can
+  // ask for only the motors newer than the sequence they last saw.
+  virtual uint32_t changeSeq() const {
+    return change_seq_;
+  }
+  virtual uint32_t motorChangeSeq(size_t idx) const {
+    return idx < motor_seq_.size() ? motor_seq_[idx] : 0;
+  }
+
+protected:
+  // Implementations bracket tick() with these so each stop is reported once,
+  // after the motor's state has been finalized.
+  uint32_t ongoingMask() const {
+    uint32_t mask = 0;
+    for (size_t i = 0; i < motorCount() && i < 32; ++i) {
+      if (state(i).last_op_ongoing) {
+        mask |= (1u << i);
+      }
+    }
+    return mask;
+  }
+  void notifyCompleted(uint32_t ongoing_before) const {
+    if (!completion_observer_ || ongoing_before == 0) {
+      return;
+    }
+    for (size_t i = 0; i < motorCount() && i < 32; ++i) {
+      if ((ongoing_before & (1u << i)) && !state(i).last_op_ongoing) {
+        completion_observer_(state(i));
+      }
+    }
+  }
+
+  // Implementations call this at the end of tick().
+  void recordVisibleChanges();
+
+private:
+  CompletionObserver completion_observer_;
+  uint32_t change_seq_ = 0;
+  std::vector<uint32_t> motor_seq_;
+  std::vector<MotorState> last_visible_;
 };
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace motor {
+
+// Decides when a rendered status snapshot should go out: as soon as it differs
+// from the last one sent, otherwise as a heartbeat once the motion or idle
+// interval elapsed. Shared by the MQTT status publisher and serial SUB STATUS.
+class StatusCadence {
+public:
+  struct Config {
+    uint32_t idle_interval_ms = 1000;
+    uint32_t motion_interval_ms = 200;
+    // Changed snapshots wait at least this long after the previous send.
+    uint32_t min_interval_ms = 0;
+    // When false, an unchanged snapshot is never resent.
+    bool heartbeat = true;
+  };
+
+  StatusCadence() = default;
+  explicit StatusCadence(const Config& cfg) : cfg_(cfg) {}
+
+  void configure(const Config& cfg) {
+    cfg_ = cfg;
+  }
+  const Config& config() const {
+    return cfg_;
+  }
+
+  // The next due() returns true regardless of content or timing.
+  void force() {
+    force_ = true;
+  }
+
+  // Returns true when snapshot should be sent now; call markSent() once it was.
+  bool due(const std::string& snapshot, bool motion_active, uint32_t now_ms) {
+    return dueHashed(std::hash<std::string>{}(snapshot), motion_active, now_ms);
+  }
+  // due() for callers that kept the hash of a snapshot they did not rebuild.
+  bool dueHashed(std::size_t snapshot_hash, bool motion_active, uint32_t now_ms) {
+    pending_hash_ = snapshot_hash;
+    if (force_ || !has_last_) {
+      return true;
+    }
+    const uint32_t since = now_ms - last_sent_ms_;
+    if (pending_hash_ != last_hash_) {
+      return since >= cfg_.min_interval_ms;
+    }
+    const uint32_t interval = motion_active ? cfg_.motion_interval_ms : cfg_.idle_interval_ms;
+    return cfg_.heartbeat && since >= interval;
+  }
+
+  void markSent(uint32_t now_ms) {
+    last_hash_ = pending_hash_;
+    has_last_ = true;
+    last_sent_ms_ = now_ms;
+    force_ = false;
+  }
+
+  uint32_t lastSentMs() const {
+    return last_sent_ms_;
+  }
+
+private:
+  Config cfg_;
+  std::size_t pending_hash_ = 0;
+  std::size_t last_hash_ = 0;
+  bool has_last_ = false;
+  bool force_ = true;
+  uint32_t last_sent_ms_ = 0;
+};
+
+}  // namespace motor
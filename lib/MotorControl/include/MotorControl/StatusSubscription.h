@@ -0,0 +1,59 @@
+#pragma once
+
+#include "MotorControl/MotorController.h"
+#include "MotorControl/StatusCadence.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace motor {
+
+// Serial push-mode status (SUB STATUS,<interval_ms>[,changes_only]). poll()
+// renders one compact line per due frame:
+//   ST t=<ms> <motor> <motor> ...
+// where each motor is colon separated:
+//   <id>:<pos>:<flags>:<steps_since_home>:<budget_t>:<ttfc_t>:<speed>:<accel>:
+//   <est_ms>:<started_ms>[:<actual_ms>]
+// flags is a bitmask (1 moving, 2 awake, 4 homed) and budget/ttfc are in tenths
+// of a second. Frames follow StatusCadence: every interval_ms while anything
+// moves, on change or once per second at idle. With changes_only a frame lists
+// only motors whose fields changed and idle heartbeats are skipped.
+class StatusSubscription {
+public:
+  static constexpr uint32_t kMinIntervalMs = 20;
+  static constexpr uint32_t kMaxIntervalMs = 60000;
+  static constexpr uint32_t kIdleIntervalMs = 1000;
+
+  bool active() const {
+    return active_;
+  }
+  uint32_t intervalMs() const {
+    return interval_ms_;
+  }
+  bool changesOnly() const {
+    return changes_only_;
+  }
+
+  // interval_ms is clamped to [kMinIntervalMs, kMaxIntervalMs]. The first frame
+  // after subscribing always lists every motor.
+  void subscribe(uint32_t interval_ms, bool changes_only);
+  void unsubscribe();
+
+  // Renders the next frame into out when one is due. out keeps its capacity
+  // between calls, so steady-state polling does not allocate.
+  bool poll(const MotorController& controller, uint32_t now_ms, std::string& out);
+
+private:
+  bool active_ = false;
+  bool changes_only_ = false;
+  bool send_all_ = true;
+  uint32_t interval_ms_ = 0;
+  StatusCadence cadence_;
+  std::string motors_;
+  std::vector<size_t> offsets_;
+  std::vector<uint32_t> sent_hashes_;
+};
+
+}  // namespace motor
@@ -13,10 +13,6 @@ public:
                         CommandExecutionContext& context,
                         CommandRouter& router,
                         uint32_t now_ms);
-
-private:
-  bool isMotionAction(const std::string& action) const;
-  uint32_t maskFor(const ParsedCommand& command, const CommandExecutionContext& context) const;
 };
 
 }  // namespace command
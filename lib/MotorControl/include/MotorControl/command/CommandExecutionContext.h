@@ -1,7 +1,9 @@
 #pragma once
 
 #include "MotorControl/MotorController.h"
+#include "MotorControl/StatusSubscription.h"
 #include "net_onboarding/NetOnboarding.h"
+#include "transport/MessageId.h"
 
 #include <string>
 
@@ -16,10 +18,13 @@ public:
                           int& default_accel_sps2,
                           int& default_decel_sps2,
                           bool& in_batch,
-                          bool& batch_initially_idle);
+                          bool& batch_initially_idle,
+                          const transport::message_id::Id& cmd_id_override,
+                          StatusSubscription& status_subscription);
 
   MotorController& controller();
   const MotorController& controller() const;
+  StatusSubscription& statusSubscription() const;
 
   bool thermalLimitsEnabled() const;
   void setThermalLimitsEnabled(bool enabled);
@@ -28,8 +33,9 @@ public:
   int& defaultAccel();
   int& defaultDecel();
 
-  std::string nextMsgId() const;
-  void setActiveMsgId(const std::string& msg_id) const;
+  // Returns the host-supplied cmd_id when the line carried one, otherwise a fresh id.
+  transport::message_id::Id nextMsgId() const;
+  void setActiveMsgId(const transport::message_id::Id& msg_id) const;
   void clearActiveMsgId() const;
   bool printCtrlLineImmediate(const std::string& line) const;
 
@@ -47,6 +53,8 @@ private:
   int& default_decel_sps2_;
   bool& in_batch_;
   bool& batch_initially_idle_;
+  const transport::message_id::Id& cmd_id_override_;
+  StatusSubscription& status_subscription_;
 };
 
 }  // namespace command
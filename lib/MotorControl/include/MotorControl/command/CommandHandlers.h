@@ -12,12 +12,12 @@ public:
   execute(const ParsedCommand& command, CommandExecutionContext& context, uint32_t now_ms) override;
 
 private:
-  CommandResult handleWake(const std::string& args, CommandExecutionContext& context);
-  CommandResult handleSleep(const std::string& args, CommandExecutionContext& context);
+  CommandResult handleWake(const ParsedCommand& command, CommandExecutionContext& context);
+  CommandResult handleSleep(const ParsedCommand& command, CommandExecutionContext& context);
   CommandResult
-  handleMove(const std::string& args, CommandExecutionContext& context, uint32_t now_ms);
+  handleMove(const ParsedCommand& command, CommandExecutionContext& context, uint32_t now_ms);
   CommandResult
-  handleHome(const std::string& args, CommandExecutionContext& context, uint32_t now_ms);
+  handleHome(const ParsedCommand& command, CommandExecutionContext& context, uint32_t now_ms);
 };
 
 class QueryCommandHandler : public CommandHandler {
@@ -27,10 +27,12 @@ public:
   execute(const ParsedCommand& command, CommandExecutionContext& context, uint32_t now_ms) override;
 
 private:
-  CommandResult handleHelp() const;
-  CommandResult handleStatus(CommandExecutionContext& context);
+  CommandResult handleHelp(CommandExecutionContext& context) const;
+  CommandResult handleStatus(const std::string& args, CommandExecutionContext& context);
   CommandResult handleGet(const std::string& args, CommandExecutionContext& context);
   CommandResult handleSet(const std::string& args, CommandExecutionContext& context);
+  CommandResult handleSubscribe(const std::string& args, CommandExecutionContext& context);
+  CommandResult handleUnsubscribe(const std::string& args, CommandExecutionContext& context);
 };
 
 class NetCommandHandler : public CommandHandler {
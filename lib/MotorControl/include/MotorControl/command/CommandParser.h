@@ -1,5 +1,6 @@
 #pragma once
 
+#include "MotorControl/MotorControlConstants.h"
 #include "MotorControl/command/CommandResult.h"
 #include "MotorControl/command/CommandUtils.h"
 
@@ -10,15 +11,56 @@
 namespace motor {
 namespace command {
 
+// Longest host-supplied correlation id accepted via the `#<cmd_id>` line prefix.
+constexpr size_t kMaxCmdIdLength = 48;
+
+enum class MotionKind : uint8_t { kNone, kMove, kHome, kWake, kSleep };
+
+// Typed arguments for motion commands, validated once at parse time so the
+// batch executor and handlers do not re-split the raw args.
+struct MotionArgs {
+  uint32_t mask = 0;
+  long target = 0;
+  long overshoot = MotorControlConstants::DEFAULT_OVERSHOOT;
+  long backoff = MotorControlConstants::DEFAULT_BACKOFF;
+  long full_range = 0;
+  int speed = 0;  // 0 = use the context default
+  int accel = 0;  // 0 = use the context default
+};
+
 struct ParsedCommand {
   std::string raw;
   std::string action;
   std::string args;
+  MotionKind motion_kind = MotionKind::kNone;
+  MotionArgs motion;
+  // First validation failure found while typing the args; empty when valid.
+  std::string error_code;
+  std::string error_reason;
+
+  bool isMotion() const {
+    return motion_kind != MotionKind::kNone;
+  }
+  bool valid() const {
+    return error_code.empty();
+  }
+};
+
+// A whole input line: its optional `#<cmd_id>` prefix and the commands after it.
+struct ParsedLine {
+  bool cmd_id_valid = true;  // false when the prefix is malformed; commands is empty
+  std::string cmd_id;
+  std::vector<ParsedCommand> commands;
 };
 
 class CommandParser {
 public:
-  std::vector<ParsedCommand> parse(const std::string& line) const;
+  std::vector<ParsedCommand> parse(const std::string& line, uint8_t motor_count = 8) const;
+  ParsedLine parseLine(const std::string& line, uint8_t motor_count = 8) const;
+
+  // Splits an optional leading `#<cmd_id>` prefix from a line. cmd_id is left
+  // empty when no prefix is present; returns false if the prefix is malformed.
+  bool splitCmdIdPrefix(const std::string& line, std::string& cmd_id, std::string& rest) const;
 };
 
 }  // namespace command
@@ -2,8 +2,9 @@
 
 #include "transport/CommandSchema.h"
 
+#include <cstddef>
 #include <string>
-#include <vector>
+#include <utility>
 
 namespace motor {
 namespace command {
@@ -16,6 +17,15 @@ struct CommandResult {
     structured.lines.push_back(line);
   }
 
+  void append(transport::command::ResponseLine&& line) {
+    structured.lines.push_back(std::move(line));
+  }
+
+  // Sizes the line storage up front so multi-line responses grow at most once.
+  void reserve(size_t lines) {
+    structured.lines.reserve(lines);
+  }
+
   void mergeFrom(const CommandResult& other) {
     if (&other == this) {
       return;
@@ -28,6 +38,22 @@ struct CommandResult {
     }
   }
 
+  void mergeFrom(CommandResult&& other) {
+    if (&other == this) {
+      return;
+    }
+    if (structured.lines.empty()) {
+      structured.lines = std::move(other.structured.lines);
+    } else {
+      for (auto& line : other.structured.lines) {
+        append(std::move(line));
+      }
+    }
+    if (other.is_error) {
+      is_error = true;
+    }
+  }
+
   bool hasStructuredResponse() const {
     return !structured.lines.empty();
   }
@@ -37,7 +37,9 @@ HardwareMotorController::HardwareMotorController(IShift595& shift,
                             0,
                             0,
                             0,
-                            false};
+                            false,
+                            0,
+                            0};
     homing_[i] = HomingPlan{false, 0, 0, 0, 0, 0, 0};
   }
   // Initialize hardware/adapters
@@ -85,7 +87,9 @@ HardwareMotorController::HardwareMotorController() {
                             0,
                             0,
                             0,
-                            false};
+                            false,
+                            0,
+                            0};
     homing_[i] = HomingPlan{false, 0, 0, 0, 0, 0, 0};
   }
   shift_->begin();
@@ -221,6 +225,8 @@ bool HardwareMotorController::moveAbsMask(
       est = MotionKinematics::estimateMoveTimeMs(dist, speed, accel);
 #endif
       motors_[i].last_op_type = 1;
+      motors_[i].last_op_start_pos = cur;
+      motors_[i].last_op_target = target;
       motors_[i].last_op_started_ms = now_ms;
       motors_[i].last_op_est_ms = est;
       motors_[i].last_op_ongoing = true;
@@ -291,6 +297,8 @@ bool HardwareMotorController::homeMask(uint32_t mask,
           overshoot, backoff, full_range, speed, accel);
 #endif
       motors_[i].last_op_type = 2;
+      motors_[i].last_op_start_pos = cur;
+      motors_[i].last_op_target = 0;
       motors_[i].last_op_started_ms = now_ms;
       motors_[i].last_op_est_ms = est;
       motors_[i].last_op_ongoing = true;
@@ -311,6 +319,7 @@ bool HardwareMotorController::homeMask(uint32_t mask,
 }
 
 void HardwareMotorController::tick(uint32_t now_ms) {
+  const uint32_t ongoing_before = ongoingMask();
   // Pull runtime state from adapter; awake reflects running or WAKE override
   for (uint8_t i = 0; i < count_; ++i) {
     if (now_ms >= motors_[i].last_update_ms) {
@@ -451,6 +460,8 @@ void HardwareMotorController::tick(uint32_t now_ms) {
     }
   }
   // Native: start/stop latches handled above; Arduino: adapter handles gating
+  notifyCompleted(ongoing_before);
+  recordVisibleChanges();
 }
 
 void HardwareMotorController::setDeceleration(int decel_sps2) {
@@ -139,6 +139,54 @@ uint32_t estimateMoveTimeMsAsym(int64_t distance_steps,
   }
 }
 
+uint32_t profileSpeedSps(int64_t done_steps,
+                         int64_t remaining_steps,
+                         int64_t speed_sps,
+                         int64_t accel_sps2) {
+  if (speed_sps <= 0 || accel_sps2 <= 0)
+    return 0;
+  // v^2 = 2*a*s on both ramps; whichever end is closer bounds the speed.
+  int64_t s = iabs64(done_steps);
+  int64_t rem = iabs64(remaining_steps);
+  if (rem < s)
+    s = rem;
+  int64_t v = isqrt_ceil(2 * accel_sps2 * s);
+  if (v > speed_sps)
+    v = speed_sps;
+  return (uint32_t)v;
+}
+
+uint32_t remainingMoveTimeMs(int64_t remaining_steps,
+                             int64_t current_sps,
+                             int64_t speed_sps,
+                             int64_t accel_sps2) {
+  int64_t d = iabs64(remaining_steps);
+  if (d <= 0)
+    return 0;
+  if (speed_sps <= 0)
+    speed_sps = 1;
+  if (accel_sps2 <= 0)
+    accel_sps2 = 1;
+  int64_t v = current_sps < 0 ? 0 : current_sps;
+  if (v > speed_sps)
+    v = speed_sps;
+  int64_t a = accel_sps2;
+
+  // Already braking: constant deceleration covers d at average speed v/2.
+  if (v * v >= 2 * a * d)
+    return (uint32_t)ceil_div(2 * d * 1000, v);
+
+  // Ramp up to the peak, optionally cruise, then brake to zero.
+  int64_t peak = isqrt_ceil((v * v + 2 * a * d) / 2);
+  if (peak < speed_sps)
+    return (uint32_t)ceil_div((2 * peak - v) * 1000, a);
+  int64_t vmax = speed_sps;
+  int64_t ramp_steps = (vmax * vmax - v * v) / (2 * a) + (vmax * vmax) / (2 * a);
+  int64_t cruise_steps = d > ramp_steps ? d - ramp_steps : 0;
+  int64_t t_ms = ceil_div((2 * vmax - v) * 1000, a) + ceil_div(cruise_steps * 1000, vmax);
+  return (uint32_t)t_ms;
+}
+
 uint32_t estimateHomeTimeMs(int64_t overshoot_steps,
                             int64_t backoff_steps,
                             int64_t speed_sps,
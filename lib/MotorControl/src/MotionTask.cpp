@@ -0,0 +1,292 @@
+#include "MotorControl/MotionTask.h"
+
+#include "transport/CompletionTracker.h"
+#include "transport/ResponseDispatcher.h"
+
+#include <utility>
+
+#if defined(ARDUINO)
+#include <Arduino.h>
+#else
+#include <chrono>
+#endif
+
+namespace motor {
+
+namespace {
+
+uint32_t DefaultClock() {
+#if defined(ARDUINO)
+  return millis();
+#else
+  static const auto start = std::chrono::steady_clock::now();
+  return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                   std::chrono::steady_clock::now() - start)
+                                   .count());
+#endif
+}
+
+void Yield() {
+#if defined(ARDUINO) && defined(ESP32)
+  vTaskDelay(1);
+#else
+  std::this_thread::yield();
+#endif
+}
+
+}  // namespace
+
+const MotorState& SnapshotMotorController::state(size_t idx) const {
+  static const MotorState kNoMotor{};
+  return idx < snapshot_.motor_count ? snapshot_.motors[idx] : kNoMotor;
+}
+
+bool SnapshotMotorController::isAnyMovingForMask(uint32_t mask) const {
+  for (size_t i = 0; i < snapshot_.motor_count; ++i) {
+    if ((mask & (1u << i)) && snapshot_.motors[i].moving) {
+      return true;
+    }
+  }
+  return false;
+}
+
+MotionTask::MotionTask(MotorCommandProcessor& processor) : MotionTask(processor, Config()) {}
+
+MotionTask::MotionTask(MotorCommandProcessor& processor, Config cfg)
+    : processor_(processor), cfg_(std::move(cfg)), jobs_(cfg_.job_depth),
+      events_(cfg_.event_depth) {
+  if (!cfg_.clock) {
+    cfg_.clock = DefaultClock;
+  }
+  finished_.reserve(cfg_.job_depth);
+  publishSnapshot(now());
+}
+
+MotionTask::~MotionTask() {
+  stop();
+}
+
+bool MotionTask::start() {
+  if (running()) {
+    return true;
+  }
+  transport::response::ResponseDispatcher::Instance().SetEmitHook(
+      [this](const transport::response::Event& event,
+             const transport::command::ResponseLine* line) {
+        return this->captureEvent(event, line);
+      });
+  exited_.store(false, std::memory_order_release);
+  running_.store(true, std::memory_order_release);
+#if defined(ARDUINO) && defined(ESP32)
+  TaskHandle_t handle = nullptr;
+  if (xTaskCreatePinnedToCore(&MotionTask::TaskEntry,
+                              "motion",
+                              cfg_.stack_bytes,
+                              this,
+                              cfg_.priority,
+                              &handle,
+                              cfg_.core) != pdPASS) {
+    running_.store(false, std::memory_order_release);
+    exited_.store(true, std::memory_order_release);
+    transport::response::ResponseDispatcher::Instance().SetEmitHook(nullptr);
+    return false;
+  }
+#else
+  thread_ = std::thread([this]() { this->run(); });
+#endif
+  return true;
+}
+
+void MotionTask::stop() {
+  if (!running()) {
+    return;
+  }
+  running_.store(false, std::memory_order_release);
+  // The task may be waiting to queue a control event.
+  while (!exited_.load(std::memory_order_acquire)) {
+    pumpEvents();
+    Yield();
+  }
+#if !(defined(ARDUINO) && defined(ESP32))
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+#endif
+  transport::response::ResponseDispatcher::Instance().SetEmitHook(nullptr);
+  pumpEvents();
+}
+
+#if defined(ARDUINO) && defined(ESP32)
+void MotionTask::TaskEntry(void* arg) {
+  static_cast<MotionTask*>(arg)->run();
+  vTaskDelete(nullptr);
+}
+#endif
+
+void MotionTask::run() {
+#if defined(ARDUINO) && defined(ESP32)
+  task_.store(xTaskGetCurrentTaskHandle(), std::memory_order_release);
+  const TickType_t period = pdMS_TO_TICKS(cfg_.period_ms) > 0 ? pdMS_TO_TICKS(cfg_.period_ms) : 1;
+#else
+  thread_id_.store(std::this_thread::get_id(), std::memory_order_release);
+#endif
+  while (running_.load(std::memory_order_acquire)) {
+    step(now());
+#if defined(ARDUINO) && defined(ESP32)
+    vTaskDelay(period);
+#else
+    std::this_thread::sleep_for(std::chrono::milliseconds(cfg_.period_ms));
+#endif
+  }
+  // Finish jobs a caller may still be waiting on.
+  PendingJob pending;
+  while (jobs_.pop(pending)) {
+    (*pending.job)(now());
+    pending.done->store(true, std::memory_order_release);
+  }
+#if defined(ARDUINO) && defined(ESP32)
+  task_.store(nullptr, std::memory_order_release);
+#else
+  thread_id_.store(std::thread::id(), std::memory_order_release);
+#endif
+  exited_.store(true, std::memory_order_release);
+}
+
+bool MotionTask::onMotionTask() const {
+#if defined(ARDUINO) && defined(ESP32)
+  return xTaskGetCurrentTaskHandle() == task_.load(std::memory_order_acquire);
+#else
+  return std::this_thread::get_id() == thread_id_.load(std::memory_order_acquire);
+#endif
+}
+
+void MotionTask::step(uint32_t now_ms) {
+  PendingJob pending;
+  while (finished_.size() < finished_.capacity() && jobs_.pop(pending)) {
+    (*pending.job)(now_ms);
+    finished_.push_back(pending.done);
+  }
+  processor_.tick(now_ms);
+  transport::response::CompletionTracker::Instance().Tick(now_ms);
+  publishSnapshot(now_ms);
+  // Release callers only now so the snapshot they read next already reflects their job.
+  for (auto* done : finished_) {
+    done->store(true, std::memory_order_release);
+  }
+  finished_.clear();
+  steps_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void MotionTask::call(const Job& job) {
+  if (!running() || onMotionTask()) {
+    job(now());
+    return;
+  }
+  std::atomic<bool> done{false};
+  PendingJob pending;
+  pending.job = &job;
+  pending.done = &done;
+  while (!jobs_.push(std::move(pending))) {
+    Yield();
+  }
+  // Keep draining events so a job that raises many of them is never stuck.
+  while (!done.load(std::memory_order_acquire)) {
+    pumpEvents();
+    Yield();
+  }
+  pumpEvents();
+}
+
+command::CommandResult MotionTask::execute(const std::string& line, uint32_t now_ms) {
+  // Parsed once here; the motion task executes the parsed commands.
+  const command::ParsedLine parsed = processor_.parse(line);
+  if (!needsController(parsed)) {
+    return processor_.execute(parsed, now_ms);
+  }
+  command::CommandResult result;
+  call([&](uint32_t) { result = processor_.execute(parsed, now_ms); });
+  return result;
+}
+
+bool MotionTask::needsController(const command::ParsedLine& parsed) const {
+  if (!parsed.cmd_id_valid || parsed.commands.empty()) {
+    return true;
+  }
+  for (const auto& command : parsed.commands) {
+    if (command.action != "NET" && command.action != "MQTT" && command.action != "SUB" &&
+        command.action != "UNSUB") {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool MotionTask::captureEvent(const transport::response::Event& event,
+                              const transport::command::ResponseLine* line) {
+  if (!onMotionTask()) {
+    return false;
+  }
+  // The line does not outlive this call, so the queued copy takes its fields.
+  transport::response::Event queued =
+      line != nullptr ? transport::response::BuildEvent(*line, event.action) : event;
+  const bool control = queued.type != transport::response::EventType::kInfo &&
+                       queued.type != transport::response::EventType::kData;
+  while (!events_.push(std::move(queued))) {
+    if (!control) {
+      events_dropped_.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+    // Hosts wait on ACK/DONE/ERROR; hold the motion task until the caller
+    // task pumps rather than lose one.
+    Yield();
+  }
+  const size_t depth = events_.size();
+  size_t high_water = event_high_water_.load(std::memory_order_relaxed);
+  while (depth > high_water &&
+         !event_high_water_.compare_exchange_weak(high_water, depth, std::memory_order_relaxed)) {
+  }
+  return true;
+}
+
+size_t MotionTask::pumpEvents() {
+  size_t count = 0;
+  transport::response::Event event;
+  while (events_.pop(event)) {
+    transport::response::ResponseDispatcher::Instance().Emit(event);
+    ++count;
+  }
+  return count;
+}
+
+bool MotionTask::snapshot(MotionSnapshot& out) const {
+  return snapshot_.load(out);
+}
+
+MotionTask::Stats MotionTask::stats() const {
+  Stats stats;
+  stats.steps = steps_.load(std::memory_order_relaxed);
+  stats.events_dropped = events_dropped_.load(std::memory_order_relaxed);
+  stats.event_high_water = event_high_water_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void MotionTask::publishSnapshot(uint32_t now_ms) {
+  MotionSnapshot& snapshot = scratch_;
+  snapshot.taken_ms = now_ms;
+  const MotorController& controller = processor_.controller();
+  const size_t count =
+      controller.motorCount() < kMaxSnapshotMotors ? controller.motorCount() : kMaxSnapshotMotors;
+  snapshot.motor_count = static_cast<uint8_t>(count);
+  snapshot.change_seq = controller.changeSeq();
+  for (size_t i = 0; i < count; ++i) {
+    snapshot.motors[i] = controller.state(i);
+    snapshot.motor_seq[i] = controller.motorChangeSeq(i);
+  }
+  snapshot_.store(snapshot);
+}
+
+uint32_t MotionTask::now() const {
+  return cfg_.clock();
+}
+
+}  // namespace motor
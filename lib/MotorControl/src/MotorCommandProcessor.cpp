@@ -5,7 +5,10 @@
 #include "MotorControl/command/CommandResult.h"
 #include "MotorControl/command/ResponseFormatter.h"
 #include "StubMotorController.h"
+#include "transport/CommandSchema.h"
 #include "transport/CompletionTracker.h"
+#include "transport/ResponseDispatcher.h"
+#include "transport/ResponseModel.h"
 #if !defined(USE_STUB_BACKEND) && !defined(UNIT_TEST)
 #include "MotorControl/HardwareMotorController.h"
 #endif
@@ -20,6 +23,7 @@ using motor::command::CommandParser;
 using motor::command::CommandResult;
 using motor::command::CommandRouter;
 using motor::command::ParsedCommand;
+using motor::command::ParsedLine;
 
 MotorCommandProcessor::MotorCommandProcessor()
 #if !defined(USE_STUB_BACKEND) && !defined(UNIT_TEST)
@@ -33,6 +37,10 @@ MotorCommandProcessor::MotorCommandProcessor()
   default_accel_sps2_ = MotorControlConstants::DEFAULT_ACCEL_SPS2;
   default_decel_sps2_ = 0;
   controller_->setDeceleration(default_decel_sps2_);
+  MotorController* controller = controller_.get();
+  controller_->setCompletionObserver([controller](const MotorState& state) {
+    transport::response::CompletionTracker::Instance().OnMotorCompleted(*controller, state);
+  });
 
   std::vector<std::unique_ptr<CommandHandler>> handlers;
   handlers.emplace_back(std::unique_ptr<CommandHandler>(new motor::command::MotorCommandHandler()));
@@ -48,17 +56,40 @@ MotorCommandProcessor::~MotorCommandProcessor() {
 }
 
 CommandResult MotorCommandProcessor::execute(const std::string& line, uint32_t now_ms) {
-  auto commands = parser_.parse(line);
+  return execute(parse(line), now_ms);
+}
+
+ParsedLine MotorCommandProcessor::parse(const std::string& line) const {
+  return parser_.parseLine(line, static_cast<uint8_t>(controller_->motorCount()));
+}
+
+CommandResult MotorCommandProcessor::execute(const ParsedLine& parsed, uint32_t now_ms) {
+  if (!parsed.cmd_id_valid) {
+    CommandExecutionContext context = makeContext();
+    auto err_line =
+        transport::command::MakeErrorLine(context.nextMsgId(), "E03", "BAD_PARAM CMD_ID", {});
+    transport::response::ResponseDispatcher::Instance().Emit(err_line, std::string());
+    return CommandResult::Error(err_line);
+  }
+  const auto& commands = parsed.commands;
   if (commands.empty()) {
     return CommandResult();
   }
 
+  // Every id minted while executing this line resolves to the host's cmd_id so
+  // ACK/DONE/ERR events echo it back for out-of-order correlation.
+  cmd_id_override_ = parsed.cmd_id;
+  transport::response::CompletionTracker::Instance().BeginCommandLine();
   CommandExecutionContext context = makeContext();
+  CommandResult result;
   if (commands.size() == 1) {
     context.setBatchState(false, false);
-    return dispatchSingle(commands[0], context, now_ms);
+    result = dispatchSingle(commands[0], context, now_ms);
+  } else {
+    result = batch_executor_.execute(commands, context, *router_, now_ms);
   }
-  return batch_executor_.execute(commands, context, *router_, now_ms);
+  cmd_id_override_.clear();
+  return result;
 }
 
 std::string MotorCommandProcessor::processLine(const std::string& line, uint32_t now_ms) {
@@ -73,7 +104,9 @@ CommandExecutionContext MotorCommandProcessor::makeContext() {
                                  default_accel_sps2_,
                                  default_decel_sps2_,
                                  in_batch_,
-                                 batch_initially_idle_);
+                                 batch_initially_idle_,
+                                 cmd_id_override_,
+                                 status_subscription_);
 }
 
 CommandResult MotorCommandProcessor::dispatchSingle(const ParsedCommand& command,
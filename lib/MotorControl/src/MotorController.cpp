@@ -0,0 +1,43 @@
+#include "MotorControl/MotorController.h"
+
+namespace {
+
+// The fields STATUS reports; last_update_ms moves every tick and is left out.
+bool SameVisibleState(const MotorState& a, const MotorState& b) {
+  return a.position == b.position && a.speed == b.speed && a.accel == b.accel &&
+         a.moving == b.moving && a.awake == b.awake && a.homed == b.homed &&
+         a.steps_since_home == b.steps_since_home && a.budget_tenths == b.budget_tenths &&
+         a.last_op_started_ms == b.last_op_started_ms && a.last_op_last_ms == b.last_op_last_ms &&
+         a.last_op_est_ms == b.last_op_est_ms && a.last_op_ongoing == b.last_op_ongoing &&
+         a.last_op_start_pos == b.last_op_start_pos && a.last_op_target == b.last_op_target;
+}
+
+}  // namespace
+
+void MotorController::recordVisibleChanges() {
+  const size_t count = motorCount();
+  if (last_visible_.size() != count) {
+    // First tick (or a resize): every motor counts as changed.
+    last_visible_.assign(count, MotorState{});
+    motor_seq_.assign(count, 0);
+    ++change_seq_;
+    for (size_t i = 0; i < count; ++i) {
+      last_visible_[i] = state(i);
+      motor_seq_[i] = change_seq_;
+    }
+    return;
+  }
+  bool bumped = false;
+  for (size_t i = 0; i < count; ++i) {
+    const MotorState& current = state(i);
+    if (SameVisibleState(current, last_visible_[i])) {
+      continue;
+    }
+    if (!bumped) {
+      ++change_seq_;
+      bumped = true;
+    }
+    last_visible_[i] = current;
+    motor_seq_[i] = change_seq_;
+  }
+}
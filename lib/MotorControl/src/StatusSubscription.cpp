@@ -0,0 +1,151 @@
+#include "MotorControl/StatusSubscription.h"
+
+#include "MotorControl/MotorControlConstants.h"
+
+namespace motor {
+
+namespace {
+
+void AppendUnsigned(std::string& out, unsigned long long value) {
+  char buffer[21];
+  size_t len = 0;
+  do {
+    buffer[len++] = static_cast<char>('0' + (value % 10ULL));
+    value /= 10ULL;
+  } while (value != 0ULL);
+  while (len > 0) {
+    out.push_back(buffer[--len]);
+  }
+}
+
+void AppendSigned(std::string& out, long long value) {
+  if (value < 0) {
+    out.push_back('-');
+    AppendUnsigned(out, static_cast<unsigned long long>(-(value + 1LL)) + 1ULL);
+    return;
+  }
+  AppendUnsigned(out, static_cast<unsigned long long>(value));
+}
+
+// FNV-1a; hashes a motor's slice of the frame without copying it out.
+uint32_t HashRange(const char* data, size_t len) {
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < len; ++i) {
+    hash = (hash ^ static_cast<uint8_t>(data[i])) * 16777619u;
+  }
+  return hash;
+}
+
+int32_t TimeToFullTenths(int32_t budget_tenths) {
+  const int32_t missing = MotorControlConstants::BUDGET_TENTHS_MAX - budget_tenths;
+  if (missing <= 0) {
+    return 0;
+  }
+  const int32_t ttfc = static_cast<int32_t>((static_cast<int64_t>(missing) * 10 +
+                                             MotorControlConstants::REFILL_TENTHS_PER_SEC - 1) /
+                                            MotorControlConstants::REFILL_TENTHS_PER_SEC);
+  const int32_t max_tenths = MotorControlConstants::MAX_COOL_DOWN_TIME_S * 10;
+  return ttfc > max_tenths ? max_tenths : ttfc;
+}
+
+void AppendMotor(const MotorState& s, std::string& out) {
+  const unsigned flags = (s.moving ? 1u : 0u) | (s.awake ? 2u : 0u) | (s.homed ? 4u : 0u);
+  AppendUnsigned(out, s.id);
+  out.push_back(':');
+  AppendSigned(out, s.position);
+  out.push_back(':');
+  AppendUnsigned(out, flags);
+  out.push_back(':');
+  AppendSigned(out, s.steps_since_home);
+  out.push_back(':');
+  AppendSigned(out, s.budget_tenths);
+  out.push_back(':');
+  AppendSigned(out, TimeToFullTenths(s.budget_tenths));
+  out.push_back(':');
+  AppendSigned(out, s.speed);
+  out.push_back(':');
+  AppendSigned(out, s.accel);
+  out.push_back(':');
+  AppendUnsigned(out, s.last_op_est_ms);
+  out.push_back(':');
+  AppendUnsigned(out, s.last_op_started_ms);
+  if (!s.last_op_ongoing) {
+    out.push_back(':');
+    AppendUnsigned(out, s.last_op_last_ms);
+  }
+}
+
+}  // namespace
+
+void StatusSubscription::subscribe(uint32_t interval_ms, bool changes_only) {
+  if (interval_ms < kMinIntervalMs) {
+    interval_ms = kMinIntervalMs;
+  } else if (interval_ms > kMaxIntervalMs) {
+    interval_ms = kMaxIntervalMs;
+  }
+  active_ = true;
+  changes_only_ = changes_only;
+  interval_ms_ = interval_ms;
+  send_all_ = true;
+
+  StatusCadence::Config cfg;
+  cfg.motion_interval_ms = interval_ms;
+  cfg.min_interval_ms = interval_ms;
+  cfg.idle_interval_ms = interval_ms > kIdleIntervalMs ? interval_ms : kIdleIntervalMs;
+  cfg.heartbeat = !changes_only;
+  cadence_.configure(cfg);
+  cadence_.force();
+}
+
+void StatusSubscription::unsubscribe() {
+  active_ = false;
+}
+
+bool StatusSubscription::poll(const MotorController& controller,
+                              uint32_t now_ms,
+                              std::string& out) {
+  if (!active_) {
+    return false;
+  }
+  const size_t count = controller.motorCount();
+  motors_.clear();
+  offsets_.clear();
+  bool motion_active = false;
+  for (size_t i = 0; i < count; ++i) {
+    const MotorState& s = controller.state(i);
+    offsets_.push_back(motors_.size());
+    AppendMotor(s, motors_);
+    motion_active = motion_active || s.moving;
+  }
+  offsets_.push_back(motors_.size());
+
+  if (!cadence_.due(motors_, motion_active, now_ms)) {
+    return false;
+  }
+  if (sent_hashes_.size() != count) {
+    sent_hashes_.assign(count, 0);
+    send_all_ = true;
+  }
+
+  out.clear();
+  out.append("ST t=");
+  AppendUnsigned(out, now_ms);
+  const size_t header = out.size();
+  for (size_t i = 0; i < count; ++i) {
+    const char* begin = motors_.data() + offsets_[i];
+    const size_t len = offsets_[i + 1] - offsets_[i];
+    const uint32_t hash = HashRange(begin, len);
+    if (changes_only_ && !send_all_ && hash == sent_hashes_[i]) {
+      continue;
+    }
+    sent_hashes_[i] = hash;
+    out.push_back(' ');
+    out.append(begin, len);
+  }
+  cadence_.markSent(now_ms);
+  send_all_ = false;
+  // A changes-only heartbeat with nothing new is not worth a line.
+  return out.size() > header || !changes_only_;
+}
+
+}  // namespace motor
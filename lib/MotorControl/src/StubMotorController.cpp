@@ -27,7 +27,9 @@ StubMotorController::StubMotorController(uint8_t count) : count_(count) {
                             0,
                             0,
                             0,
-                            false};
+                            false,
+                            0,
+                            0};
     plans_[i] = MovePlan{false, false, 0, 0, 0};
   }
 }
@@ -83,6 +85,8 @@ bool StubMotorController::moveAbsMask(
       plans_[i].start_pos = motors_[i].position;
       plans_[i].end_ms = now_ms + dur_ms;
       motors_[i].last_op_type = 1;
+      motors_[i].last_op_start_pos = motors_[i].position;
+      motors_[i].last_op_target = target;
       motors_[i].last_op_started_ms = now_ms;
       motors_[i].last_op_est_ms = dur_ms;
       motors_[i].last_op_ongoing = true;
@@ -113,6 +117,8 @@ bool StubMotorController::homeMask(uint32_t mask,
       plans_[i].start_pos = motors_[i].position;
       plans_[i].end_ms = now_ms + dur_ms;
       motors_[i].last_op_type = 2;
+      motors_[i].last_op_start_pos = motors_[i].position;
+      motors_[i].last_op_target = 0;
       motors_[i].last_op_started_ms = now_ms;
       motors_[i].last_op_est_ms = dur_ms;
       motors_[i].last_op_ongoing = true;
@@ -122,6 +128,7 @@ bool StubMotorController::homeMask(uint32_t mask,
 }
 
 void StubMotorController::tick(uint32_t now_ms) {
+  const uint32_t ongoing_before = ongoingMask();
   // Budget bookkeeping (tenths of seconds)
 
   for (uint8_t i = 0; i < count_; ++i) {
@@ -193,4 +200,6 @@ void StubMotorController::tick(uint32_t now_ms) {
       plans_[i].active = false;
     }
   }
+  notifyCompleted(ongoing_before);
+  recordVisibleChanges();
 }
@@ -1,6 +1,5 @@
 #include "MotorControl/command/CommandBatchExecutor.h"
 
-#include "MotorControl/command/CommandUtils.h"
 #include "transport/CommandSchema.h"
 #include "transport/ResponseDispatcher.h"
 #include "transport/ResponseModel.h"
@@ -12,30 +11,19 @@ namespace {
 
 void EmitLineEvent(const transport::command::ResponseLine& line,
                    const std::string& action = std::string()) {
-  transport::response::ResponseDispatcher::Instance().Emit(
-      transport::response::BuildEvent(line, action));
-}
-
-CommandResult MakeErrorResult(const transport::command::ResponseLine& line,
-                              const std::string& action = std::string()) {
-  EmitLineEvent(line, action);
-  CommandResult res;
-  res.is_error = true;
-  res.append(line);
-  return res;
+  transport::response::ResponseDispatcher::Instance().Emit(line, action);
 }
 
 bool ExtractUintField(const transport::command::ResponseLine& line,
-                      const std::string& key,
+                      const char* key,
                       uint32_t& out_value) {
   for (const auto& field : line.fields) {
-    if (field.key == key) {
-      try {
-        out_value = static_cast<uint32_t>(std::stoul(field.value));
-        return true;
-      } catch (...) {
+    if (transport::command::KeyEquals(field, key)) {
+      if (field.kind != transport::command::FieldKind::kInteger || field.number < 0) {
         return false;
       }
+      out_value = static_cast<uint32_t>(field.number);
+      return true;
     }
   }
   return false;
@@ -47,24 +35,39 @@ CommandResult CommandBatchExecutor::execute(const std::vector<ParsedCommand>& co
                                             CommandExecutionContext& context,
                                             CommandRouter& router,
                                             uint32_t now_ms) {
-  // Overlap detection
+  // Validate every command up front and report all failures together, so a
+  // rejected batch never starts any motion.
+  transport::message_id::Id err_msg_id;
+  CommandResult errors;
+  auto reject = [&](size_t index, const std::string& code, const std::string& reason,
+                    const std::string& action) {
+    if (err_msg_id.empty()) {
+      err_msg_id = context.nextMsgId();
+    }
+    auto line = transport::command::MakeErrorLine(err_msg_id, code, reason, {{"index", index}});
+    EmitLineEvent(line, action);
+    errors.append(line);
+  };
   uint32_t seen = 0;
-  for (const auto& cmd : commands) {
-    uint32_t mask = maskFor(cmd, context);
-    if (mask != 0 && (mask & seen)) {
-      auto line = transport::command::MakeErrorLine(
-          context.nextMsgId(), "E03", "BAD_PARAM MULTI_CMD_CONFLICT", {});
-      return MakeErrorResult(line);
+  for (size_t i = 0; i < commands.size(); ++i) {
+    const auto& cmd = commands[i];
+    if (!router.knowsAction(cmd.action)) {
+      reject(i, "E01", "BAD_CMD", cmd.action);
+      continue;
+    }
+    if (!cmd.valid()) {
+      reject(i, cmd.error_code, cmd.error_reason, cmd.action);
+      continue;
+    }
+    const uint32_t mask = cmd.motion.mask;
+    if (mask & seen) {
+      reject(i, "E03", "BAD_PARAM MULTI_CMD_CONFLICT", cmd.action);
     }
     seen |= mask;
   }
-
-  // Unknown action detection
-  for (const auto& cmd : commands) {
-    if (!router.knowsAction(cmd.action)) {
-      auto line = transport::command::MakeErrorLine(context.nextMsgId(), "E01", "BAD_CMD", {});
-      return MakeErrorResult(line, cmd.action);
-    }
+  if (errors.hasStructuredResponse()) {
+    errors.is_error = true;
+    return errors;
   }
 
   bool initially_idle = true;
@@ -110,8 +113,7 @@ CommandResult CommandBatchExecutor::execute(const std::vector<ParsedCommand>& co
   context.setBatchState(prev_in_batch, prev_initially_idle);
 
   if (saw_est) {
-    auto ack_line = transport::command::MakeAckLine(context.nextMsgId(),
-                                                    {{"est_ms", std::to_string(agg_est_ms)}});
+    auto ack_line = transport::command::MakeAckLine(context.nextMsgId(), {{"est_ms", agg_est_ms}});
     EmitLineEvent(ack_line);
     aggregate.lines.push_back(ack_line);
   }
@@ -120,28 +122,5 @@ CommandResult CommandBatchExecutor::execute(const std::vector<ParsedCommand>& co
   return res;
 }
 
-bool CommandBatchExecutor::isMotionAction(const std::string& action) const {
-  return action == "MOVE" || action == "M" || action == "HOME" || action == "H" ||
-         action == "WAKE" || action == "SLEEP";
-}
-
-uint32_t CommandBatchExecutor::maskFor(const ParsedCommand& command,
-                                       const CommandExecutionContext& context) const {
-  if (!isMotionAction(command.action)) {
-    return 0;
-  }
-  uint32_t mask = 0;
-  if (command.action == "MOVE" || command.action == "M" || command.action == "HOME" ||
-      command.action == "H") {
-    auto parts = Split(Trim(command.args), ',');
-    if (!parts.empty()) {
-      ParseIdMask(Trim(parts[0]), mask, context.controller().motorCount());
-    }
-  } else {
-    ParseIdMask(Trim(command.args), mask, context.controller().motorCount());
-  }
-  return mask;
-}
-
 }  // namespace command
 }  // namespace motor
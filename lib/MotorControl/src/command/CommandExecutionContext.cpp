@@ -13,11 +13,14 @@ CommandExecutionContext::CommandExecutionContext(MotorController& controller,
                                                  int& default_accel_sps2,
                                                  int& default_decel_sps2,
                                                  bool& in_batch,
-                                                 bool& batch_initially_idle)
+                                                 bool& batch_initially_idle,
+                                                 const transport::message_id::Id& cmd_id_override,
+                                                 StatusSubscription& status_subscription)
     : controller_(controller), thermal_limits_enabled_(thermal_limits_enabled),
       default_speed_sps_(default_speed_sps), default_accel_sps2_(default_accel_sps2),
       default_decel_sps2_(default_decel_sps2), in_batch_(in_batch),
-      batch_initially_idle_(batch_initially_idle) {}
+      batch_initially_idle_(batch_initially_idle), cmd_id_override_(cmd_id_override),
+      status_subscription_(status_subscription) {}
 
 MotorController& CommandExecutionContext::controller() {
   return controller_;
@@ -26,6 +29,10 @@ const MotorController& CommandExecutionContext::controller() const {
   return controller_;
 }
 
+StatusSubscription& CommandExecutionContext::statusSubscription() const {
+  return status_subscription_;
+}
+
 bool CommandExecutionContext::thermalLimitsEnabled() const {
   return thermal_limits_enabled_;
 }
@@ -45,11 +52,14 @@ int& CommandExecutionContext::defaultDecel() {
   return default_decel_sps2_;
 }
 
-std::string CommandExecutionContext::nextMsgId() const {
-  return transport::message_id::Next();
+transport::message_id::Id CommandExecutionContext::nextMsgId() const {
+  if (!cmd_id_override_.empty()) {
+    return cmd_id_override_;
+  }
+  return transport::message_id::NextId();
 }
 
-void CommandExecutionContext::setActiveMsgId(const std::string& msg_id) const {
+void CommandExecutionContext::setActiveMsgId(const transport::message_id::Id& msg_id) const {
   transport::message_id::SetActive(msg_id);
 }
 
@@ -34,9 +34,6 @@ namespace command {
 
 namespace {
 
-constexpr long kMinPos = MotorControlConstants::MIN_POS_STEPS;
-constexpr long kMaxPos = MotorControlConstants::MAX_POS_STEPS;
-
 uint32_t parseEstMs(const std::string& line) {
   size_t pos = line.find("est_ms=");
   if (pos == std::string::npos)
@@ -75,8 +72,13 @@ std::string FormatTenths(int32_t tenths) {
   return oss.str();
 }
 
-inline const char* BoolToFlag(bool value) {
-  return value ? "1" : "0";
+inline int BoolToFlag(bool value) {
+  return value ? 1 : 0;
+}
+
+const char* MsgIdFormatName() {
+  return transport::message_id::CurrentFormat() == transport::message_id::Format::kUuid ? "UUID"
+                                                                                         : "HEX";
 }
 
 long GetFreeHeapBytes() {
@@ -90,19 +92,22 @@ long GetFreeHeapBytes() {
 }
 
 void EmitResponseEvent(const char* action, const transport::command::ResponseLine& line) {
-  transport::response::ResponseDispatcher::Instance().Emit(
-      transport::response::BuildEvent(line, action ? action : std::string()));
+  auto& dispatcher = transport::response::ResponseDispatcher::Instance();
+  if (!dispatcher.HasSinks()) {
+    return;
+  }
+  dispatcher.Emit(line, action ? action : std::string());
 }
 
 CommandResult MakeResultWithLine(const char* action, transport::command::ResponseLine line) {
   EmitResponseEvent(action, line);
   CommandResult res;
-  res.append(line);
+  res.append(std::move(line));
   return res;
 }
 
 CommandResult MakeDoneResult(const char* action,
-                             const std::string& msg_id,
+                             const transport::message_id::Id& msg_id,
                              const std::vector<transport::command::Field>& fields = {}) {
   transport::response::Event event;
   event.type = transport::response::EventType::kDone;
@@ -110,9 +115,9 @@ CommandResult MakeDoneResult(const char* action,
   if (action) {
     event.action = action;
   }
-  event.attributes["status"] = "done";
+  transport::response::SetAttribute(event, "status", "done");
   for (const auto& field : fields) {
-    event.attributes[field.key] = field.value;
+    transport::response::SetAttribute(event, field);
   }
   transport::response::ResponseDispatcher::Instance().Emit(event);
   transport::command::ResponseLine line = transport::response::EventToLine(event);
@@ -123,10 +128,10 @@ CommandResult MakeDoneResult(const char* action,
 
 CommandResult AppendDoneResult(CommandResult res,
                                const char* action,
-                               const std::string& msg_id,
+                               const transport::message_id::Id& msg_id,
                                const std::vector<transport::command::Field>& fields = {}) {
   CommandResult done = MakeDoneResult(action, msg_id, fields);
-  res.mergeFrom(done);
+  res.mergeFrom(std::move(done));
   return res;
 }
 
@@ -207,9 +212,12 @@ bool ParseKeyValueArgs(const std::string& input,
 std::vector<transport::command::Field> BuildMqttConfigFields(const mqtt::BrokerConfig& cfg) {
   std::vector<transport::command::Field> fields;
   fields.push_back({"host", QuoteString(cfg.host)});
-  fields.push_back({"port", std::to_string(static_cast<unsigned long long>(cfg.port))});
+  fields.push_back({"port", static_cast<unsigned long long>(cfg.port)});
   fields.push_back({"user", QuoteString(cfg.user)});
   fields.push_back({"pass", QuoteString(cfg.pass)});
+  fields.push_back({"groups", QuoteString(cfg.groups)});
+  fields.push_back({"status_max_hz", static_cast<unsigned long long>(cfg.status_max_hz)});
+  fields.push_back({"status_topics", cfg.status_topics});
   return fields;
 }
 
@@ -239,33 +247,34 @@ bool MotorCommandHandler::canHandle(const std::string& action) const {
 CommandResult MotorCommandHandler::execute(const ParsedCommand& command,
                                            CommandExecutionContext& context,
                                            uint32_t now_ms) {
-  if (command.action == "WAKE") {
+  switch (command.motion_kind) {
+  case MotionKind::kWake:
     context.controller().tick(now_ms);
-    return handleWake(command.args, context);
-  }
-  if (command.action == "SLEEP") {
+    return handleWake(command, context);
+  case MotionKind::kSleep:
     context.controller().tick(now_ms);
-    return handleSleep(command.args, context);
-  }
-  if (command.action == "MOVE" || command.action == "M") {
-    return handleMove(command.args, context, now_ms);
-  }
-  if (command.action == "HOME" || command.action == "H") {
-    return handleHome(command.args, context, now_ms);
+    return handleSleep(command, context);
+  case MotionKind::kMove:
+    return handleMove(command, context, now_ms);
+  case MotionKind::kHome:
+    return handleHome(command, context, now_ms);
+  case MotionKind::kNone:
+    break;
   }
   auto err_line = transport::command::MakeErrorLine(context.nextMsgId(), "E01", "BAD_CMD", {});
   return MakeResultWithLine(command.action.c_str(), err_line);
 }
 
-CommandResult MotorCommandHandler::handleWake(const std::string& args,
+CommandResult MotorCommandHandler::handleWake(const ParsedCommand& command,
                                               CommandExecutionContext& context) {
   constexpr const char* kAction = "WAKE";
-  std::string msg_id = context.nextMsgId();
-  uint32_t mask;
-  if (!ParseIdMask(Trim(args), mask, context.controller().motorCount())) {
-    auto err_line = transport::command::MakeErrorLine(msg_id, "E02", "BAD_ID", {});
+  transport::message_id::Id msg_id = context.nextMsgId();
+  if (!command.valid()) {
+    auto err_line =
+        transport::command::MakeErrorLine(msg_id, command.error_code, command.error_reason, {});
     return MakeResultWithLine(kAction, err_line);
   }
+  const uint32_t mask = command.motion.mask;
   for (uint8_t id = 0; id < context.controller().motorCount(); ++id) {
     if ((mask & (1u << id)) == 0) {
       continue;
@@ -290,31 +299,33 @@ CommandResult MotorCommandHandler::handleWake(const std::string& args,
   return MakeDoneResult(kAction, msg_id);
 }
 
-CommandResult MotorCommandHandler::handleSleep(const std::string& args,
+CommandResult MotorCommandHandler::handleSleep(const ParsedCommand& command,
                                                CommandExecutionContext& context) {
   constexpr const char* kAction = "SLEEP";
-  std::string msg_id = context.nextMsgId();
-  uint32_t mask;
-  if (!ParseIdMask(Trim(args), mask, context.controller().motorCount())) {
-    auto err_line = transport::command::MakeErrorLine(msg_id, "E02", "BAD_ID", {});
+  transport::message_id::Id msg_id = context.nextMsgId();
+  if (!command.valid()) {
+    auto err_line =
+        transport::command::MakeErrorLine(msg_id, command.error_code, command.error_reason, {});
     return MakeResultWithLine(kAction, err_line);
   }
-  if (!context.controller().sleepMask(mask)) {
+  if (!context.controller().sleepMask(command.motion.mask)) {
     auto err_line = transport::command::MakeErrorLine(msg_id, "E04", "BUSY", {});
     return MakeResultWithLine(kAction, err_line);
   }
   return MakeDoneResult(kAction, msg_id);
 }
 
-CommandResult MotorCommandHandler::handleMove(const std::string& args,
+CommandResult MotorCommandHandler::handleMove(const ParsedCommand& command,
                                               CommandExecutionContext& context,
                                               uint32_t now_ms) {
-  using motor::command::Split;
-  std::string msg_id = context.nextMsgId();
+  transport::message_id::Id msg_id = context.nextMsgId();
   using transport::command::Field;
   auto emitLine = [&](const transport::command::ResponseLine& line) {
-    auto event = transport::response::BuildEvent(line, "MOVE");
-    transport::response::ResponseDispatcher::Instance().Emit(event);
+    // Inside a batch CommandBatchExecutor announces one ACK with the largest est_ms.
+    if (context.inBatch() && line.type == transport::command::ResponseLineType::kAck) {
+      return;
+    }
+    transport::response::ResponseDispatcher::Instance().Emit(line, "MOVE");
   };
   auto emitError = [&](const std::string& code,
                        const std::string& reason,
@@ -332,47 +343,14 @@ CommandResult MotorCommandHandler::handleMove(const std::string& args,
     emitLine(line);
     return CommandResult::SingleLine(line);
   };
-  auto parts = Split(args, ',');
-  if (parts.size() < 2) {
-    return emitError("E03", "BAD_PARAM");
-  }
-  uint32_t mask;
-  if (!ParseIdMask(Trim(parts[0]), mask, context.controller().motorCount())) {
-    return emitError("E02", "BAD_ID");
-  }
-  long target;
-  if (!ParseInt(Trim(parts[1]), target)) {
-    return emitError("E03", "BAD_PARAM");
-  }
-  if (target < kMinPos || target > kMaxPos) {
-    return emitError("E07", "POS_OUT_OF_RANGE");
-  }
-  int speed = context.defaultSpeed();
-  int accel = context.defaultAccel();
-#if (USE_SHARED_STEP)
-  if ((parts.size() >= 3 && !Trim(parts[2]).empty()) ||
-      (parts.size() >= 4 && !Trim(parts[3]).empty())) {
-    return emitError("E03", "BAD_PARAM");
-  }
-#else
-  if (parts.size() >= 3 && !Trim(parts[2]).empty()) {
-    if (!ParseInt(Trim(parts[2]), speed) || speed <= 0) {
-      return emitError("E03", "BAD_PARAM");
-    }
-  }
-  if (parts.size() >= 4 && !Trim(parts[3]).empty()) {
-    if (!ParseInt(Trim(parts[3]), accel) || accel <= 0) {
-      return emitError("E03", "BAD_PARAM");
-    }
-  }
-  if (parts.size() > 4) {
-    for (size_t i = 4; i < parts.size(); ++i) {
-      if (!Trim(parts[i]).empty()) {
-        return emitError("E03", "BAD_PARAM");
-      }
-    }
-  }
-#endif
+  if (!command.valid()) {
+    return emitError(command.error_code, command.error_reason);
+  }
+  const MotionArgs& args = command.motion;
+  const uint32_t mask = args.mask;
+  const long target = args.target;
+  const int speed = args.speed > 0 ? args.speed : context.defaultSpeed();
+  const int accel = args.accel > 0 ? args.accel : context.defaultAccel();
 #if (USE_SHARED_STEP)
   if (!(context.inBatch() && context.batchInitiallyIdle())) {
     for (uint8_t id = 0; id < context.controller().motorCount(); ++id) {
@@ -405,10 +383,9 @@ CommandResult MotorCommandHandler::handleMove(const std::string& args,
         return emitError(
             "E10",
             "THERMAL_REQ_GT_MAX",
-            {{"id", std::to_string(static_cast<int>(id))},
-             {"req_ms", std::to_string(req_ms)},
-             {"max_budget_s",
-              std::to_string(static_cast<int>(MotorControlConstants::MAX_RUNNING_TIME_S))}});
+            {{"id", static_cast<int>(id)},
+             {"req_ms", req_ms},
+             {"max_budget_s", static_cast<int>(MotorControlConstants::MAX_RUNNING_TIME_S)}});
       } else {
         if (!context.controller().moveAbsMask(mask, target, speed, accel, now_ms)) {
           return emitError("E04", "BUSY");
@@ -422,12 +399,10 @@ CommandResult MotorCommandHandler::handleMove(const std::string& args,
                 msg_id,
                 "THERMAL_REQ_GT_MAX",
                 "",
-                {{"id", std::to_string(static_cast<int>(id))},
-                 {"req_ms", std::to_string(req_ms)},
-                 {"max_budget_s",
-                  std::to_string(static_cast<int>(MotorControlConstants::MAX_RUNNING_TIME_S))}}));
-        appendLine(res,
-                   transport::command::MakeAckLine(msg_id, {{"est_ms", std::to_string(req_ms)}}));
+                {{"id", static_cast<int>(id)},
+                 {"req_ms", req_ms},
+                 {"max_budget_s", static_cast<int>(MotorControlConstants::MAX_RUNNING_TIME_S)}}));
+        appendLine(res, transport::command::MakeAckLine(msg_id, {{"est_ms", req_ms}}));
         return res;
       }
     }
@@ -455,10 +430,10 @@ CommandResult MotorCommandHandler::handleMove(const std::string& args,
       if (context.thermalLimitsEnabled()) {
         return emitError("E11",
                          "THERMAL_NO_BUDGET",
-                         {{"id", std::to_string(static_cast<int>(id))},
-                          {"req_ms", std::to_string(max_req_ms)},
-                          {"budget_s", std::to_string(avail_s)},
-                          {"ttfc_s", std::to_string(ttfc_s)}});
+                         {{"id", static_cast<int>(id)},
+                          {"req_ms", max_req_ms},
+                          {"budget_s", avail_s},
+                          {"ttfc_s", ttfc_s}});
       } else {
         if (!context.controller().moveAbsMask(mask, target, speed, accel, now_ms)) {
           return emitError("E04", "BUSY");
@@ -470,12 +445,11 @@ CommandResult MotorCommandHandler::handleMove(const std::string& args,
                    transport::command::MakeWarnLine(msg_id,
                                                     "THERMAL_NO_BUDGET",
                                                     "",
-                                                    {{"id", std::to_string(static_cast<int>(id))},
-                                                     {"req_ms", std::to_string(max_req_ms)},
-                                                     {"budget_s", std::to_string(avail_s)},
-                                                     {"ttfc_s", std::to_string(ttfc_s)}}));
-        appendLine(
-            res, transport::command::MakeAckLine(msg_id, {{"est_ms", std::to_string(max_req_ms)}}));
+                                                    {{"id", static_cast<int>(id)},
+                                                     {"req_ms", max_req_ms},
+                                                     {"budget_s", avail_s},
+                                                     {"ttfc_s", ttfc_s}}));
+        appendLine(res, transport::command::MakeAckLine(msg_id, {{"est_ms", max_req_ms}}));
         return res;
       }
     }
@@ -485,18 +459,20 @@ CommandResult MotorCommandHandler::handleMove(const std::string& args,
   }
   transport::response::CompletionTracker::Instance().RegisterOperation(
       msg_id, "MOVE", mask, context.controller());
-  return emitAck({{"est_ms", std::to_string(max_req_ms)}});
+  return emitAck({{"est_ms", max_req_ms}});
 }
 
-CommandResult MotorCommandHandler::handleHome(const std::string& args,
+CommandResult MotorCommandHandler::handleHome(const ParsedCommand& command,
                                               CommandExecutionContext& context,
                                               uint32_t now_ms) {
-  auto parts = Split(args, ',');
-  std::string msg_id = context.nextMsgId();
+  transport::message_id::Id msg_id = context.nextMsgId();
   using transport::command::Field;
   auto emitLine = [&](const transport::command::ResponseLine& line) {
-    auto event = transport::response::BuildEvent(line, "HOME");
-    transport::response::ResponseDispatcher::Instance().Emit(event);
+    // Inside a batch CommandBatchExecutor announces one ACK with the largest est_ms.
+    if (context.inBatch() && line.type == transport::command::ResponseLineType::kAck) {
+      return;
+    }
+    transport::response::ResponseDispatcher::Instance().Emit(line, "HOME");
   };
   auto emitError = [&](const std::string& code,
                        const std::string& reason,
@@ -515,70 +491,16 @@ CommandResult MotorCommandHandler::handleHome(const std::string& args,
     return CommandResult::SingleLine(line);
   };
 
-  if (parts.empty()) {
-    return emitError("E03", "BAD_PARAM");
-  }
-  uint32_t mask;
-  if (!ParseIdMask(Trim(parts[0]), mask, context.controller().motorCount())) {
-    return emitError("E02", "BAD_ID");
+  if (!command.valid()) {
+    return emitError(command.error_code, command.error_reason);
   }
-
-  auto token = [&](size_t idx) -> std::string {
-    if (idx >= parts.size())
-      return std::string();
-    return Trim(parts[idx]);
-  };
-
-  long overshoot = MotorControlConstants::DEFAULT_OVERSHOOT;
-  long backoff = MotorControlConstants::DEFAULT_BACKOFF;
-  long full_range = 0;
-  int speed = context.defaultSpeed();
-  int accel = context.defaultAccel();
-
-  if (!token(1).empty()) {
-    if (!ParseInt(token(1), overshoot)) {
-      return emitError("E03", "BAD_PARAM");
-    }
-  }
-  if (!token(2).empty()) {
-    if (!ParseInt(token(2), backoff)) {
-      return emitError("E03", "BAD_PARAM");
-    }
-  }
-
-#if (USE_SHARED_STEP)
-  if (!token(3).empty()) {
-    if (!ParseInt(token(3), full_range)) {
-      return emitError("E03", "BAD_PARAM");
-    }
-  }
-  if (!token(4).empty()) {
-    return emitError("E03", "BAD_PARAM");
-  }
-#else
-  if (!token(3).empty()) {
-    if (!ParseInt(token(3), speed) || speed <= 0) {
-      return emitError("E03", "BAD_PARAM");
-    }
-  }
-  if (!token(4).empty()) {
-    if (!ParseInt(token(4), accel) || accel <= 0) {
-      return emitError("E03", "BAD_PARAM");
-    }
-  }
-  if (!token(5).empty()) {
-    if (!ParseInt(token(5), full_range)) {
-      return emitError("E03", "BAD_PARAM");
-    }
-  }
-  if (parts.size() > 6) {
-    for (size_t i = 6; i < parts.size(); ++i) {
-      if (!Trim(parts[i]).empty()) {
-        return emitError("E03", "BAD_PARAM");
-      }
-    }
-  }
-#endif
+  const MotionArgs& args = command.motion;
+  const uint32_t mask = args.mask;
+  const long overshoot = args.overshoot;
+  const long backoff = args.backoff;
+  long full_range = args.full_range;
+  const int speed = args.speed > 0 ? args.speed : context.defaultSpeed();
+  const int accel = args.accel > 0 ? args.accel : context.defaultAccel();
 
   context.controller().tick(now_ms);
   if (full_range <= 0) {
@@ -606,10 +528,9 @@ CommandResult MotorCommandHandler::handleHome(const std::string& args,
       return emitError(
           "E10",
           "THERMAL_REQ_GT_MAX",
-          {{"id", std::to_string(static_cast<int>(first_id))},
-           {"req_ms", std::to_string(req_ms_total)},
-           {"max_budget_s",
-            std::to_string(static_cast<int>(MotorControlConstants::MAX_RUNNING_TIME_S))}});
+          {{"id", static_cast<int>(first_id)},
+           {"req_ms", req_ms_total},
+           {"max_budget_s", static_cast<int>(MotorControlConstants::MAX_RUNNING_TIME_S)}});
     } else {
       if (!context.controller().homeMask(
               mask, overshoot, backoff, speed, accel, full_range, now_ms)) {
@@ -624,12 +545,10 @@ CommandResult MotorCommandHandler::handleHome(const std::string& args,
               msg_id,
               "THERMAL_REQ_GT_MAX",
               "",
-              {{"id", std::to_string(static_cast<int>(first_id))},
-               {"req_ms", std::to_string(req_ms_total)},
-               {"max_budget_s",
-                std::to_string(static_cast<int>(MotorControlConstants::MAX_RUNNING_TIME_S))}}));
-      appendLine(
-          res, transport::command::MakeAckLine(msg_id, {{"est_ms", std::to_string(req_ms_total)}}));
+              {{"id", static_cast<int>(first_id)},
+               {"req_ms", req_ms_total},
+               {"max_budget_s", static_cast<int>(MotorControlConstants::MAX_RUNNING_TIME_S)}}));
+      appendLine(res, transport::command::MakeAckLine(msg_id, {{"est_ms", req_ms_total}}));
       return res;
     }
   }
@@ -656,10 +575,10 @@ CommandResult MotorCommandHandler::handleHome(const std::string& args,
       if (context.thermalLimitsEnabled()) {
         return emitError("E11",
                          "THERMAL_NO_BUDGET",
-                         {{"id", std::to_string(static_cast<int>(id))},
-                          {"req_ms", std::to_string(req_ms_total)},
-                          {"budget_s", std::to_string(avail_s)},
-                          {"ttfc_s", std::to_string(ttfc_s)}});
+                         {{"id", static_cast<int>(id)},
+                          {"req_ms", req_ms_total},
+                          {"budget_s", avail_s},
+                          {"ttfc_s", ttfc_s}});
       } else {
         if (!context.controller().homeMask(
                 mask, overshoot, backoff, speed, accel, full_range, now_ms)) {
@@ -672,13 +591,11 @@ CommandResult MotorCommandHandler::handleHome(const std::string& args,
                    transport::command::MakeWarnLine(msg_id,
                                                     "THERMAL_NO_BUDGET",
                                                     "",
-                                                    {{"id", std::to_string(static_cast<int>(id))},
-                                                     {"req_ms", std::to_string(req_ms_total)},
-                                                     {"budget_s", std::to_string(avail_s)},
-                                                     {"ttfc_s", std::to_string(ttfc_s)}}));
-        appendLine(
-            res,
-            transport::command::MakeAckLine(msg_id, {{"est_ms", std::to_string(req_ms_total)}}));
+                                                    {{"id", static_cast<int>(id)},
+                                                     {"req_ms", req_ms_total},
+                                                     {"budget_s", avail_s},
+                                                     {"ttfc_s", ttfc_s}}));
+        appendLine(res, transport::command::MakeAckLine(msg_id, {{"est_ms", req_ms_total}}));
         return res;
       }
     }
@@ -689,14 +606,14 @@ CommandResult MotorCommandHandler::handleHome(const std::string& args,
   }
   transport::response::CompletionTracker::Instance().RegisterOperation(
       msg_id, "HOME", mask, context.controller());
-  return emitAck({{"est_ms", std::to_string(req_ms_total)}});
+  return emitAck({{"est_ms", req_ms_total}});
 }
 
 // ---------------- QueryCommandHandler ----------------
 
 bool QueryCommandHandler::canHandle(const std::string& action) const {
   return action == "HELP" || action == "STATUS" || action == "ST" || action == "GET" ||
-         action == "SET";
+         action == "SET" || action == "SUB" || action == "UNSUB";
 }
 
 CommandResult QueryCommandHandler::execute(const ParsedCommand& command,
@@ -704,11 +621,11 @@ CommandResult QueryCommandHandler::execute(const ParsedCommand& command,
                                            uint32_t now_ms) {
   (void)now_ms;
   if (command.action == "HELP") {
-    return handleHelp();
+    return handleHelp(context);
   }
   if (command.action == "STATUS" || command.action == "ST") {
     context.controller().tick(now_ms);
-    return handleStatus(context);
+    return handleStatus(command.args, context);
   }
   if (command.action == "GET") {
     context.controller().tick(now_ms);
@@ -718,11 +635,17 @@ CommandResult QueryCommandHandler::execute(const ParsedCommand& command,
     context.controller().tick(now_ms);
     return handleSet(command.args, context);
   }
+  if (command.action == "SUB") {
+    return handleSubscribe(command.args, context);
+  }
+  if (command.action == "UNSUB") {
+    return handleUnsubscribe(command.args, context);
+  }
   auto err_line = transport::command::MakeErrorLine(context.nextMsgId(), "E01", "BAD_CMD", {});
   return MakeResultWithLine(command.action.c_str(), err_line);
 }
 
-CommandResult QueryCommandHandler::handleHelp() const {
+CommandResult QueryCommandHandler::handleHelp(CommandExecutionContext& context) const {
   constexpr const char* kAction = "HELP";
   const std::string& help_text = HelpText();
   CommandResult res;
@@ -737,23 +660,43 @@ CommandResult QueryCommandHandler::handleHelp() const {
 #endif
   }
   // Signal immediate completion so transports publish a single 'done' payload.
-  // Generate a fresh msg_id so downstream transports can correlate HELP results
-  // consistently with other commands.
-  std::string msg_id = transport::message_id::Next();
-  return AppendDoneResult(res, kAction, msg_id);
+  // Generate a fresh msg_id (or reuse the caller's cmd_id) so downstream
+  // transports can correlate HELP results consistently with other commands.
+  transport::message_id::Id msg_id = context.nextMsgId();
+  return AppendDoneResult(std::move(res), kAction, msg_id);
 }
 
-CommandResult QueryCommandHandler::handleStatus(CommandExecutionContext& context) {
+// STATUS lists every motor; STATUS:SINCE=<seq> only those whose change
+// sequence is newer than seq. Both report the current sequence on the ACK.
+CommandResult QueryCommandHandler::handleStatus(const std::string& args,
+                                                CommandExecutionContext& context) {
   constexpr const char* kAction = "STATUS";
-  std::string msg_id = context.nextMsgId();
+  // Fields per motor row; more than a FieldList holds inline, so reserve once.
+  constexpr size_t kStatusFieldCount = 13;
+  transport::message_id::Id msg_id = context.nextMsgId();
+  const MotorController& controller = context.controller();
+  std::string filter = ToUpperCopy(Trim(args));
+  long since = -1;
+  if (!filter.empty()) {
+    constexpr char kSince[] = "SINCE=";
+    if (filter.rfind(kSince, 0) != 0 || !ParseInt(filter.substr(sizeof(kSince) - 1), since) ||
+        since < 0) {
+      auto err_line = transport::command::MakeErrorLine(msg_id, "E03", "BAD_PARAM", {});
+      return MakeResultWithLine(kAction, err_line);
+    }
+  }
   CommandResult res;
+  res.reserve(controller.motorCount() + 1);
 
-  auto ack_line = transport::command::MakeAckLine(msg_id, {});
+  auto ack_line = transport::command::MakeAckLine(msg_id, {{"seq", controller.changeSeq()}});
   EmitResponseEvent(kAction, ack_line);
-  res.append(ack_line);
+  res.append(std::move(ack_line));
 
-  for (size_t i = 0; i < context.controller().motorCount(); ++i) {
-    const MotorState& s = context.controller().state(i);
+  for (size_t i = 0; i < controller.motorCount(); ++i) {
+    if (since >= 0 && controller.motorChangeSeq(i) <= static_cast<unsigned long>(since)) {
+      continue;
+    }
+    const MotorState& s = controller.state(i);
     int32_t missing_t = MotorControlConstants::BUDGET_TENTHS_MAX - s.budget_tenths;
     if (missing_t < 0) {
       missing_t = 0;
@@ -771,24 +714,25 @@ CommandResult QueryCommandHandler::handleStatus(CommandExecutionContext& context
 
     transport::command::ResponseLine data_line;
     data_line.type = transport::command::ResponseLineType::kData;
-    data_line.fields.push_back({"id", std::to_string(static_cast<int>(s.id))});
-    data_line.fields.push_back({"pos", std::to_string(s.position)});
+    data_line.fields.reserve(kStatusFieldCount);
+    data_line.fields.push_back({"id", static_cast<int>(s.id)});
+    data_line.fields.push_back({"pos", s.position});
     data_line.fields.push_back({"moving", BoolToFlag(s.moving)});
     data_line.fields.push_back({"awake", BoolToFlag(s.awake)});
     data_line.fields.push_back({"homed", BoolToFlag(s.homed)});
-    data_line.fields.push_back({"steps_since_home", std::to_string(s.steps_since_home)});
+    data_line.fields.push_back({"steps_since_home", s.steps_since_home});
     data_line.fields.push_back({"budget_s", FormatSignedTenths(s.budget_tenths)});
     data_line.fields.push_back({"ttfc_s", FormatTenths(ttfc_tenths)});
-    data_line.fields.push_back({"speed", std::to_string(s.speed)});
-    data_line.fields.push_back({"accel", std::to_string(s.accel)});
-    data_line.fields.push_back({"est_ms", std::to_string(s.last_op_est_ms)});
-    data_line.fields.push_back({"started_ms", std::to_string(s.last_op_started_ms)});
+    data_line.fields.push_back({"speed", s.speed});
+    data_line.fields.push_back({"accel", s.accel});
+    data_line.fields.push_back({"est_ms", s.last_op_est_ms});
+    data_line.fields.push_back({"started_ms", s.last_op_started_ms});
     if (!s.last_op_ongoing) {
-      data_line.fields.push_back({"actual_ms", std::to_string(s.last_op_last_ms)});
+      data_line.fields.push_back({"actual_ms", s.last_op_last_ms});
     }
 
     EmitResponseEvent(kAction, data_line);
-    res.append(data_line);
+    res.append(std::move(data_line));
   }
   return res;
 }
@@ -796,41 +740,43 @@ CommandResult QueryCommandHandler::handleStatus(CommandExecutionContext& context
 CommandResult QueryCommandHandler::handleGet(const std::string& args,
                                              CommandExecutionContext& context) {
   constexpr const char* kAction = "GET";
-  std::string msg_id = context.nextMsgId();
+  transport::message_id::Id msg_id = context.nextMsgId();
   std::string key = ToUpperCopy(Trim(args));
   if (key.empty() || key == "ALL") {
     long free_heap = GetFreeHeapBytes();
     std::vector<transport::command::Field> fields = {
-        {"SPEED", std::to_string(context.defaultSpeed())},
-        {"ACCEL", std::to_string(context.defaultAccel())},
-        {"DECEL", std::to_string(context.defaultDecel())},
+        {"SPEED", context.defaultSpeed()},
+        {"ACCEL", context.defaultAccel()},
+        {"DECEL", context.defaultDecel()},
         {"THERMAL_LIMITING", context.thermalLimitsEnabled() ? "ON" : "OFF"},
-        {"max_budget_s",
-         std::to_string(static_cast<int>(MotorControlConstants::MAX_RUNNING_TIME_S))},
+        {"max_budget_s", static_cast<int>(MotorControlConstants::MAX_RUNNING_TIME_S)},
+        {"MSG_ID_FORMAT", MsgIdFormatName()},
     };
     if (free_heap >= 0) {
-      fields.push_back({"free_heap_bytes", std::to_string(free_heap)});
+      fields.push_back({"free_heap_bytes", free_heap});
     } else {
       fields.push_back({"free_heap_bytes", "unknown"});
     }
     return MakeDoneResult(kAction, msg_id, fields);
   }
   if (key == "SPEED") {
-    return MakeDoneResult(kAction, msg_id, {{"SPEED", std::to_string(context.defaultSpeed())}});
+    return MakeDoneResult(kAction, msg_id, {{"SPEED", context.defaultSpeed()}});
   }
   if (key == "ACCEL") {
-    return MakeDoneResult(kAction, msg_id, {{"ACCEL", std::to_string(context.defaultAccel())}});
+    return MakeDoneResult(kAction, msg_id, {{"ACCEL", context.defaultAccel()}});
   }
   if (key == "DECEL") {
-    return MakeDoneResult(kAction, msg_id, {{"DECEL", std::to_string(context.defaultDecel())}});
+    return MakeDoneResult(kAction, msg_id, {{"DECEL", context.defaultDecel()}});
   }
   if (key == "THERMAL_LIMITING") {
     return MakeDoneResult(
         kAction,
         msg_id,
         {{"THERMAL_LIMITING", context.thermalLimitsEnabled() ? "ON" : "OFF"},
-         {"max_budget_s",
-          std::to_string(static_cast<int>(MotorControlConstants::MAX_RUNNING_TIME_S))}});
+         {"max_budget_s", static_cast<int>(MotorControlConstants::MAX_RUNNING_TIME_S)}});
+  }
+  if (key == "MSG_ID_FORMAT") {
+    return MakeDoneResult(kAction, msg_id, {{"MSG_ID_FORMAT", MsgIdFormatName()}});
   }
   if (key.rfind("LAST_OP_TIMING", 0) == 0) {
     std::string rest;
@@ -839,7 +785,7 @@ CommandResult QueryCommandHandler::handleGet(const std::string& args,
       rest = Trim(key.substr(p + 1));
     if (rest.empty() || rest == "ALL") {
       CommandResult res;
-      std::string list_cid = context.nextMsgId();
+      transport::message_id::Id list_cid = context.nextMsgId();
       auto ack_line = transport::command::MakeAckLine(list_cid, {});
       EmitResponseEvent(kAction, ack_line);
       res.append(ack_line);
@@ -856,18 +802,18 @@ CommandResult QueryCommandHandler::handleGet(const std::string& args,
         const MotorState& s = context.controller().state(i);
         transport::command::ResponseLine data_line;
         data_line.type = transport::command::ResponseLineType::kData;
-        data_line.fields.push_back({"id", std::to_string(static_cast<int>(i))});
+        data_line.fields.push_back({"id", static_cast<int>(i)});
         data_line.fields.push_back({"ongoing", BoolToFlag(s.last_op_ongoing)});
-        data_line.fields.push_back({"est_ms", std::to_string(s.last_op_est_ms)});
-        data_line.fields.push_back({"started_ms", std::to_string(s.last_op_started_ms)});
+        data_line.fields.push_back({"est_ms", s.last_op_est_ms});
+        data_line.fields.push_back({"started_ms", s.last_op_started_ms});
         if (!s.last_op_ongoing) {
-          data_line.fields.push_back({"actual_ms", std::to_string(s.last_op_last_ms)});
+          data_line.fields.push_back({"actual_ms", s.last_op_last_ms});
         }
         EmitResponseEvent(kAction, data_line);
-        res.append(data_line);
+        res.append(std::move(data_line));
       }
       auto done = MakeDoneResult(kAction, list_cid);
-      res.mergeFrom(done);
+      res.mergeFrom(std::move(done));
       return res;
     }
     uint32_t mask;
@@ -885,13 +831,13 @@ CommandResult QueryCommandHandler::handleGet(const std::string& args,
     }
     const MotorState& s = context.controller().state(id);
     std::vector<transport::command::Field> fields = {
-        {"LAST_OP_TIMING", "1"},
+        {"LAST_OP_TIMING", 1},
         {"ongoing", BoolToFlag(s.last_op_ongoing)},
-        {"id", std::to_string(static_cast<int>(id))},
-        {"est_ms", std::to_string(s.last_op_est_ms)},
-        {"started_ms", std::to_string(s.last_op_started_ms)}};
+        {"id", static_cast<int>(id)},
+        {"est_ms", s.last_op_est_ms},
+        {"started_ms", s.last_op_started_ms}};
     if (!s.last_op_ongoing) {
-      fields.push_back({"actual_ms", std::to_string(s.last_op_last_ms)});
+      fields.push_back({"actual_ms", s.last_op_last_ms});
     }
     return MakeDoneResult(kAction, msg_id, fields);
   }
@@ -902,7 +848,7 @@ CommandResult QueryCommandHandler::handleGet(const std::string& args,
 CommandResult QueryCommandHandler::handleSet(const std::string& args,
                                              CommandExecutionContext& context) {
   constexpr const char* kAction = "SET";
-  std::string msg_id = context.nextMsgId();
+  transport::message_id::Id msg_id = context.nextMsgId();
   std::string payload = Trim(args);
   std::string up = ToUpperCopy(payload);
   size_t eq = up.find('=');
@@ -969,10 +915,61 @@ CommandResult QueryCommandHandler::handleSet(const std::string& args,
     context.controller().setDeceleration(context.defaultDecel());
     return MakeDoneResult(kAction, msg_id);
   }
+  if (key == "MSG_ID_FORMAT") {
+    // Applies to every id rendered from now on, this reply's included.
+    if (val == "HEX") {
+      transport::message_id::SetFormat(transport::message_id::Format::kHex16);
+      return MakeDoneResult(kAction, msg_id);
+    } else if (val == "UUID") {
+      transport::message_id::SetFormat(transport::message_id::Format::kUuid);
+      return MakeDoneResult(kAction, msg_id);
+    }
+    auto err_line = transport::command::MakeErrorLine(msg_id, "E03", "BAD_PARAM", {});
+    return MakeResultWithLine(kAction, err_line);
+  }
   auto err_line = transport::command::MakeErrorLine(msg_id, "E03", "BAD_PARAM", {});
   return MakeResultWithLine(kAction, err_line);
 }
 
+CommandResult QueryCommandHandler::handleSubscribe(const std::string& args,
+                                                   CommandExecutionContext& context) {
+  constexpr const char* kAction = "SUB";
+  transport::message_id::Id msg_id = context.nextMsgId();
+  auto parts = Split(args, ',');
+  long interval = 0;
+  bool changes_only = false;
+  bool ok = parts.size() >= 2 && parts.size() <= 3 && ToUpperCopy(Trim(parts[0])) == "STATUS" &&
+            ParseInt(Trim(parts[1]), interval) &&
+            interval >= static_cast<long>(StatusSubscription::kMinIntervalMs) &&
+            interval <= static_cast<long>(StatusSubscription::kMaxIntervalMs);
+  if (ok && parts.size() == 3) {
+    changes_only = ToUpperCopy(Trim(parts[2])) == "CHANGES_ONLY";
+    ok = changes_only;
+  }
+  if (!ok) {
+    auto err_line = transport::command::MakeErrorLine(msg_id, "E03", "BAD_PARAM", {});
+    return MakeResultWithLine(kAction, err_line);
+  }
+  context.statusSubscription().subscribe(static_cast<uint32_t>(interval), changes_only);
+  return MakeDoneResult(kAction,
+                        msg_id,
+                        {{"interval_ms", interval},
+                         {"changes_only", BoolToFlag(changes_only)}});
+}
+
+CommandResult QueryCommandHandler::handleUnsubscribe(const std::string& args,
+                                                     CommandExecutionContext& context) {
+  constexpr const char* kAction = "UNSUB";
+  transport::message_id::Id msg_id = context.nextMsgId();
+  std::string topic = ToUpperCopy(Trim(args));
+  if (!topic.empty() && topic != "STATUS") {
+    auto err_line = transport::command::MakeErrorLine(msg_id, "E03", "BAD_PARAM", {});
+    return MakeResultWithLine(kAction, err_line);
+  }
+  context.statusSubscription().unsubscribe();
+  return MakeDoneResult(kAction, msg_id);
+}
+
 // ---------------- NetCommandHandler ----------------
 
 bool NetCommandHandler::canHandle(const std::string& action) const {
@@ -998,7 +995,7 @@ CommandResult NetCommandHandler::execute(const ParsedCommand& command,
 
   if (sub == "RESET") {
     auto before = context.net().status().state;
-    std::string msg_id = context.nextMsgId();
+    transport::message_id::Id msg_id = context.nextMsgId();
     if (before == State::CONNECTING) {
       auto err_line = transport::command::MakeErrorLine(
           msg_id, "NET_BUSY_CONNECTING", "", {sub_field("RESET")});
@@ -1021,7 +1018,7 @@ CommandResult NetCommandHandler::execute(const ParsedCommand& command,
       info_line.fields.push_back({"ssid", QuoteString(ssid)});
       info_line.fields.push_back({"ip", ip});
       info_line.raw =
-          "CTRL: NET:AP_ACTIVE msg_id=" + msg_id + " ssid=" + QuoteString(ssid) + " ip=" + ip;
+          "CTRL: NET:AP_ACTIVE msg_id=" + msg_id.str() + " ssid=" + QuoteString(ssid) + " ip=" + ip;
       EmitResponseEvent(kAction, info_line);
       res.append(info_line);
       return AppendDoneResult(
@@ -1037,11 +1034,12 @@ CommandResult NetCommandHandler::execute(const ParsedCommand& command,
 
   if (sub == "STATUS") {
     auto s = context.net().status();
-    std::string msg_id = context.nextMsgId();
+    transport::message_id::Id msg_id = context.nextMsgId();
     std::vector<transport::command::Field> fields = {
         sub_field("STATUS"),
         {"state", NetStateToString(s.state)},
-        {"rssi", (s.state == State::CONNECTED) ? std::to_string(s.rssi_dbm) : "NA"},
+        (s.state == State::CONNECTED) ? transport::command::Field("rssi", s.rssi_dbm)
+                                      : transport::command::Field("rssi", "NA"),
         {"ip", s.ip.data()},
         {"ssid", QuoteString(std::string(s.ssid.data()))}};
     if (s.state == State::AP_ACTIVE) {
@@ -1055,7 +1053,7 @@ CommandResult NetCommandHandler::execute(const ParsedCommand& command,
   }
 
   if (sub == "SET") {
-    std::string msg_id = context.nextMsgId();
+    transport::message_id::Id msg_id = context.nextMsgId();
     if (context.net().status().state == State::CONNECTING) {
       auto err_line =
           transport::command::MakeErrorLine(msg_id, "NET_BUSY_CONNECTING", "", {sub_field("SET")});
@@ -1096,7 +1094,7 @@ CommandResult NetCommandHandler::execute(const ParsedCommand& command,
   }
 
   if (sub == "LIST") {
-    std::string msg_id = context.nextMsgId();
+    transport::message_id::Id msg_id = context.nextMsgId();
     if (context.net().status().state != State::AP_ACTIVE) {
       auto err_line =
           transport::command::MakeErrorLine(msg_id, "NET_SCAN_AP_ONLY", "", {sub_field("LIST")});
@@ -1107,7 +1105,7 @@ CommandResult NetCommandHandler::execute(const ParsedCommand& command,
       EmitResponseEvent(kAction, line);
       res.append(line);
     };
-    append_line(transport::command::MakeAckLine(msg_id, {sub_field("LIST"), {"scanning", "1"}}));
+    append_line(transport::command::MakeAckLine(msg_id, {sub_field("LIST"), {"scanning", 1}}));
     std::vector<net_onboarding::WifiScanResult> nets;
     int n = context.net().scanNetworks(nets, 12, true);
     if (n < 0) {
@@ -1118,8 +1116,8 @@ CommandResult NetCommandHandler::execute(const ParsedCommand& command,
     header.msg_id = msg_id;
     header.code = "NET:LIST";
     header.fields.push_back(sub_field("LIST"));
-    header.fields.push_back({"count", std::to_string(n)});
-    header.raw = "NET:LIST msg_id=" + msg_id;
+    header.fields.push_back({"count", n});
+    header.raw = "NET:LIST msg_id=" + msg_id.str();
     append_line(header);
 
     for (int i = 0; i < n; ++i) {
@@ -1127,20 +1125,19 @@ CommandResult NetCommandHandler::execute(const ParsedCommand& command,
       transport::command::ResponseLine data_line;
       data_line.type = transport::command::ResponseLineType::kData;
       data_line.fields.push_back({"SSID", QuoteString(r.ssid)});
-      data_line.fields.push_back({"rssi", std::to_string(r.rssi)});
-      data_line.fields.push_back({"secure", r.secure ? "1" : "0"});
-      data_line.fields.push_back({"channel", std::to_string(r.channel)});
+      data_line.fields.push_back({"rssi", r.rssi});
+      data_line.fields.push_back({"secure", BoolToFlag(r.secure)});
+      data_line.fields.push_back({"channel", r.channel});
       std::ostringstream raw;
       raw << "SSID=" << QuoteString(r.ssid) << " rssi=" << r.rssi
           << " secure=" << (r.secure ? 1 : 0) << " channel=" << r.channel;
       data_line.raw = raw.str();
       append_line(data_line);
     }
-    return AppendDoneResult(
-        std::move(res), kAction, msg_id, {sub_field("LIST"), {"count", std::to_string(n)}});
+    return AppendDoneResult(std::move(res), kAction, msg_id, {sub_field("LIST"), {"count", n}});
   }
 
-  std::string msg_id = context.nextMsgId();
+  transport::message_id::Id msg_id = context.nextMsgId();
   auto err_line =
       transport::command::MakeErrorLine(msg_id, "E03", "BAD_PARAM", {{"requested", sub}});
   return MakeResultWithLine(kAction, err_line);
@@ -1156,7 +1153,7 @@ CommandResult MqttConfigCommandHandler::execute(const ParsedCommand& command,
                                                 CommandExecutionContext& context,
                                                 uint32_t /*now_ms*/) {
   constexpr const char* kAction = "MQTT";
-  std::string msg_id = context.nextMsgId();
+  transport::message_id::Id msg_id = context.nextMsgId();
   std::string args = Trim(command.args);
   if (args.empty()) {
     auto err_line =
@@ -1189,9 +1186,11 @@ CommandResult MqttConfigCommandHandler::execute(const ParsedCommand& command,
 
     std::string tail_upper = ToUpperCopy(tail);
     if (tail_upper == "RESET" || tail_upper == "DEFAULTS") {
-      update.host_set = update.port_set = update.user_set = update.pass_set = true;
+      update.host_set = update.port_set = update.user_set = update.pass_set =
+          update.groups_set = update.status_max_hz_set = update.status_topics_set = true;
       update.host_use_default = update.port_use_default = update.user_use_default =
-          update.pass_use_default = true;
+          update.pass_use_default = update.groups_use_default =
+              update.status_max_hz_use_default = update.status_topics_use_default = true;
     } else {
       std::vector<std::pair<std::string, std::string>> kv;
       std::string parse_error;
@@ -1237,6 +1236,26 @@ CommandResult MqttConfigCommandHandler::execute(const ParsedCommand& command,
         } else if (key == "PASS" || key == "PASSWORD") {
           update.pass_set = true;
           update.pass = value;
+        } else if (key == "GROUPS") {
+          update.groups_set = true;
+          update.groups = value;
+        } else if (key == "STATUS_MAX_HZ") {
+          update.status_max_hz_set = true;
+          long parsed = 0;
+          if (!ParseInt(value, parsed) || parsed < mqtt::kMinStatusMaxHz ||
+              parsed > mqtt::kMaxStatusMaxHz) {
+            auto err_line = transport::command::MakeErrorLine(
+                msg_id, "MQTT_BAD_PARAM", "INVALID_STATUS_MAX_HZ", {{"detail", value}});
+            return MakeResultWithLine(kAction, err_line);
+          }
+          update.status_max_hz = static_cast<uint16_t>(parsed);
+        } else if (key == "STATUS_TOPICS") {
+          update.status_topics_set = true;
+          if (!mqtt::NormalizeStatusTopics(value, update.status_topics)) {
+            auto err_line = transport::command::MakeErrorLine(
+                msg_id, "MQTT_BAD_PARAM", "INVALID_STATUS_TOPICS", {{"detail", value}});
+            return MakeResultWithLine(kAction, err_line);
+          }
         } else {
           auto err_line = transport::command::MakeErrorLine(
               msg_id, "MQTT_BAD_PARAM", "UNSUPPORTED_FIELD", {{"field", key}});
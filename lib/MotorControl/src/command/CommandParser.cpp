@@ -1,9 +1,155 @@
 #include "MotorControl/command/CommandParser.h"
 
+#include "MotorControl/BuildConfig.h"
+
+#include <cctype>
+#include <utility>
+
 namespace motor {
 namespace command {
 
-std::vector<ParsedCommand> CommandParser::parse(const std::string& line) const {
+namespace {
+
+bool IsCmdIdChar(char c) {
+  return std::isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '_' || c == '.';
+}
+
+MotionKind MotionKindFor(const std::string& action) {
+  if (action == "MOVE" || action == "M") {
+    return MotionKind::kMove;
+  }
+  if (action == "HOME" || action == "H") {
+    return MotionKind::kHome;
+  }
+  if (action == "WAKE") {
+    return MotionKind::kWake;
+  }
+  if (action == "SLEEP") {
+    return MotionKind::kSleep;
+  }
+  return MotionKind::kNone;
+}
+
+void Reject(ParsedCommand& cmd, const char* code, const char* reason) {
+  cmd.error_code = code;
+  cmd.error_reason = reason;
+}
+
+std::string TokenAt(const std::vector<std::string>& parts, size_t idx) {
+  return idx < parts.size() ? Trim(parts[idx]) : std::string();
+}
+
+bool ParsePositive(const std::string& token, int& out) {
+  return ParseInt(token, out) && out > 0;
+}
+
+bool TrailingEmpty(const std::vector<std::string>& parts, size_t from) {
+  for (size_t i = from; i < parts.size(); ++i) {
+    if (!Trim(parts[i]).empty()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void ParseMoveArgs(ParsedCommand& cmd, uint8_t motor_count) {
+  auto parts = Split(cmd.args, ',');
+  MotionArgs& m = cmd.motion;
+  if (parts.size() < 2) {
+    return Reject(cmd, "E03", "BAD_PARAM");
+  }
+  if (!ParseIdMask(Trim(parts[0]), m.mask, motor_count)) {
+    return Reject(cmd, "E02", "BAD_ID");
+  }
+  if (!ParseInt(Trim(parts[1]), m.target)) {
+    return Reject(cmd, "E03", "BAD_PARAM");
+  }
+  if (m.target < MotorControlConstants::MIN_POS_STEPS ||
+      m.target > MotorControlConstants::MAX_POS_STEPS) {
+    return Reject(cmd, "E07", "POS_OUT_OF_RANGE");
+  }
+#if (USE_SHARED_STEP)
+  if (!TokenAt(parts, 2).empty() || !TokenAt(parts, 3).empty()) {
+    return Reject(cmd, "E03", "BAD_PARAM");
+  }
+#else
+  if (!TokenAt(parts, 2).empty() && !ParsePositive(TokenAt(parts, 2), m.speed)) {
+    return Reject(cmd, "E03", "BAD_PARAM");
+  }
+  if (!TokenAt(parts, 3).empty() && !ParsePositive(TokenAt(parts, 3), m.accel)) {
+    return Reject(cmd, "E03", "BAD_PARAM");
+  }
+  if (!TrailingEmpty(parts, 4)) {
+    return Reject(cmd, "E03", "BAD_PARAM");
+  }
+#endif
+}
+
+void ParseHomeArgs(ParsedCommand& cmd, uint8_t motor_count) {
+  auto parts = Split(cmd.args, ',');
+  MotionArgs& m = cmd.motion;
+  if (parts.empty()) {
+    return Reject(cmd, "E03", "BAD_PARAM");
+  }
+  if (!ParseIdMask(Trim(parts[0]), m.mask, motor_count)) {
+    return Reject(cmd, "E02", "BAD_ID");
+  }
+  if (!TokenAt(parts, 1).empty() && !ParseInt(TokenAt(parts, 1), m.overshoot)) {
+    return Reject(cmd, "E03", "BAD_PARAM");
+  }
+  if (!TokenAt(parts, 2).empty() && !ParseInt(TokenAt(parts, 2), m.backoff)) {
+    return Reject(cmd, "E03", "BAD_PARAM");
+  }
+#if (USE_SHARED_STEP)
+  if (!TokenAt(parts, 3).empty() && !ParseInt(TokenAt(parts, 3), m.full_range)) {
+    return Reject(cmd, "E03", "BAD_PARAM");
+  }
+  if (!TokenAt(parts, 4).empty()) {
+    return Reject(cmd, "E03", "BAD_PARAM");
+  }
+#else
+  if (!TokenAt(parts, 3).empty() && !ParsePositive(TokenAt(parts, 3), m.speed)) {
+    return Reject(cmd, "E03", "BAD_PARAM");
+  }
+  if (!TokenAt(parts, 4).empty() && !ParsePositive(TokenAt(parts, 4), m.accel)) {
+    return Reject(cmd, "E03", "BAD_PARAM");
+  }
+  if (!TokenAt(parts, 5).empty() && !ParseInt(TokenAt(parts, 5), m.full_range)) {
+    return Reject(cmd, "E03", "BAD_PARAM");
+  }
+  if (!TrailingEmpty(parts, 6)) {
+    return Reject(cmd, "E03", "BAD_PARAM");
+  }
+#endif
+}
+
+void ParseMotionArgs(ParsedCommand& cmd, uint8_t motor_count) {
+  cmd.motion_kind = MotionKindFor(cmd.action);
+  switch (cmd.motion_kind) {
+  case MotionKind::kMove:
+    ParseMoveArgs(cmd, motor_count);
+    break;
+  case MotionKind::kHome:
+    ParseHomeArgs(cmd, motor_count);
+    break;
+  case MotionKind::kWake:
+  case MotionKind::kSleep:
+    if (!ParseIdMask(Trim(cmd.args), cmd.motion.mask, motor_count)) {
+      Reject(cmd, "E02", "BAD_ID");
+    }
+    break;
+  case MotionKind::kNone:
+    break;
+  }
+  if (!cmd.valid()) {
+    cmd.motion.mask = 0;
+  }
+}
+
+}  // namespace
+
+std::vector<ParsedCommand> CommandParser::parse(const std::string& line,
+                                                uint8_t motor_count) const {
   std::vector<ParsedCommand> out;
   auto trimmed = Trim(line);
   if (trimmed.empty()) {
@@ -31,10 +177,45 @@ std::vector<ParsedCommand> CommandParser::parse(const std::string& line) const {
       parsed.action = ToUpperCopy(cmd);
       parsed.args.clear();
     }
-    out.push_back(parsed);
+    ParseMotionArgs(parsed, motor_count);
+    out.push_back(std::move(parsed));
+  }
+  return out;
+}
+
+ParsedLine CommandParser::parseLine(const std::string& line, uint8_t motor_count) const {
+  ParsedLine out;
+  std::string body;
+  out.cmd_id_valid = splitCmdIdPrefix(line, out.cmd_id, body);
+  if (out.cmd_id_valid) {
+    out.commands = parse(body, motor_count);
   }
   return out;
 }
 
+bool CommandParser::splitCmdIdPrefix(const std::string& line,
+                                     std::string& cmd_id,
+                                     std::string& rest) const {
+  cmd_id.clear();
+  auto trimmed = Trim(line);
+  if (trimmed.empty() || trimmed[0] != '#') {
+    rest = trimmed;
+    return true;
+  }
+  size_t end = 1;
+  while (end < trimmed.size() && !std::isspace(static_cast<unsigned char>(trimmed[end]))) {
+    if (!IsCmdIdChar(trimmed[end])) {
+      return false;
+    }
+    ++end;
+  }
+  if (end == 1 || end - 1 > kMaxCmdIdLength) {
+    return false;
+  }
+  cmd_id = trimmed.substr(1, end - 1);
+  rest = Trim(trimmed.substr(end));
+  return true;
+}
+
 }  // namespace command
 }  // namespace motor
@@ -27,10 +27,9 @@ CommandResult CommandRouter::dispatch(const ParsedCommand& command,
       return handler->execute(command, context, now_ms);
     }
   }
-  std::string msg_id = context.nextMsgId();
+  transport::message_id::Id msg_id = context.nextMsgId();
   auto line = transport::command::MakeErrorLine(msg_id, "E01", "BAD_CMD", {});
-  transport::response::ResponseDispatcher::Instance().Emit(
-      transport::response::BuildEvent(line, command.action));
+  transport::response::ResponseDispatcher::Instance().Emit(line, command.action);
   CommandResult res;
   res.is_error = true;
   res.append(line);
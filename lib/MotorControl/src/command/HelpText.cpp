@@ -19,12 +19,18 @@ const std::string& HelpText() {
     os << "NET:LIST (scan nearby SSIDs; AP mode only)\n";
     os << "MQTT:GET_CONFIG\n";
     os << "MQTT:SET_CONFIG host=<host> port=<port> user=<user> pass=\\\"<pass>\\\"\n";
+    os << "MQTT:SET_CONFIG groups=\\\"<group>[,<group>...]\\\"\n";
+    os << "MQTT:SET_CONFIG status_max_hz=<1-50>\n";
+    os << "MQTT:SET_CONFIG status_topics=<aggregate|motors|both>\n";
     os << "MQTT:SET_CONFIG RESET\n";
 #if !(USE_SHARED_STEP)
     os << "MOVE:<id|ALL>,<abs_steps>[,<speed>][,<accel>]\n";
     os << "HOME:<id|ALL>[,<overshoot>][,<backoff>][,<speed>][,<accel>][,<full_range>]\n";
 #endif
     os << "STATUS\n";
+    os << "STATUS:SINCE=<seq> (only motors changed after seq; ACK carries the current seq)\n";
+    os << "SUB STATUS,<interval_ms>[,CHANGES_ONLY] (push ST frames on serial)\n";
+    os << "UNSUB [STATUS]\n";
     os << "GET\n";
     os << "GET ALL\n";
     os << "GET LAST_OP_TIMING[:<id|ALL>]\n";
@@ -32,13 +38,16 @@ const std::string& HelpText() {
     os << "GET ACCEL\n";
     os << "GET DECEL\n";
     os << "GET THERMAL_LIMITING\n";
+    os << "GET MSG_ID_FORMAT\n";
     os << "SET THERMAL_LIMITING=OFF|ON\n";
     os << "SET SPEED=<steps_per_second>\n";
     os << "SET ACCEL=<steps_per_second^2>\n";
     os << "SET DECEL=<steps_per_second^2>\n";
+    os << "SET MSG_ID_FORMAT=HEX|UUID (text form of generated ids)\n";
     os << "WAKE:<id|ALL>\n";
     os << "SLEEP:<id|ALL>\n";
     os << "Shortcuts: M=MOVE, H=HOME, ST=STATUS\n";
+    os << "Correlation: #<cmd_id> <cmd> (responses echo <cmd_id> as msg_id/cmd_id)\n";
     os << "Multicommand: <cmd1>;<cmd2> note: no cmd queuing; only distinct motors allowed";
     return os.str();
   }();
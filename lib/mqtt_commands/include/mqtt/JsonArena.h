@@ -0,0 +1,101 @@
+#pragma once
+
+#include <ArduinoJson.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace mqtt {
+
+// Bump allocator over one buffer reserved up front, handed to a JsonDocument
+// so parsing a command never touches the heap. Freeing only rolls back the
+// most recent block; everything else is reclaimed by reset() once the document
+// has been cleared. When the buffer is exhausted allocate() returns nullptr and
+// deserializeJson() reports NoMemory.
+class JsonArena : public ArduinoJson::Allocator {
+public:
+  explicit JsonArena(size_t capacity) : buffer_(capacity) {}
+
+  JsonArena(const JsonArena&) = delete;
+  JsonArena& operator=(const JsonArena&) = delete;
+
+  void* allocate(size_t size) override {
+    const size_t header = headerSize();
+    const size_t needed = header + roundUp(size);
+    if (needed < size || buffer_.size() - top_ < needed) {
+      return nullptr;
+    }
+    uint8_t* block = buffer_.data() + top_;
+    std::memcpy(block, &size, sizeof(size));
+    last_ = top_;
+    top_ += needed;
+    used_high_water_ = top_ > used_high_water_ ? top_ : used_high_water_;
+    return block + header;
+  }
+
+  void deallocate(void* ptr) override {
+    if (ptr != nullptr && isLast(ptr)) {
+      top_ = last_;
+    }
+  }
+
+  void* reallocate(void* ptr, size_t new_size) override {
+    if (ptr == nullptr) {
+      return allocate(new_size);
+    }
+    const size_t header = headerSize();
+    if (isLast(ptr)) {
+      const size_t needed = header + roundUp(new_size);
+      if (buffer_.size() - last_ < needed) {
+        return nullptr;
+      }
+      std::memcpy(buffer_.data() + last_, &new_size, sizeof(new_size));
+      top_ = last_ + needed;
+      used_high_water_ = top_ > used_high_water_ ? top_ : used_high_water_;
+      return ptr;
+    }
+    size_t old_size = 0;
+    std::memcpy(&old_size, static_cast<uint8_t*>(ptr) - header, sizeof(old_size));
+    void* moved = allocate(new_size);
+    if (moved != nullptr) {
+      std::memcpy(moved, ptr, old_size < new_size ? old_size : new_size);
+    }
+    return moved;
+  }
+
+  // Only valid once no document still holds memory from the arena.
+  void reset() {
+    top_ = 0;
+    last_ = 0;
+  }
+
+  size_t capacity() const {
+    return buffer_.size();
+  }
+  size_t used() const {
+    return top_;
+  }
+  size_t highWater() const {
+    return used_high_water_;
+  }
+
+private:
+  static size_t roundUp(size_t size) {
+    const size_t align = alignof(std::max_align_t);
+    return (size + align - 1) & ~(align - 1);
+  }
+  static size_t headerSize() {
+    return roundUp(sizeof(size_t));
+  }
+  bool isLast(const void* ptr) const {
+    return top_ != 0 && static_cast<const uint8_t*>(ptr) == buffer_.data() + last_ + headerSize();
+  }
+
+  std::vector<uint8_t> buffer_;
+  size_t top_ = 0;
+  size_t last_ = 0;
+  size_t used_high_water_ = 0;
+};
+
+}  // namespace mqtt
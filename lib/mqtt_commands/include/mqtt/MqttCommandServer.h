@@ -1,12 +1,20 @@
 #pragma once
 
 #include "MotorControl/MotorCommandProcessor.h"
+#include "mqtt/JsonArena.h"
 #include "mqtt/MqttPresenceClient.h"
+#include "mqtt/ResponseCache.h"
 #include "transport/CommandSchema.h"
+#include "transport/MessageId.h"
+#include "transport/PayloadEncoding.h"
 #include "transport/ResponseDispatcher.h"
 #include "transport/ResponseModel.h"
+#include "transport/SpscRing.h"
 
 #include <ArduinoJson.h>
+#include <array>
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
 #include <deque>
 #include <functional>
@@ -24,12 +32,59 @@ public:
   using SubscribeFn = std::function<bool(const std::string&, uint8_t, SubscribeCallback)>;
   using LogFn = std::function<void(const std::string&)>;
   using ClockFn = std::function<uint32_t()>;
+  using ExecuteFn =
+      std::function<motor::command::CommandResult(const std::string& line, uint32_t now_ms)>;
 
   struct Config {
-    Config(size_t cache = 12, uint32_t interval = 1000)
-        : duplicate_cache(cache), duplicate_log_interval_ms(interval) {}
+    Config(size_t cache = 32, uint32_t interval = 1000, size_t inbound_depth = 8)
+        : duplicate_cache(cache), duplicate_log_interval_ms(interval),
+          inbound_queue_depth(inbound_depth) {}
+    // Completed commands whose responses are replayed for a redelivered cmd_id.
     size_t duplicate_cache;
+    // Arena holding those responses; least recently used ones go first when full.
+    size_t duplicate_cache_bytes = 8192;
     uint32_t duplicate_log_interval_ms;
+    // Commands buffered between the MQTT client task and loop(); more are rejected as busy.
+    size_t inbound_queue_depth;
+    // Larger command payloads are rejected unparsed with MQTT_PAYLOAD_TOO_LARGE.
+    size_t max_payload_bytes = 1024;
+    // Limit for groups/<name>/cmd, where one payload carries every node's slice.
+    // Only this node's slice (and the top-level fields) is kept while parsing,
+    // so the parse arena still only has to fit one node's share.
+    size_t max_group_payload_bytes = 8192;
+    // Fixed pool each inbound command is parsed into; sized for a max_payload_bytes
+    // command on a 64-bit host, which leaves headroom on the ESP32.
+    size_t parse_arena_bytes = 6144;
+    // Answer commands whose completion is known at dispatch time with a single
+    // "done" message carrying the ACK fields. A request's "coalesce" field overrides it.
+    bool coalesce_responses = false;
+    // FastFrameStats go out on cmd/fast/stats at most this often, and only after
+    // they changed. 0 disables the publish.
+    uint32_t fast_stats_interval_ms = 1000;
+  };
+
+  struct InboundQueueStats {
+    size_t depth = 0;
+    size_t capacity = 0;
+    size_t high_water = 0;
+    uint32_t accepted = 0;
+    uint32_t rejected = 0;
+    uint32_t oversized = 0;
+    // Rejected commands whose error could not be queued either, so the sender
+    // got no answer.
+    uint32_t unanswered = 0;
+  };
+
+  // Counters for the QoS0 cmd/fast topic, cumulative since boot.
+  struct FastFrameStats {
+    uint32_t received = 0;
+    // Sequence numbers skipped over, i.e. frames lost before they were executed.
+    uint32_t dropped = 0;
+    // Frames not newer than the last executed one, discarded unexecuted.
+    uint32_t late = 0;
+    // Frames rejected by validation or execution; each is answered with an error.
+    uint32_t errors = 0;
+    uint32_t last_seq = 0;
   };
 
   MqttCommandServer(MotorCommandProcessor& processor,
@@ -41,14 +96,52 @@ public:
   ~MqttCommandServer();
 
   bool begin(const std::string& device_topic);
+  // Drains queued inbound commands; completions go out as CompletionTracker emits
+  // their DONE. Call from the main loop only.
   void loop(uint32_t now_ms);
+  InboundQueueStats inboundQueueStats() const;
+  FastFrameStats fastFrameStats() const {
+    return fast_stats_;
+  }
+  // Routes command execution and motor state reads away from the processor,
+  // e.g. to a MotionTask that owns the controller on another core.
+  void setExecutor(ExecuteFn execute, const MotorController* state_view);
 
 private:
+  struct InboundMessage {
+    std::string topic;
+    std::string payload;
+  };
+  struct RejectedCommand {
+    std::string cmd_id;
+    std::string action;
+    // Non-zero when the payload exceeded its topic's limit rather than the queue being full.
+    size_t oversized_bytes = 0;
+    size_t oversized_limit = 0;
+    transport::PayloadEncoding encoding = transport::PayloadEncoding::kJson;
+  };
+
+  bool isCommandTopic(const std::string& topic) const;
+  bool isGroupTopic(const std::string& topic) const;
+  bool isFastTopic(const std::string& topic) const;
+  void handleFastFrame(const std::string& topic, const std::string& payload);
+  void rejectFastFrame(const std::string& cmd_id,
+                       const std::string& action,
+                       const transport::command::ResponseLine& error_line,
+                       uint32_t now_ms);
+  void publishFastStats(uint32_t now_ms);
+  void markFastMessage(const transport::message_id::Id& msg_id);
+  bool isFastMessage(const transport::message_id::Id& msg_id) const;
+  void refreshGroupSubscriptions();
+  void enqueueIncoming(const std::string& topic, const std::string& payload);
+  void drainInbound();
   void handleIncoming(const std::string& topic, const std::string& payload);
+  const MotorController& controllerView() const;
   bool isDuplicate(const std::string& cmd_id) const;
   void recordCompleted(const std::string& cmd_id,
                        const std::string& ack_payload,
                        const std::string& completion_payload);
+  const std::string& responseTopicFor(const std::string& payload) const;
   bool publishAck(const std::string& payload);
   bool publishCompletion(const std::string& payload);
   bool buildCommandLine(const std::string& action,
@@ -57,6 +150,10 @@ private:
                         std::vector<uint8_t>& targets,
                         std::string& error,
                         bool& unsupported) const;
+  bool buildBatchCommand(ArduinoJson::JsonVariantConst batch,
+                         std::string& out,
+                         std::vector<uint8_t>& targets,
+                         std::string& error) const;
   bool buildMoveCommand(ArduinoJson::JsonVariantConst params,
                         std::string& out,
                         std::vector<uint8_t>& targets,
@@ -100,8 +197,14 @@ private:
                          long& value,
                          std::string& error) const;
   bool parsePayload(const std::string& payload,
+                    transport::PayloadEncoding encoding,
+                    JsonArena& arena,
                     ArduinoJson::JsonDocument& doc,
-                    std::string& error) const;
+                    std::string& error,
+                    bool& out_of_memory,
+                    const ArduinoJson::JsonDocument* filter = nullptr) const;
+  size_t payloadLimit(bool group_command) const;
+  std::string payloadTooLargeMessage(size_t payload_bytes, size_t limit) const;
   std::string buildAckPayload(const std::string& cmd_id,
                               const std::string& action,
                               const transport::command::Response& response,
@@ -117,8 +220,10 @@ private:
                          uint32_t mask,
                          uint32_t started_ms,
                          bool include_motor_snapshot,
-                         int32_t actual_ms = -1);
-  void finalizeCompleted(uint32_t now_ms);
+                         int32_t actual_ms = -1,
+                         const transport::command::ResponseLine* coalesced_ack = nullptr);
+  // Publishes the completion of the pending command the DONE belongs to.
+  bool completePending(const transport::response::Event& done);
   uint32_t maskForTargets(const std::vector<uint8_t>& targets) const;
   std::string statusToString(transport::command::CompletionStatus status) const;
   void logDuplicate(const std::string& cmd_id, uint32_t now_ms);
@@ -126,7 +231,8 @@ private:
   collectErrors(const transport::command::Response& response) const;
   std::vector<transport::command::ResponseLine>
   collectDataLines(const transport::command::Response& response) const;
-  void handleDispatcherEvent(const transport::response::Event& event);
+  void handleDispatcherEvent(const transport::response::Event& event,
+                             const transport::command::ResponseLine* line);
   void ensureStream(const std::string& cmd_id,
                     const std::string& action,
                     uint32_t mask,
@@ -142,6 +248,8 @@ private:
     std::string command_line;
     std::vector<uint8_t> targets;
     uint32_t mask = 0;
+    bool coalesce = false;
+    transport::PayloadEncoding encoding = transport::PayloadEncoding::kJson;
   };
   bool handleDuplicateCommand(const std::string& cmd_id, uint32_t now_ms);
   void respondWithError(const std::string& cmd_id,
@@ -154,7 +262,11 @@ private:
                        const transport::response::CommandResponse& contract,
                        const std::shared_ptr<DispatchStream>& stream_ref,
                        uint32_t now_ms);
-  std::shared_ptr<DispatchStream> findStream(const std::string& cmd_id);
+  std::shared_ptr<DispatchStream> findStream(const std::string& cmd_id) const;
+  // The stream a dispatcher event belongs to: by its bound message id, or by
+  // the host's cmd_id before one is bound.
+  std::shared_ptr<DispatchStream> findStreamFor(const transport::message_id::Id& msg_id) const;
+  void eraseStream(const std::string& cmd_id);
   bool streamConsumesResponse(DispatchStream* stream_ptr,
                               const CommandDispatch& dispatch,
                               const transport::command::Response& response,
@@ -164,29 +276,27 @@ private:
                                const std::string& action,
                                std::string command_line,
                                std::vector<uint8_t> targets,
-                               uint32_t mask) const;
-
-  struct CachedResponse {
-    std::string cmd_id;
-    std::string ack_payload;
-    std::string completion_payload;
-  };
+                               uint32_t mask,
+                               bool coalesce) const;
+  void finishCoalescing(DispatchStream& stream);
 
   struct PendingCompletion {
-    std::string cmd_id;
+    transport::message_id::CmdId cmd_id;
     std::string action;
     std::string command_line;
     transport::command::Response response;
     std::string ack_payload;
     uint32_t mask = 0;
     uint32_t started_ms = 0;
-    bool awaiting_motor_finish = false;
+    // Id of the CompletionTracker DONE that completes the command.
+    transport::message_id::Id msg_id;
     std::vector<uint8_t> targets;
+    transport::PayloadEncoding encoding = transport::PayloadEncoding::kJson;
   };
 
   struct DispatchStream {
     std::string cmd_id;
-    std::string msg_id;
+    transport::message_id::Id msg_id;
     std::string action;
     transport::command::Response response;
     uint32_t mask = 0;
@@ -194,6 +304,11 @@ private:
     bool saw_event = false;
     bool ack_published = false;
     bool done_published = false;
+    // While set, the ACK is held back in case the DONE arrives before dispatch
+    // returns; ack_deferred records that one was held.
+    bool coalesce = false;
+    bool ack_deferred = false;
+    transport::PayloadEncoding encoding = transport::PayloadEncoding::kJson;
     std::string ack_payload;
   };
 
@@ -203,21 +318,79 @@ private:
   LogFn log_;
   ClockFn clock_;
   Config config_;
+  ExecuteFn execute_;
+  const MotorController* state_view_ = nullptr;
 
   std::string command_topic_;
   std::string response_topic_;
+  // The same topics with kMsgPackTopicSuffix; commands arriving on the former
+  // are answered in MessagePack on the latter.
+  std::string msgpack_command_topic_;
+  std::string msgpack_response_topic_;
+  // Sequenced QoS0 frames that are executed without ACK or DONE.
+  std::string fast_topic_;
+  std::string msgpack_fast_topic_;
+  std::string fast_stats_topic_;
+  FastFrameStats fast_stats_;
+  bool fast_seq_valid_ = false;
+  bool fast_stats_dirty_ = false;
+  uint32_t last_fast_stats_ms_ = 0;
+  transport::PayloadEncoding fast_encoding_ = transport::PayloadEncoding::kJson;
+  // Hashed message ids of the latest fast frames. Nothing answers them, so
+  // their ACK/DONE events are skipped instead of being parked as orphans.
+  std::array<uint64_t, 16> fast_msg_ids_{};
+  size_t fast_msg_cursor_ = 0;
+  // Last segment of the device topic; group payloads address this node by it.
+  std::string node_id_;
+  // groups/<name>/cmd topics (both encodings) of the groups in ConfigStore,
+  // rebuilt when its revision changes. Topics of removed groups stay
+  // subscribed, since the client cannot unsubscribe, but are ignored.
+  std::vector<std::string> group_topics_;
+  std::vector<std::string> subscribed_group_topics_;
+  uint32_t groups_revision_ = 0;
   bool subscribed_ = false;
   uint32_t last_duplicate_log_ms_ = 0;
 
-  std::deque<CachedResponse> recent_;
+  // Filled from the MQTT client callback, drained by loop().
+  transport::SpscRing<InboundMessage> inbound_;
+  transport::SpscRing<RejectedCommand> rejected_;
+  std::atomic<size_t> inbound_high_water_{0};
+  std::atomic<uint32_t> inbound_accepted_{0};
+  std::atomic<uint32_t> inbound_rejected_{0};
+  std::atomic<uint32_t> inbound_oversized_{0};
+  std::atomic<uint32_t> inbound_unanswered_{0};
+  uint32_t inbound_rejected_logged_ = 0;
+  uint32_t inbound_unanswered_logged_ = 0;
+  // Inbound payloads are swapped out of the ring into this message, so the
+  // string buffers circulate instead of being reallocated per command.
+  InboundMessage current_inbound_;
+  // loop() parses every command into parse_doc_, backed by a fixed arena.
+  JsonArena parse_arena_;
+  ArduinoJson::JsonDocument parse_doc_;
+  // Keeps the top-level fields and nodes.<node_id> of group commands.
+  ArduinoJson::JsonDocument group_filter_;
+
+  // Reused for every outgoing payload so building one does not grow the heap.
+  mutable std::string json_buffer_;
+  // Encoding of the payloads being built, taken from the command they answer.
+  // Replayed payloads carry their encoding in their first byte.
+  transport::PayloadEncoding response_encoding_ = transport::PayloadEncoding::kJson;
+
+  ResponseCache recent_;
   std::vector<PendingCompletion> pending_;
   transport::response::ResponseDispatcher::SinkToken dispatcher_token_ = 0;
-  std::unordered_map<std::string, std::shared_ptr<DispatchStream>> streams_;
-  std::unordered_map<std::string, std::vector<transport::response::Event>> orphan_events_;
-  std::deque<std::string> orphan_order_;
+  // Keyed by the hash of the host's cmd_id, like ResponseCache; lookups also
+  // compare the text. stream_by_msg_ maps a bound message id's key to its
+  // stream's key, so dispatcher events find their stream without a scan.
+  std::unordered_map<uint64_t, std::shared_ptr<DispatchStream>> streams_;
+  std::unordered_map<uint64_t, uint64_t> stream_by_msg_;
+  std::unordered_map<uint64_t, std::vector<transport::response::Event>> orphan_events_;
+  std::deque<uint64_t> orphan_order_;
 
-  void bindStreamToMessageId(DispatchStream& stream, const std::string& msg_id);
-  void processStreamEvent(DispatchStream& stream, const transport::response::Event& event);
+  void bindStreamToMessageId(DispatchStream& stream, const transport::message_id::Id& msg_id);
+  void processStreamEvent(DispatchStream& stream,
+                          const transport::response::Event& event,
+                          const transport::command::ResponseLine* line);
 };
 
 }  // namespace mqtt
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace mqtt {
+
+// Responses of completed commands, kept so a redelivered cmd_id can be
+// answered without executing it again. Lookups probe an open-addressing table
+// keyed by the 64-bit cmd_id hash; the id text is compared only on a hash hit.
+// Records (id, ack payload, completion payload) are appended to a fixed ring
+// arena and evicted oldest first. A hit re-appends its record, so the ring
+// order is least recently used first.
+class ResponseCache {
+public:
+  struct View {
+    const char* ack = nullptr;
+    size_t ack_len = 0;
+    const char* completion = nullptr;
+    size_t completion_len = 0;
+  };
+
+  ResponseCache(size_t max_entries, size_t arena_bytes);
+
+  ResponseCache(const ResponseCache&) = delete;
+  ResponseCache& operator=(const ResponseCache&) = delete;
+
+  // Stores or replaces the responses for cmd_id, evicting least recently used
+  // records until they fit. Returns false when caching is disabled or the
+  // record is larger than the whole arena.
+  bool put(uint64_t hash,
+           const std::string& cmd_id,
+           const std::string& ack,
+           const std::string& completion);
+  // A hit becomes the most recently used entry. The view points into the arena
+  // and stays valid until the next put() or find().
+  bool find(uint64_t hash, const std::string& cmd_id, View& out);
+  bool contains(uint64_t hash, const std::string& cmd_id) const;
+
+  size_t size() const {
+    return count_;
+  }
+  size_t maxEntries() const {
+    return max_entries_;
+  }
+  size_t bytesUsed() const {
+    return used_;
+  }
+  void clear();
+
+private:
+  struct Slot {
+    uint64_t hash = 0;
+    uint32_t offset = 0;
+    bool used = false;
+  };
+  struct Header {
+    uint64_t hash;
+    uint32_t total;  // bytes including this header; 0 marks wrap padding
+    uint32_t id_len;
+    uint32_t ack_len;
+    uint32_t completion_len;
+  };
+
+  size_t findSlot(uint64_t hash, const std::string& cmd_id) const;
+  size_t slotForOffset(uint64_t hash, uint32_t offset) const;
+  void eraseSlot(size_t index);
+  void insertSlot(uint64_t hash, uint32_t offset);
+  Header headerAt(uint32_t offset) const;
+  bool reserve(size_t bytes, uint32_t& offset);
+  bool evictOldest();
+  uint32_t append(uint64_t hash,
+                  const char* id,
+                  size_t id_len,
+                  const char* ack,
+                  size_t ack_len,
+                  const char* completion,
+                  size_t completion_len);
+  View viewAt(uint32_t offset) const;
+
+  size_t max_entries_;
+  size_t count_ = 0;
+  std::vector<Slot> slots_;  // power-of-two size, at most half full
+  std::vector<char> arena_;
+  size_t head_ = 0;  // next write position
+  size_t tail_ = 0;  // oldest record
+  size_t used_ = 0;  // bytes between tail_ and head_, padding included
+  std::string scratch_;  // holds a record while a hit re-appends it
+};
+
+}  // namespace mqtt
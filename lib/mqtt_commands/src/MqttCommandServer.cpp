@@ -1,8 +1,10 @@
 #include "mqtt/MqttCommandServer.h"
 
+#include "MotorControl/command/CommandParser.h"
 #include "MotorControl/command/CommandUtils.h"
 #include "MotorControl/command/HelpText.h"
-#include "transport/CompletionTracker.h"
+#include "mqtt/MqttConfigStore.h"
+#include "transport/JsonWriter.h"
 #include "transport/MessageId.h"
 #include "transport/ResponseDispatcher.h"
 #include "transport/ResponseModel.h"
@@ -21,6 +23,12 @@ namespace mqtt {
 
 namespace {
 
+constexpr const char* kBatchAction = "BATCH";
+constexpr const char* kGroupTopicPrefix = "groups/";
+constexpr const char* kGroupCommandSuffix = "/cmd";
+constexpr const char* kFastCommandPrefix = "fast-";
+constexpr size_t kMaxActionLength = 32;
+
 std::string ToUpper(std::string value) {
   std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) {
     return static_cast<char>(std::toupper(c));
@@ -28,6 +36,19 @@ std::string ToUpper(std::string value) {
   return value;
 }
 
+// Shape check only, so it is safe on the MQTT client task; loop() decides
+// whether the group is still configured.
+bool IsGroupCommandTopic(const std::string& topic) {
+  size_t end = topic.size();
+  if (transport::TopicEncoding(topic) == transport::PayloadEncoding::kMsgPack) {
+    end -= std::strlen(transport::kMsgPackTopicSuffix);
+  }
+  const size_t prefix_len = std::strlen(kGroupTopicPrefix);
+  const size_t suffix_len = std::strlen(kGroupCommandSuffix);
+  return end > prefix_len + suffix_len && topic.compare(0, prefix_len, kGroupTopicPrefix) == 0 &&
+         topic.compare(end - suffix_len, suffix_len, kGroupCommandSuffix) == 0;
+}
+
 bool IsInteger(const std::string& value) {
   if (value.empty()) {
     return false;
@@ -115,41 +136,206 @@ std::string QuoteIfNeeded(const std::string& value) {
   return out;
 }
 
-void AppendFields(ArduinoJson::JsonObject obj,
-                  const std::vector<transport::command::Field>& fields) {
-  for (const auto& field : fields) {
-    if (field.key == "detail") {
-      std::string value = Unquote(field.value);
-      if (value.empty()) {
+
+// Copies the first string value stored under key without parsing the payload,
+// so the MQTT client task can name the command it turns away. Gives up on
+// escaped JSON strings and on values longer than max_len.
+bool ScanStringField(const std::string& payload,
+                     transport::PayloadEncoding encoding,
+                     const char* key,
+                     size_t max_len,
+                     std::string& out) {
+  const size_t key_len = std::strlen(key);
+  std::string needle;
+  if (encoding == transport::PayloadEncoding::kMsgPack) {
+    if (key_len > 31) {
+      return false;
+    }
+    needle.push_back(static_cast<char>(0xA0 | key_len));  // fixstr key
+    needle.append(key);
+  } else {
+    needle.push_back('"');
+    needle.append(key).push_back('"');
+  }
+  const size_t found = payload.find(needle);
+  if (found == std::string::npos) {
+    return false;
+  }
+  size_t pos = found + needle.size();
+  size_t len = 0;
+  if (encoding == transport::PayloadEncoding::kMsgPack) {
+    if (pos >= payload.size()) {
+      return false;
+    }
+    const auto marker = static_cast<uint8_t>(payload[pos++]);
+    if ((marker & 0xE0) == 0xA0) {
+      len = marker & 0x1F;
+    } else if (marker == 0xD9 && pos < payload.size()) {
+      len = static_cast<uint8_t>(payload[pos++]);
+    } else {
+      return false;
+    }
+  } else {
+    while (pos < payload.size() && (std::isspace(static_cast<unsigned char>(payload[pos])) ||
+                                     payload[pos] == ':')) {
+      ++pos;
+    }
+    if (pos >= payload.size() || payload[pos++] != '"') {
+      return false;
+    }
+    const size_t close = payload.find('"', pos);
+    if (close == std::string::npos ||
+        std::memchr(payload.data() + pos, '\\', close - pos) != nullptr) {
+      return false;
+    }
+    len = close - pos;
+  }
+  if (len == 0 || len > max_len || pos + len > payload.size()) {
+    return false;
+  }
+  out.assign(payload, pos, len);
+  return true;
+}
+
+// "<verb>:<token><args>", or one such command per motor when the selector was
+// a list (token empty), joined into a multicommand.
+std::string ForEachTarget(const char* verb,
+                          const std::vector<uint8_t>& targets,
+                          const std::string& token,
+                          const std::string& args) {
+  if (!token.empty()) {
+    return std::string(verb) + ":" + token + args;
+  }
+  std::string out;
+  for (uint8_t id : targets) {
+    if (!out.empty()) {
+      out.push_back(';');
+    }
+    out.append(verb).append(":").append(std::to_string(id)).append(args);
+  }
+  return out;
+}
+
+// Integer fields are written as numbers; text fields carry what serial prints,
+// strings possibly quoted.
+void WriteFieldValue(transport::JsonWriter& json, const transport::command::Field& field) {
+  if (field.kind == transport::command::FieldKind::kInteger) {
+    json.field(field.key, field.number);
+    return;
+  }
+  const std::string& raw = field.value;
+  const bool quoted = raw.size() >= 2 && raw.front() == '"' && raw.back() == '"';
+  if (quoted && raw.find('\\') != std::string::npos) {
+    json.field(field.key, Unquote(raw));
+    return;
+  }
+  json.field(field.key, raw.data() + (quoted ? 1 : 0), raw.size() - (quoted ? 2 : 0));
+}
+
+// "detail" fields fold into a single "message" ("; "-joined), written after the
+// catalog description when there is one, otherwise where the first detail was.
+void WriteLineFields(transport::JsonWriter& json,
+                     const transport::command::FieldList& fields,
+                     const char* description) {
+  bool message_written = false;
+  auto write_message = [&]() {
+    std::string message = description ? description : "";
+    for (const auto& field : fields) {
+      if (!transport::command::KeyEquals(field, "detail")) {
         continue;
       }
-      const char* existing = obj["message"].isNull() ? nullptr : obj["message"].as<const char*>();
-      if (!existing || existing[0] == '\0') {
-        obj["message"] = value;
-      } else {
-        std::string combined(existing);
-        combined.append("; ");
-        combined.append(value);
-        obj["message"] = combined;
+      std::string detail = Unquote(field.value);
+      if (detail.empty()) {
+        continue;
+      }
+      if (!message.empty()) {
+        message.append("; ");
+      }
+      message.append(detail);
+    }
+    if (!message.empty()) {
+      json.field("message", message);
+    }
+    message_written = true;
+  };
+  if (description) {
+    write_message();
+  }
+  for (const auto& field : fields) {
+    if (transport::command::KeyEquals(field, "detail")) {
+      if (!message_written && !Unquote(field.value).empty()) {
+        write_message();
       }
       continue;
     }
-    const std::string& key = field.key;
-    const std::string value = Unquote(field.value);
-    if (IsInteger(value)) {
-      obj[key] = ParseLong(value);
-    } else {
-      obj[key] = value;
+    WriteFieldValue(json, field);
+  }
+}
+
+bool HasField(const transport::command::FieldList& fields, const char* key) {
+  for (const auto& field : fields) {
+    if (transport::command::KeyEquals(field, key)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+const transport::command::ResponseLine* FindDoneLine(const transport::command::Response& response) {
+  for (const auto& line : response.lines) {
+    if (transport::response::IsDoneLine(line)) {
+      return &line;
+    }
+  }
+  return nullptr;
+}
+
+void WriteWarnings(transport::JsonWriter& json,
+                   const std::vector<transport::command::ResponseLine>& warnings) {
+  if (warnings.empty()) {
+    return;
+  }
+  json.beginArray("warnings");
+  for (const auto& warn : warnings) {
+    json.beginObject().field("code", warn.code);
+    if (!warn.reason.empty()) {
+      json.field("reason", warn.reason);
+    }
+    WriteLineFields(json, warn.fields, nullptr);
+    json.endObject();
+  }
+  json.endArray();
+}
+
+void WriteErrors(transport::JsonWriter& json,
+                 const std::vector<transport::command::ResponseLine>& errors) {
+  if (errors.empty()) {
+    return;
+  }
+  json.beginArray("errors");
+  for (const auto& err : errors) {
+    const auto* desc = transport::command::LookupError(err.code);
+    json.beginObject().field("code", err.code);
+    if (!err.reason.empty()) {
+      json.field("reason", err.reason);
+    } else if (desc && desc->reason) {
+      json.field("reason", desc->reason);
     }
+    WriteLineFields(json, err.fields, desc ? desc->description : nullptr);
+    json.endObject();
   }
+  json.endArray();
 }
 
-bool ExtractIntField(const std::vector<transport::command::Field>& fields,
-                     const std::string& key,
+bool ExtractIntField(const transport::command::FieldList& fields,
+                     const char* key,
                      int32_t& out_value) {
   for (const auto& field : fields) {
-    if (field.key == key) {
-      out_value = ParseLong(Unquote(field.value));
+    if (transport::command::KeyEquals(field, key)) {
+      if (field.kind != transport::command::FieldKind::kInteger) {
+        return false;
+      }
+      out_value = static_cast<int32_t>(field.number);
       return true;
     }
   }
@@ -196,15 +382,21 @@ MqttCommandServer::MqttCommandServer(MotorCommandProcessor& processor,
                                      ClockFn clock,
                                      Config cfg)
     : processor_(processor), publish_(std::move(publish)), subscribe_(std::move(subscribe)),
-      log_(std::move(log)), clock_(std::move(clock)), config_(cfg) {
+      log_(std::move(log)), clock_(std::move(clock)), config_(cfg),
+      inbound_(cfg.inbound_queue_depth), rejected_(cfg.inbound_queue_depth),
+      parse_arena_(cfg.parse_arena_bytes), parse_doc_(&parse_arena_),
+      recent_(cfg.duplicate_cache, cfg.duplicate_cache_bytes) {
   if (!log_) {
     log_ = [](const std::string&) {};
   }
   if (!clock_) {
     clock_ = []() -> uint32_t { return 0; };
   }
+  json_buffer_.reserve(512);
   dispatcher_token_ = transport::response::ResponseDispatcher::Instance().RegisterSink(
-      [this](const transport::response::Event& evt) { this->handleDispatcherEvent(evt); });
+      [this](const transport::response::Event& evt, const transport::command::ResponseLine* line) {
+        this->handleDispatcherEvent(evt, line);
+      });
 }
 
 MqttCommandServer::~MqttCommandServer() {
@@ -239,40 +431,273 @@ bool MqttCommandServer::begin(const std::string& device_topic) {
     }
     return false;
   }
+  node_id_ = base.substr(last_slash + 1);
+  group_filter_.clear();
+  group_filter_["*"] = true;
+  group_filter_["nodes"][node_id_] = true;
   command_topic_ = base + "/cmd";
   response_topic_ = base + "/cmd/resp";
+  msgpack_command_topic_ =
+      transport::EncodedTopic(command_topic_, transport::PayloadEncoding::kMsgPack);
+  msgpack_response_topic_ =
+      transport::EncodedTopic(response_topic_, transport::PayloadEncoding::kMsgPack);
+  fast_topic_ = base + "/cmd/fast";
+  msgpack_fast_topic_ = transport::EncodedTopic(fast_topic_, transport::PayloadEncoding::kMsgPack);
+  fast_stats_topic_ = fast_topic_ + "/stats";
   if (!subscribe_) {
     return false;
   }
   auto callback = [this](const std::string& topic, const std::string& payload) {
-    this->handleIncoming(topic, payload);
+    this->enqueueIncoming(topic, payload);
   };
-  subscribed_ = subscribe_(command_topic_, 1, std::move(callback));
+  subscribed_ = subscribe_(command_topic_, 1, callback) &&
+                subscribe_(msgpack_command_topic_, 1, callback) &&
+                subscribe_(fast_topic_, 0, callback) &&
+                subscribe_(msgpack_fast_topic_, 0, std::move(callback));
+  if (subscribed_) {
+    groups_revision_ = 0;
+    refreshGroupSubscriptions();
+  }
   return subscribed_;
 }
 
+void MqttCommandServer::refreshGroupSubscriptions() {
+  ConfigStore& store = ConfigStore::Instance();
+  if (store.Revision() == groups_revision_) {
+    return;
+  }
+  const std::string groups = store.Current().groups;
+  groups_revision_ = store.Revision();
+  group_topics_.clear();
+  for (const auto& name : SplitGroups(groups)) {
+    std::string topic = kGroupTopicPrefix + name + kGroupCommandSuffix;
+    group_topics_.push_back(transport::EncodedTopic(topic, transport::PayloadEncoding::kMsgPack));
+    group_topics_.push_back(std::move(topic));
+  }
+  for (const auto& topic : group_topics_) {
+    if (std::find(subscribed_group_topics_.begin(), subscribed_group_topics_.end(), topic) !=
+        subscribed_group_topics_.end()) {
+      continue;
+    }
+    auto callback = [this](const std::string& t, const std::string& payload) {
+      this->enqueueIncoming(t, payload);
+    };
+    if (subscribe_(topic, 1, std::move(callback))) {
+      subscribed_group_topics_.push_back(topic);
+    } else {
+      // Retried on the next loop().
+      groups_revision_ = 0;
+    }
+  }
+}
+
 void MqttCommandServer::loop(uint32_t now_ms) {
-  finalizeCompleted(now_ms);
-  transport::response::CompletionTracker::Instance().Tick(now_ms);
+  if (subscribed_) {
+    refreshGroupSubscriptions();
+  }
+  drainInbound();
+  publishFastStats(now_ms);
+}
+
+void MqttCommandServer::setExecutor(ExecuteFn execute, const MotorController* state_view) {
+  execute_ = std::move(execute);
+  state_view_ = state_view;
+}
+
+const MotorController& MqttCommandServer::controllerView() const {
+  return state_view_ ? *state_view_ : processor_.controller();
+}
+
+MqttCommandServer::InboundQueueStats MqttCommandServer::inboundQueueStats() const {
+  InboundQueueStats stats;
+  stats.depth = inbound_.size();
+  stats.capacity = inbound_.capacity();
+  stats.high_water = inbound_high_water_.load(std::memory_order_relaxed);
+  stats.accepted = inbound_accepted_.load(std::memory_order_relaxed);
+  stats.rejected = inbound_rejected_.load(std::memory_order_relaxed);
+  stats.oversized = inbound_oversized_.load(std::memory_order_relaxed);
+  stats.unanswered = inbound_unanswered_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+// Runs on the MQTT client task: only copies the payload, never touches the processor.
+bool MqttCommandServer::isCommandTopic(const std::string& topic) const {
+  return topic == command_topic_ || topic == msgpack_command_topic_;
+}
+
+bool MqttCommandServer::isFastTopic(const std::string& topic) const {
+  return topic == fast_topic_ || topic == msgpack_fast_topic_;
+}
+
+bool MqttCommandServer::isGroupTopic(const std::string& topic) const {
+  return std::find(group_topics_.begin(), group_topics_.end(), topic) != group_topics_.end();
+}
+
+void MqttCommandServer::enqueueIncoming(const std::string& topic, const std::string& payload) {
+  // Fast frames are never answered for being oversized or queued out; the
+  // sequence gap accounts for them instead.
+  const bool fast = isFastTopic(topic);
+  if (!fast && !isCommandTopic(topic) && !IsGroupCommandTopic(topic)) {
+    return;
+  }
+  const transport::PayloadEncoding encoding = transport::TopicEncoding(topic);
+  const size_t limit = payloadLimit(IsGroupCommandTopic(topic));
+  if (payload.size() > limit) {
+    if (fast) {
+      return;
+    }
+    inbound_oversized_.fetch_add(1, std::memory_order_relaxed);
+    RejectedCommand rejected;
+    rejected.encoding = encoding;
+    rejected.cmd_id = transport::message_id::Next();
+    rejected.oversized_bytes = payload.size();
+    rejected.oversized_limit = limit;
+    if (!rejected_.push(std::move(rejected))) {
+      inbound_unanswered_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return;
+  }
+  if (inbound_.pushWith([&](InboundMessage& slot) {
+        slot.topic.assign(topic);
+        slot.payload.assign(payload);
+      })) {
+    inbound_accepted_.fetch_add(1, std::memory_order_relaxed);
+    const size_t depth = inbound_.size();
+    size_t high_water = inbound_high_water_.load(std::memory_order_relaxed);
+    while (depth > high_water &&
+           !inbound_high_water_.compare_exchange_weak(
+               high_water, depth, std::memory_order_relaxed)) {
+    }
+    return;
+  }
+  inbound_rejected_.fetch_add(1, std::memory_order_relaxed);
+  if (fast) {
+    return;
+  }
+  // Full: keep just enough to answer the sender with a busy error from loop().
+  // The ids are scanned for rather than parsed, so this stays cheap on the
+  // client task; a payload they cannot be found in is answered under a fresh id.
+  RejectedCommand rejected;
+  rejected.encoding = encoding;
+  if (!ScanStringField(
+          payload, encoding, "cmd_id", motor::command::kMaxCmdIdLength, rejected.cmd_id)) {
+    rejected.cmd_id = transport::message_id::Next();
+  }
+  if (ScanStringField(payload, encoding, "action", kMaxActionLength, rejected.action)) {
+    rejected.action = ToUpper(std::move(rejected.action));
+  }
+  if (!rejected_.push(std::move(rejected))) {
+    inbound_unanswered_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void MqttCommandServer::drainInbound() {
+  RejectedCommand rejected;
+  while (rejected_.pop(rejected)) {
+    response_encoding_ = rejected.encoding;
+    if (rejected.oversized_bytes > 0) {
+      respondWithError(rejected.cmd_id,
+                       "UNKNOWN",
+                       MakeErrorLine("MQTT_PAYLOAD_TOO_LARGE",
+                                     "TOO_LARGE",
+                                     payloadTooLargeMessage(rejected.oversized_bytes,
+                                                            rejected.oversized_limit)),
+                       clock_ ? clock_() : 0);
+      continue;
+    }
+    respondWithError(rejected.cmd_id,
+                     rejected.action,
+                     MakeErrorLine("MQTT_BUSY", "QUEUE_FULL"),
+                     clock_ ? clock_() : 0);
+  }
+  const uint32_t rejected_total = inbound_rejected_.load(std::memory_order_relaxed);
+  if (rejected_total != inbound_rejected_logged_ && log_) {
+    log_("CTRL:WARN MQTT_CMD_QUEUE_FULL rejected=" +
+         std::to_string(rejected_total - inbound_rejected_logged_) +
+         " capacity=" + std::to_string(inbound_.capacity()));
+  }
+  inbound_rejected_logged_ = rejected_total;
+  const uint32_t unanswered = inbound_unanswered_.load(std::memory_order_relaxed);
+  if (unanswered != inbound_unanswered_logged_) {
+    log_("CTRL:WARN MQTT_CMD_UNANSWERED dropped=" +
+         std::to_string(unanswered - inbound_unanswered_logged_));
+    inbound_unanswered_logged_ = unanswered;
+  }
+
+  // Bounded so a steady stream of commands cannot starve the rest of loop().
+  for (size_t budget = inbound_.capacity(); budget > 0 && inbound_.popSwap(current_inbound_);
+       --budget) {
+    handleIncoming(current_inbound_.topic, current_inbound_.payload);
+  }
 }
 
 void MqttCommandServer::handleIncoming(const std::string& topic, const std::string& payload) {
-  if (topic != command_topic_) {
+  if (isFastTopic(topic)) {
+    handleFastFrame(topic, payload);
+    return;
+  }
+  const bool group_command = isGroupTopic(topic);
+  if (!group_command && !isCommandTopic(topic)) {
     return;
   }
   uint32_t now_ms = clock_ ? clock_() : 0;
+  // Answers go back in the encoding the command arrived in.
+  const transport::PayloadEncoding encoding = transport::TopicEncoding(topic);
+  response_encoding_ = encoding;
+
+  const size_t limit = payloadLimit(group_command);
+  if (payload.size() > limit) {
+    respondWithError(transport::message_id::Next(),
+                     "UNKNOWN",
+                     MakeErrorLine("MQTT_PAYLOAD_TOO_LARGE",
+                                   "TOO_LARGE",
+                                   payloadTooLargeMessage(payload.size(), limit)),
+                     now_ms);
+    return;
+  }
 
-  ArduinoJson::JsonDocument doc;
+  // cmd_id, action and params below are views into parse_doc_; only what a
+  // dispatch has to keep is copied out.
   std::string parse_error;
-  if (!parsePayload(payload, doc, parse_error)) {
+  bool out_of_memory = false;
+  if (!parsePayload(payload,
+                    encoding,
+                    parse_arena_,
+                    parse_doc_,
+                    parse_error,
+                    out_of_memory,
+                    group_command ? &group_filter_ : nullptr)) {
     const std::string cmd_id = transport::message_id::Next();
+    if (out_of_memory) {
+      respondWithError(cmd_id,
+                       "UNKNOWN",
+                       MakeErrorLine("MQTT_PAYLOAD_TOO_LARGE", "TOO_LARGE", parse_error),
+                       now_ms);
+      return;
+    }
     respondWithError(
         cmd_id, "UNKNOWN", MakeErrorLine("MQTT_BAD_PAYLOAD", "INVALID", parse_error), now_ms);
     return;
   }
+  const ArduinoJson::JsonDocument& doc = parse_doc_;
 
   const char* action_c = doc["action"].as<const char*>();
-  if (!action_c) {
+  ArduinoJson::JsonVariantConst params = doc["params"];
+  ArduinoJson::JsonVariantConst batch = doc["batch"];
+  if (group_command && !doc["nodes"].isNull()) {
+    // One publish for many nodes: each takes its own params (or batch
+    // entries) from nodes.<node_id> and ignores commands that do not list it.
+    ArduinoJson::JsonVariantConst slice = doc["nodes"][node_id_];
+    if (slice.isNull()) {
+      return;
+    }
+    if (slice.is<ArduinoJson::JsonArrayConst>()) {
+      batch = slice;
+    } else {
+      params = slice;
+    }
+  }
+  if (!action_c && batch.isNull()) {
     const std::string cmd_id = transport::message_id::Next();
     respondWithError(
         cmd_id, "UNKNOWN", MakeErrorLine("MQTT_BAD_PAYLOAD", "MISSING_FIELDS"), now_ms);
@@ -282,47 +707,69 @@ void MqttCommandServer::handleIncoming(const std::string& topic, const std::stri
   const char* cmd_id_c = doc["cmd_id"].as<const char*>();
   std::string cmd_id =
       cmd_id_c && cmd_id_c[0] ? std::string(cmd_id_c) : transport::message_id::Next();
-  std::string action = ToUpper(std::string(action_c));
+  std::string action = action_c ? ToUpper(std::string(action_c)) : std::string(kBatchAction);
 
   if (handleDuplicateCommand(cmd_id, now_ms)) {
     return;
   }
 
+  if (action_c && !batch.isNull()) {
+    respondWithError(
+        cmd_id,
+        action,
+        MakeErrorLine("MQTT_BAD_PAYLOAD", "INVALID", "action and batch are mutually exclusive"),
+        now_ms);
+    return;
+  }
+
   if (action == "HELP") {
     respondWithHelp(cmd_id, now_ms);
     return;
   }
 
-  ArduinoJson::JsonVariantConst params = doc["params"];
-
   std::vector<uint8_t> targets;
   std::string command_line;
   std::string build_error;
   bool unsupported_action = false;
-  if (!buildCommandLine(action, params, command_line, targets, build_error, unsupported_action)) {
+  const bool built =
+      batch.isNull()
+          ? buildCommandLine(action, params, command_line, targets, build_error, unsupported_action)
+          : buildBatchCommand(batch, command_line, targets, build_error);
+  if (!built) {
     const char* code = unsupported_action ? "MQTT_UNSUPPORTED_ACTION" : "MQTT_BAD_PAYLOAD";
     const char* reason = unsupported_action ? "UNSUPPORTED" : "INVALID";
     respondWithError(cmd_id, action, MakeErrorLine(code, reason, build_error), now_ms);
     return;
   }
 
+  ArduinoJson::JsonVariantConst coalesce_field = doc["coalesce"];
+  const bool coalesce =
+      coalesce_field.is<bool>() ? coalesce_field.as<bool>() : config_.coalesce_responses;
   uint32_t mask = maskForTargets(targets);
   CommandDispatch dispatch =
-      makeDispatch(cmd_id, action, std::move(command_line), std::move(targets), mask);
+      makeDispatch(cmd_id, action, std::move(command_line), std::move(targets), mask, coalesce);
+  dispatch.encoding = encoding;
   ensureStream(dispatch.cmd_id, dispatch.action, dispatch.mask, now_ms);
   auto stream_ref = findStream(dispatch.cmd_id);
   DispatchStream* stream_ptr = stream_ref.get();
-  if (stream_ptr && stream_ptr->action.empty()) {
-    stream_ptr->action = dispatch.action;
+  if (stream_ptr) {
+    if (stream_ptr->action.empty()) {
+      stream_ptr->action = dispatch.action;
+    }
+    stream_ptr->coalesce = dispatch.coalesce;
+    stream_ptr->encoding = encoding;
   }
 
-  motor::command::CommandResult result = processor_.execute(dispatch.command_line, now_ms);
+  motor::command::CommandResult result =
+      execute_ ? execute_(dispatch.command_line, now_ms)
+               : processor_.execute(dispatch.command_line, now_ms);
+  response_encoding_ = encoding;
   if (!result.hasStructuredResponse()) {
     respondWithError(dispatch.cmd_id,
                      dispatch.action,
                      MakeErrorLine("MQTT_NO_STRUCTURED_RESPONSE", "NO_RESPONSE"),
                      now_ms);
-    streams_.erase(dispatch.cmd_id);
+    eraseStream(dispatch.cmd_id);
     return;
   }
 
@@ -331,19 +778,181 @@ void MqttCommandServer::handleIncoming(const std::string& topic, const std::stri
       transport::response::BuildCommandResponse(response, dispatch.action);
 
   executeDispatch(dispatch, response, contract, stream_ref, now_ms);
+  if (stream_ptr) {
+    finishCoalescing(*stream_ptr);
+  }
+}
+
+void MqttCommandServer::handleFastFrame(const std::string& topic, const std::string& payload) {
+  const uint32_t now_ms = clock_ ? clock_() : 0;
+  fast_encoding_ = transport::TopicEncoding(topic);
+  response_encoding_ = fast_encoding_;
+
+  std::string parse_error;
+  bool out_of_memory = false;
+  if (!parsePayload(
+          payload, fast_encoding_, parse_arena_, parse_doc_, parse_error, out_of_memory)) {
+    rejectFastFrame(kFastCommandPrefix + transport::message_id::Next(),
+                    "UNKNOWN",
+                    MakeErrorLine("MQTT_BAD_PAYLOAD", "INVALID", parse_error),
+                    now_ms);
+    return;
+  }
+  const ArduinoJson::JsonDocument& doc = parse_doc_;
+  const char* action_c = doc["action"].as<const char*>();
+  ArduinoJson::JsonVariantConst batch = doc["batch"];
+  const std::string action =
+      action_c ? ToUpper(std::string(action_c)) : std::string(kBatchAction);
+  ArduinoJson::JsonVariantConst seq_field = doc["seq"];
+  if (!seq_field.is<uint32_t>()) {
+    rejectFastFrame(kFastCommandPrefix + transport::message_id::Next(),
+                    action,
+                    MakeErrorLine("MQTT_BAD_PAYLOAD", "INVALID", "seq must be an unsigned integer"),
+                    now_ms);
+    return;
+  }
+
+  // Only frames newer than the last executed one run; seq 0 restarts the
+  // sequence for a sender that reconnected.
+  const uint32_t seq = seq_field.as<uint32_t>();
+  ++fast_stats_.received;
+  fast_stats_dirty_ = true;
+  if (fast_seq_valid_ && seq != 0) {
+    const int32_t ahead = static_cast<int32_t>(seq - fast_stats_.last_seq);
+    if (ahead <= 0) {
+      ++fast_stats_.late;
+      return;
+    }
+    fast_stats_.dropped += static_cast<uint32_t>(ahead - 1);
+  }
+  fast_seq_valid_ = true;
+  fast_stats_.last_seq = seq;
+
+  const std::string cmd_id = kFastCommandPrefix + std::to_string(seq);
+  if (action_c && !batch.isNull()) {
+    rejectFastFrame(
+        cmd_id,
+        action,
+        MakeErrorLine("MQTT_BAD_PAYLOAD", "INVALID", "action and batch are mutually exclusive"),
+        now_ms);
+    return;
+  }
+  // Queries have nothing to say without a response, so only motion commands qualify.
+  if (batch.isNull() && action != "MOVE" && action != "HOME" && action != "WAKE" &&
+      action != "SLEEP") {
+    rejectFastFrame(cmd_id,
+                    action,
+                    MakeErrorLine("MQTT_UNSUPPORTED_ACTION", "UNSUPPORTED", "not a fast action"),
+                    now_ms);
+    return;
+  }
+
+  std::vector<uint8_t> targets;
+  std::string command_line;
+  std::string build_error;
+  bool unsupported_action = false;
+  const bool built =
+      batch.isNull()
+          ? buildCommandLine(
+                action, doc["params"], command_line, targets, build_error, unsupported_action)
+          : buildBatchCommand(batch, command_line, targets, build_error);
+  if (!built) {
+    rejectFastFrame(
+        cmd_id, action, MakeErrorLine("MQTT_BAD_PAYLOAD", "INVALID", build_error), now_ms);
+    return;
+  }
+  // The message id is fixed up front (batches already carry one) so the
+  // dispatcher events it produces can be told apart from real commands'.
+  if (command_line[0] == '#') {
+    markFastMessage(command_line.substr(1, command_line.find(' ') - 1));
+  } else {
+    // Rendered here since the id travels back parsed from the command text.
+    const std::string msg_id = transport::message_id::Next();
+    markFastMessage(msg_id);
+    command_line.insert(0, "#" + msg_id + " ");
+  }
+
+  motor::command::CommandResult result =
+      execute_ ? execute_(command_line, now_ms) : processor_.execute(command_line, now_ms);
+  response_encoding_ = fast_encoding_;
+  if (!result.hasStructuredResponse()) {
+    rejectFastFrame(
+        cmd_id, action, MakeErrorLine("MQTT_NO_STRUCTURED_RESPONSE", "NO_RESPONSE"), now_ms);
+    return;
+  }
+  const auto errors = collectErrors(result.structuredResponse());
+  if (!errors.empty()) {
+    rejectFastFrame(cmd_id, action, errors.front(), now_ms);
+  }
+}
+
+void MqttCommandServer::rejectFastFrame(const std::string& cmd_id,
+                                        const std::string& action,
+                                        const transport::command::ResponseLine& error_line,
+                                        uint32_t now_ms) {
+  ++fast_stats_.errors;
+  fast_stats_dirty_ = true;
+  // Not cached: fast frames have no cmd_id a client could redeliver.
+  transport::command::Response empty;
+  publishCompletion(buildCompletionPayload(cmd_id,
+                                           action,
+                                           empty,
+                                           transport::command::CompletionStatus::kError,
+                                           {},
+                                           {error_line},
+                                           {},
+                                           0,
+                                           now_ms,
+                                           false));
+}
+
+void MqttCommandServer::markFastMessage(const transport::message_id::Id& msg_id) {
+  fast_msg_ids_[fast_msg_cursor_] = msg_id.key();
+  fast_msg_cursor_ = (fast_msg_cursor_ + 1) % fast_msg_ids_.size();
+}
+
+bool MqttCommandServer::isFastMessage(const transport::message_id::Id& msg_id) const {
+  return std::find(fast_msg_ids_.begin(), fast_msg_ids_.end(), msg_id.key()) !=
+         fast_msg_ids_.end();
+}
+
+void MqttCommandServer::publishFastStats(uint32_t now_ms) {
+  if (!fast_stats_dirty_ || config_.fast_stats_interval_ms == 0 || !publish_ ||
+      now_ms - last_fast_stats_ms_ < config_.fast_stats_interval_ms) {
+    return;
+  }
+  json_buffer_.clear();
+  transport::JsonWriter json(json_buffer_, fast_encoding_);
+  json.beginObject()
+      .field("received", fast_stats_.received)
+      .field("dropped", fast_stats_.dropped)
+      .field("late", fast_stats_.late)
+      .field("errors", fast_stats_.errors)
+      .field("last_seq", fast_stats_.last_seq)
+      .endObject();
+  PublishMessage msg;
+  msg.topic = transport::EncodedTopic(fast_stats_topic_, fast_encoding_);
+  msg.payload = json_buffer_;
+  msg.qos = 0;
+  msg.retain = false;
+  msg.priority = PublishPriority::kInfo;
+  if (publish_(msg)) {
+    fast_stats_dirty_ = false;
+    last_fast_stats_ms_ = now_ms;
+  }
 }
 
 bool MqttCommandServer::isDuplicate(const std::string& cmd_id) const {
-  if (streams_.find(cmd_id) != streams_.end()) {
+  const uint64_t hash = transport::message_id::Hash(cmd_id);
+  if (recent_.contains(hash, cmd_id)) {
     return true;
   }
-  for (const auto& pending : pending_) {
-    if (pending.cmd_id == cmd_id) {
-      return true;
-    }
+  if (findStream(cmd_id)) {
+    return true;
   }
-  for (const auto& cached : recent_) {
-    if (cached.cmd_id == cmd_id) {
+  // Only commands still waiting for their motors; at most one per motor.
+  for (const auto& pending : pending_) {
+    if (pending.cmd_id.matches(hash, cmd_id)) {
       return true;
     }
   }
@@ -355,6 +964,17 @@ bool MqttCommandServer::handleDuplicateCommand(const std::string& cmd_id, uint32
     return false;
   }
   logDuplicate(cmd_id, now_ms);
+  const uint64_t hash = transport::message_id::Hash(cmd_id);
+  ResponseCache::View cached;
+  if (recent_.find(hash, cmd_id, cached)) {
+    if (cached.ack_len > 0) {
+      publishAck(std::string(cached.ack, cached.ack_len));
+    }
+    if (cached.completion_len > 0) {
+      publishCompletion(std::string(cached.completion, cached.completion_len));
+    }
+    return true;
+  }
   if (auto stream_ref = findStream(cmd_id)) {
     if (!stream_ref->ack_payload.empty()) {
       publishAck(stream_ref->ack_payload);
@@ -363,28 +983,19 @@ bool MqttCommandServer::handleDuplicateCommand(const std::string& cmd_id, uint32
   }
   if (transport::response::ResponseDispatcher::Instance().Replay(
           cmd_id,
-          [this](const transport::response::Event& evt) { this->handleDispatcherEvent(evt); })) {
+          [this](const transport::response::Event& evt) {
+            this->handleDispatcherEvent(evt, nullptr);
+          })) {
     return true;
   }
   for (const auto& pending : pending_) {
-    if (pending.cmd_id == cmd_id) {
+    if (pending.cmd_id.matches(hash, cmd_id)) {
       if (!pending.ack_payload.empty()) {
         publishAck(pending.ack_payload);
       }
       return true;
     }
   }
-  for (const auto& cached : recent_) {
-    if (cached.cmd_id == cmd_id) {
-      if (!cached.ack_payload.empty()) {
-        publishAck(cached.ack_payload);
-      }
-      if (!cached.completion_payload.empty()) {
-        publishCompletion(cached.completion_payload);
-      }
-      return true;
-    }
-  }
   return true;
 }
 
@@ -428,28 +1039,30 @@ void MqttCommandServer::respondWithHelp(const std::string& cmd_id, uint32_t now_
     log_("CTRL:DONE cmd_id=" + cmd_id + " action=HELP status=done");
   }
 
-  ArduinoJson::JsonDocument doc;
-  doc["cmd_id"] = cmd_id;
-  doc["action"] = "HELP";
-  doc["status"] = "done";
-  doc["result"]["text"] = help_text;
-
-  std::string payload;
-  ArduinoJson::serializeJson(doc, payload);
-  publishCompletion(payload);
-  recordCompleted(cmd_id, "", payload);
+  json_buffer_.clear();
+  transport::JsonWriter json(json_buffer_, response_encoding_);
+  json.beginObject()
+      .field("cmd_id", cmd_id)
+      .field("action", "HELP")
+      .field("status", "done")
+      .beginObject("result")
+      .field("text", help_text)
+      .endObject()
+      .endObject();
+  publishCompletion(json_buffer_);
+  recordCompleted(cmd_id, "", json_buffer_);
 }
 
 void MqttCommandServer::recordCompleted(const std::string& cmd_id,
                                         const std::string& ack_payload,
                                         const std::string& completion_payload) {
-  if (config_.duplicate_cache == 0) {
-    return;
-  }
-  recent_.push_back(CachedResponse{cmd_id, ack_payload, completion_payload});
-  while (recent_.size() > config_.duplicate_cache) {
-    recent_.pop_front();
-  }
+  (void)recent_.put(transport::message_id::Hash(cmd_id), cmd_id, ack_payload, completion_payload);
+}
+
+const std::string& MqttCommandServer::responseTopicFor(const std::string& payload) const {
+  return transport::PayloadEncodingOf(payload) == transport::PayloadEncoding::kMsgPack
+             ? msgpack_response_topic_
+             : response_topic_;
 }
 
 bool MqttCommandServer::publishAck(const std::string& payload) {
@@ -457,7 +1070,7 @@ bool MqttCommandServer::publishAck(const std::string& payload) {
     return false;
   }
   PublishMessage msg;
-  msg.topic = response_topic_;
+  msg.topic = responseTopicFor(payload);
   msg.payload = payload;
   msg.qos = 1;
   msg.retain = false;
@@ -469,7 +1082,7 @@ bool MqttCommandServer::publishCompletion(const std::string& payload) {
     return false;
   }
   PublishMessage msg;
-  msg.topic = response_topic_;
+  msg.topic = responseTopicFor(payload);
   msg.payload = payload;
   msg.qos = 1;
   msg.retain = false;
@@ -480,29 +1093,86 @@ MqttCommandServer::CommandDispatch MqttCommandServer::makeDispatch(const std::st
                                                                    const std::string& action,
                                                                    std::string command_line,
                                                                    std::vector<uint8_t> targets,
-                                                                   uint32_t mask) const {
+                                                                   uint32_t mask,
+                                                                   bool coalesce) const {
   CommandDispatch dispatch;
   dispatch.cmd_id = cmd_id;
   dispatch.action = action;
   dispatch.command_line = std::move(command_line);
   dispatch.targets = std::move(targets);
   dispatch.mask = mask;
+  dispatch.coalesce = coalesce;
   return dispatch;
 }
 
 std::shared_ptr<MqttCommandServer::DispatchStream>
-MqttCommandServer::findStream(const std::string& cmd_id) {
-  auto it = streams_.find(cmd_id);
-  if (it == streams_.end()) {
+MqttCommandServer::findStream(const std::string& cmd_id) const {
+  auto it = streams_.find(transport::message_id::Hash(cmd_id));
+  if (it == streams_.end() || it->second->cmd_id != cmd_id) {
+    return nullptr;
+  }
+  return it->second;
+}
+
+std::shared_ptr<MqttCommandServer::DispatchStream>
+MqttCommandServer::findStreamFor(const transport::message_id::Id& msg_id) const {
+  auto bound = stream_by_msg_.find(msg_id.key());
+  if (bound != stream_by_msg_.end()) {
+    auto it = streams_.find(bound->second);
+    if (it != streams_.end() && it->second->msg_id == msg_id) {
+      return it->second;
+    }
+  }
+  if (msg_id.generated()) {
+    return nullptr;
+  }
+  auto it = streams_.find(msg_id.key());
+  if (it == streams_.end() || msg_id != transport::message_id::Id(it->second->cmd_id)) {
     return nullptr;
   }
   return it->second;
 }
 
+void MqttCommandServer::eraseStream(const std::string& cmd_id) {
+  const uint64_t key = transport::message_id::Hash(cmd_id);
+  auto it = streams_.find(key);
+  if (it == streams_.end() || it->second->cmd_id != cmd_id) {
+    return;
+  }
+  auto bound = stream_by_msg_.find(it->second->msg_id.key());
+  if (bound != stream_by_msg_.end() && bound->second == key) {
+    stream_by_msg_.erase(bound);
+  }
+  // May destroy the stream cmd_id refers to, so it goes last.
+  streams_.erase(it);
+}
+
 bool MqttCommandServer::parsePayload(const std::string& payload,
+                                     transport::PayloadEncoding encoding,
+                                     JsonArena& arena,
                                      ArduinoJson::JsonDocument& doc,
-                                     std::string& error) const {
-  auto err = ArduinoJson::deserializeJson(doc, payload);
+                                     std::string& error,
+                                     bool& out_of_memory,
+                                     const ArduinoJson::JsonDocument* filter) const {
+  // Clearing hands every block back before the arena is rewound.
+  doc.clear();
+  arena.reset();
+  ArduinoJson::DeserializationError err;
+  if (filter) {
+    ArduinoJson::DeserializationOption::Filter keep(*filter);
+    err = encoding == transport::PayloadEncoding::kMsgPack
+              ? ArduinoJson::deserializeMsgPack(doc, payload, keep)
+              : ArduinoJson::deserializeJson(doc, payload, keep);
+  } else {
+    err = encoding == transport::PayloadEncoding::kMsgPack
+              ? ArduinoJson::deserializeMsgPack(doc, payload)
+              : ArduinoJson::deserializeJson(doc, payload);
+  }
+  out_of_memory = err == ArduinoJson::DeserializationError::NoMemory;
+  if (out_of_memory) {
+    error = "parse pool of " + std::to_string(arena.capacity()) + " bytes exhausted";
+    return false;
+  }
   if (err) {
     error = err.c_str();
     return false;
@@ -510,6 +1180,15 @@ bool MqttCommandServer::parsePayload(const std::string& payload,
   return true;
 }
 
+size_t MqttCommandServer::payloadLimit(bool group_command) const {
+  return group_command ? config_.max_group_payload_bytes : config_.max_payload_bytes;
+}
+
+std::string MqttCommandServer::payloadTooLargeMessage(size_t payload_bytes, size_t limit) const {
+  return "payload " + std::to_string(payload_bytes) + " bytes exceeds limit of " +
+         std::to_string(limit);
+}
+
 bool MqttCommandServer::streamConsumesResponse(DispatchStream* stream_ptr,
                                                const CommandDispatch& dispatch,
                                                const transport::command::Response& response,
@@ -566,18 +1245,14 @@ void MqttCommandServer::executeDispatch(const CommandDispatch& dispatch,
   bool handled_by_dispatcher =
       streamConsumesResponse(stream_ptr, dispatch, response, contract, ack_line);
   if (!handled_by_dispatcher) {
-    for (const auto& cached : recent_) {
-      if (cached.cmd_id == dispatch.cmd_id) {
-        handled_by_dispatcher = true;
-        break;
-      }
-    }
+    handled_by_dispatcher =
+        recent_.contains(transport::message_id::Hash(dispatch.cmd_id), dispatch.cmd_id);
   }
   if (handled_by_dispatcher) {
     return;
   }
 
-  streams_.erase(dispatch.cmd_id);
+  eraseStream(dispatch.cmd_id);
   auto warnings = transport::command::CollectWarnings(response);
   auto errors = collectErrors(response);
   auto data_lines = collectDataLines(response);
@@ -585,41 +1260,56 @@ void MqttCommandServer::executeDispatch(const CommandDispatch& dispatch,
   transport::command::CompletionStatus status =
       transport::command::DeriveCompletionStatus(response);
 
-  std::string ack_payload;
-  if (accepted) {
-    ack_payload = buildAckPayload(dispatch.cmd_id, dispatch.action, response, warnings);
-    publishAck(ack_payload);
-  }
-
   bool awaiting = false;
-  if (status == transport::command::CompletionStatus::kOk && dispatch.action == "MOVE") {
-    if (dispatch.mask != 0 && processor_.controller().isAnyMovingForMask(dispatch.mask)) {
+  if (status == transport::command::CompletionStatus::kOk &&
+      (dispatch.action == "MOVE" || dispatch.action == kBatchAction)) {
+    if (dispatch.mask != 0 && controllerView().isAnyMovingForMask(dispatch.mask)) {
       awaiting = true;
     }
   }
 
+  // Nothing is left to wait for, so a coalesced ACK folds into the completion.
+  const bool coalesced = accepted && dispatch.coalesce && !awaiting;
+  std::string ack_payload;
+  if (accepted && !coalesced) {
+    ack_payload = buildAckPayload(dispatch.cmd_id, dispatch.action, response, warnings);
+    publishAck(ack_payload);
+  }
+
   if (awaiting) {
     PendingCompletion pending;
-    pending.cmd_id = dispatch.cmd_id;
+    pending.cmd_id = transport::message_id::CmdId(dispatch.cmd_id);
     pending.action = dispatch.action;
     pending.command_line = dispatch.command_line;
     pending.response = response;
     pending.ack_payload = ack_payload;
     pending.mask = dispatch.mask;
     pending.started_ms = now_ms;
-    pending.awaiting_motor_finish = true;
+    pending.msg_id = ack_line != nullptr ? ack_line->msg_id : contract.cmd_id;
+    pending.encoding = dispatch.encoding;
     pending.targets = dispatch.targets;
     pending_.push_back(std::move(pending));
+    // The motors may have stopped before this returned; their DONE is parked.
+    auto parked = orphan_events_.find(pending_.back().msg_id.key());
+    if (parked != orphan_events_.end()) {
+      const uint64_t msg_id = parked->first;
+      const std::vector<transport::response::Event> events = std::move(parked->second);
+      orphan_events_.erase(parked);
+      orphan_order_.erase(std::remove(orphan_order_.begin(), orphan_order_.end(), msg_id),
+                          orphan_order_.end());
+      for (const auto& evt : events) {
+        if (evt.type == transport::response::EventType::kDone && completePending(evt)) {
+          break;
+        }
+      }
+    }
     return;
   }
 
   int32_t completion_actual_ms = -1;
   for (const auto& evt : contract.events) {
     if (evt.type == transport::response::EventType::kDone) {
-      auto attr = evt.attributes.find("actual_ms");
-      if (attr != evt.attributes.end()) {
-        completion_actual_ms = static_cast<int32_t>(ParseLong(attr->second, -1));
-      }
+      transport::response::ExtractInt(evt, "actual_ms", completion_actual_ms);
       break;
     }
   }
@@ -643,7 +1333,8 @@ void MqttCommandServer::executeDispatch(const CommandDispatch& dispatch,
                                                           dispatch.mask,
                                                           now_ms,
                                                           false,
-                                                          completion_actual_ms);
+                                                          completion_actual_ms,
+                                                          coalesced ? ack_line : nullptr);
   publishCompletion(completion_payload);
   recordCompleted(dispatch.cmd_id, ack_payload, completion_payload);
 }
@@ -686,12 +1377,12 @@ bool MqttCommandServer::parseMotorTargetSelector(ArduinoJson::JsonVariantConst s
   targets.clear();
   auto appendAllTargets = [&](void) -> void {
     uint32_t mask = 0;
-    motor::command::ParseIdMask("ALL", mask, processor_.controller().motorCount());
-    targets = TargetsFromMask(mask, processor_.controller().motorCount());
+    motor::command::ParseIdMask("ALL", mask, controllerView().motorCount());
+    targets = TargetsFromMask(mask, controllerView().motorCount());
     token = "ALL";
   };
   auto appendSingleTarget = [&](long id) -> bool {
-    if (id < 0 || id >= static_cast<long>(processor_.controller().motorCount())) {
+    if (id < 0 || id >= static_cast<long>(controllerView().motorCount())) {
       error = "target out of range";
       return false;
     }
@@ -742,7 +1433,40 @@ bool MqttCommandServer::parseMotorTargetSelector(ArduinoJson::JsonVariantConst s
     return appendSingleTarget(id);
   }
 
-  error = "target_ids must be string or int";
+  // A list of ids leaves token empty; the builders expand it into one command
+  // per motor (see ForEachTarget).
+  if (selector.is<ArduinoJson::JsonArrayConst>()) {
+    auto ids = selector.as<ArduinoJson::JsonArrayConst>();
+    if (ids.size() == 0) {
+      error = "target_ids must not be empty";
+      return false;
+    }
+    uint32_t seen = 0;
+    for (ArduinoJson::JsonVariantConst id_field : ids) {
+      if (!(id_field.is<long>() || id_field.is<int>())) {
+        error = "target_ids entries must be int";
+        return false;
+      }
+      const long id = id_field.as<long>();
+      if (id < 0 || id >= static_cast<long>(controllerView().motorCount())) {
+        error = "target out of range";
+        return false;
+      }
+      if (seen & (1u << id)) {
+        error = "target_ids has duplicates";
+        return false;
+      }
+      seen |= 1u << id;
+      targets.push_back(static_cast<uint8_t>(id));
+    }
+    token.clear();
+    if (targets.size() == 1) {
+      token = std::to_string(targets[0]);
+    }
+    return true;
+  }
+
+  error = "target_ids must be string, int or array of int";
   return false;
 }
 
@@ -766,26 +1490,27 @@ bool MqttCommandServer::buildMoveCommand(ArduinoJson::JsonVariantConst params,
     return false;
   }
 
-  out = "MOVE:" + target_token + "," + std::to_string(position);
+  std::string args = "," + std::to_string(position);
 
   long speed = 0;
   if (!obj["speed_sps"].isNull()) {
     if (!parseIntegerField(obj["speed_sps"], "speed_sps", false, speed, error)) {
       return false;
     }
-    out.append(",");
-    out.append(std::to_string(speed));
+    args.append(",");
+    args.append(std::to_string(speed));
 
     long accel = 0;
     if (!obj["accel_sps2"].isNull()) {
       if (!parseIntegerField(obj["accel_sps2"], "accel_sps2", false, accel, error)) {
         return false;
       }
-      out.append(",");
-      out.append(std::to_string(accel));
+      args.append(",");
+      args.append(std::to_string(accel));
     }
   }
 
+  out = ForEachTarget("MOVE", targets, target_token, args);
   return true;
 }
 
@@ -821,7 +1546,7 @@ bool MqttCommandServer::buildHomeCommand(ArduinoJson::JsonVariantConst params,
     }
   }
 
-  out = "HOME:" + target_token;
+  std::string args;
   int max_idx = -1;
   for (int i = 0; i < static_cast<int>(present.size()); ++i) {
     if (present[i]) {
@@ -829,11 +1554,12 @@ bool MqttCommandServer::buildHomeCommand(ArduinoJson::JsonVariantConst params,
     }
   }
   for (int i = 0; i <= max_idx; ++i) {
-    out.append(",");
+    args.append(",");
     if (present[i]) {
-      out.append(optionals[i]);
+      args.append(optionals[i]);
     }
   }
+  out = ForEachTarget("HOME", targets, target_token, args);
   return true;
 }
 
@@ -851,7 +1577,7 @@ bool MqttCommandServer::buildWakeSleepCommand(const std::string& action,
   if (!parseMotorTargetSelector(obj["target_ids"], targets, token, error, true)) {
     return false;
   }
-  out = action + ":" + token;
+  out = ForEachTarget(action.c_str(), targets, token, "");
   return true;
 }
 
@@ -928,6 +1654,10 @@ bool MqttCommandServer::buildGetCommand(ArduinoJson::JsonVariantConst params,
         if (!parseMotorTargetSelector(selector, tmp_targets, token, error, false)) {
           return false;
         }
+        if (token.empty()) {
+          error = "LAST_OP_TIMING takes one target or ALL";
+          return false;
+        }
         target_token = token;
       }
     } else if (!resource.empty()) {
@@ -944,7 +1674,7 @@ bool MqttCommandServer::buildGetCommand(ArduinoJson::JsonVariantConst params,
   }
 
   if (resource == "ALL" || resource == "SPEED" || resource == "ACCEL" || resource == "DECEL" ||
-      resource == "THERMAL_LIMITING") {
+      resource == "THERMAL_LIMITING" || resource == "MSG_ID_FORMAT") {
     out = "GET " + resource;
     return true;
   }
@@ -1095,6 +1825,50 @@ bool MqttCommandServer::buildMqttConfigCommand(const std::string& action,
       return false;
     }
 
+    ArduinoJson::JsonVariantConst groups_field = obj["groups"];
+    if (groups_field.is<ArduinoJson::JsonArrayConst>()) {
+      saw_field = true;
+      std::string groups;
+      for (ArduinoJson::JsonVariantConst entry : groups_field.as<ArduinoJson::JsonArrayConst>()) {
+        if (!entry.is<const char*>()) {
+          error = "groups entries must be strings";
+          return false;
+        }
+        if (!groups.empty()) {
+          groups.push_back(',');
+        }
+        groups.append(entry.as<const char*>());
+      }
+      cmd.append(" groups=");
+      cmd.append(QuoteIfNeeded(groups));
+    } else if (!append_string_field("groups", groups_field, "groups")) {
+      return false;
+    }
+
+    if (!obj["status_max_hz"].isNull()) {
+      saw_field = true;
+      auto field = obj["status_max_hz"];
+      long parsed = -1;
+      if (field.is<const char*>()) {
+        parsed = ParseLong(field.as<const char*>(), -1);
+      } else if (field.is<int>() || field.is<long>()) {
+        parsed = field.as<long>();
+      } else {
+        error = "status_max_hz must be string or integer";
+        return false;
+      }
+      if (parsed < kMinStatusMaxHz || parsed > kMaxStatusMaxHz) {
+        error = "status_max_hz must be " + std::to_string(kMinStatusMaxHz) + "-" +
+                std::to_string(kMaxStatusMaxHz);
+        return false;
+      }
+      cmd.append(" status_max_hz=");
+      cmd.append(std::to_string(parsed));
+    }
+    if (!append_string_field("status_topics", obj["status_topics"], "status_topics")) {
+      return false;
+    }
+
     if (!saw_field) {
       error = "no fields provided";
       return false;
@@ -1140,6 +1914,19 @@ bool MqttCommandServer::buildSetCommand(ArduinoJson::JsonVariantConst params,
       key = "THERMAL_LIMITING";
       value = val;
       recognized = true;
+    } else if (name == "MSG_ID_FORMAT") {
+      if (!kv.value().is<const char*>()) {
+        error = "MSG_ID_FORMAT must be string";
+        return false;
+      }
+      std::string val = Trim(ToUpper(std::string(kv.value().as<const char*>())));
+      if (val != "HEX" && val != "UUID") {
+        error = "MSG_ID_FORMAT must be HEX or UUID";
+        return false;
+      }
+      key = "MSG_ID_FORMAT";
+      value = val;
+      recognized = true;
     } else if (name == "SPEED_SPS" || name == "ACCEL_SPS2" || name == "DECEL_SPS2") {
       if (!(kv.value().is<long>() || kv.value().is<int>())) {
         error = name + " must be integer";
@@ -1175,6 +1962,52 @@ bool MqttCommandServer::buildSetCommand(ArduinoJson::JsonVariantConst params,
   return true;
 }
 
+bool MqttCommandServer::buildBatchCommand(ArduinoJson::JsonVariantConst batch,
+                                          std::string& out,
+                                          std::vector<uint8_t>& targets,
+                                          std::string& error) const {
+  targets.clear();
+  if (!batch.is<ArduinoJson::JsonArrayConst>() || batch.size() == 0) {
+    error = "batch must be a non-empty array";
+    return false;
+  }
+  // One message id for every command in the line makes the processor emit a
+  // single ACK (largest est_ms) and CompletionTracker a single DONE once all
+  // motors stopped. Validation and overlap checks run before any motion starts.
+  out = "#" + transport::message_id::Next() + " ";
+  size_t index = 0;
+  std::string line;
+  std::vector<uint8_t> entry_targets;
+  for (ArduinoJson::JsonVariantConst entry : batch.as<ArduinoJson::JsonArrayConst>()) {
+    const std::string prefix = "batch[" + std::to_string(index) + "]: ";
+    const char* entry_action_c = entry["action"].as<const char*>();
+    if (!entry.is<ArduinoJson::JsonObjectConst>() || !entry_action_c) {
+      error = prefix + "action required";
+      return false;
+    }
+    const std::string entry_action = ToUpper(std::string(entry_action_c));
+    bool ok = false;
+    if (entry_action == "MOVE") {
+      ok = buildMoveCommand(entry["params"], line, entry_targets, error);
+    } else if (entry_action == "HOME") {
+      ok = buildHomeCommand(entry["params"], line, entry_targets, error);
+    } else {
+      error = "only MOVE and HOME can be batched";
+    }
+    if (!ok) {
+      error = prefix + error;
+      return false;
+    }
+    if (index > 0) {
+      out.push_back(';');
+    }
+    out.append(line);
+    targets.insert(targets.end(), entry_targets.begin(), entry_targets.end());
+    ++index;
+  }
+  return true;
+}
+
 bool MqttCommandServer::buildCommandLine(const std::string& action,
                                          ArduinoJson::JsonVariantConst params,
                                          std::string& out,
@@ -1183,14 +2016,21 @@ bool MqttCommandServer::buildCommandLine(const std::string& action,
                                          bool& unsupported) const {
   targets.clear();
   unsupported = false;
-  if (action == "MOVE") {
-    return buildMoveCommand(params, out, targets, error);
-  }
-  if (action == "HOME") {
-    return buildHomeCommand(params, out, targets, error);
-  }
-  if (action == "WAKE" || action == "SLEEP") {
-    return buildWakeSleepCommand(action, params, out, targets, error);
+  if (action == "MOVE" || action == "HOME" || action == "WAKE" || action == "SLEEP") {
+    bool ok = false;
+    if (action == "MOVE") {
+      ok = buildMoveCommand(params, out, targets, error);
+    } else if (action == "HOME") {
+      ok = buildHomeCommand(params, out, targets, error);
+    } else {
+      ok = buildWakeSleepCommand(action, params, out, targets, error);
+    }
+    // A target list expands into several commands; one id for all of them
+    // gives a single ACK and DONE, as for a batch.
+    if (ok && out.find(';') != std::string::npos) {
+      out.insert(0, "#" + transport::message_id::Next() + " ");
+    }
+    return ok;
   }
   if (action.rfind("NET:", 0) == 0) {
     return buildNetCommand(action, params, out, error, unsupported);
@@ -1236,8 +2076,13 @@ void MqttCommandServer::ensureStream(const std::string& cmd_id,
                                      const std::string& action,
                                      uint32_t mask,
                                      uint32_t started_ms) {
-  auto it = streams_.find(cmd_id);
+  const uint64_t key = transport::message_id::Hash(cmd_id);
+  auto it = streams_.find(key);
   if (it != streams_.end()) {
+    if (it->second->cmd_id != cmd_id) {
+      // Hash collision with a stream in flight: this command goes without one.
+      return;
+    }
     auto& existing = *it->second;
     if (existing.action.empty()) {
       existing.action = action;
@@ -1260,47 +2105,41 @@ void MqttCommandServer::ensureStream(const std::string& cmd_id,
   stream->saw_event = false;
   stream->ack_published = false;
   stream->done_published = false;
+  stream->coalesce = false;
+  stream->ack_deferred = false;
   stream->response.lines.clear();
   stream->ack_payload.clear();
-  streams_.emplace(cmd_id, std::move(stream));
+  streams_.emplace(key, std::move(stream));
 }
 
-void MqttCommandServer::handleDispatcherEvent(const transport::response::Event& event) {
-  if (event.cmd_id.empty()) {
+void MqttCommandServer::handleDispatcherEvent(const transport::response::Event& event,
+                                              const transport::command::ResponseLine* line) {
+  if (event.cmd_id.empty() || isFastMessage(event.cmd_id)) {
     return;
   }
   constexpr std::size_t kMaxOrphanCommands = 4;
-  std::shared_ptr<DispatchStream> stream;
-  std::string key;
-  auto direct = streams_.find(event.cmd_id);
-  if (direct != streams_.end()) {
-    stream = direct->second;
-    key = direct->first;
-  } else {
-    for (auto& entry : streams_) {
-      if (entry.second && !entry.second->msg_id.empty() && entry.second->msg_id == event.cmd_id) {
-        stream = entry.second;
-        key = entry.first;
-        break;
-      }
-    }
-  }
+  std::shared_ptr<DispatchStream> stream = findStreamFor(event.cmd_id);
   if (!stream) {
-    auto emplace = orphan_events_.emplace(event.cmd_id, std::vector<transport::response::Event>{});
+    if (event.type == transport::response::EventType::kDone && completePending(event)) {
+      return;
+    }
+    auto emplace =
+        orphan_events_.emplace(event.cmd_id.key(), std::vector<transport::response::Event>{});
     if (emplace.second) {
-      orphan_order_.push_back(event.cmd_id);
+      orphan_order_.push_back(event.cmd_id.key());
       while (orphan_order_.size() > kMaxOrphanCommands) {
-        const std::string& oldest = orphan_order_.front();
-        orphan_events_.erase(oldest);
+        orphan_events_.erase(orphan_order_.front());
         orphan_order_.pop_front();
       }
     }
-    emplace.first->second.push_back(event);
+    // Kept past this call, so the line's fields are copied in.
+    emplace.first->second.push_back(
+        line != nullptr ? transport::response::BuildEvent(*line, event.action) : event);
     return;
   }
-  processStreamEvent(*stream, event);
+  processStreamEvent(*stream, event, line);
   if (event.type == transport::response::EventType::kDone) {
-    streams_.erase(key);
+    eraseStream(stream->cmd_id);
   }
 }
 
@@ -1314,6 +2153,10 @@ void MqttCommandServer::publishAckFromStream(DispatchStream& stream) {
   if (transport::command::FindAckLine(stream.response) == nullptr) {
     return;
   }
+  if (stream.coalesce) {
+    stream.ack_deferred = true;
+    return;
+  }
   std::string action = stream.action.empty() ? "UNKNOWN" : stream.action;
   auto warnings = transport::command::CollectWarnings(stream.response);
   std::string payload =
@@ -1330,11 +2173,9 @@ int32_t MqttCommandServer::extractActualMs(const transport::response::Event* don
   if (!done_event) {
     return -1;
   }
-  auto it = done_event->attributes.find("actual_ms");
-  if (it == done_event->attributes.end()) {
-    return -1;
-  }
-  return static_cast<int32_t>(ParseLong(it->second, -1));
+  int32_t actual_ms = -1;
+  transport::response::ExtractInt(*done_event, "actual_ms", actual_ms);
+  return actual_ms;
 }
 
 void MqttCommandServer::publishCompletionFromStream(DispatchStream& stream,
@@ -1361,6 +2202,8 @@ void MqttCommandServer::publishCompletionFromStream(DispatchStream& stream,
     }
   }
   std::string action = stream.action.empty() ? "UNKNOWN" : stream.action;
+  const transport::command::ResponseLine* coalesced_ack =
+      stream.ack_deferred ? transport::command::FindAckLine(stream.response) : nullptr;
   bool include_snapshot = (stream.mask != 0 && stream.started_ms != 0);
   std::string completion_payload = buildCompletionPayload(stream.cmd_id,
                                                           action,
@@ -1372,41 +2215,64 @@ void MqttCommandServer::publishCompletionFromStream(DispatchStream& stream,
                                                           stream.mask,
                                                           stream.started_ms,
                                                           include_snapshot,
-                                                          actual_ms);
+                                                          actual_ms,
+                                                          coalesced_ack);
   publishCompletion(completion_payload);
   recordCompleted(stream.cmd_id, stream.ack_payload, completion_payload);
   stream.done_published = true;
+  stream.ack_deferred = false;
+}
+
+void MqttCommandServer::finishCoalescing(DispatchStream& stream) {
+  // Dispatch has returned without a DONE, so the held ACK goes out on its own.
+  stream.coalesce = false;
+  if (stream.ack_deferred && !stream.done_published) {
+    stream.ack_deferred = false;
+    publishAckFromStream(stream);
+  }
 }
 
-void MqttCommandServer::bindStreamToMessageId(DispatchStream& stream, const std::string& msg_id) {
+void MqttCommandServer::bindStreamToMessageId(DispatchStream& stream,
+                                              const transport::message_id::Id& msg_id) {
   if (msg_id.empty()) {
     return;
   }
+  const uint64_t stream_key = transport::message_id::Hash(stream.cmd_id);
+  auto bound = stream_by_msg_.find(stream.msg_id.key());
+  if (!stream.msg_id.empty() && bound != stream_by_msg_.end() && bound->second == stream_key) {
+    stream_by_msg_.erase(bound);
+  }
   stream.msg_id = msg_id;
-  auto it = orphan_events_.find(msg_id);
+  stream_by_msg_[msg_id.key()] = stream_key;
+  auto it = orphan_events_.find(msg_id.key());
   if (it == orphan_events_.end()) {
     return;
   }
   for (const auto& evt : it->second) {
-    processStreamEvent(stream, evt);
+    processStreamEvent(stream, evt, nullptr);
   }
   stream.saw_event = true;
-  if (stream.done_published) {
-    streams_.erase(stream.cmd_id);
-  }
   orphan_events_.erase(it);
-  orphan_order_.erase(std::remove(orphan_order_.begin(), orphan_order_.end(), msg_id),
+  orphan_order_.erase(std::remove(orphan_order_.begin(), orphan_order_.end(), msg_id.key()),
                       orphan_order_.end());
+  if (stream.done_published) {
+    eraseStream(stream.cmd_id);
+  }
 }
 
 void MqttCommandServer::processStreamEvent(DispatchStream& stream,
-                                           const transport::response::Event& event) {
+                                           const transport::response::Event& event,
+                                           const transport::command::ResponseLine* line) {
+  response_encoding_ = stream.encoding;
   stream.saw_event = true;
   if (!event.action.empty() && stream.action.empty()) {
     stream.action = event.action;
   }
-  transport::command::ResponseLine line = transport::response::EventToLine(event);
-  stream.response.lines.push_back(line);
+  if (line != nullptr) {
+    stream.response.lines.push_back(*line);
+  } else {
+    stream.response.lines.push_back(transport::response::EventToLine(event));
+  }
   switch (event.type) {
   case transport::response::EventType::kAck:
     publishAckFromStream(stream);
@@ -1444,57 +2310,33 @@ MqttCommandServer::collectDataLines(const transport::command::Response& response
   return out;
 }
 
-void MqttCommandServer::finalizeCompleted(uint32_t now_ms) {
-  for (auto it = pending_.begin(); it != pending_.end();) {
-    if (!it->awaiting_motor_finish) {
-      ++it;
-      continue;
-    }
-    if (processor_.controller().isAnyMovingForMask(it->mask)) {
-      ++it;
-      continue;
-    }
-
-    auto warnings = transport::command::CollectWarnings(it->response);
-    auto errors = collectErrors(it->response);
-    auto data_lines = collectDataLines(it->response);
-    int32_t actual_ms = -1;
-    if (it->mask != 0) {
-      actual_ms = 0;
-      bool any_actual = false;
-      size_t count = processor_.controller().motorCount();
-      for (size_t idx = 0; idx < count; ++idx) {
-        if (idx >= 32 || !(it->mask & (1u << idx))) {
-          continue;
-        }
-        const MotorState& state = processor_.controller().state(idx);
-        if (!state.last_op_ongoing) {
-          any_actual = true;
-          if (state.last_op_last_ms > actual_ms) {
-            actual_ms = state.last_op_last_ms;
-          }
-        }
-      }
-      if (!any_actual) {
-        actual_ms = -1;
-      }
-    }
-    std::string completion_payload =
-        buildCompletionPayload(it->cmd_id,
-                               it->action,
-                               it->response,
-                               transport::command::CompletionStatus::kOk,
-                               warnings,
-                               errors,
-                               data_lines,
-                               it->mask,
-                               it->started_ms,
-                               true,
-                               actual_ms);
-    publishCompletion(completion_payload);
-    recordCompleted(it->cmd_id, it->ack_payload, completion_payload);
-    it = pending_.erase(it);
+bool MqttCommandServer::completePending(const transport::response::Event& done) {
+  auto it = std::find_if(pending_.begin(), pending_.end(), [&](const PendingCompletion& pending) {
+    return !pending.msg_id.empty() && pending.msg_id == done.cmd_id;
+  });
+  if (it == pending_.end()) {
+    return false;
   }
+  response_encoding_ = it->encoding;
+  auto warnings = transport::command::CollectWarnings(it->response);
+  auto errors = collectErrors(it->response);
+  auto data_lines = collectDataLines(it->response);
+  std::string completion_payload =
+      buildCompletionPayload(it->cmd_id.text,
+                             it->action,
+                             it->response,
+                             transport::command::CompletionStatus::kOk,
+                             warnings,
+                             errors,
+                             data_lines,
+                             it->mask,
+                             it->started_ms,
+                             true,
+                             extractActualMs(&done));
+  publishCompletion(completion_payload);
+  recordCompleted(it->cmd_id.text, it->ack_payload, completion_payload);
+  pending_.erase(it);
+  return true;
 }
 
 std::string
@@ -1502,31 +2344,17 @@ MqttCommandServer::buildAckPayload(const std::string& cmd_id,
                                    const std::string& action,
                                    const transport::command::Response& response,
                                    std::vector<transport::command::ResponseLine> warnings) const {
-  ArduinoJson::JsonDocument doc;
-  doc["cmd_id"] = cmd_id;
-  doc["action"] = action;
-  doc["status"] = "ack";
-
+  json_buffer_.clear();
+  transport::JsonWriter json(json_buffer_, response_encoding_);
+  json.beginObject().field("cmd_id", cmd_id).field("action", action).field("status", "ack");
   if (const auto* ack = transport::command::FindAckLine(response)) {
-    auto result = doc["result"].to<ArduinoJson::JsonObject>();
-    AppendFields(result, ack->fields);
-  }
-
-  if (!warnings.empty()) {
-    auto arr = doc["warnings"].to<ArduinoJson::JsonArray>();
-    for (const auto& warn : warnings) {
-      auto obj = arr.add<ArduinoJson::JsonObject>();
-      obj["code"] = warn.code;
-      if (!warn.reason.empty()) {
-        obj["reason"] = warn.reason;
-      }
-      AppendFields(obj, warn.fields);
-    }
+    json.beginObject("result");
+    WriteLineFields(json, ack->fields, nullptr);
+    json.endObject();
   }
-
-  std::string out;
-  ArduinoJson::serializeJson(doc, out);
-  return out;
+  WriteWarnings(json, warnings);
+  json.endObject();
+  return json_buffer_;
 }
 
 std::string MqttCommandServer::buildCompletionPayload(
@@ -1540,103 +2368,83 @@ std::string MqttCommandServer::buildCompletionPayload(
     uint32_t mask,
     uint32_t started_ms,
     bool include_motor_snapshot,
-    int32_t actual_ms) {
-  ArduinoJson::JsonDocument doc;
-  doc["cmd_id"] = cmd_id;
-  doc["action"] = action;
-  doc["status"] = statusToString(status);
-
-  if (!warnings.empty()) {
-    auto arr = doc["warnings"].to<ArduinoJson::JsonArray>();
-    for (const auto& warn : warnings) {
-      auto obj = arr.add<ArduinoJson::JsonObject>();
-      obj["code"] = warn.code;
-      if (!warn.reason.empty()) {
-        obj["reason"] = warn.reason;
-      }
-      AppendFields(obj, warn.fields);
+    int32_t actual_ms,
+    const transport::command::ResponseLine* coalesced_ack) {
+  json_buffer_.clear();
+  transport::JsonWriter json(json_buffer_, response_encoding_);
+  json.beginObject()
+      .field("cmd_id", cmd_id)
+      .field("action", action)
+      .field("status", statusToString(status));
+  WriteWarnings(json, warnings);
+  WriteErrors(json, errors);
+
+  const bool snapshot = include_motor_snapshot && mask != 0;
+  const bool lines = snapshot || !data_lines.empty() || action == "HELP";
+  const transport::command::ResponseLine* done = lines ? nullptr : FindDoneLine(response);
+  bool result_open = false;
+  auto open_result = [&json, &result_open]() {
+    if (!result_open) {
+      json.beginObject("result");
+      result_open = true;
     }
-  }
-
-  if (!errors.empty()) {
-    auto arr = doc["errors"].to<ArduinoJson::JsonArray>();
-    for (const auto& err : errors) {
-      auto obj = arr.add<ArduinoJson::JsonObject>();
-      obj["code"] = err.code;
-      if (!err.reason.empty()) {
-        obj["reason"] = err.reason;
-      } else if (const auto* desc = transport::command::LookupError(err.code)) {
-        if (desc->reason) {
-          obj["reason"] = desc->reason;
-        }
-      }
-      if (const auto* desc = transport::command::LookupError(err.code)) {
-        if (desc->description) {
-          obj["message"] = desc->description;
-        }
+  };
+  if (coalesced_ack) {
+    // The ACK was never published on its own, so its fields ride along here.
+    // Anything the completion reports itself takes precedence.
+    for (const auto& field : coalesced_ack->fields) {
+      if (transport::command::KeyEquals(field, "status") ||
+          (actual_ms >= 0 && transport::command::KeyEquals(field, "actual_ms")) ||
+          (done && HasField(done->fields, field.key))) {
+        continue;
       }
-      AppendFields(obj, err.fields);
-    }
-  }
-
-  transport::response::CommandResponse contract =
-      transport::response::BuildCommandResponse(response, action);
-  const transport::response::Event* done_event = nullptr;
-  for (const auto& evt : contract.events) {
-    if (evt.type == transport::response::EventType::kDone) {
-      done_event = &evt;
-      break;
+      open_result();
+      WriteFieldValue(json, field);
     }
   }
-
-  if (actual_ms >= 0) {
-    doc["result"]["actual_ms"] = actual_ms;
-  }
-  if (include_motor_snapshot && mask != 0) {
-    doc["result"]["started_ms"] = started_ms;
-  } else if (!data_lines.empty()) {
-    auto lines = doc["result"]["lines"].to<ArduinoJson::JsonArray>();
-    for (const auto& line : data_lines) {
-      lines.add(line.raw);
+  if (lines) {
+    open_result();
+    if (actual_ms >= 0) {
+      json.field("actual_ms", actual_ms);
     }
-  } else if (action == "HELP") {
-    // For HELP, include the same human-readable lines that serial prints.
-    // Prefer info/raw lines (excluding transport control markers) when no data lines exist.
-    auto lines = doc["result"]["lines"].to<ArduinoJson::JsonArray>();
-    for (const auto& line : response.lines) {
-      if (line.type == transport::command::ResponseLineType::kInfo && !line.raw.empty()) {
-        // Skip control-stamped synthetic lines such as CTRL:DONE
-        if (line.raw.rfind("CTRL:", 0) == 0) {
-          continue;
+    if (snapshot) {
+      json.field("started_ms", started_ms);
+    } else if (!data_lines.empty()) {
+      json.beginArray("lines");
+      for (const auto& line : data_lines) {
+        json.value(line.raw);
+      }
+      json.endArray();
+    } else {
+      // For HELP, include the same human-readable lines that serial prints,
+      // skipping control-stamped synthetic lines such as CTRL:DONE.
+      json.beginArray("lines");
+      for (const auto& line : response.lines) {
+        if (line.type == transport::command::ResponseLineType::kInfo && !line.raw.empty() &&
+            line.raw.rfind("CTRL:", 0) != 0) {
+          json.value(line.raw);
         }
-        lines.add(line.raw);
       }
+      json.endArray();
     }
-  } else if (done_event) {
-    auto result_obj = doc["result"].to<ArduinoJson::JsonObject>();
-    for (const auto& kv : done_event->attributes) {
-      if (kv.first == "status") {
+  } else if (done) {
+    // The completion's own attributes replace any actual_ms measured here.
+    for (const auto& field : done->fields) {
+      if (transport::command::KeyEquals(field, "status")) {
         continue;
       }
-      std::string value = Unquote(kv.second);
-      if (IsInteger(value)) {
-        result_obj[kv.first] = ParseLong(value);
-      } else {
-        result_obj[kv.first] = value;
-      }
+      open_result();
+      WriteFieldValue(json, field);
     }
+  } else if (actual_ms >= 0) {
+    open_result();
+    json.field("actual_ms", actual_ms);
   }
-
-  if (doc["result"].is<ArduinoJson::JsonObject>()) {
-    auto result_obj = doc["result"].as<ArduinoJson::JsonObject>();
-    if (!result_obj.isNull() && result_obj.size() == 0) {
-      doc.remove("result");
-    }
+  if (result_open) {
+    json.endObject();
   }
-
-  std::string out;
-  ArduinoJson::serializeJson(doc, out);
-  return out;
+  json.endObject();
+  return json_buffer_;
 }
 
 std::string MqttCommandServer::statusToString(transport::command::CompletionStatus status) const {
@@ -0,0 +1,254 @@
+#include "mqtt/ResponseCache.h"
+
+#include <cstring>
+
+namespace mqtt {
+
+namespace {
+
+constexpr size_t kNoSlot = static_cast<size_t>(-1);
+
+size_t TableSizeFor(size_t max_entries) {
+  size_t size = 4;
+  while (size < max_entries * 2) {
+    size <<= 1;
+  }
+  return size;
+}
+
+}  // namespace
+
+ResponseCache::ResponseCache(size_t max_entries, size_t arena_bytes)
+    : max_entries_(arena_bytes > 0 ? max_entries : 0) {
+  if (max_entries_ > 0) {
+    slots_.resize(TableSizeFor(max_entries_));
+    arena_.resize(arena_bytes);
+  }
+}
+
+void ResponseCache::clear() {
+  for (auto& slot : slots_) {
+    slot.used = false;
+  }
+  count_ = 0;
+  head_ = 0;
+  tail_ = 0;
+  used_ = 0;
+}
+
+bool ResponseCache::put(uint64_t hash,
+                        const std::string& cmd_id,
+                        const std::string& ack,
+                        const std::string& completion) {
+  if (max_entries_ == 0) {
+    return false;
+  }
+  const size_t bytes = sizeof(Header) + cmd_id.size() + ack.size() + completion.size();
+  if (bytes > arena_.size()) {
+    return false;
+  }
+  const size_t existing = findSlot(hash, cmd_id);
+  if (existing != kNoSlot) {
+    // The old record stays in the ring unreferenced until the tail passes it.
+    eraseSlot(existing);
+  }
+  while (count_ >= max_entries_ && evictOldest()) {
+  }
+  const uint32_t offset = append(hash,
+                                 cmd_id.data(),
+                                 cmd_id.size(),
+                                 ack.data(),
+                                 ack.size(),
+                                 completion.data(),
+                                 completion.size());
+  insertSlot(hash, offset);
+  return true;
+}
+
+bool ResponseCache::find(uint64_t hash, const std::string& cmd_id, View& out) {
+  const size_t index = findSlot(hash, cmd_id);
+  if (index == kNoSlot) {
+    return false;
+  }
+  uint32_t offset = slots_[index].offset;
+  const Header header = headerAt(offset);
+  if (offset + header.total != head_) {
+    scratch_.assign(arena_.data() + offset, header.total);
+    eraseSlot(index);
+    const char* id = scratch_.data() + sizeof(Header);
+    const char* ack = id + header.id_len;
+    const char* completion = ack + header.ack_len;
+    offset = append(hash,
+                    id,
+                    header.id_len,
+                    ack,
+                    header.ack_len,
+                    completion,
+                    header.completion_len);
+    insertSlot(hash, offset);
+  }
+  out = viewAt(offset);
+  return true;
+}
+
+bool ResponseCache::contains(uint64_t hash, const std::string& cmd_id) const {
+  return findSlot(hash, cmd_id) != kNoSlot;
+}
+
+size_t ResponseCache::findSlot(uint64_t hash, const std::string& cmd_id) const {
+  if (slots_.empty()) {
+    return kNoSlot;
+  }
+  const size_t mask = slots_.size() - 1;
+  for (size_t i = hash & mask; slots_[i].used; i = (i + 1) & mask) {
+    if (slots_[i].hash != hash) {
+      continue;
+    }
+    const Header header = headerAt(slots_[i].offset);
+    if (header.id_len == cmd_id.size() &&
+        std::memcmp(arena_.data() + slots_[i].offset + sizeof(Header),
+                    cmd_id.data(),
+                    cmd_id.size()) == 0) {
+      return i;
+    }
+  }
+  return kNoSlot;
+}
+
+size_t ResponseCache::slotForOffset(uint64_t hash, uint32_t offset) const {
+  const size_t mask = slots_.size() - 1;
+  for (size_t i = hash & mask; slots_[i].used; i = (i + 1) & mask) {
+    if (slots_[i].offset == offset) {
+      return i;
+    }
+  }
+  return kNoSlot;
+}
+
+void ResponseCache::eraseSlot(size_t index) {
+  // Backward-shift deletion keeps probe chains intact without tombstones.
+  const size_t mask = slots_.size() - 1;
+  size_t hole = index;
+  for (size_t j = (index + 1) & mask; slots_[j].used; j = (j + 1) & mask) {
+    const size_t home = slots_[j].hash & mask;
+    const bool stays = hole <= j ? (home > hole && home <= j) : (home > hole || home <= j);
+    if (!stays) {
+      slots_[hole] = slots_[j];
+      hole = j;
+    }
+  }
+  slots_[hole].used = false;
+  --count_;
+}
+
+void ResponseCache::insertSlot(uint64_t hash, uint32_t offset) {
+  const size_t mask = slots_.size() - 1;
+  size_t i = hash & mask;
+  while (slots_[i].used) {
+    i = (i + 1) & mask;
+  }
+  slots_[i].hash = hash;
+  slots_[i].offset = offset;
+  slots_[i].used = true;
+  ++count_;
+}
+
+ResponseCache::Header ResponseCache::headerAt(uint32_t offset) const {
+  Header header;
+  std::memcpy(&header, arena_.data() + offset, sizeof(header));
+  return header;
+}
+
+bool ResponseCache::reserve(size_t bytes, uint32_t& offset) {
+  const size_t capacity = arena_.size();
+  for (;;) {
+    if (used_ == 0) {
+      head_ = 0;
+      tail_ = 0;
+    }
+    // Free space is [head_, capacity) + [0, tail_) when the ring has not
+    // wrapped, [head_, tail_) when it has; head_ == tail_ means empty or full.
+    const bool wrapped = used_ != 0 && head_ <= tail_;
+    const size_t end = wrapped ? tail_ : capacity;
+    if (end - head_ >= bytes) {
+      offset = static_cast<uint32_t>(head_);
+      head_ += bytes;
+      used_ += bytes;
+      return true;
+    }
+    if (!wrapped) {
+      // Too little room before the end: pad it out and continue at the start.
+      const size_t pad = capacity - head_;
+      if (pad >= sizeof(Header)) {
+        Header marker{};
+        std::memcpy(arena_.data() + head_, &marker, sizeof(marker));
+      }
+      used_ += pad;
+      head_ = 0;
+      continue;
+    }
+    if (!evictOldest()) {
+      return false;
+    }
+  }
+}
+
+bool ResponseCache::evictOldest() {
+  if (used_ == 0) {
+    return false;
+  }
+  const size_t capacity = arena_.size();
+  if (capacity - tail_ < sizeof(Header) || headerAt(static_cast<uint32_t>(tail_)).total == 0) {
+    used_ -= capacity - tail_;
+    tail_ = 0;
+    return true;
+  }
+  const Header header = headerAt(static_cast<uint32_t>(tail_));
+  const size_t slot = slotForOffset(header.hash, static_cast<uint32_t>(tail_));
+  if (slot != kNoSlot) {
+    eraseSlot(slot);
+  }
+  used_ -= header.total;
+  tail_ += header.total;
+  if (tail_ == capacity) {
+    tail_ = 0;
+  }
+  return true;
+}
+
+uint32_t ResponseCache::append(uint64_t hash,
+                               const char* id,
+                               size_t id_len,
+                               const char* ack,
+                               size_t ack_len,
+                               const char* completion,
+                               size_t completion_len) {
+  Header header;
+  header.hash = hash;
+  header.total = static_cast<uint32_t>(sizeof(Header) + id_len + ack_len + completion_len);
+  header.id_len = static_cast<uint32_t>(id_len);
+  header.ack_len = static_cast<uint32_t>(ack_len);
+  header.completion_len = static_cast<uint32_t>(completion_len);
+  uint32_t offset = 0;
+  // Callers checked the record fits the arena, so reserve() only fails if empty.
+  (void)reserve(header.total, offset);
+  char* out = arena_.data() + offset;
+  std::memcpy(out, &header, sizeof(header));
+  out += sizeof(header);
+  std::memcpy(out, id, id_len);
+  std::memcpy(out + id_len, ack, ack_len);
+  std::memcpy(out + id_len + ack_len, completion, completion_len);
+  return offset;
+}
+
+ResponseCache::View ResponseCache::viewAt(uint32_t offset) const {
+  const Header header = headerAt(offset);
+  View view;
+  view.ack = arena_.data() + offset + sizeof(Header) + header.id_len;
+  view.ack_len = header.ack_len;
+  view.completion = view.ack + header.ack_len;
+  view.completion_len = header.completion_len;
+  return view;
+}
+
+}  // namespace mqtt
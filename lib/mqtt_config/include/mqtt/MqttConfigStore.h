@@ -1,20 +1,44 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <mutex>
 #include <string>
+#include <vector>
 
 namespace mqtt {
 
+// Group names become topics (groups/<name>/cmd), so they are limited to
+// [A-Za-z0-9_-] and a handful per node.
+constexpr size_t kMaxCommandGroups = 4;
+constexpr size_t kMaxGroupNameLength = 32;
+
+// Ceiling for the adaptive status rate; the publisher backs off below it.
+constexpr uint16_t kMinStatusMaxHz = 1;
+constexpr uint16_t kMaxStatusMaxHz = 50;
+
+// Status topic modes: the aggregate devices/<id>/status, per-motor
+// devices/<id>/motors/<n>/status, or both.
+constexpr const char* kStatusTopicsAggregate = "aggregate";
+constexpr const char* kStatusTopicsMotors = "motors";
+constexpr const char* kStatusTopicsBoth = "both";
+
 struct BrokerConfig {
   std::string host;
   uint16_t port = 0;
   std::string user;
   std::string pass;
+  // Comma-separated command groups this node also listens to; empty for none.
+  std::string groups;
+  uint16_t status_max_hz = 0;
+  std::string status_topics;
   bool host_overridden = false;
   bool port_overridden = false;
   bool user_overridden = false;
   bool pass_overridden = false;
+  bool groups_overridden = false;
+  bool status_max_hz_overridden = false;
+  bool status_topics_overridden = false;
 };
 
 struct ConfigUpdate {
@@ -33,8 +57,29 @@ struct ConfigUpdate {
   bool pass_set = false;
   bool pass_use_default = false;
   std::string pass;
+
+  bool groups_set = false;
+  bool groups_use_default = false;
+  std::string groups;
+
+  bool status_max_hz_set = false;
+  bool status_max_hz_use_default = false;
+  uint16_t status_max_hz = 0;
+
+  bool status_topics_set = false;
+  bool status_topics_use_default = false;
+  std::string status_topics;
 };
 
+// Splits a comma-separated group list, trimming blanks and dropping empty entries.
+std::vector<std::string> SplitGroups(const std::string& groups);
+bool IsValidGroupName(const std::string& name);
+// Lower-cases a status topic mode; returns false unless it names one of the modes above.
+bool NormalizeStatusTopics(const std::string& value, std::string& out);
+// True when host, port, user or password differ, i.e. the broker session must be re-established.
+// Groups and status settings are applied live and do not count.
+bool ConnectionSettingsChanged(const BrokerConfig& applied, const BrokerConfig& next);
+
 class ConfigStore {
 public:
   static ConfigStore& Instance();
@@ -54,6 +54,30 @@ struct DefaultsProvider {
     return MQTT_BROKER_PASS;
 #else
     return "";
+#endif
+  }
+
+  static std::string Groups() {
+#ifdef MQTT_COMMAND_GROUPS
+    return MQTT_COMMAND_GROUPS;
+#else
+    return "";
+#endif
+  }
+
+  static uint16_t StatusMaxHz() {
+#ifdef MQTT_STATUS_MAX_HZ
+    return static_cast<uint16_t>(MQTT_STATUS_MAX_HZ);
+#else
+    return 20;
+#endif
+  }
+
+  static std::string StatusTopics() {
+#ifdef MQTT_STATUS_TOPICS
+    return MQTT_STATUS_TOPICS;
+#else
+    return kStatusTopicsAggregate;
 #endif
   }
 };
@@ -168,15 +192,96 @@ uint16_t ParsePort(const std::string& value, uint16_t fallback) {
   return static_cast<uint16_t>(parsed);
 }
 
+uint16_t ParseStatusMaxHz(const std::string& value, uint16_t fallback) {
+  if (value.empty()) {
+    return fallback;
+  }
+  char* end = nullptr;
+  long parsed = std::strtol(value.c_str(), &end, 10);
+  if (!end || *end != '\0' || parsed < kMinStatusMaxHz || parsed > kMaxStatusMaxHz) {
+    return fallback;
+  }
+  return static_cast<uint16_t>(parsed);
+}
+
 void ApplyDefaultFlags(const BrokerConfig& defaults, BrokerConfig& config) {
   config.host_overridden = (config.host != defaults.host);
   config.port_overridden = (config.port != defaults.port);
   config.user_overridden = (config.user != defaults.user);
   config.pass_overridden = (config.pass != defaults.pass);
+  config.groups_overridden = (config.groups != defaults.groups);
+  config.status_max_hz_overridden = (config.status_max_hz != defaults.status_max_hz);
+  config.status_topics_overridden = (config.status_topics != defaults.status_topics);
+}
+
+std::string JoinGroups(const std::vector<std::string>& names) {
+  std::string out;
+  for (const auto& name : names) {
+    if (!out.empty()) {
+      out.push_back(',');
+    }
+    out.append(name);
+  }
+  return out;
 }
 
 }  // namespace
 
+std::vector<std::string> SplitGroups(const std::string& groups) {
+  std::vector<std::string> names;
+  size_t pos = 0;
+  while (pos <= groups.size()) {
+    size_t comma = groups.find(',', pos);
+    if (comma == std::string::npos) {
+      comma = groups.size();
+    }
+    size_t start = pos;
+    size_t end = comma;
+    while (start < end && std::isspace(static_cast<unsigned char>(groups[start]))) {
+      ++start;
+    }
+    while (end > start && std::isspace(static_cast<unsigned char>(groups[end - 1]))) {
+      --end;
+    }
+    if (end > start) {
+      names.emplace_back(groups.substr(start, end - start));
+    }
+    pos = comma + 1;
+  }
+  return names;
+}
+
+bool IsValidGroupName(const std::string& name) {
+  if (name.empty() || name.size() > kMaxGroupNameLength) {
+    return false;
+  }
+  for (char c : name) {
+    if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_' && c != '-') {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool NormalizeStatusTopics(const std::string& value, std::string& out) {
+  std::string lower;
+  lower.reserve(value.size());
+  for (char c : value) {
+    lower.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(c))));
+  }
+  if (lower != kStatusTopicsAggregate && lower != kStatusTopicsMotors &&
+      lower != kStatusTopicsBoth) {
+    return false;
+  }
+  out = lower;
+  return true;
+}
+
+bool ConnectionSettingsChanged(const BrokerConfig& applied, const BrokerConfig& next) {
+  return applied.host != next.host || applied.port != next.port || applied.user != next.user ||
+         applied.pass != next.pass;
+}
+
 ConfigStore& ConfigStore::Instance() {
   static ConfigStore store;
   return store;
@@ -187,10 +292,18 @@ ConfigStore::ConfigStore() {
   defaults_.port = DefaultsProvider::Port();
   defaults_.user = DefaultsProvider::User();
   defaults_.pass = DefaultsProvider::Pass();
+  defaults_.groups = JoinGroups(SplitGroups(DefaultsProvider::Groups()));
+  defaults_.status_max_hz = DefaultsProvider::StatusMaxHz();
+  if (!NormalizeStatusTopics(DefaultsProvider::StatusTopics(), defaults_.status_topics)) {
+    defaults_.status_topics = kStatusTopicsAggregate;
+  }
   defaults_.host_overridden = false;
   defaults_.port_overridden = false;
   defaults_.user_overridden = false;
   defaults_.pass_overridden = false;
+  defaults_.groups_overridden = false;
+  defaults_.status_max_hz_overridden = false;
+  defaults_.status_topics_overridden = false;
   current_ = defaults_;
   revision_ = 1;
 }
@@ -276,6 +389,32 @@ bool ConfigStore::validateUpdate(const ConfigUpdate& update, std::string* error)
       return false;
     }
   }
+  if (update.groups_set && !update.groups_use_default) {
+    const std::vector<std::string> names = SplitGroups(update.groups);
+    if (names.size() > kMaxCommandGroups) {
+      setError("too many groups");
+      return false;
+    }
+    for (const auto& name : names) {
+      if (!IsValidGroupName(name)) {
+        setError("invalid group name " + name);
+        return false;
+      }
+    }
+  }
+  if (update.status_max_hz_set && !update.status_max_hz_use_default) {
+    if (update.status_max_hz < kMinStatusMaxHz || update.status_max_hz > kMaxStatusMaxHz) {
+      setError("status_max_hz out of range");
+      return false;
+    }
+  }
+  if (update.status_topics_set && !update.status_topics_use_default) {
+    std::string normalized;
+    if (!NormalizeStatusTopics(update.status_topics, normalized)) {
+      setError("invalid status_topics " + update.status_topics);
+      return false;
+    }
+  }
   if (error)
     error->clear();
   return true;
@@ -316,6 +455,29 @@ BrokerConfig ConfigStore::mergeUpdate(const ConfigUpdate& update, std::string* e
     }
   }
 
+  if (update.groups_set) {
+    if (update.groups_use_default) {
+      merged.groups = defaults_.groups;
+    } else {
+      merged.groups = JoinGroups(SplitGroups(update.groups));
+    }
+  }
+
+  if (update.status_max_hz_set) {
+    if (update.status_max_hz_use_default) {
+      merged.status_max_hz = defaults_.status_max_hz;
+    } else {
+      merged.status_max_hz = update.status_max_hz;
+    }
+  }
+
+  if (update.status_topics_set) {
+    if (update.status_topics_use_default ||
+        !NormalizeStatusTopics(update.status_topics, merged.status_topics)) {
+      merged.status_topics = defaults_.status_topics;
+    }
+  }
+
   ApplyDefaultFlags(defaults_, merged);
   if (error)
     error->clear();
@@ -366,6 +528,25 @@ BrokerConfig ConfigStore::loadLocked() {
     cfg.pass = defaults_.pass;
   }
 
+  if (prefs.hasKey("groups")) {
+    cfg.groups = prefs.getString("groups", defaults_.groups);
+  } else {
+    cfg.groups = defaults_.groups;
+  }
+
+  if (prefs.hasKey("status_hz")) {
+    cfg.status_max_hz =
+        ParseStatusMaxHz(prefs.getString("status_hz", ""), defaults_.status_max_hz);
+  } else {
+    cfg.status_max_hz = defaults_.status_max_hz;
+  }
+
+  cfg.status_topics = defaults_.status_topics;
+  if (prefs.hasKey("status_topics") &&
+      !NormalizeStatusTopics(prefs.getString("status_topics", ""), cfg.status_topics)) {
+    cfg.status_topics = defaults_.status_topics;
+  }
+
   prefs.end();
 
   ApplyDefaultFlags(defaults_, cfg);
@@ -396,6 +577,15 @@ bool ConfigStore::persistLocked(const BrokerConfig& config) {
 
   writeString("user", config.user_overridden, config.user);
   writeString("pass", config.pass_overridden, config.pass);
+  writeString("groups", config.groups_overridden, config.groups);
+
+  if (config.status_max_hz_overridden) {
+    prefs.putString("status_hz",
+                    std::to_string(static_cast<unsigned long long>(config.status_max_hz)));
+  } else {
+    prefs.remove("status_hz");
+  }
+  writeString("status_topics", config.status_topics_overridden, config.status_topics);
 
   prefs.end();
   return true;
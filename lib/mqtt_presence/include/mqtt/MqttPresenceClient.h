@@ -1,5 +1,8 @@
 #pragma once
 
+#include "mqtt/PublishMessage.h"
+#include "mqtt/PublishQueue.h"
+
 #include <array>
 #include <cstdint>
 #include <functional>
@@ -11,14 +14,6 @@ class NetOnboarding;
 
 namespace mqtt {
 
-struct PublishMessage {
-  std::string topic;
-  std::string payload;
-  uint8_t qos = 0;
-  bool retain = false;
-  bool is_status = false;
-};
-
 class MqttPresenceClient {
 public:
   using PublishFn = std::function<bool(const PublishMessage&)>;
@@ -97,10 +92,16 @@ public:
   void loop(uint32_t now_ms);
   void updateMotionState(bool active);
   void updatePowerState(bool active);
+  // Returns false when the queue dropped or refused the message.
   bool enqueuePublish(const PublishMessage& msg);
   const std::string& statusTopic() const;
   const std::string& offlinePayload() const;
   bool subscribe(const std::string& topic, uint8_t qos, MessageCallback cb);
+  // Successful broker connections so far; a change means the session was re-established.
+  uint32_t connectCount() const;
+  // Messages waiting for the broker; a growing backlog means publishers should slow down.
+  size_t queuedPublishes() const;
+  PublishQueue::Stats publishQueueStats() const;
 
 private:
   class Impl;
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace mqtt {
+
+// How a queued message is treated while the broker link is backed up; the
+// publish queue sends the classes in this order.
+enum class PublishPriority : uint8_t {
+  kResponse = 0,   // ACK/DONE: never evicted, refused only when nothing else can make room
+  kSequenced = 1,  // delta-mode status: each builds on the last, so never superseded or evicted
+  kStatus = 2,     // telemetry: the latest message per topic wins
+  kInfo = 3,       // logs and counters: dropped first
+};
+
+struct PublishMessage {
+  std::string topic;
+  std::string payload;
+  uint8_t qos = 0;
+  bool retain = false;
+  PublishPriority priority = PublishPriority::kResponse;
+};
+
+}  // namespace mqtt
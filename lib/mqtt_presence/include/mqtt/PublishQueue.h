@@ -0,0 +1,102 @@
+#pragma once
+
+#include "mqtt/PublishMessage.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace mqtt {
+
+// Outgoing messages waiting for the broker, held in a fixed slab of slots
+// whose topic and payload buffers are reserved up front and reused, so a
+// steady stream of publishes does not allocate. Each priority class is a FIFO
+// threaded through the slots; the next message is always taken from the most
+// important non-empty class.
+//
+// When every slot is taken:
+// - a response evicts the oldest info message, then the oldest status; it is
+//   never evicted itself and is refused (counted, push returns false) only
+//   when all slots hold responses or sequenced statuses
+// - a sequenced status evicts like a response, but is itself never evicted or
+//   replaced; at most a quarter of the slots hold them, beyond that they are
+//   refused so the sender can retry with a newer one
+// - a status replaces the queued status for the same topic, otherwise evicts
+//   the oldest info message or is dropped
+// - an info message is dropped
+class PublishQueue {
+public:
+  struct Stats {
+    // Responses refused because every slot held a response.
+    uint32_t responses_refused = 0;
+    uint32_t sequenced_refused = 0;
+    uint32_t status_dropped = 0;
+    uint32_t info_dropped = 0;
+    // Statuses that replaced a queued status for the same topic.
+    uint32_t status_superseded = 0;
+    size_t high_water = 0;
+  };
+
+  PublishQueue(size_t slots, size_t payload_reserve, size_t topic_reserve = 64);
+
+  PublishQueue(const PublishQueue&) = delete;
+  PublishQueue& operator=(const PublishQueue&) = delete;
+
+  // Copies into a slot's reserved buffers. Returns false when the message was
+  // dropped or refused.
+  bool push(const PublishMessage& msg);
+
+  // Next message to send, or nullptr when empty. Stays valid until pop().
+  const PublishMessage* front() const;
+  void pop();
+
+  bool empty() const {
+    return count_ == 0;
+  }
+  size_t size() const {
+    return count_;
+  }
+  size_t capacity() const {
+    return slots_.size();
+  }
+  const Stats& stats() const {
+    return stats_;
+  }
+  void clear();
+
+private:
+  static constexpr uint16_t kNone = 0xFFFF;
+  static constexpr size_t kClasses = 4;
+
+  struct Slot {
+    PublishMessage msg;
+    size_t topic_hash = 0;
+    uint16_t next = kNone;
+  };
+  struct List {
+    uint16_t head = kNone;
+    uint16_t tail = kNone;
+    uint16_t size = 0;
+  };
+
+  // Picks the slot msg goes to, evicting or replacing as described above;
+  // kNone when it is dropped. Sets replaced when the slot is already linked.
+  uint16_t claimSlot(const PublishMessage& msg, size_t topic_hash, bool& replaced);
+  uint16_t findStatus(const std::string& topic, size_t topic_hash) const;
+  uint16_t popHead(PublishPriority priority);
+  void append(PublishPriority priority, uint16_t index);
+  static size_t classIndex(PublishPriority priority) {
+    return static_cast<size_t>(priority);
+  }
+
+  std::vector<Slot> slots_;
+  std::array<List, kClasses> lists_{};
+  uint16_t free_ = kNone;
+  size_t sequenced_limit_ = 1;
+  size_t count_ = 0;
+  Stats stats_;
+};
+
+}  // namespace mqtt
@@ -1,15 +1,13 @@
 #include "mqtt/MqttPresenceClient.h"
 
-#include "mqtt/PublishQueuePolicy.h"
-
 #include "mqtt/MqttConfigStore.h"
 #include "net_onboarding/NetOnboarding.h"
 #include "net_onboarding/SerialImmediate.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cctype>
 #include <cstring>
-#include <deque>
 #include <string>
 #include <utility>
 #include <vector>
@@ -32,6 +30,11 @@ constexpr const char* kOfflinePayloadJson = "{\"node_state\":\"offline\",\"motor
 constexpr uint32_t kInitialReconnectDelayMs = 1000;
 constexpr uint32_t kMaxReconnectDelayMs = 30000;
 constexpr size_t kMaxQueuedMessages = 32;
+// Reserved per queue slot up front; a longer payload grows its slot once.
+constexpr size_t kQueuedPayloadReserve = 256;
+// Inbound messages arrive in TCP-sized chunks and are put back together up to
+// this size; larger ones are dropped with a warning.
+constexpr size_t kMaxInboundPayload = 16384;
 
 }  // namespace
 
@@ -59,7 +62,7 @@ MqttPresenceClient::MqttPresenceClient(net_onboarding::NetOnboarding& net,
   ready_publish_.topic = topic_;
   ready_publish_.retain = false;
   ready_publish_.qos = 0;
-  ready_publish_.is_status = true;
+  ready_publish_.priority = PublishPriority::kStatus;
   offline_payload_ = BuildOfflinePayload();
   last_ip_ = "0.0.0.0";
   updateIdentityIfNeeded();
@@ -207,7 +210,7 @@ void MqttPresenceClient::updateIdentityIfNeeded() {
       mac_topic_ = normalized;
       topic_ = std::string(kTopicPrefix) + mac_topic_ + kTopicSuffix;
       ready_publish_.topic = topic_;
-      ready_publish_.is_status = true;
+      ready_publish_.priority = PublishPriority::kStatus;
       publish_pending_ = true;
       if (connected_) {
         immediate_requested_ = true;
@@ -337,9 +340,14 @@ public:
   }
 
   bool enqueue(const PublishMessage& msg) {
-    return EnqueuePublishMessage(publish_queue_, kMaxQueuedMessages, msg);
+    const bool queued = publish_queue_.push(msg);
+    if (!queued && msg.priority == PublishPriority::kResponse) {
+      logRefused(msg.topic);
+    }
+    return queued;
   }
 
+
   bool
   subscribe(const std::string& topic, uint8_t qos, AsyncMqttPresenceClient::MessageCallback cb) {
     if (topic.empty() || !cb) {
@@ -356,10 +364,22 @@ public:
     return logic_.topic();
   }
 
+  uint32_t connectCount() const {
+    return connect_count_.load(std::memory_order_relaxed);
+  }
+
   const std::string& offlinePayload() const {
     return logic_.offlinePayload();
   }
 
+  size_t queuedPublishes() const {
+    return publish_queue_.size();
+  }
+
+  const PublishQueue::Stats& publishQueueStats() const {
+    return publish_queue_.stats();
+  }
+
 private:
   void logDisconnected(AsyncMqttClientDisconnectReason reason) {
     std::string line("CTRL: MQTT_DISCONNECTED");
@@ -393,6 +413,16 @@ private:
     log(line);
   }
 
+  // Responses are only refused when every queue slot already holds one; the
+  // command's cached responses can still be replayed by resending its cmd_id.
+  void logRefused(const std::string& topic) {
+    std::string line("CTRL:WARN MQTT_RESPONSE_REFUSED topic=");
+    line += topic;
+    line += " queued=";
+    line += std::to_string(publish_queue_.size());
+    log(line);
+  }
+
   bool publish(const PublishMessage& pub) {
     if (!client_.connected()) {
       return false;
@@ -414,14 +444,15 @@ private:
       reconnect_backoff_ms_ = kInitialReconnectDelayMs;
       next_reconnect_ms_ = 0;
       std::string broker_info;
-      if (!broker_host_.empty()) {
-        broker_info = broker_host_;
+      if (!broker_.host.empty()) {
+        broker_info = broker_.host;
       }
-      broker_info += ":" + std::to_string(broker_port_);
+      broker_info += ":" + std::to_string(broker_.port);
       logic_.handleConnected(millis(), broker_info);
       for (const auto& sub : subscriptions_) {
         client_.subscribe(sub.topic.c_str(), sub.qos);
       }
+      connect_count_.fetch_add(1, std::memory_order_relaxed);
     });
     client_.onDisconnect([this](AsyncMqttClientDisconnectReason reason) {
       bool was_connected = connect_succeeded_;
@@ -456,11 +487,26 @@ private:
                              size_t len,
                              size_t index,
                              size_t total) {
+      if (total > kMaxInboundPayload) {
+        if (index + len == total) {
+          log(std::string("CTRL:WARN MQTT_PAYLOAD_DROPPED bytes=") + std::to_string(total) +
+              " topic=" + (topic ? topic : ""));
+        }
+        return;
+      }
+      if (index == 0) {
+        inbound_payload_.clear();
+        inbound_payload_.reserve(total);
+      }
+      if (payload && len) {
+        inbound_payload_.append(payload, len);
+      }
       if (index + len != total) {
         return;  // wait for final chunk
       }
       std::string topic_str(topic ? topic : "");
-      std::string payload_str(payload && len ? std::string(payload, payload + len) : std::string());
+      std::string payload_str;
+      payload_str.swap(inbound_payload_);
       for (const auto& sub : subscriptions_) {
         if (topic_str == sub.topic && sub.callback) {
           sub.callback(topic_str, payload_str);
@@ -519,43 +565,40 @@ private:
   }
 
   void applyBrokerConfig(const mqtt::BrokerConfig& cfg, bool force_reconnect) {
-    bool host_changed = (cfg.host != broker_host_) || (cfg.port != broker_port_);
-    bool user_changed = (cfg.user != broker_user_);
-    bool pass_changed = (cfg.pass != broker_pass_);
-    if (!host_changed && !user_changed && !pass_changed && !force_reconnect) {
+    if (!force_reconnect && !mqtt::ConnectionSettingsChanged(broker_, cfg)) {
       return;
     }
 
-    broker_host_ = cfg.host;
-    broker_port_ = cfg.port;
-    broker_user_ = cfg.user;
-    broker_pass_ = cfg.pass;
+    broker_.host = cfg.host;
+    broker_.port = cfg.port;
+    broker_.user = cfg.user;
+    broker_.pass = cfg.pass;
 
-    client_.setServer(broker_host_.c_str(), broker_port_);
-    if (!broker_user_.empty() || !broker_pass_.empty()) {
-      const char* user_ptr = broker_user_.empty() ? "" : broker_user_.c_str();
-      const char* pass_ptr = broker_pass_.empty() ? nullptr : broker_pass_.c_str();
+    client_.setServer(broker_.host.c_str(), broker_.port);
+    if (!broker_.user.empty() || !broker_.pass.empty()) {
+      const char* user_ptr = broker_.user.empty() ? "" : broker_.user.c_str();
+      const char* pass_ptr = broker_.pass.empty() ? nullptr : broker_.pass.c_str();
       client_.setCredentials(user_ptr, pass_ptr);
     } else {
       client_.setCredentials("", nullptr);
     }
 
-    if (host_changed || user_changed || pass_changed || force_reconnect) {
-      if (client_.connected()) {
-        client_.disconnect();
-      }
-      connect_attempted_ = false;
-      connect_succeeded_ = false;
-      next_reconnect_ms_ = 0;
-      reconnect_backoff_ms_ = kInitialReconnectDelayMs;
+    if (client_.connected()) {
+      client_.disconnect();
     }
+    connect_attempted_ = false;
+    connect_succeeded_ = false;
+    next_reconnect_ms_ = 0;
+    reconnect_backoff_ms_ = kInitialReconnectDelayMs;
   }
 
+  // Every SET_CONFIG bumps the revision, including groups and status settings that
+  // never touch the connection; only a changed broker address or login reconnects.
   void maybeRefreshBrokerConfig() {
     uint32_t revision = mqtt::ConfigStore::Instance().Revision();
     if (revision != last_config_revision_) {
       mqtt::BrokerConfig cfg = mqtt::ConfigStore::Instance().Current();
-      applyBrokerConfig(cfg, true);
+      applyBrokerConfig(cfg, false);
       last_config_revision_ = revision;
     }
   }
@@ -571,35 +614,33 @@ private:
     if (!client_.connected()) {
       return;
     }
-    while (!publish_queue_.empty()) {
-      PublishMessage msg = std::move(publish_queue_.front());
-      publish_queue_.pop_front();
-      auto payload_len = static_cast<uint16_t>(msg.payload.size());
-      uint16_t packet_id =
-          client_.publish(msg.topic.c_str(), msg.qos, msg.retain, msg.payload.c_str(), payload_len);
+    while (const PublishMessage* msg = publish_queue_.front()) {
+      auto payload_len = static_cast<uint16_t>(msg->payload.size());
+      uint16_t packet_id = client_.publish(
+          msg->topic.c_str(), msg->qos, msg->retain, msg->payload.c_str(), payload_len);
       if (packet_id == 0) {
-        publish_queue_.push_front(std::move(msg));
         break;
       }
+      publish_queue_.pop();
     }
   }
 
   std::string connectionSummary() const {
     std::string summary;
-    if (!broker_host_.empty() || broker_port_ != 0) {
+    if (!broker_.host.empty() || broker_.port != 0) {
       summary += "broker=";
-      if (!broker_host_.empty()) {
-        summary += broker_host_;
+      if (!broker_.host.empty()) {
+        summary += broker_.host;
       }
       summary += ":";
-      summary += std::to_string(broker_port_);
+      summary += std::to_string(broker_.port);
     }
-    if (!broker_user_.empty()) {
+    if (!broker_.user.empty()) {
       if (!summary.empty()) {
         summary += " ";
       }
       summary += "user=";
-      summary += broker_user_;
+      summary += broker_.user;
     }
     if (!client_id_.empty()) {
       if (!summary.empty()) {
@@ -616,7 +657,7 @@ private:
   LogFn log_fn_;
   AsyncMqttClient client_;
   MqttPresenceClient logic_;
-  std::deque<PublishMessage> publish_queue_;
+  PublishQueue publish_queue_{kMaxQueuedMessages, kQueuedPayloadReserve};
   struct Subscription {
     Subscription() = default;
     Subscription(std::string t, uint8_t q, AsyncMqttPresenceClient::MessageCallback cb)
@@ -626,17 +667,18 @@ private:
     AsyncMqttPresenceClient::MessageCallback callback;
   };
   std::vector<Subscription> subscriptions_;
+  // Chunks of the inbound message being received.
+  std::string inbound_payload_;
   string last_will_topic_;
-  string broker_host_;
-  string broker_user_;
-  string broker_pass_;
-  uint16_t broker_port_ = 0;
+  // Last applied settings; only the connection fields are kept current.
+  mqtt::BrokerConfig broker_;
   string client_id_;
   uint32_t last_config_revision_ = 0;
   uint32_t next_reconnect_ms_ = 0;
   uint32_t reconnect_backoff_ms_ = kInitialReconnectDelayMs;
   bool connect_attempted_ = false;
   bool connect_succeeded_ = false;
+  std::atomic<uint32_t> connect_count_{0};
 };
 
 AsyncMqttPresenceClient::AsyncMqttPresenceClient(net_onboarding::NetOnboarding& net, LogFn log)
@@ -685,6 +727,18 @@ const std::string& AsyncMqttPresenceClient::offlinePayload() const {
   return impl_->offlinePayload();
 }
 
+uint32_t AsyncMqttPresenceClient::connectCount() const {
+  return impl_ ? impl_->connectCount() : 0;
+}
+
+size_t AsyncMqttPresenceClient::queuedPublishes() const {
+  return impl_ ? impl_->queuedPublishes() : 0;
+}
+
+PublishQueue::Stats AsyncMqttPresenceClient::publishQueueStats() const {
+  return impl_ ? impl_->publishQueueStats() : PublishQueue::Stats{};
+}
+
 bool AsyncMqttPresenceClient::subscribe(const std::string& topic, uint8_t qos, MessageCallback cb) {
   if (!impl_) {
     return false;
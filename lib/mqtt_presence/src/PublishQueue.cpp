@@ -0,0 +1,166 @@
+#include "mqtt/PublishQueue.h"
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+
+namespace mqtt {
+
+PublishQueue::PublishQueue(size_t slots, size_t payload_reserve, size_t topic_reserve)
+    : slots_(std::min<size_t>(slots, kNone)),
+      sequenced_limit_(std::max<size_t>(1, slots_.size() / 4)) {
+  for (auto& slot : slots_) {
+    slot.msg.topic.reserve(topic_reserve);
+    slot.msg.payload.reserve(payload_reserve);
+  }
+  clear();
+}
+
+void PublishQueue::clear() {
+  for (auto& list : lists_) {
+    list = List{};
+  }
+  free_ = kNone;
+  for (size_t i = slots_.size(); i-- > 0;) {
+    slots_[i].msg.topic.clear();
+    slots_[i].msg.payload.clear();
+    slots_[i].next = free_;
+    free_ = static_cast<uint16_t>(i);
+  }
+  count_ = 0;
+}
+
+bool PublishQueue::push(const PublishMessage& msg) {
+  const size_t hash =
+      msg.priority == PublishPriority::kStatus ? std::hash<std::string>{}(msg.topic) : 0;
+  bool replaced = false;
+  const uint16_t index = claimSlot(msg, hash, replaced);
+  if (index == kNone) {
+    return false;
+  }
+  Slot& slot = slots_[index];
+  slot.msg.topic.assign(msg.topic);
+  slot.msg.payload.assign(msg.payload);
+  slot.msg.qos = msg.qos;
+  slot.msg.retain = msg.retain;
+  slot.msg.priority = msg.priority;
+  slot.topic_hash = hash;
+  if (!replaced) {
+    append(msg.priority, index);
+  }
+  return true;
+}
+
+const PublishMessage* PublishQueue::front() const {
+  for (const auto& list : lists_) {
+    if (list.head != kNone) {
+      return &slots_[list.head].msg;
+    }
+  }
+  return nullptr;
+}
+
+void PublishQueue::pop() {
+  for (size_t cls = 0; cls < kClasses; ++cls) {
+    if (lists_[cls].head == kNone) {
+      continue;
+    }
+    const uint16_t index = popHead(static_cast<PublishPriority>(cls));
+    Slot& slot = slots_[index];
+    slot.msg.topic.clear();
+    slot.msg.payload.clear();
+    slot.next = free_;
+    free_ = index;
+    return;
+  }
+}
+
+uint16_t PublishQueue::claimSlot(const PublishMessage& msg, size_t topic_hash, bool& replaced) {
+  if (msg.priority == PublishPriority::kStatus) {
+    const uint16_t queued = findStatus(msg.topic, topic_hash);
+    if (queued != kNone) {
+      replaced = true;
+      ++stats_.status_superseded;
+      return queued;
+    }
+  }
+  if (msg.priority == PublishPriority::kSequenced &&
+      lists_[classIndex(PublishPriority::kSequenced)].size >= sequenced_limit_) {
+    ++stats_.sequenced_refused;
+    return kNone;
+  }
+  if (free_ != kNone) {
+    const uint16_t index = free_;
+    free_ = slots_[index].next;
+    return index;
+  }
+  const bool info_queued = lists_[classIndex(PublishPriority::kInfo)].head != kNone;
+  switch (msg.priority) {
+  case PublishPriority::kResponse:
+  case PublishPriority::kSequenced:
+    if (info_queued) {
+      ++stats_.info_dropped;
+      return popHead(PublishPriority::kInfo);
+    }
+    if (lists_[classIndex(PublishPriority::kStatus)].head != kNone) {
+      ++stats_.status_dropped;
+      return popHead(PublishPriority::kStatus);
+    }
+    if (msg.priority == PublishPriority::kSequenced) {
+      ++stats_.sequenced_refused;
+    } else {
+      ++stats_.responses_refused;
+    }
+    return kNone;
+  case PublishPriority::kStatus:
+    if (info_queued) {
+      ++stats_.info_dropped;
+      return popHead(PublishPriority::kInfo);
+    }
+    ++stats_.status_dropped;
+    return kNone;
+  case PublishPriority::kInfo:
+    break;
+  }
+  ++stats_.info_dropped;
+  return kNone;
+}
+
+uint16_t PublishQueue::findStatus(const std::string& topic, size_t topic_hash) const {
+  for (uint16_t i = lists_[classIndex(PublishPriority::kStatus)].head; i != kNone;
+       i = slots_[i].next) {
+    if (slots_[i].topic_hash == topic_hash && slots_[i].msg.topic == topic) {
+      return i;
+    }
+  }
+  return kNone;
+}
+
+uint16_t PublishQueue::popHead(PublishPriority priority) {
+  List& list = lists_[classIndex(priority)];
+  const uint16_t index = list.head;
+  list.head = slots_[index].next;
+  if (list.head == kNone) {
+    list.tail = kNone;
+  }
+  slots_[index].next = kNone;
+  --list.size;
+  --count_;
+  return index;
+}
+
+void PublishQueue::append(PublishPriority priority, uint16_t index) {
+  List& list = lists_[classIndex(priority)];
+  slots_[index].next = kNone;
+  if (list.tail == kNone) {
+    list.head = index;
+  } else {
+    slots_[list.tail].next = index;
+  }
+  list.tail = index;
+  ++list.size;
+  ++count_;
+  stats_.high_water = std::max(stats_.high_water, count_);
+}
+
+}  // namespace mqtt
@@ -1,23 +1,69 @@
 #pragma once
 
 #include "MotorControl/MotorController.h"
+#include "MotorControl/StatusCadence.h"
 #include "mqtt/MqttPresenceClient.h"
 #include "net_onboarding/NetOnboarding.h"
+#include "transport/JsonWriter.h"
+#include "transport/PayloadEncoding.h"
 
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <string>
+#include <vector>
 
 namespace mqtt {
 
 class MqttStatusPublisher {
 public:
   using PublishFn = std::function<bool(const PublishMessage&)>;
+  // Messages still waiting in the client's publish queue.
+  using QueueDepthFn = std::function<size_t()>;
 
   struct Config {
     uint32_t idle_interval_ms = 1000;   // 1 Hz when idle
     uint32_t motion_interval_ms = 200;  // 5 Hz during motion
     size_t max_motors = 8;
+    // MessagePack snapshots go to the status topic plus kMsgPackTopicSuffix.
+#if defined(MQTT_STATUS_MSGPACK) && MQTT_STATUS_MSGPACK
+    transport::PayloadEncoding encoding = transport::PayloadEncoding::kMsgPack;
+#else
+    transport::PayloadEncoding encoding = transport::PayloadEncoding::kJson;
+#endif
+    // Delta mode: each status carries a "seq" number and only the motors and
+    // fields that changed since the previous one. A full keyframe ("key": true)
+    // goes out at least every keyframe_interval_ms and after forceImmediate().
+    // "seq" and the delta base only advance once the client queued the
+    // message, which it then never replaces (PublishPriority::kSequenced).
+#if defined(MQTT_STATUS_DELTA) && MQTT_STATUS_DELTA
+    bool delta = true;
+#else
+    bool delta = false;
+#endif
+    uint32_t keyframe_interval_ms = 10000;
+    // Adaptive cadence: changed snapshots go out at most max_rate_hz while
+    // idle and for boost_ms after any motor starts or stops, and at the motion
+    // rate (1000 / motion_interval_ms) in between. A publish queue holding
+    // backlog_depth or more messages, or a failed publish, halves the rate;
+    // each quiet recover_ms doubles it again. The effective rate is sent as
+    // "rate_hz".
+    uint32_t max_rate_hz = 20;
+    uint32_t boost_ms = 1000;
+    size_t backlog_depth = 2;
+    uint32_t recover_ms = 1000;
+    // Where status goes: the aggregate topic, and/or one retained
+    // <device>/motors/<id>/status per motor, sent only when that motor's
+    // fields changed. Both follow the cadence above.
+    bool aggregate_topic = true;
+    bool motor_topics = false;
+    // An unchanged motor is re-sent every motor_refresh_ms, so a retained
+    // status the publish queue had to give up is replaced. At most
+    // motor_topics_per_pass go out per pass; the rest follow at the current
+    // rate rather than filling the queue at once.
+    uint32_t motor_refresh_ms = 10000;
+    size_t motor_topics_per_pass = 8;
   };
 
   MqttStatusPublisher(PublishFn publish, net_onboarding::NetOnboarding& net);
@@ -25,38 +71,135 @@ public:
 
   void setTopic(const std::string& topic);
   void forceImmediate();
+  // Makes the next delta-mode status a keyframe, e.g. when a consumer saw a
+  // gap in "seq". Safe to call from the MQTT client task.
+  void requestKeyframe();
 
   void loop(const MotorController& controller, uint32_t now_ms);
 
+  void setQueueDepthFn(QueueDepthFn fn);
+  // Ceiling for the adaptive rate, e.g. from MQTT:SET_CONFIG status_max_hz.
+  void setMaxRateHz(uint32_t hz);
+  // Selects the aggregate and per-motor topics, e.g. from MQTT:SET_CONFIG status_topics.
+  void setTopicModes(bool aggregate, bool motor_topics);
+  uint32_t rateHz() const {
+    return rate_hz_;
+  }
+
   const std::string& lastPayload() const {
     return last_payload_;
   }
   uint32_t lastPublishMs() const {
-    return last_publish_ms_;
+    return cadence_.lastSentMs();
+  }
+  // Sequence number the next delta-mode status will carry.
+  uint32_t nextSeq() const {
+    return seq_;
   }
 
 private:
-  bool buildSnapshot(const MotorController& controller, bool& out_motion_active);
-  bool publish();
-  void appendMotorJson(const MotorState& state,
-                       int32_t budget_tenths,
-                       int32_t ttfc_tenths,
-                       bool include_actual_ms,
-                       std::string& out);
-  static void appendFixedTenths(int32_t tenths, std::string& out);
+  // The reported fields of one motor, kept for the previous status so delta
+  // payloads can leave out what did not change.
+  struct MotorFields {
+    uint8_t id = 0;
+    long position = 0;
+    bool moving = false;
+    bool awake = false;
+    bool homed = false;
+    int32_t steps_since_home = 0;
+    int32_t budget_tenths = 0;
+    int32_t ttfc_tenths = 0;
+    int speed = 0;
+    int accel = 0;
+    uint32_t est_ms = 0;
+    uint32_t started_ms = 0;
+    long target = 0;
+    int32_t velocity = 0;
+    uint32_t eta_ms = 0;
+    bool has_actual_ms = false;
+    uint32_t actual_ms = 0;
+
+    bool operator==(const MotorFields& other) const;
+  };
+
+  // Re-reads what changed since the last call and re-serializes those motors.
+  // Returns false when nothing reported changed, leaving the cached snapshot
+  // valid; the controller's change sequence and the network status revision
+  // let that be decided without reading any state.
+  bool refreshState(const MotorController& controller, uint32_t now_ms);
+  // Re-evaluates the effective rate; returns true when it changed.
+  bool adaptRate(uint32_t now_ms);
+  void backOff(uint32_t now_ms);
+  static void captureMotor(const MotorState& state, MotorFields& out);
+  void buildSnapshot(bool keyframe);
+  void buildDelta();
+  bool publish(uint32_t now_ms);
+  // Publishes the motors whose fields changed since their last per-motor
+  // status, or that are due a refresh, up to motor_topics_per_pass.
+  bool publishMotorTopics(uint32_t now_ms);
+  // Hands msg to the client and counts it towards the current pass.
+  bool send(const PublishMessage& msg, uint32_t now_ms);
+  static void appendMotorJson(const MotorFields& motor, transport::JsonWriter& json);
+  static void appendMotorDelta(const MotorFields& motor,
+                               const MotorFields& previous,
+                               transport::JsonWriter& json);
 
 private:
   PublishFn publish_;
+  QueueDepthFn queue_depth_;
   net_onboarding::NetOnboarding& net_;
   Config cfg_;
 
   std::string topic_;
+  std::string publish_topic_;
+  // "<device>/motors/"; the id and "/status" are appended per publish.
+  std::string motor_topic_prefix_;
+  std::string motor_scratch_;
+  std::vector<MotorFields> motor_topic_sent_;
+  std::vector<uint32_t> motor_topic_sent_ms_;
+  // Motors owed a status regardless of change, e.g. after a topic switch.
+  std::vector<uint8_t> motor_topic_owed_;
+  size_t motor_topic_cursor_ = 0;
+  bool motor_topics_pending_ = true;
+  // Some due motors were left for a later pass by motor_topics_per_pass.
+  bool motor_topics_backlog_ = false;
+  uint32_t motor_topics_pass_ms_ = 0;
   std::string scratch_;
   std::string last_payload_;
-  std::size_t last_hash_ = 0;
-  bool has_last_hash_ = false;
-  uint32_t last_publish_ms_ = 0;
-  bool force_immediate_ = true;
+  motor::StatusCadence cadence_;
+
+  std::string ip_;
+  std::vector<MotorFields> motors_;
+  // Encoded motor objects and the motorChangeSeq() each was built at; the
+  // snapshot is stitched together from these.
+  std::vector<std::string> fragments_;
+  std::vector<uint32_t> fragment_seq_;
+  bool built_ = false;
+  uint32_t built_change_seq_ = 0;
+  uint32_t built_net_revision_ = 0;
+  bool motion_active_ = false;
+  uint32_t moving_mask_ = 0;
+  uint32_t boost_mask_ = 0;
+  uint32_t boost_start_ms_ = 0;
+  bool boosting_ = false;
+  uint32_t rate_hz_ = 0;
+  uint32_t ceiling_hz_ = 0;
+  uint32_t last_rate_adjust_ms_ = 0;
+  // Messages queued by the latest pass; they are not backlog until they had
+  // one interval to drain.
+  uint32_t last_pass_ms_ = 0;
+  size_t last_pass_queued_ = 0;
+  uint32_t published_rate_hz_ = 0;
+  // When the reported state last changed; sent as "ts_ms".
+  uint32_t sample_ms_ = 0;
+  uint32_t published_sample_ms_ = 0;
+  std::size_t snapshot_hash_ = 0;
+  std::string published_ip_;
+  std::vector<MotorFields> published_motors_;
+  uint32_t seq_ = 0;
+  uint32_t last_keyframe_ms_ = 0;
+  bool keyframe_pending_ = true;
+  std::atomic<bool> keyframe_requested_{false};
 };
 
 }  // namespace mqtt
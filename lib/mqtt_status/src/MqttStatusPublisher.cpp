@@ -1,10 +1,11 @@
 #include "mqtt/MqttStatusPublisher.h"
 
+#include "MotorControl/MotionKinematics.h"
 #include "MotorControl/MotorControlConstants.h"
+#include "transport/JsonWriter.h"
 
 #include <algorithm>
 #include <cmath>
-#include <functional>
 #include <utility>
 
 namespace mqtt {
@@ -12,32 +13,28 @@ namespace mqtt {
 namespace {
 
 constexpr const char* kDefaultIp = "0.0.0.0";
+constexpr const char* kStatusLeaf = "/status";
+constexpr size_t kStatusLeafLength = 7;
+
+// Changed snapshots are never spaced closer than 1 ms.
+constexpr uint32_t kMaxRateHz = 1000;
 
 uint32_t clampInterval(uint32_t value, uint32_t fallback) {
   return value == 0 ? fallback : value;
 }
 
-void AppendUnsignedDigits(std::string& out, unsigned long long value) {
-  char buffer[21];
+// Motor ids are uint8_t, so the key never needs more than three digits.
+size_t FormatMotorKey(uint8_t id, char (&out)[4]) {
   size_t len = 0;
-  do {
-    buffer[len++] = static_cast<char>('0' + (value % 10ULL));
-    value /= 10ULL;
-  } while (value != 0ULL);
-  while (len > 0) {
-    out.push_back(buffer[--len]);
+  if (id >= 100) {
+    out[len++] = static_cast<char>('0' + id / 100);
   }
-}
-
-void AppendSignedDigits(std::string& out, long long value) {
-  unsigned long long magnitude;
-  if (value < 0) {
-    out.push_back('-');
-    magnitude = static_cast<unsigned long long>(-(value + 1LL)) + 1ULL;
-  } else {
-    magnitude = static_cast<unsigned long long>(value);
+  if (id >= 10) {
+    out[len++] = static_cast<char>('0' + (id / 10) % 10);
   }
-  AppendUnsignedDigits(out, magnitude);
+  out[len++] = static_cast<char>('0' + id % 10);
+  out[len] = '\0';
+  return len;
 }
 
 }  // namespace
@@ -54,6 +51,12 @@ MqttStatusPublisher::MqttStatusPublisher(PublishFn publish,
   }
   cfg_.idle_interval_ms = clampInterval(cfg_.idle_interval_ms, 1000);
   cfg_.motion_interval_ms = clampInterval(cfg_.motion_interval_ms, 200);
+  cfg_.max_rate_hz = std::max<uint32_t>(1, std::min(cfg_.max_rate_hz, kMaxRateHz));
+  ceiling_hz_ = cfg_.max_rate_hz;
+  motor::StatusCadence::Config cadence;
+  cadence.idle_interval_ms = cfg_.idle_interval_ms;
+  cadence.motion_interval_ms = cfg_.motion_interval_ms;
+  cadence_.configure(cadence);
   scratch_.reserve(256);
   last_payload_.reserve(256);
 }
@@ -61,176 +64,494 @@ MqttStatusPublisher::MqttStatusPublisher(PublishFn publish,
 void MqttStatusPublisher::setTopic(const std::string& topic) {
   if (topic != topic_) {
     topic_ = topic;
-    force_immediate_ = true;
+    publish_topic_ = topic.empty() ? topic : transport::EncodedTopic(topic, cfg_.encoding);
+    // devices/<id>/status -> devices/<id>/motors/
+    motor_topic_prefix_ = topic;
+    if (motor_topic_prefix_.size() >= kStatusLeafLength &&
+        motor_topic_prefix_.compare(motor_topic_prefix_.size() - kStatusLeafLength,
+                                    kStatusLeafLength,
+                                    kStatusLeaf) == 0) {
+      motor_topic_prefix_.resize(motor_topic_prefix_.size() - kStatusLeafLength);
+    }
+    motor_topic_prefix_.append("/motors/");
+    forceImmediate();
   }
 }
 
 void MqttStatusPublisher::forceImmediate() {
-  force_immediate_ = true;
+  cadence_.force();
+  keyframe_pending_ = true;
+  motor_topics_pending_ = true;
+}
+
+void MqttStatusPublisher::setQueueDepthFn(QueueDepthFn fn) {
+  queue_depth_ = std::move(fn);
+}
+
+void MqttStatusPublisher::setMaxRateHz(uint32_t hz) {
+  hz = std::max<uint32_t>(1, std::min(hz, kMaxRateHz));
+  if (hz != cfg_.max_rate_hz) {
+    cfg_.max_rate_hz = hz;
+    ceiling_hz_ = hz;
+  }
+}
+
+void MqttStatusPublisher::setTopicModes(bool aggregate, bool motor_topics) {
+  if (aggregate == cfg_.aggregate_topic && motor_topics == cfg_.motor_topics) {
+    return;
+  }
+  cfg_.aggregate_topic = aggregate;
+  cfg_.motor_topics = motor_topics;
+  forceImmediate();
+}
+
+void MqttStatusPublisher::requestKeyframe() {
+  keyframe_requested_.store(true, std::memory_order_relaxed);
 }
 
 void MqttStatusPublisher::loop(const MotorController& controller, uint32_t now_ms) {
   if (topic_.empty()) {
     return;
   }
-  bool motion_active = false;
-  if (!buildSnapshot(controller, motion_active)) {
+  const bool state_changed = refreshState(controller, now_ms);
+  // The rate is reported in the snapshot, so a new rate is a change too.
+  if (adaptRate(now_ms) || state_changed) {
+    buildSnapshot(false);
+    snapshot_hash_ = std::hash<std::string>{}(scratch_);
+  }
+
+  if (keyframe_requested_.exchange(false, std::memory_order_relaxed)) {
+    keyframe_pending_ = true;
+    cadence_.force();
+  }
+  if (!cadence_.dueHashed(snapshot_hash_, motion_active_, now_ms)) {
+    // Motors held back by motor_topics_per_pass follow at the current rate.
+    if (cfg_.motor_topics && motor_topics_backlog_ &&
+        now_ms - motor_topics_pass_ms_ >= 1000 / std::max<uint32_t>(1, rate_hz_) &&
+        !publishMotorTopics(now_ms)) {
+      backOff(now_ms);
+    }
     return;
   }
+  if (cfg_.motor_topics && !publishMotorTopics(now_ms)) {
+    backOff(now_ms);
+    return;
+  }
+  if (!cfg_.aggregate_topic) {
+    cadence_.markSent(now_ms);
+    return;
+  }
+  // Outside delta mode scratch_ still holds the snapshot the cadence judged;
+  // in delta mode it is replaced by the keyframe or delta actually sent.
+  bool keyframe = false;
+  if (cfg_.delta) {
+    keyframe = keyframe_pending_ || published_motors_.size() != motors_.size() ||
+               now_ms - last_keyframe_ms_ >= cfg_.keyframe_interval_ms;
+    if (keyframe) {
+      buildSnapshot(true);
+    } else {
+      buildDelta();
+    }
+  }
+  if (!publish(now_ms)) {
+    backOff(now_ms);
+    return;
+  }
+  cadence_.markSent(now_ms);
+  last_payload_ = scratch_;
+  if (cfg_.delta) {
+    published_ip_ = ip_;
+    published_motors_ = motors_;
+    published_sample_ms_ = sample_ms_;
+    published_rate_hz_ = rate_hz_;
+    ++seq_;
+    if (keyframe) {
+      keyframe_pending_ = false;
+      last_keyframe_ms_ = now_ms;
+    }
+  }
+}
 
-  std::size_t hash = std::hash<std::string>{}(scratch_);
-  bool changed = !has_last_hash_ || hash != last_hash_;
-  uint32_t interval = motion_active ? cfg_.motion_interval_ms : cfg_.idle_interval_ms;
-  bool due = false;
-  if (!has_last_hash_) {
-    due = true;
-  } else {
-    due = static_cast<uint32_t>(now_ms - last_publish_ms_) >= interval;
+bool MqttStatusPublisher::adaptRate(uint32_t now_ms) {
+  // Any motor starting or stopping opens a window at the full rate, so short
+  // moves are seen at both ends.
+  if (moving_mask_ != boost_mask_) {
+    boost_mask_ = moving_mask_;
+    boost_start_ms_ = now_ms;
+    boosting_ = true;
+  }
+  if (boosting_ && now_ms - boost_start_ms_ >= cfg_.boost_ms) {
+    boosting_ = false;
   }
 
-  if (!force_immediate_ && !changed && !due) {
-    return;
+  size_t depth = queue_depth_ ? queue_depth_() : 0;
+  // A pass that queued several per-motor statuses is not a backlog yet.
+  if (rate_hz_ != 0 && now_ms - last_pass_ms_ < 1000 / rate_hz_) {
+    depth -= std::min(depth, last_pass_queued_);
+  }
+  if (depth >= cfg_.backlog_depth) {
+    backOff(now_ms);
+  } else if (ceiling_hz_ < cfg_.max_rate_hz && now_ms - last_rate_adjust_ms_ >= cfg_.recover_ms) {
+    ceiling_hz_ = std::min(ceiling_hz_ * 2, cfg_.max_rate_hz);
+    last_rate_adjust_ms_ = now_ms;
   }
 
-  if (!publish()) {
-    return;
+  const uint32_t base_hz = std::max<uint32_t>(1, 1000 / cfg_.motion_interval_ms);
+  // Idle changes are rare and go out promptly; steady motion settles at the
+  // motion rate.
+  const bool full = boosting_ || !motion_active_;
+  const uint32_t target_hz = full ? cfg_.max_rate_hz : std::min(base_hz, cfg_.max_rate_hz);
+  const uint32_t rate_hz = std::max<uint32_t>(1, std::min(target_hz, ceiling_hz_));
+  if (rate_hz == rate_hz_) {
+    return false;
   }
+  rate_hz_ = rate_hz;
+  motor::StatusCadence::Config cadence = cadence_.config();
+  cadence.min_interval_ms = 1000 / rate_hz;
+  cadence_.configure(cadence);
+  return true;
+}
 
-  last_hash_ = hash;
-  has_last_hash_ = true;
-  last_payload_ = scratch_;
-  last_publish_ms_ = now_ms;
-  force_immediate_ = false;
+void MqttStatusPublisher::backOff(uint32_t now_ms) {
+  // Halve at most once per current interval so one backlog is not counted on
+  // every loop pass.
+  if (rate_hz_ != 0 && now_ms - last_rate_adjust_ms_ < 1000 / rate_hz_) {
+    return;
+  }
+  const uint32_t current = rate_hz_ != 0 ? std::min(rate_hz_, ceiling_hz_) : ceiling_hz_;
+  ceiling_hz_ = std::max<uint32_t>(1, current / 2);
+  last_rate_adjust_ms_ = now_ms;
 }
 
-bool MqttStatusPublisher::buildSnapshot(const MotorController& controller,
-                                        bool& out_motion_active) {
-  const auto status = net_.status();
-  const char* ip = status.ip[0] ? status.ip.data() : kDefaultIp;
+bool MqttStatusPublisher::refreshState(const MotorController& controller, uint32_t now_ms) {
+  const uint32_t change_seq = controller.changeSeq();
+  const uint32_t net_revision = net_.statusRevision();
+  const size_t motor_count = controller.motorCount();
+  // Controllers that never record changes report sequence 0 and are re-read
+  // on every call.
+  const bool tracked = change_seq != 0;
+  const bool reuse = built_ && tracked && motor_count == motors_.size();
+  if (reuse && change_seq == built_change_seq_ && net_revision == built_net_revision_) {
+    return false;
+  }
+  bool changed = !built_ || motor_count != motors_.size();
+  if (!built_ || net_revision != built_net_revision_) {
+    const auto status = net_.status();
+    const char* ip = status.ip[0] ? status.ip.data() : kDefaultIp;
+    changed = changed || ip_ != ip;
+    ip_.assign(ip);
+  }
 
-  scratch_.clear();
-  scratch_.reserve(128 + cfg_.max_motors * 160);
-  scratch_.append("{\"node_state\":\"ready\",\"ip\":\"");
-  scratch_.append(ip);
-  scratch_.append("\",\"motors\":{");
-
-  out_motion_active = false;
-  bool first = true;
-  size_t motor_count = controller.motorCount();
+  const size_t previous_count = motors_.size();
+  motors_.resize(motor_count);
+  fragments_.resize(motor_count);
+  fragment_seq_.resize(motor_count);
+  bool motion_active = false;
+  uint32_t moving_mask = 0;
   for (size_t idx = 0; idx < motor_count; ++idx) {
-    const MotorState& state = controller.state(idx);
-    if (!first) {
-      scratch_.push_back(',');
+    MotorFields& motor = motors_[idx];
+    const uint32_t motor_seq = controller.motorChangeSeq(idx);
+    if (!reuse || motor_seq != fragment_seq_[idx]) {
+      const MotorFields previous = motor;
+      captureMotor(controller.state(idx), motor);
+      fragment_seq_[idx] = motor_seq;
+      if (!built_ || idx >= previous_count || !(motor == previous)) {
+        changed = true;
+        std::string& fragment = fragments_[idx];
+        fragment.clear();
+        transport::JsonWriter json(fragment, cfg_.encoding);
+        json.beginObject();
+        appendMotorJson(motor, json);
+        json.endObject();
+      }
     }
-    first = false;
-
-    int32_t budget_t = state.budget_tenths;
-    int32_t missing_t = MotorControlConstants::BUDGET_TENTHS_MAX - state.budget_tenths;
-    if (missing_t < 0) {
-      missing_t = 0;
-    }
-    int32_t ttfc_tenths =
-        (missing_t <= 0) ? 0
-                         : static_cast<int32_t>((static_cast<int64_t>(missing_t) * 10 +
-                                                 MotorControlConstants::REFILL_TENTHS_PER_SEC - 1) /
-                                                MotorControlConstants::REFILL_TENTHS_PER_SEC);
-    const int32_t kTtfcMaxTenths = MotorControlConstants::MAX_COOL_DOWN_TIME_S * 10;
-    if (ttfc_tenths > kTtfcMaxTenths) {
-      ttfc_tenths = kTtfcMaxTenths;
+    motion_active = motion_active || motor.moving;
+    if (motor.moving && idx < 32) {
+      moving_mask |= 1u << idx;
     }
+  }
+  motion_active_ = motion_active;
+  moving_mask_ = moving_mask;
+  if (changed) {
+    sample_ms_ = now_ms;
+  }
+  built_ = true;
+  built_change_seq_ = change_seq;
+  built_net_revision_ = net_revision;
+  return changed;
+}
 
-    scratch_.push_back('\"');
-    AppendUnsignedDigits(scratch_, static_cast<unsigned long long>(state.id));
-    scratch_.append("\":{");
-    appendMotorJson(state, budget_t, ttfc_tenths, !state.last_op_ongoing, scratch_);
-    scratch_.push_back('}');
+void MqttStatusPublisher::captureMotor(const MotorState& state, MotorFields& out) {
+  int32_t missing_t = MotorControlConstants::BUDGET_TENTHS_MAX - state.budget_tenths;
+  if (missing_t < 0) {
+    missing_t = 0;
+  }
+  int32_t ttfc_tenths =
+      (missing_t <= 0) ? 0
+                       : static_cast<int32_t>((static_cast<int64_t>(missing_t) * 10 +
+                                               MotorControlConstants::REFILL_TENTHS_PER_SEC - 1) /
+                                              MotorControlConstants::REFILL_TENTHS_PER_SEC);
+  const int32_t kTtfcMaxTenths = MotorControlConstants::MAX_COOL_DOWN_TIME_S * 10;
+  if (ttfc_tenths > kTtfcMaxTenths) {
+    ttfc_tenths = kTtfcMaxTenths;
+  }
+
+  out.id = state.id;
+  out.position = state.position;
+  out.moving = state.moving;
+  out.awake = state.awake;
+  out.homed = state.homed;
+  out.steps_since_home = state.steps_since_home;
+  out.budget_tenths = state.budget_tenths;
+  out.ttfc_tenths = ttfc_tenths;
+  out.speed = state.speed;
+  out.accel = state.accel;
+  out.est_ms = state.last_op_est_ms;
+  out.started_ms = state.last_op_started_ms;
+  // Moving motors carry enough for hosts to extrapolate between samples; the
+  // profile is evaluated by position so an unchanged sample stays identical.
+  out.target = state.moving ? state.last_op_target : state.position;
+  out.velocity = 0;
+  out.eta_ms = 0;
+  if (state.moving && state.last_op_type == 1) {
+    const int64_t done = static_cast<int64_t>(state.position) - state.last_op_start_pos;
+    const int64_t remaining = static_cast<int64_t>(state.last_op_target) - state.position;
+    const uint32_t speed =
+        MotionKinematics::profileSpeedSps(done, remaining, state.speed, state.accel);
+    out.velocity = remaining < 0 ? -static_cast<int32_t>(speed) : static_cast<int32_t>(speed);
+    out.eta_ms = MotionKinematics::remainingMoveTimeMs(remaining, speed, state.speed, state.accel);
+  }
+  out.has_actual_ms = !state.last_op_ongoing;
+  out.actual_ms = state.last_op_last_ms;
+}
 
-    out_motion_active = out_motion_active || state.moving;
+void MqttStatusPublisher::buildSnapshot(bool keyframe) {
+  scratch_.clear();
+  scratch_.reserve(128 + cfg_.max_motors * 200);
+  transport::JsonWriter json(scratch_, cfg_.encoding);
+  json.beginObject()
+      .field("node_state", "ready")
+      .field("ip", ip_)
+      .field("ts_ms", sample_ms_)
+      .field("rate_hz", rate_hz_);
+  if (keyframe) {
+    json.field("seq", seq_).field("key", true);
+  }
+  json.beginObject("motors");
+  for (size_t idx = 0; idx < motors_.size(); ++idx) {
+    char key[4];
+    const size_t key_len = FormatMotorKey(motors_[idx].id, key);
+    json.fieldRaw(key, key_len, fragments_[idx]);
+  }
+  json.endObject().endObject();
+}
+
+void MqttStatusPublisher::buildDelta() {
+  scratch_.clear();
+  transport::JsonWriter json(scratch_, cfg_.encoding);
+  json.beginObject().field("seq", seq_);
+  if (ip_ != published_ip_) {
+    json.field("ip", ip_);
+  }
+  if (sample_ms_ != published_sample_ms_) {
+    json.field("ts_ms", sample_ms_);
+  }
+  if (rate_hz_ != published_rate_hz_) {
+    json.field("rate_hz", rate_hz_);
+  }
+  bool motors_open = false;
+  for (size_t idx = 0; idx < motors_.size(); ++idx) {
+    const MotorFields& motor = motors_[idx];
+    const MotorFields& previous = published_motors_[idx];
+    if (motor == previous) {
+      continue;
+    }
+    if (!motors_open) {
+      json.beginObject("motors");
+      motors_open = true;
+    }
+    char key[4];
+    const size_t key_len = FormatMotorKey(motor.id, key);
+    json.beginObject(key, key_len);
+    appendMotorDelta(motor, previous, json);
+    json.endObject();
   }
+  if (motors_open) {
+    json.endObject();
+  }
+  json.endObject();
+}
 
-  scratch_.append("}}");
+bool MqttStatusPublisher::send(const PublishMessage& msg, uint32_t now_ms) {
+  if (!publish_(msg)) {
+    return false;
+  }
+  if (now_ms != last_pass_ms_) {
+    last_pass_ms_ = now_ms;
+    last_pass_queued_ = 0;
+  }
+  ++last_pass_queued_;
   return true;
 }
 
-bool MqttStatusPublisher::publish() {
+bool MqttStatusPublisher::publish(uint32_t now_ms) {
   if (!publish_) {
     return false;
   }
   PublishMessage msg;
-  msg.topic = topic_;
+  msg.topic = publish_topic_;
   msg.payload = scratch_;
   msg.qos = 0;
   msg.retain = false;
-  msg.is_status = true;
-  return publish_(msg);
-}
-
-void MqttStatusPublisher::appendMotorJson(const MotorState& state,
-                                          int32_t budget_tenths,
-                                          int32_t ttfc_tenths,
-                                          bool include_actual_ms,
-                                          std::string& out) {
-  auto appendBool = [&out](const char* key, bool value) {
-    out.push_back('\"');
-    out.append(key);
-    out.append("\":");
-    out.append(value ? "true" : "false");
-    out.push_back(',');
-  };
-  auto appendInt = [&out](const char* key, long value) {
-    out.push_back('\"');
-    out.append(key);
-    out.append("\":");
-    AppendSignedDigits(out, static_cast<long long>(value));
-    out.push_back(',');
-  };
-
-  appendInt("id", state.id);
-  appendInt("position", state.position);
-  appendBool("moving", state.moving);
-  appendBool("awake", state.awake);
-  appendBool("homed", state.homed);
-  appendInt("steps_since_home", state.steps_since_home);
-
-  out.push_back('\"');
-  out.append("budget_s");
-  out.append("\":");
-  appendFixedTenths(budget_tenths, out);
-  out.push_back(',');
-
-  out.push_back('\"');
-  out.append("ttfc_s");
-  out.append("\":");
-  appendFixedTenths(ttfc_tenths, out);
-  out.push_back(',');
-
-  appendInt("speed", state.speed);
-  appendInt("accel", state.accel);
-  appendInt("est_ms", state.last_op_est_ms);
-  appendInt("started_ms", state.last_op_started_ms);
-  if (include_actual_ms) {
-    out.push_back('\"');
-    out.append("actual_ms");
-    out.append("\":");
-    AppendSignedDigits(out, static_cast<long long>(state.last_op_last_ms));
-    out.push_back(',');
-  }
-  if (!out.empty() && out.back() == ',') {
-    out.pop_back();
-  }
-}
-
-void MqttStatusPublisher::appendFixedTenths(int32_t tenths, std::string& out) {
-  bool neg = tenths < 0;
-  int32_t abs_value = neg ? -tenths : tenths;
-  int32_t whole = abs_value / 10;
-  int32_t frac = abs_value % 10;
-  if (neg) {
-    out.push_back('-');
-  }
-  AppendUnsignedDigits(out, static_cast<unsigned long long>(whole));
-  out.push_back('.');
-  out.push_back(static_cast<char>('0' + frac));
+  // Deltas only make sense after the message they build on, so they must not
+  // be replaced in the queue; a refused one is rebuilt from the same base.
+  msg.priority = cfg_.delta ? PublishPriority::kSequenced : PublishPriority::kStatus;
+  return send(msg, now_ms);
+}
+
+bool MqttStatusPublisher::publishMotorTopics(uint32_t now_ms) {
+  const size_t count = motors_.size();
+  if (motor_topic_sent_.size() != count) {
+    motor_topic_sent_.resize(count);
+    motor_topic_sent_ms_.resize(count);
+    motor_topic_owed_.resize(count);
+    motor_topics_pending_ = true;
+  }
+  if (motor_topics_pending_) {
+    std::fill(motor_topic_owed_.begin(), motor_topic_owed_.end(), 1);
+    motor_topics_pending_ = false;
+  }
+  motor_topics_pass_ms_ = now_ms;
+  motor_topics_backlog_ = false;
+  const size_t limit = std::max<size_t>(1, cfg_.motor_topics_per_pass);
+  size_t sent = 0;
+  // Resume where the previous pass stopped so busy low motors cannot starve the rest.
+  for (size_t n = 0; n < count; ++n) {
+    const size_t idx = (motor_topic_cursor_ + n) % count;
+    const MotorFields& motor = motors_[idx];
+    if (!motor_topic_owed_[idx] && motor == motor_topic_sent_[idx] &&
+        now_ms - motor_topic_sent_ms_[idx] < cfg_.motor_refresh_ms) {
+      continue;
+    }
+    if (sent == limit) {
+      motor_topics_backlog_ = true;
+      motor_topic_cursor_ = idx;
+      break;
+    }
+    char key[4];
+    const size_t key_len = FormatMotorKey(motor.id, key);
+    motor_scratch_.clear();
+    transport::JsonWriter json(motor_scratch_, cfg_.encoding);
+    json.beginObject().field("ts_ms", sample_ms_);
+    appendMotorJson(motor, json);
+    json.endObject();
+
+    PublishMessage msg;
+    msg.topic = motor_topic_prefix_;
+    msg.topic.append(key, key_len).append(kStatusLeaf);
+    msg.topic = transport::EncodedTopic(msg.topic, cfg_.encoding);
+    msg.payload = motor_scratch_;
+    msg.qos = 0;
+    // Retained so a new subscriber sees a motor that has not moved in a while.
+    msg.retain = true;
+    msg.priority = PublishPriority::kStatus;
+    if (!send(msg, now_ms)) {
+      // Motors not yet marked sent are retried on the next pass.
+      motor_topic_cursor_ = idx;
+      return false;
+    }
+    motor_topic_sent_[idx] = motor;
+    motor_topic_sent_ms_[idx] = now_ms;
+    motor_topic_owed_[idx] = 0;
+    ++sent;
+  }
+  return true;
+}
+
+bool MqttStatusPublisher::MotorFields::operator==(const MotorFields& other) const {
+  return id == other.id && position == other.position && moving == other.moving &&
+         awake == other.awake && homed == other.homed &&
+         steps_since_home == other.steps_since_home && budget_tenths == other.budget_tenths &&
+         ttfc_tenths == other.ttfc_tenths && speed == other.speed && accel == other.accel &&
+         est_ms == other.est_ms && started_ms == other.started_ms && target == other.target &&
+         velocity == other.velocity && eta_ms == other.eta_ms &&
+         has_actual_ms == other.has_actual_ms && actual_ms == other.actual_ms;
+}
+
+void MqttStatusPublisher::appendMotorJson(const MotorFields& motor, transport::JsonWriter& json) {
+  json.field("id", motor.id)
+      .field("position", motor.position)
+      .field("moving", motor.moving)
+      .field("awake", motor.awake)
+      .field("homed", motor.homed)
+      .field("steps_since_home", motor.steps_since_home)
+      .fieldTenths("budget_s", motor.budget_tenths)
+      .fieldTenths("ttfc_s", motor.ttfc_tenths)
+      .field("speed", motor.speed)
+      .field("accel", motor.accel)
+      .field("est_ms", motor.est_ms)
+      .field("started_ms", motor.started_ms)
+      .field("target", motor.target)
+      .field("velocity", motor.velocity)
+      .field("eta_ms", motor.eta_ms);
+  if (motor.has_actual_ms) {
+    json.field("actual_ms", motor.actual_ms);
+  }
+}
+
+void MqttStatusPublisher::appendMotorDelta(const MotorFields& motor,
+                                           const MotorFields& previous,
+                                           transport::JsonWriter& json) {
+  if (motor.position != previous.position) {
+    json.field("position", motor.position);
+  }
+  if (motor.moving != previous.moving) {
+    json.field("moving", motor.moving);
+  }
+  if (motor.awake != previous.awake) {
+    json.field("awake", motor.awake);
+  }
+  if (motor.homed != previous.homed) {
+    json.field("homed", motor.homed);
+  }
+  if (motor.steps_since_home != previous.steps_since_home) {
+    json.field("steps_since_home", motor.steps_since_home);
+  }
+  if (motor.budget_tenths != previous.budget_tenths) {
+    json.fieldTenths("budget_s", motor.budget_tenths);
+  }
+  if (motor.ttfc_tenths != previous.ttfc_tenths) {
+    json.fieldTenths("ttfc_s", motor.ttfc_tenths);
+  }
+  if (motor.speed != previous.speed) {
+    json.field("speed", motor.speed);
+  }
+  if (motor.accel != previous.accel) {
+    json.field("accel", motor.accel);
+  }
+  if (motor.est_ms != previous.est_ms) {
+    json.field("est_ms", motor.est_ms);
+  }
+  if (motor.started_ms != previous.started_ms) {
+    json.field("started_ms", motor.started_ms);
+  }
+  if (motor.target != previous.target) {
+    json.field("target", motor.target);
+  }
+  if (motor.velocity != previous.velocity) {
+    json.field("velocity", motor.velocity);
+  }
+  if (motor.eta_ms != previous.eta_ms) {
+    json.field("eta_ms", motor.eta_ms);
+  }
+  // actual_ms is only reported between operations; null marks it withdrawn.
+  if (motor.has_actual_ms) {
+    if (!previous.has_actual_ms || motor.actual_ms != previous.actual_ms) {
+      json.field("actual_ms", motor.actual_ms);
+    }
+  } else if (previous.has_actual_ms) {
+    json.fieldNull("actual_ms");
+  }
 }
 
 }  // namespace mqtt
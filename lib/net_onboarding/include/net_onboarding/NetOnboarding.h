@@ -56,6 +56,11 @@ public:
 
   // Snapshot of current state, RSSI, and IP (connected only).
   Status status() const;
+  // Bumped on every state transition, which covers every IP change, so
+  // pollers can skip re-reading status() while it stays the same.
+  uint32_t statusRevision() const {
+    return status_revision_;
+  }
   void apPassword(std::array<char, 65>& out) const;
   void deviceMac(std::array<char, 18>& out) const;
   void softApSsid(std::array<char, 32>& out) const;
@@ -105,6 +110,7 @@ private:
   Status st_{State::AP_ACTIVE, 0, {'0', '.', '0', '.', '0', '.', '0', '\0'}, {}, {}, {}};
   uint32_t connect_timeout_ms_{10000};
   uint32_t connecting_since_ms_{0};
+  uint32_t status_revision_{0};
 
   // Platform adapters (ESP32 or stub)
   std::unique_ptr<IWifi> wifi_;
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <functional>
 #include <string>
 
 namespace net_onboarding {
@@ -10,4 +11,9 @@ namespace net_onboarding {
 // return value to decide whether to also buffer the line in their response.
 bool PrintCtrlLineImmediate(const std::string& line);
 
+// Routes PrintCtrlLineImmediate through writer (e.g. a buffered serial sink) so
+// all console output stays in order. Pass nullptr to write to Serial directly.
+using CtrlLineWriter = std::function<void(const std::string& line)>;
+void SetCtrlLineWriter(CtrlLineWriter writer);
+
 }  // namespace net_onboarding
@@ -463,6 +463,7 @@ void NetOnboarding::enterApMode_() {
 
   updateIdentity_();
   refreshLedPattern_();
+  ++status_revision_;
 }
 
 void NetOnboarding::enterConnecting_(const char* ssid, const char* pass) {
@@ -495,6 +496,7 @@ void NetOnboarding::enterConnecting_(const char* ssid, const char* pass) {
 
   updateIdentity_();
   refreshLedPattern_();
+  ++status_revision_;
 }
 
 void NetOnboarding::enterConnected_() {
@@ -510,6 +512,7 @@ void NetOnboarding::enterConnected_() {
 
   updateIdentity_();
   refreshLedPattern_();
+  ++status_revision_;
 }
 
 void NetOnboarding::buildApSsid_(std::array<char, 32>& out) const {
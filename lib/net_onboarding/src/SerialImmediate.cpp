@@ -1,13 +1,32 @@
 #include "net_onboarding/SerialImmediate.h"
 
+#include <utility>
+
 #if defined(ARDUINO)
 #include <Arduino.h>
 #endif
 
 namespace net_onboarding {
 
+namespace {
+
+CtrlLineWriter& Writer() {
+  static CtrlLineWriter writer;
+  return writer;
+}
+
+}  // namespace
+
+void SetCtrlLineWriter(CtrlLineWriter writer) {
+  Writer() = std::move(writer);
+}
+
 bool PrintCtrlLineImmediate(const std::string& line) {
 #if defined(ARDUINO)
+  if (Writer()) {
+    Writer()(line);
+    return true;
+  }
   Serial.println(line.c_str());
   return true;
 #else
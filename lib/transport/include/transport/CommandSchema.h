@@ -1,7 +1,15 @@
 #pragma once
 
+#include "transport/MessageId.h"
+#include "transport/SmallVector.h"
+
+#include <cstddef>
+#include <cstdint>
 #include <initializer_list>
+#include <iosfwd>
 #include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace transport {
@@ -9,23 +17,54 @@ namespace command {
 
 enum class ResponseLineType { kAck, kWarn, kError, kInfo, kData, kUnknown };
 
+// Text fields keep the text serial prints; integer fields keep the number, which
+// MQTT JSON and MsgPack write as is. Serial renders it with WriteFieldText().
+enum class FieldKind : uint8_t { kText, kInteger };
+
+// Field names are never owned by a Field: they are string literals, so building
+// a line does not copy its keys.
 struct Field {
-  std::string key;
-  std::string value;
+  const char* key = "";
+  std::string value;   // kText only
+  int64_t number = 0;  // kInteger only
+  FieldKind kind = FieldKind::kText;
+
+  Field() = default;
+  Field(const char* name, std::string text) : key(name), value(std::move(text)) {}
+  template <typename T,
+            typename = typename std::enable_if<std::is_integral<T>::value &&
+                                               !std::is_same<T, bool>::value>::type>
+  Field(const char* name, T integer)
+      : key(name), number(static_cast<int64_t>(integer)), kind(FieldKind::kInteger) {}
 };
 
+bool KeyEquals(const Field& field, const char* key);
+// The value as serial prints it.
+void WriteFieldText(std::ostream& out, const Field& field);
+std::string FieldText(const Field& field);
+
+// Fits ACK/DONE/ERR lines and LAST_OP_TIMING rows. STATUS rows (13 fields) go
+// to the heap; inline room for them would make every line and queued Event
+// several times larger.
+constexpr std::size_t kInlineFieldCapacity = 5;
+// Most commands answer with a single ACK/ERR/DONE line.
+constexpr std::size_t kInlineLineCapacity = 1;
+
+using FieldList = SmallVector<Field, kInlineFieldCapacity>;
+
 struct ResponseLine {
   ResponseLineType type = ResponseLineType::kUnknown;
-  std::string msg_id;
+  message_id::Id msg_id;
   std::string code;
   std::string reason;
-  std::vector<Field> fields;
-  std::vector<std::string> tokens;
+  FieldList fields;
   std::string raw;
 };
 
+using LineList = SmallVector<ResponseLine, kInlineLineCapacity>;
+
 struct Response {
-  std::vector<ResponseLine> lines;
+  LineList lines;
 };
 
 enum class CompletionStatus { kOk, kError, kUnknown };
@@ -40,16 +79,16 @@ struct ErrorDescriptor {
 const std::vector<ErrorDescriptor>& ErrorCatalog();
 const ErrorDescriptor* LookupError(const std::string& code);
 
-ResponseLine MakeAckLine(const std::string& msg_id, std::initializer_list<Field> fields = {});
-ResponseLine MakeWarnLine(const std::string& msg_id,
+ResponseLine MakeAckLine(const message_id::Id& msg_id, std::initializer_list<Field> fields = {});
+ResponseLine MakeWarnLine(const message_id::Id& msg_id,
                           const std::string& code,
                           const std::string& reason,
                           std::initializer_list<Field> fields = {});
-ResponseLine MakeInfoLine(const std::string& msg_id,
+ResponseLine MakeInfoLine(const message_id::Id& msg_id,
                           const std::string& code,
                           const std::string& reason,
                           std::initializer_list<Field> fields = {});
-ResponseLine MakeErrorLine(const std::string& msg_id,
+ResponseLine MakeErrorLine(const message_id::Id& msg_id,
                            const std::string& code,
                            const std::string& reason,
                            std::initializer_list<Field> fields = {});
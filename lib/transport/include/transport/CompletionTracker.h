@@ -1,7 +1,9 @@
 #pragma once
 
 #include "MotorControl/MotorController.h"
+#include "transport/MessageId.h"
 
+#include <array>
 #include <cstdint>
 #include <string>
 #include <vector>
@@ -13,10 +15,18 @@ class CompletionTracker {
 public:
   static CompletionTracker& Instance();
 
-  void RegisterOperation(const std::string& cmd_id,
+  // Starts a new command line. Operations sharing a cmd_id merge into one DONE
+  // only within a line (a batch); a later line reusing a cmd_id that is still
+  // open supersedes the earlier operation instead of widening it.
+  void BeginCommandLine();
+  void RegisterOperation(const message_id::Id& cmd_id,
                          const std::string& action,
                          uint32_t mask,
                          MotorController& controller);
+  // Fed by MotorController::CompletionObserver; resolves the owning
+  // operation in O(1) and queues its DONE once the last motor stops.
+  void OnMotorCompleted(MotorController& controller, const MotorState& state);
+  // Emits DONE events queued by OnMotorCompleted().
   void Tick(uint32_t now_ms);
   void Clear();
   void RemoveController(MotorController* controller);
@@ -24,15 +34,41 @@ public:
 private:
   CompletionTracker() = default;
 
+  static constexpr size_t kMaxMotors = 32;
+  static constexpr int16_t kNoSlot = -1;
+
   struct Pending {
-    std::string cmd_id;
+    message_id::Id cmd_id;
     std::string action;
-    uint32_t mask = 0;
+    uint32_t remaining = 0;  // motors still running
+    // Subset of remaining that a newer operation took over; still awaited, but
+    // the newer operation owns their completion.
+    uint32_t handed_over = 0;
+    int32_t actual_ms = -1;
     MotorController* controller = nullptr;
+    uint32_t line = 0;  // BeginCommandLine() count when registered
     bool active = false;
   };
 
-  std::vector<Pending> pending_;
+  // Which pending slot owns each motor of a controller.
+  struct Owners {
+    MotorController* controller = nullptr;
+    std::array<int16_t, kMaxMotors> slot;
+  };
+
+  int16_t* findOwner(MotorController* controller, uint8_t id);
+  Owners& ownersFor(MotorController* controller);
+  void claim(size_t slot, uint32_t mask);
+  void release(size_t slot);
+  void clearMotor(size_t slot, uint8_t id);
+  void finishHandedOver(MotorController* controller, uint8_t id, int32_t actual_ms);
+
+  std::vector<Pending> pending_;  // slots are reused, so indices stay stable
+  std::vector<Owners> owners_;
+  std::vector<int16_t> ready_;
+  // Motors awaited through handed_over; scanned for only while non-zero.
+  size_t handed_over_count_ = 0;
+  uint32_t line_ = 0;
 };
 
 }  // namespace response
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "transport/PayloadEncoding.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+namespace transport {
+
+// Append-only JSON writer over a caller-owned buffer. Values are written
+// straight into the buffer as they are added, so once a reused buffer has grown
+// to the largest payload, building another allocates nothing. Keys are written
+// verbatim and must not need escaping; string values are escaped.
+//
+// With PayloadEncoding::kMsgPack the same calls produce MessagePack instead.
+// Containers are written with 16-bit length headers that are patched when they
+// close, so nothing has to be counted up front.
+class JsonWriter {
+public:
+  static constexpr size_t kMaxDepth = 8;
+
+  explicit JsonWriter(std::string& out, PayloadEncoding encoding = PayloadEncoding::kJson)
+      : out_(out), msgpack_(encoding == PayloadEncoding::kMsgPack) {}
+
+  JsonWriter& beginObject();
+  JsonWriter& beginObject(const char* key);
+  JsonWriter& beginObject(const char* key, size_t key_len);
+  JsonWriter& endObject();
+  JsonWriter& beginArray();
+  JsonWriter& beginArray(const char* key);
+  JsonWriter& endArray();
+
+  // Object members.
+  JsonWriter& field(const char* key, const char* value);
+  JsonWriter& field(const char* key, const std::string& value) {
+    return field(key, value.data(), value.size());
+  }
+  JsonWriter& field(const char* key, const char* value, size_t len);
+  JsonWriter& field(const char* key, bool value);
+  template <typename T>
+  typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value,
+                          JsonWriter&>::type
+  field(const char* key, T value) {
+    writeKey(key, std::strlen(key));
+    writeInteger(value);
+    return *this;
+  }
+  JsonWriter& fieldNull(const char* key);
+  // Writes key followed by a value some writer with the same encoding already
+  // produced, so cached fragments can be stitched into a new document.
+  JsonWriter& fieldRaw(const char* key, size_t key_len, const std::string& encoded);
+  // Writes tenths as a number with one decimal (e.g. 905 -> 90.5).
+  JsonWriter& fieldTenths(const char* key, int32_t tenths);
+
+  // Array elements.
+  JsonWriter& value(const char* text, size_t len);
+  JsonWriter& value(const std::string& text) {
+    return value(text.data(), text.size());
+  }
+  template <typename T>
+  typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value,
+                          JsonWriter&>::type
+  value(T number) {
+    separate();
+    writeInteger(number);
+    return *this;
+  }
+
+  // False once nesting went past kMaxDepth or an end did not match a begin.
+  bool ok() const {
+    return ok_;
+  }
+  size_t depth() const {
+    return depth_;
+  }
+
+  static void AppendEscaped(std::string& out, const char* text, size_t len);
+
+private:
+  void separate();
+  void writeKey(const char* key, size_t len);
+  void writeString(const char* text, size_t len);
+  void writeBool(bool value);
+  void writeBigEndian(uint8_t tag, uint64_t value, size_t bytes);
+  void open(char bracket);
+  void close(char bracket);
+  template <typename T> void writeInteger(T value) {
+    if (std::is_signed<T>::value) {
+      writeSigned(static_cast<long long>(value));
+    } else {
+      writeUnsigned(static_cast<unsigned long long>(value));
+    }
+  }
+  void writeSigned(long long value);
+  void writeUnsigned(unsigned long long value);
+
+  std::string& out_;
+  bool msgpack_;
+  // Members written so far at each level; for MessagePack also where the
+  // level's length header sits.
+  std::array<uint32_t, kMaxDepth> count_{};
+  std::array<size_t, kMaxDepth> header_{};
+  size_t depth_ = 0;
+  bool ok_ = true;
+};
+
+}  // namespace transport
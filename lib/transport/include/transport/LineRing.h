@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace transport {
+
+// Preallocated byte ring for outbound text lines. Lines are queued whole and
+// drained in whatever chunks the output accepts, so a slow or absent reader
+// never blocks the producer. Low-priority lines are dropped (and counted) once
+// the ring reaches its low-priority limit; the reserve above that is kept for
+// high-priority lines. When even the reserve is full, a high-priority line
+// evicts queued low-priority lines, oldest first, and is only rejected (and
+// counted) when no low-priority line is left to evict. Not thread-safe: the
+// owner serialises push and drain.
+class LineRing {
+public:
+  enum class Priority : uint8_t { kLow, kHigh };
+  // Writes up to len bytes and returns how many were accepted.
+  using WriteFn = std::function<size_t(const char* data, size_t len)>;
+
+  struct Stats {
+    size_t used = 0;
+    size_t high_water = 0;
+    // Low-priority lines refused at push or evicted for a high-priority line.
+    uint32_t dropped_low = 0;
+    uint32_t rejected_high = 0;
+  };
+
+  LineRing(size_t capacity, size_t high_reserve);
+
+  // Queues text plus a trailing "\r\n". Returns false when it does not fit.
+  bool push(const char* text, size_t len, Priority priority);
+  bool push(const std::string& line, Priority priority) {
+    return push(line.data(), line.size(), priority);
+  }
+
+  // Hands out at most budget bytes; stops early once write accepts less than offered.
+  size_t drain(const WriteFn& write, size_t budget);
+
+  size_t size() const {
+    return used_;
+  }
+  bool empty() const {
+    return used_ == 0;
+  }
+  size_t capacity() const {
+    return buffer_.size();
+  }
+  Stats stats() const;
+
+private:
+  struct Line {
+    uint16_t len = 0;
+    Priority priority = Priority::kLow;
+    bool evict = false;
+  };
+
+  // Frees room for needed bytes by evicting low-priority lines that have not
+  // started draining. Evicts nothing and returns false when that is not enough.
+  bool evictLow(size_t needed);
+  void append(const char* data, size_t len);
+  Line& lineAt(size_t offset) {
+    return lines_[(line_head_ + offset) % lines_.size()];
+  }
+
+  std::vector<char> buffer_;
+  std::vector<Line> lines_;
+  size_t low_limit_;
+  size_t head_ = 0;  // next byte to drain
+  size_t used_ = 0;
+  size_t line_head_ = 0;
+  size_t line_count_ = 0;
+  size_t head_sent_ = 0;  // bytes of the oldest line already drained
+  size_t high_water_ = 0;
+  uint32_t dropped_low_ = 0;
+  uint32_t rejected_high_ = 0;
+};
+
+}  // namespace transport
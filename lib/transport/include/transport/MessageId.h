@@ -1,19 +1,92 @@
 #pragma once
 
+#include <cstdint>
 #include <functional>
 #include <string>
+#include <utility>
 
 namespace transport {
 namespace message_id {
 
-// UUID-backed message identifiers shared across transports.
+// Text form used when a 64-bit id is rendered at the transport edge.
+enum class Format : uint8_t {
+  kHex16,  // 16 lowercase hex digits
+  kUuid,   // RFC 4122 layout, for hosts that expect UUID-shaped ids
+};
+
+// Ids are a per-boot random nonce (upper 32 bits) plus a counter (lower 32
+// bits), so they never repeat within a boot and rarely across boots.
+uint64_t NextValue();
+std::string Render(uint64_t value);
+void SetFormat(Format format);
+Format CurrentFormat();
+
+// Message identifiers shared across transports: NextValue() rendered in the
+// current format (or produced by the test generator when one is installed).
 std::string Next();
-void SetActive(const std::string& msg_id);
+
+// 64-bit FNV-1a hash of a host-supplied id.
+uint64_t Hash(const std::string& text);
+
+// A message id as it travels between components. Generated ids stay a 64-bit
+// value until a transport renders them (so a format change applies to all
+// output from then on); host-supplied ids keep their text. key() is the value
+// or the text's hash, so ids compare and index without rendering.
+class Id {
+public:
+  Id() = default;
+  Id(std::string text);  // NOLINT(google-explicit-constructor): host-supplied text
+  Id(const char* text);  // NOLINT(google-explicit-constructor)
+  static Id FromValue(uint64_t value);
+
+  bool empty() const {
+    return !generated_ && text_.empty();
+  }
+  bool generated() const {
+    return generated_;
+  }
+  uint64_t key() const {
+    return key_;
+  }
+  // Rendered text; only transports and logs should need it.
+  std::string str() const;
+  void appendTo(std::string& out) const;
+  void clear();
+
+  friend bool operator==(const Id& a, const Id& b);
+  friend bool operator!=(const Id& a, const Id& b) {
+    return !(a == b);
+  }
+
+private:
+  uint64_t key_ = 0;
+  std::string text_;
+  bool generated_ = false;
+};
+
+// Next() without rendering: a generated Id, or the test generator's text.
+Id NextId();
+// Id of the request whose asynchronous events are still to come (e.g. NET
+// connection progress); Active() is empty when there is none.
+void SetActive(const Id& msg_id);
 bool HasActive();
-std::string Active();
+Id Active();
 void ClearActive();
 
-// Test-only hooks to override UUID generation.
+// Host-supplied cmd_id kept verbatim, with its hash for cheap comparisons.
+struct CmdId {
+  uint64_t hash = 0;
+  std::string text;
+
+  CmdId() = default;
+  explicit CmdId(std::string value) : hash(Hash(value)), text(std::move(value)) {}
+
+  bool matches(uint64_t other_hash, const std::string& other_text) const {
+    return hash == other_hash && text == other_text;
+  }
+};
+
+// Test-only hooks to override id generation.
 void SetGenerator(std::function<std::string()> generator);
 void ResetGenerator();
 
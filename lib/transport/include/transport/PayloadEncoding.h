@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace transport {
+
+// Wire encoding of an MQTT payload. MessagePack carries the same schema as the
+// JSON text; it is selected per topic by appending kMsgPackTopicSuffix, e.g.
+// devices/<id>/status.mp or devices/<id>/cmd.mp.
+enum class PayloadEncoding : uint8_t {
+  kJson,
+  kMsgPack,
+};
+
+constexpr const char* kMsgPackTopicSuffix = ".mp";
+
+PayloadEncoding TopicEncoding(const std::string& topic);
+// Appends the suffix for encoding to a JSON topic.
+std::string EncodedTopic(const std::string& topic, PayloadEncoding encoding);
+// Every payload is an object, so the first byte tells the encodings apart.
+PayloadEncoding PayloadEncodingOf(const std::string& payload);
+
+}  // namespace transport
@@ -14,20 +14,34 @@ namespace response {
 class ResponseDispatcher {
 public:
   using SinkToken = std::uint32_t;
-  using SinkCallback = std::function<void(const Event&)>;
+  // line is the control line the event was emitted from, or nullptr. It is
+  // only valid during the call; the event then leaves raw text and attributes
+  // to the line, and anything kept must be built with BuildEvent(*line).
+  using SinkCallback = std::function<void(const Event&, const command::ResponseLine* line)>;
+  // Returns true when it took the event (e.g. queued it for another task);
+  // sinks are then not called for this Emit.
+  using EmitHook = std::function<bool(const Event&, const command::ResponseLine* line)>;
 
   static ResponseDispatcher& Instance();
 
   SinkToken RegisterSink(SinkCallback cb);
   void UnregisterSink(SinkToken token);
   void Emit(const Event& event);
+  // Emits a handler's line without copying its fields. DONE lines are emitted
+  // as full events, so completions always carry their attributes.
+  void Emit(const command::ResponseLine& line, const std::string& action);
+  void SetEmitHook(EmitHook hook);
+  // Lets emitters skip building an Event when neither a hook nor a sink would see it.
+  bool HasSinks() const;
   void Clear();
-  bool Replay(const std::string& cmd_id, const std::function<void(const Event&)>& cb) const;
+  bool Replay(const message_id::Id& cmd_id, const std::function<void(const Event&)>& cb) const;
   std::size_t CachedCommandCount() const;
 
 private:
   ResponseDispatcher() = default;
 
+  void Dispatch(const Event& event, const command::ResponseLine* line);
+
   struct CachedEvent {
     command::ResponseLine line;
     std::string action;
@@ -40,9 +54,10 @@ private:
   };
 
   SinkToken next_token_ = 1;
+  EmitHook emit_hook_;
   std::unordered_map<SinkToken, SinkCallback> sinks_;
-  std::unordered_map<std::string, CacheEntry> cache_;
-  std::deque<std::string> order_;
+  std::unordered_map<uint64_t, CacheEntry> cache_;
+  std::deque<uint64_t> order_;
 };
 
 }  // namespace response
@@ -2,7 +2,6 @@
 
 #include "transport/CommandSchema.h"
 
-#include <map>
 #include <string>
 #include <vector>
 
@@ -14,18 +13,27 @@ enum class EventType { kAck, kDone, kWarn, kError, kInfo, kData };
 
 struct Event {
   EventType type = EventType::kInfo;
-  std::string cmd_id;
+  message_id::Id cmd_id;
   std::string action;
   std::string code;
   std::string reason;
   // Optional raw rendering for transports that should print a preformatted line.
   // When set, sinks that convert Event->ResponseLine can preserve this text.
   std::string raw;
-  std::map<std::string, std::string> attributes;
+  // Ordered like the source line's fields; keys are string literals.
+  command::FieldList attributes;
 };
 
+// Returns the attribute, or nullptr when the event does not carry it.
+const command::Field* FindAttribute(const Event& event, const char* key);
+// Reads an integer attribute; false when it is missing or text.
+bool ExtractInt(const Event& event, const char* key, int32_t& out_value);
+// Replaces an existing attribute in place or appends a new one.
+void SetAttribute(Event& event, const char* key, std::string value);
+void SetAttribute(Event& event, command::Field field);
+
 struct CommandResponse {
-  std::string cmd_id;
+  message_id::Id cmd_id;
   std::string action;
   bool has_est_ms = false;
   int32_t est_ms = 0;
@@ -38,11 +46,20 @@ struct CommandResponse {
 CommandResponse BuildCommandResponse(const command::Response& response_lines,
                                      const std::string& action = std::string());
 
+// True for lines that BuildEvent() turns into a kDone event.
+bool IsDoneLine(const command::ResponseLine& line);
+
 // Build a single Event from a control line + action.
 Event BuildEvent(const command::ResponseLine& line, const std::string& action = std::string());
+// BuildEvent() without raw text and attributes, for handing out next to the line itself.
+Event BuildEventHeader(const command::ResponseLine& line,
+                       const std::string& action = std::string());
 
 // Convert an Event back into a control line for transport-specific rendering.
 command::ResponseLine EventToLine(const Event& event);
 
+// Serial rendering of an event. Uses the line it was built from when given.
+std::string SerializeEvent(const Event& event, const command::ResponseLine* line = nullptr);
+
 }  // namespace response
 }  // namespace transport
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace transport {
+
+// Single-writer sequence lock for publishing a plain struct to readers on
+// other tasks. The writer never waits; readers retry while a write is in
+// flight and always come away with a consistent copy.
+template <typename T> class SeqLock {
+  static_assert(std::is_trivially_copyable<T>::value, "SeqLock needs a trivially copyable T");
+
+public:
+  // Writer side; only one task may call store().
+  void store(const T& value) {
+    const uint32_t seq = seq_.load(std::memory_order_relaxed);
+    seq_.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(&value_, &value, sizeof(T));
+    seq_.store(seq + 2, std::memory_order_release);
+  }
+
+  // Returns false until the first store().
+  bool load(T& out) const {
+    for (;;) {
+      const uint32_t before = seq_.load(std::memory_order_acquire);
+      if (before & 1u) {
+        continue;
+      }
+      std::memcpy(&out, &value_, sizeof(T));
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (seq_.load(std::memory_order_relaxed) == before) {
+        return before != 0;
+      }
+    }
+  }
+
+  // Bumped twice per store(); lets readers skip work when nothing changed.
+  uint32_t sequence() const {
+    return seq_.load(std::memory_order_acquire);
+  }
+
+private:
+  std::atomic<uint32_t> seq_{0};
+  T value_{};
+};
+
+}  // namespace transport
@@ -0,0 +1,200 @@
+#pragma once
+
+#include <cstddef>
+#include <initializer_list>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace transport {
+
+// Vector with inline storage for the first N elements. Only grows onto the
+// heap once N is exceeded, so typical responses are built without allocating.
+template <typename T, std::size_t N> class SmallVector {
+public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using iterator = T*;
+  using const_iterator = const T*;
+
+  SmallVector() = default;
+
+  SmallVector(std::initializer_list<T> init) {
+    assign(init.begin(), init.end());
+  }
+
+  SmallVector(const SmallVector& other) {
+    assign(other.begin(), other.end());
+  }
+
+  SmallVector(SmallVector&& other) noexcept {
+    moveFrom(std::move(other));
+  }
+
+  ~SmallVector() {
+    clear();
+    releaseHeap();
+  }
+
+  SmallVector& operator=(const SmallVector& other) {
+    if (this != &other) {
+      assign(other.begin(), other.end());
+    }
+    return *this;
+  }
+
+  SmallVector& operator=(SmallVector&& other) noexcept {
+    if (this != &other) {
+      clear();
+      releaseHeap();
+      moveFrom(std::move(other));
+    }
+    return *this;
+  }
+
+  template <typename It> void assign(It first, It last) {
+    clear();
+    for (; first != last; ++first) {
+      push_back(*first);
+    }
+  }
+
+  void reserve(size_type wanted) {
+    if (wanted <= capacity_) {
+      return;
+    }
+    T* fresh = static_cast<T*>(::operator new(wanted * sizeof(T)));
+    for (size_type i = 0; i < size_; ++i) {
+      new (fresh + i) T(std::move(data_[i]));
+      data_[i].~T();
+    }
+    releaseHeap();
+    data_ = fresh;
+    capacity_ = wanted;
+  }
+
+  void push_back(const T& value) {
+    emplace_back(value);
+  }
+
+  void push_back(T&& value) {
+    emplace_back(std::move(value));
+  }
+
+  template <typename... Args> T& emplace_back(Args&&... args) {
+    if (size_ == capacity_) {
+      // Build first: args may alias an element that the regrow would move.
+      T value(std::forward<Args>(args)...);
+      reserve(capacity_ * 2);
+      T* slot = new (data_ + size_) T(std::move(value));
+      ++size_;
+      return *slot;
+    }
+    T* slot = new (data_ + size_) T(std::forward<Args>(args)...);
+    ++size_;
+    return *slot;
+  }
+
+  void pop_back() {
+    --size_;
+    data_[size_].~T();
+  }
+
+  void clear() {
+    for (size_type i = 0; i < size_; ++i) {
+      data_[i].~T();
+    }
+    size_ = 0;
+  }
+
+  size_type size() const {
+    return size_;
+  }
+  size_type capacity() const {
+    return capacity_;
+  }
+  bool empty() const {
+    return size_ == 0;
+  }
+  bool isInline() const {
+    return data_ == inlineData();
+  }
+
+  T* data() {
+    return data_;
+  }
+  const T* data() const {
+    return data_;
+  }
+  iterator begin() {
+    return data_;
+  }
+  iterator end() {
+    return data_ + size_;
+  }
+  const_iterator begin() const {
+    return data_;
+  }
+  const_iterator end() const {
+    return data_ + size_;
+  }
+  T& operator[](size_type i) {
+    return data_[i];
+  }
+  const T& operator[](size_type i) const {
+    return data_[i];
+  }
+  T& front() {
+    return data_[0];
+  }
+  const T& front() const {
+    return data_[0];
+  }
+  T& back() {
+    return data_[size_ - 1];
+  }
+  const T& back() const {
+    return data_[size_ - 1];
+  }
+
+private:
+  T* inlineData() {
+    return reinterpret_cast<T*>(&inline_);
+  }
+  const T* inlineData() const {
+    return reinterpret_cast<const T*>(&inline_);
+  }
+
+  void releaseHeap() {
+    if (!isInline()) {
+      ::operator delete(data_);
+      data_ = inlineData();
+      capacity_ = N;
+    }
+  }
+
+  // Expects *this to be empty and inline.
+  void moveFrom(SmallVector&& other) {
+    if (!other.isInline()) {
+      data_ = other.data_;
+      size_ = other.size_;
+      capacity_ = other.capacity_;
+      other.data_ = other.inlineData();
+      other.size_ = 0;
+      other.capacity_ = N;
+      return;
+    }
+    for (size_type i = 0; i < other.size_; ++i) {
+      new (data_ + i) T(std::move(other.data_[i]));
+    }
+    size_ = other.size_;
+    other.clear();
+  }
+
+  typename std::aligned_storage<sizeof(T) * N, alignof(T)>::type inline_;
+  T* data_ = inlineData();
+  size_type size_ = 0;
+  size_type capacity_ = N;
+};
+
+}  // namespace transport
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace transport {
+
+// Bounded single-producer/single-consumer ring. push() may only be called
+// from one task and pop() from one other task; neither blocks or locks.
+// Slots are allocated up front so the ring never grows.
+template <typename T> class SpscRing {
+public:
+  explicit SpscRing(std::size_t capacity) : slots_(capacity + 1) {}
+
+  SpscRing(const SpscRing&) = delete;
+  SpscRing& operator=(const SpscRing&) = delete;
+
+  // Producer side. Returns false without touching value when the ring is full.
+  bool push(T&& value) {
+    const std::size_t tail = tail_.load(std::memory_order_relaxed);
+    const std::size_t next = advance(tail);
+    if (next == head_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    slots_[tail] = std::move(value);
+    tail_.store(next, std::memory_order_release);
+    return true;
+  }
+
+  // Producer side. Hands the free slot to fill() to overwrite in place, so a T
+  // that owns buffers reuses their capacity instead of allocating per push.
+  // Returns false without calling fill() when the ring is full.
+  template <typename Fill> bool pushWith(Fill&& fill) {
+    const std::size_t tail = tail_.load(std::memory_order_relaxed);
+    const std::size_t next = advance(tail);
+    if (next == head_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    fill(slots_[tail]);
+    tail_.store(next, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side. Returns false when the ring is empty.
+  bool pop(T& out) {
+    const std::size_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    out = std::move(slots_[head]);
+    head_.store(advance(head), std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side. Swaps the oldest element into out, leaving out's previous
+  // buffers in the slot for the producer to reuse.
+  bool popSwap(T& out) {
+    const std::size_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    using std::swap;
+    swap(out, slots_[head]);
+    head_.store(advance(head), std::memory_order_release);
+    return true;
+  }
+
+  // Approximate when called concurrently with push()/pop().
+  std::size_t size() const {
+    const std::size_t head = head_.load(std::memory_order_acquire);
+    const std::size_t tail = tail_.load(std::memory_order_acquire);
+    return tail >= head ? tail - head : tail + slots_.size() - head;
+  }
+  std::size_t capacity() const {
+    return slots_.size() - 1;
+  }
+  bool empty() const {
+    return size() == 0;
+  }
+
+private:
+  std::size_t advance(std::size_t index) const {
+    return index + 1 == slots_.size() ? 0 : index + 1;
+  }
+
+  std::vector<T> slots_;
+  std::atomic<std::size_t> head_{0};
+  std::atomic<std::size_t> tail_{0};
+};
+
+}  // namespace transport
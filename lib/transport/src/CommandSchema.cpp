@@ -1,6 +1,7 @@
 #include "transport/CommandSchema.h"
 
 #include <algorithm>
+#include <cstring>
 #include <initializer_list>
 #include <sstream>
 
@@ -60,6 +61,10 @@ const std::vector<ErrorDescriptor>& BuildCatalog() {
        nullptr,
        CompletionStatus::kError,
        "MQTT command parameters failed validation."},
+      {"MQTT_BUSY",
+       nullptr,
+       CompletionStatus::kError,
+       "Inbound MQTT command queue is full; retry later."},
       {"MQTT_CONFIG_SAVE_FAILED",
        nullptr,
        CompletionStatus::kError,
@@ -69,7 +74,7 @@ const std::vector<ErrorDescriptor>& BuildCatalog() {
 }
 
 ResponseLine MakeControlLine(ResponseLineType type,
-                             const std::string& msg_id,
+                             const message_id::Id& msg_id,
                              const std::string& code,
                              const std::string& reason,
                              std::initializer_list<Field> fields) {
@@ -84,6 +89,22 @@ ResponseLine MakeControlLine(ResponseLineType type,
 
 }  // namespace
 
+bool KeyEquals(const Field& field, const char* key) {
+  return std::strcmp(field.key, key) == 0;
+}
+
+void WriteFieldText(std::ostream& out, const Field& field) {
+  if (field.kind == FieldKind::kInteger) {
+    out << field.number;
+  } else {
+    out << field.value;
+  }
+}
+
+std::string FieldText(const Field& field) {
+  return field.kind == FieldKind::kInteger ? std::to_string(field.number) : field.value;
+}
+
 const std::vector<ErrorDescriptor>& ErrorCatalog() {
   return BuildCatalog();
 }
@@ -99,7 +120,7 @@ const ErrorDescriptor* LookupError(const std::string& code) {
   return nullptr;
 }
 
-ResponseLine MakeAckLine(const std::string& msg_id, std::initializer_list<Field> fields) {
+ResponseLine MakeAckLine(const message_id::Id& msg_id, std::initializer_list<Field> fields) {
   ResponseLine line;
   line.type = ResponseLineType::kAck;
   line.msg_id = msg_id;
@@ -107,21 +128,21 @@ ResponseLine MakeAckLine(const std::string& msg_id, std::initializer_list<Field>
   return line;
 }
 
-ResponseLine MakeWarnLine(const std::string& msg_id,
+ResponseLine MakeWarnLine(const message_id::Id& msg_id,
                           const std::string& code,
                           const std::string& reason,
                           std::initializer_list<Field> fields) {
   return MakeControlLine(ResponseLineType::kWarn, msg_id, code, reason, fields);
 }
 
-ResponseLine MakeInfoLine(const std::string& msg_id,
+ResponseLine MakeInfoLine(const message_id::Id& msg_id,
                           const std::string& code,
                           const std::string& reason,
                           std::initializer_list<Field> fields) {
   return MakeControlLine(ResponseLineType::kInfo, msg_id, code, reason, fields);
 }
 
-ResponseLine MakeErrorLine(const std::string& msg_id,
+ResponseLine MakeErrorLine(const message_id::Id& msg_id,
                            const std::string& code,
                            const std::string& reason,
                            std::initializer_list<Field> fields) {
@@ -159,16 +180,17 @@ std::string SerializeLine(const ResponseLine& line) {
   case ResponseLineType::kAck:
     oss << "CTRL:ACK";
     if (!line.msg_id.empty()) {
-      oss << " msg_id=" << line.msg_id;
+      oss << " msg_id=" << line.msg_id.str();
     }
     for (const auto& field : line.fields) {
-      oss << ' ' << field.key << '=' << field.value;
+      oss << ' ' << field.key << '=';
+      WriteFieldText(oss, field);
     }
     break;
   case ResponseLineType::kWarn:
     oss << "CTRL:WARN";
     if (!line.msg_id.empty()) {
-      oss << " msg_id=" << line.msg_id;
+      oss << " msg_id=" << line.msg_id.str();
     }
     if (!line.code.empty()) {
       oss << ' ' << line.code;
@@ -177,13 +199,14 @@ std::string SerializeLine(const ResponseLine& line) {
       oss << ' ' << line.reason;
     }
     for (const auto& field : line.fields) {
-      oss << ' ' << field.key << '=' << field.value;
+      oss << ' ' << field.key << '=';
+      WriteFieldText(oss, field);
     }
     break;
   case ResponseLineType::kError:
     oss << "CTRL:ERR";
     if (!line.msg_id.empty()) {
-      oss << " msg_id=" << line.msg_id;
+      oss << " msg_id=" << line.msg_id.str();
     }
     if (!line.code.empty()) {
       oss << ' ' << line.code;
@@ -192,13 +215,14 @@ std::string SerializeLine(const ResponseLine& line) {
       oss << ' ' << line.reason;
     }
     for (const auto& field : line.fields) {
-      oss << ' ' << field.key << '=' << field.value;
+      oss << ' ' << field.key << '=';
+      WriteFieldText(oss, field);
     }
     break;
   case ResponseLineType::kInfo:
     oss << "CTRL:INFO";
     if (!line.msg_id.empty()) {
-      oss << " msg_id=" << line.msg_id;
+      oss << " msg_id=" << line.msg_id.str();
     }
     if (!line.code.empty()) {
       oss << ' ' << line.code;
@@ -207,7 +231,8 @@ std::string SerializeLine(const ResponseLine& line) {
       oss << ' ' << line.reason;
     }
     for (const auto& field : line.fields) {
-      oss << ' ' << field.key << '=' << field.value;
+      oss << ' ' << field.key << '=';
+      WriteFieldText(oss, field);
     }
     break;
   case ResponseLineType::kData:
@@ -217,7 +242,8 @@ std::string SerializeLine(const ResponseLine& line) {
       if (i > 0) {
         oss << ' ';
       }
-      oss << line.fields[i].key << '=' << line.fields[i].value;
+      oss << line.fields[i].key << '=';
+      WriteFieldText(oss, line.fields[i]);
     }
     break;
   }
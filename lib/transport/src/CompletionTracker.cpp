@@ -9,84 +9,205 @@ namespace transport {
 namespace response {
 
 CompletionTracker& CompletionTracker::Instance() {
-  static CompletionTracker tracker;
-  return tracker;
+  // Never destroyed: controllers owned by other statics unregister during exit.
+  static CompletionTracker* tracker = new CompletionTracker();
+  return *tracker;
 }
 
-void CompletionTracker::RegisterOperation(const std::string& cmd_id,
+void CompletionTracker::BeginCommandLine() {
+  ++line_;
+}
+
+void CompletionTracker::RegisterOperation(const message_id::Id& cmd_id,
                                           const std::string& action,
                                           uint32_t mask,
                                           MotorController& controller) {
   if (cmd_id.empty() || mask == 0) {
     return;
   }
-  // Remove any existing entry for this cmd_id
-  pending_.erase(std::remove_if(pending_.begin(),
-                                pending_.end(),
-                                [&](const Pending& p) { return p.cmd_id == cmd_id; }),
-                 pending_.end());
-  Pending pending;
+  // Commands of one line sharing a host-supplied cmd_id (e.g.
+  // `#id MOVE:0,..;MOVE:1,..`) widen the pending mask so a single DONE covers
+  // all of them.
+  for (size_t i = 0; i < pending_.size(); ++i) {
+    Pending& existing = pending_[i];
+    if (existing.active && existing.line == line_ && existing.cmd_id == cmd_id &&
+        existing.controller == &controller) {
+      claim(i, mask);
+      return;
+    }
+  }
+  // An earlier line's operation under this cmd_id is superseded without a DONE.
+  for (size_t i = 0; i < pending_.size(); ++i) {
+    if (pending_[i].active && pending_[i].cmd_id == cmd_id) {
+      release(i);
+    }
+  }
+  size_t slot = 0;
+  while (slot < pending_.size() && pending_[slot].active) {
+    ++slot;
+  }
+  if (slot == pending_.size()) {
+    pending_.emplace_back();
+  }
+  Pending& pending = pending_[slot];
   pending.cmd_id = cmd_id;
   pending.action = action;
-  pending.mask = mask;
+  pending.remaining = 0;
+  pending.handed_over = 0;
+  pending.actual_ms = -1;
   pending.controller = &controller;
+  pending.line = line_;
   pending.active = true;
-  pending_.push_back(std::move(pending));
+  claim(slot, mask);
 }
 
-void CompletionTracker::Tick(uint32_t /*now_ms*/) {
-  for (auto it = pending_.begin(); it != pending_.end();) {
-    if (!it->active || it->controller == nullptr) {
-      it = pending_.erase(it);
-      continue;
-    }
-    if (it->controller->isAnyMovingForMask(it->mask)) {
-      ++it;
-      continue;
-    }
+void CompletionTracker::OnMotorCompleted(MotorController& controller, const MotorState& state) {
+  if (handed_over_count_ != 0) {
+    finishHandedOver(&controller, state.id, static_cast<int32_t>(state.last_op_last_ms));
+  }
+  int16_t* owner = findOwner(&controller, state.id);
+  if (owner == nullptr || *owner == kNoSlot) {
+    return;
+  }
+  Pending& pending = pending_[*owner];
+  *owner = kNoSlot;
+  pending.actual_ms = std::max(pending.actual_ms, static_cast<int32_t>(state.last_op_last_ms));
+  pending.remaining &= ~(1u << state.id);
+  if (pending.remaining == 0) {
+    ready_.push_back(static_cast<int16_t>(&pending - pending_.data()));
+  }
+}
 
-    int32_t actual_ms = -1;
-    size_t count = it->controller->motorCount();
-    for (size_t idx = 0; idx < count; ++idx) {
-      if (idx >= 32 || !(it->mask & (1u << idx))) {
-        continue;
-      }
-      const MotorState& state = it->controller->state(idx);
-      if (!state.last_op_ongoing) {
-        actual_ms = std::max(actual_ms, static_cast<int32_t>(state.last_op_last_ms));
-      }
-    }
-    if (actual_ms < 0) {
-      ++it;
+void CompletionTracker::Tick(uint32_t /*now_ms*/) {
+  // Index loop: sinks may register new operations while we emit.
+  for (size_t i = 0; i < ready_.size(); ++i) {
+    const size_t slot = static_cast<size_t>(ready_[i]);
+    if (slot >= pending_.size() || !pending_[slot].active || pending_[slot].remaining != 0) {
       continue;
     }
-
     Event evt;
     evt.type = EventType::kDone;
-    evt.cmd_id = it->cmd_id;
-    evt.action = it->action;
-    evt.attributes["status"] = "done";
-    if (actual_ms >= 0) {
-      evt.attributes["actual_ms"] = std::to_string(actual_ms);
+    evt.cmd_id = pending_[slot].cmd_id;
+    evt.action = pending_[slot].action;
+    SetAttribute(evt, "status", "done");
+    if (pending_[slot].actual_ms >= 0) {
+      SetAttribute(evt, {"actual_ms", pending_[slot].actual_ms});
     }
+    release(slot);
     ResponseDispatcher::Instance().Emit(evt);
-
-    it = pending_.erase(it);
   }
+  ready_.clear();
 }
 
 void CompletionTracker::Clear() {
   pending_.clear();
+  owners_.clear();
+  ready_.clear();
+  handed_over_count_ = 0;
 }
 
 void CompletionTracker::RemoveController(MotorController* controller) {
   if (!controller) {
     return;
   }
-  pending_.erase(std::remove_if(pending_.begin(),
-                                pending_.end(),
-                                [&](const Pending& p) { return p.controller == controller; }),
-                 pending_.end());
+  for (size_t i = 0; i < pending_.size(); ++i) {
+    if (pending_[i].active && pending_[i].controller == controller) {
+      release(i);
+    }
+  }
+  owners_.erase(std::remove_if(owners_.begin(),
+                               owners_.end(),
+                               [&](const Owners& o) { return o.controller == controller; }),
+                owners_.end());
+}
+
+int16_t* CompletionTracker::findOwner(MotorController* controller, uint8_t id) {
+  if (id >= kMaxMotors) {
+    return nullptr;
+  }
+  for (auto& owners : owners_) {
+    if (owners.controller == controller) {
+      return &owners.slot[id];
+    }
+  }
+  return nullptr;
+}
+
+CompletionTracker::Owners& CompletionTracker::ownersFor(MotorController* controller) {
+  for (auto& owners : owners_) {
+    if (owners.controller == controller) {
+      return owners;
+    }
+  }
+  Owners owners;
+  owners.controller = controller;
+  owners.slot.fill(kNoSlot);
+  owners_.push_back(owners);
+  return owners_.back();
+}
+
+void CompletionTracker::claim(size_t slot, uint32_t mask) {
+  Owners& owners = ownersFor(pending_[slot].controller);
+  for (uint8_t id = 0; id < kMaxMotors; ++id) {
+    if (!(mask & (1u << id))) {
+      continue;
+    }
+    int16_t& owner = owners.slot[id];
+    if (owner != kNoSlot && owner != static_cast<int16_t>(slot)) {
+      // The motor was restarted under a new command. The old one still waits
+      // for it to stop, as it would have without the restart.
+      Pending& previous = pending_[owner];
+      if (!(previous.handed_over & (1u << id))) {
+        previous.handed_over |= (1u << id);
+        ++handed_over_count_;
+      }
+    }
+    owner = static_cast<int16_t>(slot);
+    pending_[slot].remaining |= (1u << id);
+  }
+}
+
+void CompletionTracker::release(size_t slot) {
+  Pending& pending = pending_[slot];
+  for (uint8_t id = 0; id < kMaxMotors && pending.remaining != 0; ++id) {
+    if (pending.remaining & (1u << id)) {
+      clearMotor(slot, id);
+    }
+  }
+  pending.remaining = 0;
+  pending.active = false;
+}
+
+void CompletionTracker::finishHandedOver(MotorController* controller,
+                                         uint8_t id,
+                                         int32_t actual_ms) {
+  const uint32_t bit = 1u << id;
+  for (size_t i = 0; i < pending_.size(); ++i) {
+    Pending& pending = pending_[i];
+    if (!pending.active || pending.controller != controller || !(pending.handed_over & bit)) {
+      continue;
+    }
+    pending.actual_ms = std::max(pending.actual_ms, actual_ms);
+    pending.remaining &= ~bit;
+    pending.handed_over &= ~bit;
+    --handed_over_count_;
+    if (pending.remaining == 0) {
+      ready_.push_back(static_cast<int16_t>(i));
+    }
+  }
+}
+
+void CompletionTracker::clearMotor(size_t slot, uint8_t id) {
+  Pending& pending = pending_[slot];
+  int16_t* owner = findOwner(pending.controller, id);
+  if (owner != nullptr && *owner == static_cast<int16_t>(slot)) {
+    *owner = kNoSlot;
+  }
+  if (pending.handed_over & (1u << id)) {
+    pending.handed_over &= ~(1u << id);
+    --handed_over_count_;
+  }
+  pending.remaining &= ~(1u << id);
 }
 
 }  // namespace response
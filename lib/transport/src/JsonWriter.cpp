@@ -0,0 +1,283 @@
+#include "transport/JsonWriter.h"
+
+#include <cstdint>
+#include <cstring>
+
+namespace transport {
+
+void JsonWriter::AppendEscaped(std::string& out, const char* text, size_t len) {
+  static const char kHex[] = "0123456789abcdef";
+  out.push_back('"');
+  for (size_t i = 0; i < len; ++i) {
+    const char c = text[i];
+    switch (c) {
+    case '"':
+      out.append("\\\"");
+      break;
+    case '\\':
+      out.append("\\\\");
+      break;
+    case '\b':
+      out.append("\\b");
+      break;
+    case '\f':
+      out.append("\\f");
+      break;
+    case '\n':
+      out.append("\\n");
+      break;
+    case '\r':
+      out.append("\\r");
+      break;
+    case '\t':
+      out.append("\\t");
+      break;
+    default:
+      if (static_cast<unsigned char>(c) < 0x20) {
+        out.append("\\u00");
+        out.push_back(kHex[(c >> 4) & 0x0F]);
+        out.push_back(kHex[c & 0x0F]);
+      } else {
+        out.push_back(c);
+      }
+    }
+  }
+  out.push_back('"');
+}
+
+void JsonWriter::separate() {
+  if (depth_ == 0) {
+    return;
+  }
+  if (!msgpack_ && count_[depth_ - 1] != 0) {
+    out_.push_back(',');
+  }
+  ++count_[depth_ - 1];
+}
+
+void JsonWriter::writeKey(const char* key, size_t len) {
+  separate();
+  if (msgpack_) {
+    writeString(key, len);
+    return;
+  }
+  out_.push_back('"');
+  out_.append(key, len);
+  out_.append("\":");
+}
+
+void JsonWriter::writeString(const char* text, size_t len) {
+  if (!msgpack_) {
+    AppendEscaped(out_, text, len);
+    return;
+  }
+  if (len < 32) {
+    out_.push_back(static_cast<char>(0xa0 | len));
+  } else if (len <= 0xFF) {
+    writeBigEndian(0xd9, len, 1);
+  } else if (len <= 0xFFFF) {
+    writeBigEndian(0xda, len, 2);
+  } else {
+    writeBigEndian(0xdb, len, 4);
+  }
+  out_.append(text, len);
+}
+
+void JsonWriter::writeBool(bool value) {
+  if (msgpack_) {
+    out_.push_back(static_cast<char>(value ? 0xc3 : 0xc2));
+  } else {
+    out_.append(value ? "true" : "false");
+  }
+}
+
+void JsonWriter::writeBigEndian(uint8_t tag, uint64_t value, size_t bytes) {
+  out_.push_back(static_cast<char>(tag));
+  for (size_t shift = bytes * 8; shift > 0; shift -= 8) {
+    out_.push_back(static_cast<char>((value >> (shift - 8)) & 0xFF));
+  }
+}
+
+void JsonWriter::open(char bracket) {
+  const size_t header = out_.size();
+  if (msgpack_) {
+    // map16 / array16 with a zero length, patched in close().
+    writeBigEndian(bracket == '{' ? 0xde : 0xdc, 0, 2);
+  } else {
+    out_.push_back(bracket);
+  }
+  if (depth_ == kMaxDepth) {
+    ok_ = false;
+    return;
+  }
+  header_[depth_] = header;
+  count_[depth_++] = 0;
+}
+
+void JsonWriter::close(char bracket) {
+  if (depth_ == 0) {
+    ok_ = false;
+    if (!msgpack_) {
+      out_.push_back(bracket);
+    }
+    return;
+  }
+  --depth_;
+  if (!msgpack_) {
+    out_.push_back(bracket);
+    return;
+  }
+  const uint32_t count = count_[depth_];
+  if (count > 0xFFFF) {
+    ok_ = false;
+    return;
+  }
+  out_[header_[depth_] + 1] = static_cast<char>(count >> 8);
+  out_[header_[depth_] + 2] = static_cast<char>(count & 0xFF);
+}
+
+JsonWriter& JsonWriter::beginObject() {
+  separate();
+  open('{');
+  return *this;
+}
+
+JsonWriter& JsonWriter::beginObject(const char* key) {
+  return beginObject(key, std::strlen(key));
+}
+
+JsonWriter& JsonWriter::beginObject(const char* key, size_t key_len) {
+  writeKey(key, key_len);
+  open('{');
+  return *this;
+}
+
+JsonWriter& JsonWriter::endObject() {
+  close('}');
+  return *this;
+}
+
+JsonWriter& JsonWriter::beginArray() {
+  separate();
+  open('[');
+  return *this;
+}
+
+JsonWriter& JsonWriter::beginArray(const char* key) {
+  writeKey(key, std::strlen(key));
+  open('[');
+  return *this;
+}
+
+JsonWriter& JsonWriter::endArray() {
+  close(']');
+  return *this;
+}
+
+JsonWriter& JsonWriter::field(const char* key, const char* value) {
+  return field(key, value, std::strlen(value));
+}
+
+JsonWriter& JsonWriter::field(const char* key, const char* value, size_t len) {
+  writeKey(key, std::strlen(key));
+  writeString(value, len);
+  return *this;
+}
+
+JsonWriter& JsonWriter::field(const char* key, bool value) {
+  writeKey(key, std::strlen(key));
+  writeBool(value);
+  return *this;
+}
+
+JsonWriter& JsonWriter::fieldNull(const char* key) {
+  writeKey(key, std::strlen(key));
+  if (msgpack_) {
+    out_.push_back(static_cast<char>(0xc0));
+  } else {
+    out_.append("null");
+  }
+  return *this;
+}
+
+JsonWriter& JsonWriter::fieldRaw(const char* key, size_t key_len, const std::string& encoded) {
+  writeKey(key, key_len);
+  out_.append(encoded);
+  return *this;
+}
+
+JsonWriter& JsonWriter::fieldTenths(const char* key, int32_t tenths) {
+  writeKey(key, std::strlen(key));
+  if (msgpack_) {
+    const double number = static_cast<double>(tenths) / 10.0;
+    uint64_t bits = 0;
+    std::memcpy(&bits, &number, sizeof(bits));
+    writeBigEndian(0xcb, bits, 8);
+    return *this;
+  }
+  const int64_t magnitude = tenths < 0 ? -static_cast<int64_t>(tenths) : tenths;
+  if (tenths < 0) {
+    out_.push_back('-');
+  }
+  writeUnsigned(static_cast<unsigned long long>(magnitude / 10));
+  out_.push_back('.');
+  out_.push_back(static_cast<char>('0' + magnitude % 10));
+  return *this;
+}
+
+JsonWriter& JsonWriter::value(const char* text, size_t len) {
+  separate();
+  writeString(text, len);
+  return *this;
+}
+
+void JsonWriter::writeSigned(long long value) {
+  if (msgpack_ && value < 0) {
+    if (value >= -32) {
+      out_.push_back(static_cast<char>(value));
+    } else if (value >= INT8_MIN) {
+      writeBigEndian(0xd0, static_cast<uint64_t>(value), 1);
+    } else if (value >= INT16_MIN) {
+      writeBigEndian(0xd1, static_cast<uint64_t>(value), 2);
+    } else if (value >= INT32_MIN) {
+      writeBigEndian(0xd2, static_cast<uint64_t>(value), 4);
+    } else {
+      writeBigEndian(0xd3, static_cast<uint64_t>(value), 8);
+    }
+    return;
+  }
+  if (value < 0) {
+    out_.push_back('-');
+    writeUnsigned(static_cast<unsigned long long>(-(value + 1LL)) + 1ULL);
+    return;
+  }
+  writeUnsigned(static_cast<unsigned long long>(value));
+}
+
+void JsonWriter::writeUnsigned(unsigned long long value) {
+  if (msgpack_) {
+    if (value <= 0x7F) {
+      out_.push_back(static_cast<char>(value));
+    } else if (value <= 0xFF) {
+      writeBigEndian(0xcc, value, 1);
+    } else if (value <= 0xFFFF) {
+      writeBigEndian(0xcd, value, 2);
+    } else if (value <= 0xFFFFFFFFULL) {
+      writeBigEndian(0xce, value, 4);
+    } else {
+      writeBigEndian(0xcf, value, 8);
+    }
+    return;
+  }
+  char buffer[21];
+  size_t len = 0;
+  do {
+    buffer[len++] = static_cast<char>('0' + (value % 10ULL));
+    value /= 10ULL;
+  } while (value != 0ULL);
+  while (len > 0) {
+    out_.push_back(buffer[--len]);
+  }
+}
+
+}  // namespace transport
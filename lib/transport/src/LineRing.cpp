@@ -0,0 +1,138 @@
+#include "transport/LineRing.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace transport {
+
+namespace {
+
+constexpr char kLineEnd[] = "\r\n";
+constexpr size_t kLineEndLength = sizeof(kLineEnd) - 1;
+// Line records are sized for an average line of this many bytes; a ring full
+// of shorter lines counts as full.
+constexpr size_t kAverageLineBytes = 16;
+
+}  // namespace
+
+LineRing::LineRing(size_t capacity, size_t high_reserve)
+    : buffer_(capacity),
+      lines_(std::max<size_t>(4, capacity / kAverageLineBytes)),
+      low_limit_(high_reserve < capacity ? capacity - high_reserve : 0) {}
+
+bool LineRing::push(const char* text, size_t len, Priority priority) {
+  const size_t needed = len + kLineEndLength;
+  const bool high = priority == Priority::kHigh;
+  const size_t limit = high ? buffer_.size() : low_limit_;
+  const bool fits = used_ + needed <= limit && line_count_ < lines_.size();
+  if (!fits && (!high || needed > UINT16_MAX || !evictLow(needed))) {
+    if (high) {
+      ++rejected_high_;
+    } else {
+      ++dropped_low_;
+    }
+    return false;
+  }
+  append(text, len);
+  append(kLineEnd, kLineEndLength);
+  Line& line = lineAt(line_count_++);
+  line.len = static_cast<uint16_t>(needed);
+  line.priority = priority;
+  line.evict = false;
+  high_water_ = std::max(high_water_, used_);
+  return true;
+}
+
+bool LineRing::evictLow(size_t needed) {
+  // The oldest line may be half written to the port already; it has to stay.
+  const size_t first = head_sent_ > 0 ? 1 : 0;
+  size_t freed = 0;
+  size_t records = 0;
+  for (size_t i = first; i < line_count_; ++i) {
+    Line& line = lineAt(i);
+    if (used_ - freed + needed <= buffer_.size() && line_count_ - records < lines_.size()) {
+      break;
+    }
+    if (line.priority == Priority::kLow) {
+      line.evict = true;
+      freed += line.len;
+      ++records;
+    }
+  }
+  if (used_ - freed + needed > buffer_.size() || line_count_ - records >= lines_.size()) {
+    for (size_t i = first; i < line_count_; ++i) {
+      lineAt(i).evict = false;
+    }
+    return false;
+  }
+  // Slide the kept lines towards the head over the evicted ones, keeping order.
+  size_t read = head_;
+  size_t write = head_;
+  size_t kept = 0;
+  for (size_t i = 0; i < line_count_; ++i) {
+    const Line line = lineAt(i);
+    if (line.evict) {
+      read = (read + line.len) % buffer_.size();
+      continue;
+    }
+    for (size_t b = 0; b < line.len; ++b) {
+      buffer_[write] = buffer_[read];
+      read = (read + 1) % buffer_.size();
+      write = (write + 1) % buffer_.size();
+    }
+    lineAt(kept++) = line;
+  }
+  line_count_ = kept;
+  used_ -= freed;
+  dropped_low_ += static_cast<uint32_t>(records);
+  return true;
+}
+
+void LineRing::append(const char* data, size_t len) {
+  size_t tail = (head_ + used_) % buffer_.size();
+  while (len > 0) {
+    const size_t chunk = std::min(len, buffer_.size() - tail);
+    std::memcpy(buffer_.data() + tail, data, chunk);
+    data += chunk;
+    len -= chunk;
+    used_ += chunk;
+    tail = (tail + chunk) % buffer_.size();
+  }
+}
+
+size_t LineRing::drain(const WriteFn& write, size_t budget) {
+  size_t written = 0;
+  while (used_ > 0 && written < budget) {
+    const size_t chunk = std::min({used_, buffer_.size() - head_, budget - written});
+    const size_t accepted = std::min(write(buffer_.data() + head_, chunk), chunk);
+    head_ = (head_ + accepted) % buffer_.size();
+    used_ -= accepted;
+    written += accepted;
+    head_sent_ += accepted;
+    while (line_count_ > 0 && head_sent_ >= lineAt(0).len) {
+      head_sent_ -= lineAt(0).len;
+      line_head_ = (line_head_ + 1) % lines_.size();
+      --line_count_;
+    }
+    if (accepted < chunk) {
+      break;
+    }
+  }
+  if (used_ == 0) {
+    head_ = 0;
+    line_head_ = 0;
+    head_sent_ = 0;
+  }
+  return written;
+}
+
+LineRing::Stats LineRing::stats() const {
+  Stats stats;
+  stats.used = used_;
+  stats.high_water = high_water_;
+  stats.dropped_low = dropped_low_;
+  stats.rejected_high = rejected_high_;
+  return stats;
+}
+
+}  // namespace transport
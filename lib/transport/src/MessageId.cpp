@@ -1,7 +1,7 @@
 #include "transport/MessageId.h"
 
-#include <array>
-#include <cstdio>
+#include <atomic>
+#include <cstring>
 #include <mutex>
 #include <random>
 #include <string>
@@ -23,8 +23,14 @@ std::function<std::string()>& Generator() {
   return gen;
 }
 
-std::string& ActiveId() {
-  static std::string active;
+// Set while a test generator is installed so Next() can skip the lock otherwise.
+std::atomic<bool>& HasGenerator() {
+  static std::atomic<bool> has{false};
+  return has;
+}
+
+transport::message_id::Id& ActiveId() {
+  static transport::message_id::Id active;
   return active;
 }
 
@@ -33,73 +39,48 @@ std::string& LastIssuedId() {
   return last;
 }
 
-std::string GenerateUuidV4() {
-  std::array<uint8_t, 16> bytes{};
+std::atomic<uint32_t>& Counter() {
+  static std::atomic<uint32_t> counter{0};
+  return counter;
+}
 
-#if defined(ARDUINO) && (defined(ESP32) || defined(ARDUINO_ARCH_ESP32))
-  for (size_t i = 0; i < bytes.size(); i += 4) {
-    uint32_t r = esp_random();
-    bytes[i + 0] = static_cast<uint8_t>(r & 0xFF);
-    bytes[i + 1] = static_cast<uint8_t>((r >> 8) & 0xFF);
-    bytes[i + 2] = static_cast<uint8_t>((r >> 16) & 0xFF);
-    bytes[i + 3] = static_cast<uint8_t>((r >> 24) & 0xFF);
-  }
+std::atomic<uint8_t>& FormatSetting() {
+#if defined(MESSAGE_ID_FORMAT_UUID) && MESSAGE_ID_FORMAT_UUID
+  constexpr auto kDefault = transport::message_id::Format::kUuid;
 #else
-  static std::random_device rd;
-  static std::mt19937_64 rng(rd());
-  for (size_t i = 0; i < bytes.size();) {
-    uint64_t value = rng();
-    for (size_t j = 0; j < 8 && i < bytes.size(); ++j, ++i) {
-      bytes[i] = static_cast<uint8_t>((value >> (j * 8)) & 0xFF);
-    }
-  }
+  constexpr auto kDefault = transport::message_id::Format::kHex16;
 #endif
+  static std::atomic<uint8_t> format{static_cast<uint8_t>(kDefault)};
+  return format;
+}
 
-  // RFC 4122 version 4 UUID formatting.
-  bytes[6] = static_cast<uint8_t>((bytes[6] & 0x0F) | 0x40);
-  bytes[8] = static_cast<uint8_t>((bytes[8] & 0x3F) | 0x80);
-
-  char out[37];
-  std::snprintf(out,
-                sizeof(out),
-                "%02x%02x%02x%02x-%02x%02x-%02x%02x-%02x%02x-%02x%02x%02x%02x%02x%02x",
-                bytes[0],
-                bytes[1],
-                bytes[2],
-                bytes[3],
-                bytes[4],
-                bytes[5],
-                bytes[6],
-                bytes[7],
-                bytes[8],
-                bytes[9],
-                bytes[10],
-                bytes[11],
-                bytes[12],
-                bytes[13],
-                bytes[14],
-                bytes[15]);
-  return std::string(out);
-}
-
-std::string DefaultUuidFactory() {
-  return GenerateUuidV4();
+uint32_t BootNonce() {
+  static const uint32_t nonce = []() {
+#if defined(ARDUINO) && (defined(ESP32) || defined(ARDUINO_ARCH_ESP32))
+    return static_cast<uint32_t>(esp_random());
+#else
+    std::random_device rd;
+    return static_cast<uint32_t>(rd());
+#endif
+  }();
+  return nonce;
 }
 
-}  // namespace
+constexpr char kHexDigits[] = "0123456789abcdef";
 
-namespace transport {
-namespace message_id {
+void WriteHex(char* out, uint64_t value, int digits) {
+  for (int i = digits - 1; i >= 0; --i) {
+    out[i] = kHexDigits[value & 0xF];
+    value >>= 4;
+  }
+}
 
-std::string Next() {
+std::string NextFromGenerator() {
   std::lock_guard<std::mutex> lock(IdMutex());
-  if (!Generator()) {
-    Generator() = DefaultUuidFactory;
-  }
   std::string next;
   do {
     next = Generator()();
-  } while (!ActiveId().empty() && next == ActiveId());
+  } while (!ActiveId().empty() && next == ActiveId().str());
   if (!LastIssuedId().empty() && next == LastIssuedId()) {
     next = Generator()();
   }
@@ -107,7 +88,99 @@ std::string Next() {
   return next;
 }
 
-void SetActive(const std::string& msg_id) {
+}  // namespace
+
+namespace transport {
+namespace message_id {
+
+uint64_t NextValue() {
+  uint32_t count = Counter().fetch_add(1, std::memory_order_relaxed) + 1;
+  return (static_cast<uint64_t>(BootNonce()) << 32) | count;
+}
+
+std::string Render(uint64_t value) {
+  std::string out;
+  Id::FromValue(value).appendTo(out);
+  return out;
+}
+
+void SetFormat(Format format) {
+  FormatSetting().store(static_cast<uint8_t>(format), std::memory_order_relaxed);
+}
+
+Format CurrentFormat() {
+  return static_cast<Format>(FormatSetting().load(std::memory_order_relaxed));
+}
+
+std::string Next() {
+  if (HasGenerator().load(std::memory_order_acquire)) {
+    return NextFromGenerator();
+  }
+  // Counter ids cannot repeat within a boot, so no active/last-id checks are needed.
+  return Render(NextValue());
+}
+
+Id NextId() {
+  if (HasGenerator().load(std::memory_order_acquire)) {
+    return Id(NextFromGenerator());
+  }
+  return Id::FromValue(NextValue());
+}
+
+Id::Id(std::string text) : key_(Hash(text)), text_(std::move(text)) {}
+
+Id::Id(const char* text) : Id(std::string(text != nullptr ? text : "")) {}
+
+Id Id::FromValue(uint64_t value) {
+  Id id;
+  id.key_ = value;
+  id.generated_ = true;
+  return id;
+}
+
+std::string Id::str() const {
+  if (!generated_) {
+    return text_;
+  }
+  std::string out;
+  appendTo(out);
+  return out;
+}
+
+void Id::appendTo(std::string& out) const {
+  if (!generated_) {
+    out.append(text_);
+    return;
+  }
+  if (CurrentFormat() == Format::kUuid) {
+    // nnnnnnnn-0000-4000-8000-0000cccccccc: nonce, version/variant nibbles, counter.
+    char text[36];
+    WriteHex(text, key_ >> 32, 8);
+    std::memcpy(text + 8, "-0000-4000-8000-", 16);
+    WriteHex(text + 24, key_ & 0xFFFFFFFFu, 12);
+    out.append(text, sizeof(text));
+    return;
+  }
+  char text[16];
+  WriteHex(text, key_, 16);
+  out.append(text, sizeof(text));
+}
+
+void Id::clear() {
+  key_ = 0;
+  text_.clear();
+  generated_ = false;
+}
+
+bool operator==(const Id& a, const Id& b) {
+  if (a.generated_ == b.generated_) {
+    return a.key_ == b.key_ && a.text_ == b.text_;
+  }
+  // A generated id echoed back as text by a host.
+  return a.str() == b.str();
+}
+
+void SetActive(const Id& msg_id) {
   std::lock_guard<std::mutex> lock(IdMutex());
   ActiveId() = msg_id;
 }
@@ -117,7 +190,7 @@ bool HasActive() {
   return !ActiveId().empty();
 }
 
-std::string Active() {
+Id Active() {
   std::lock_guard<std::mutex> lock(IdMutex());
   return ActiveId();
 }
@@ -127,14 +200,26 @@ void ClearActive() {
   ActiveId().clear();
 }
 
+uint64_t Hash(const std::string& text) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (unsigned char c : text) {
+    hash ^= c;
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
 void SetGenerator(std::function<std::string()> generator) {
   std::lock_guard<std::mutex> lock(IdMutex());
+  HasGenerator().store(static_cast<bool>(generator), std::memory_order_release);
   Generator() = std::move(generator);
 }
 
 void ResetGenerator() {
   std::lock_guard<std::mutex> lock(IdMutex());
-  Generator() = DefaultUuidFactory;
+  Generator() = nullptr;
+  LastIssuedId().clear();
+  HasGenerator().store(false, std::memory_order_release);
 }
 
 }  // namespace message_id
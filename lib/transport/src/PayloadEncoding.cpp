@@ -0,0 +1,25 @@
+#include "transport/PayloadEncoding.h"
+
+#include <cstring>
+
+namespace transport {
+
+PayloadEncoding TopicEncoding(const std::string& topic) {
+  const size_t suffix_len = std::strlen(kMsgPackTopicSuffix);
+  if (topic.size() > suffix_len &&
+      topic.compare(topic.size() - suffix_len, suffix_len, kMsgPackTopicSuffix) == 0) {
+    return PayloadEncoding::kMsgPack;
+  }
+  return PayloadEncoding::kJson;
+}
+
+std::string EncodedTopic(const std::string& topic, PayloadEncoding encoding) {
+  return encoding == PayloadEncoding::kMsgPack ? topic + kMsgPackTopicSuffix : topic;
+}
+
+PayloadEncoding PayloadEncodingOf(const std::string& payload) {
+  return !payload.empty() && payload[0] != '{' ? PayloadEncoding::kMsgPack
+                                               : PayloadEncoding::kJson;
+}
+
+}  // namespace transport
@@ -1,5 +1,7 @@
 #include "transport/ResponseDispatcher.h"
 
+#include <utility>
+
 namespace transport {
 namespace response {
 
@@ -28,24 +30,39 @@ void ResponseDispatcher::UnregisterSink(SinkToken token) {
 }
 
 void ResponseDispatcher::Emit(const Event& event) {
+  Dispatch(event, nullptr);
+}
+
+void ResponseDispatcher::Emit(const command::ResponseLine& line, const std::string& action) {
+  if (IsDoneLine(line)) {
+    Dispatch(BuildEvent(line, action), nullptr);
+    return;
+  }
+  Dispatch(BuildEventHeader(line, action), &line);
+}
+
+void ResponseDispatcher::Dispatch(const Event& event, const command::ResponseLine* line) {
+  if (emit_hook_ && emit_hook_(event, line)) {
+    return;
+  }
   if (!event.cmd_id.empty() && kMaxCachedResponses > 0) {
-    auto emplace_result = cache_.emplace(event.cmd_id, CacheEntry{});
+    auto emplace_result = cache_.emplace(event.cmd_id.key(), CacheEntry{});
     if (emplace_result.second) {
-      order_.push_back(event.cmd_id);
+      order_.push_back(event.cmd_id.key());
       while (order_.size() > kMaxCachedResponses) {
-        const std::string& oldest = order_.front();
+        const uint64_t oldest = order_.front();
         cache_.erase(oldest);
         order_.pop_front();
       }
     }
     CacheEntry& entry = emplace_result.first->second;
     if (event.type == EventType::kAck) {
-      entry.ack.line = EventToLine(event);
+      entry.ack.line = line != nullptr ? *line : EventToLine(event);
       entry.ack.action = event.action;
       entry.ack.type = event.type;
       entry.ack.valid = true;
     } else if (event.type == EventType::kDone) {
-      entry.done.line = EventToLine(event);
+      entry.done.line = line != nullptr ? *line : EventToLine(event);
       entry.done.action = event.action;
       entry.done.type = event.type;
       entry.done.valid = true;
@@ -53,21 +70,29 @@ void ResponseDispatcher::Emit(const Event& event) {
   }
 
   for (auto& pair : sinks_) {
-    pair.second(event);
+    pair.second(event, line);
   }
 }
 
+void ResponseDispatcher::SetEmitHook(EmitHook hook) {
+  emit_hook_ = std::move(hook);
+}
+
+bool ResponseDispatcher::HasSinks() const {
+  return emit_hook_ || !sinks_.empty();
+}
+
 void ResponseDispatcher::Clear() {
   cache_.clear();
   order_.clear();
 }
 
-bool ResponseDispatcher::Replay(const std::string& cmd_id,
+bool ResponseDispatcher::Replay(const message_id::Id& cmd_id,
                                 const std::function<void(const Event&)>& cb) const {
   if (!cb || cmd_id.empty()) {
     return false;
   }
-  auto it = cache_.find(cmd_id);
+  auto it = cache_.find(cmd_id.key());
   if (it == cache_.end()) {
     return false;
   }
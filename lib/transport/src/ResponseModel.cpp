@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <sstream>
+#include <utility>
 
 namespace transport {
 namespace response {
@@ -26,29 +27,6 @@ EventType MapLineType(command::ResponseLineType type) {
   }
 }
 
-std::map<std::string, std::string> FieldsToMap(const std::vector<command::Field>& fields) {
-  std::map<std::string, std::string> out;
-  for (const auto& field : fields) {
-    out[field.key] = field.value;
-  }
-  return out;
-}
-
-bool ExtractInt(const std::map<std::string, std::string>& fields,
-                const char* key,
-                int32_t& out_value) {
-  auto it = fields.find(key);
-  if (it == fields.end()) {
-    return false;
-  }
-  try {
-    out_value = static_cast<int32_t>(std::stol(it->second));
-    return true;
-  } catch (...) {
-    return false;
-  }
-}
-
 command::ResponseLineType MapEventType(EventType type) {
   switch (type) {
   case EventType::kAck:
@@ -69,6 +47,38 @@ command::ResponseLineType MapEventType(EventType type) {
 
 }  // namespace
 
+const command::Field* FindAttribute(const Event& event, const char* key) {
+  for (const auto& field : event.attributes) {
+    if (command::KeyEquals(field, key)) {
+      return &field;
+    }
+  }
+  return nullptr;
+}
+
+bool ExtractInt(const Event& event, const char* key, int32_t& out_value) {
+  const command::Field* field = FindAttribute(event, key);
+  if (field == nullptr || field->kind != command::FieldKind::kInteger) {
+    return false;
+  }
+  out_value = static_cast<int32_t>(field->number);
+  return true;
+}
+
+void SetAttribute(Event& event, const char* key, std::string value) {
+  SetAttribute(event, command::Field(key, std::move(value)));
+}
+
+void SetAttribute(Event& event, command::Field field) {
+  for (auto& existing : event.attributes) {
+    if (command::KeyEquals(existing, field.key)) {
+      existing = std::move(field);
+      return;
+    }
+  }
+  event.attributes.push_back(std::move(field));
+}
+
 CommandResponse BuildCommandResponse(const command::Response& response_lines,
                                      const std::string& action) {
   CommandResponse out;
@@ -83,18 +93,18 @@ CommandResponse BuildCommandResponse(const command::Response& response_lines,
         out.cmd_id = evt.cmd_id;
       }
       int32_t value = 0;
-      if (ExtractInt(evt.attributes, "est_ms", value)) {
+      if (ExtractInt(evt, "est_ms", value)) {
         out.est_ms = value;
         out.has_est_ms = true;
       }
-      if (ExtractInt(evt.attributes, "actual_ms", value)) {
+      if (ExtractInt(evt, "actual_ms", value)) {
         out.actual_ms = value;
         out.has_actual_ms = true;
       }
     }
     if (evt.type == EventType::kError) {
       int32_t value = 0;
-      if (ExtractInt(evt.attributes, "actual_ms", value)) {
+      if (ExtractInt(evt, "actual_ms", value)) {
         out.actual_ms = value;
         out.has_actual_ms = true;
       }
@@ -115,26 +125,33 @@ CommandResponse BuildCommandResponse(const command::Response& response_lines,
   return out;
 }
 
-Event BuildEvent(const command::ResponseLine& line, const std::string& action) {
+bool IsDoneLine(const command::ResponseLine& line) {
+  for (const auto& field : line.fields) {
+    if (command::KeyEquals(field, "status")) {
+      if (field.value == "done" || field.value == "DONE") {
+        return true;
+      }
+      break;
+    }
+  }
+  return MapLineType(line.type) == EventType::kInfo && line.raw.rfind("CTRL:DONE", 0) == 0;
+}
+
+Event BuildEventHeader(const command::ResponseLine& line, const std::string& action) {
   Event evt;
-  evt.type = MapLineType(line.type);
+  evt.type = IsDoneLine(line) ? EventType::kDone : MapLineType(line.type);
   evt.cmd_id = line.msg_id;
   evt.action = action;
   evt.code = line.code;
   evt.reason = line.reason;
+  return evt;
+}
+
+Event BuildEvent(const command::ResponseLine& line, const std::string& action) {
+  Event evt = BuildEventHeader(line, action);
   // Preserve any preformatted raw text for transports that want to print it.
   evt.raw = line.raw;
-  evt.attributes = FieldsToMap(line.fields);
-  auto status_it = evt.attributes.find("status");
-  if (status_it != evt.attributes.end()) {
-    const std::string& status = status_it->second;
-    if (status == "done" || status == "DONE") {
-      evt.type = EventType::kDone;
-    }
-  }
-  if (evt.type == EventType::kInfo && !line.raw.empty() && line.raw.rfind("CTRL:DONE", 0) == 0) {
-    evt.type = EventType::kDone;
-  }
+  evt.attributes = line.fields;
   return evt;
 }
 
@@ -144,9 +161,7 @@ command::ResponseLine EventToLine(const Event& event) {
   line.msg_id = event.cmd_id;
   line.code = event.code;
   line.reason = event.reason;
-  for (const auto& kv : event.attributes) {
-    line.fields.push_back({kv.first, kv.second});
-  }
+  line.fields = event.attributes;
 
   // If the event carried a raw representation, preserve it.
   if (!event.raw.empty()) {
@@ -155,18 +170,29 @@ command::ResponseLine EventToLine(const Event& event) {
     std::ostringstream oss;
     oss << "CTRL:DONE";
     if (!event.cmd_id.empty()) {
-      oss << " cmd_id=" << event.cmd_id;
+      oss << " cmd_id=" << event.cmd_id.str();
     }
     if (!event.action.empty()) {
       oss << " action=" << event.action;
     }
-    for (const auto& kv : event.attributes) {
-      oss << ' ' << kv.first << '=' << kv.second;
+    for (const auto& field : event.attributes) {
+      oss << ' ' << field.key << '=';
+      command::WriteFieldText(oss, field);
     }
     line.raw = oss.str();
   }
   return line;
 }
 
+std::string SerializeEvent(const Event& event, const command::ResponseLine* line) {
+  // DONE events are rendered from the event itself (CTRL:DONE cmd_id=...)
+  // unless the line already carries that text.
+  if (line != nullptr && (event.type != EventType::kDone || !line->raw.empty())) {
+    return command::SerializeLine(*line);
+  }
+  command::ResponseLine rendered = EventToLine(event);
+  return rendered.raw.empty() ? command::SerializeLine(rendered) : rendered.raw;
+}
+
 }  // namespace response
 }  // namespace transport
@@ -1,19 +1,24 @@
 // Arduino serial console only
 #if defined(ARDUINO)
+#include "MotorControl/MotionTask.h"
 #include "MotorControl/MotorCommandProcessor.h"
 #include "mqtt/MqttCommandServer.h"
+#include "mqtt/MqttConfigStore.h"
 #include "mqtt/MqttPresenceClient.h"
 #include "mqtt/MqttStatusPublisher.h"
 #include "net_onboarding/NetSingleton.h"
 #include "net_onboarding/SerialImmediate.h"
 #include "transport/CommandSchema.h"
 #include "transport/CompletionTracker.h"
+#include "transport/LineRing.h"
 #include "transport/ResponseDispatcher.h"
 #include "transport/ResponseModel.h"
 
 #include <Arduino.h>
+#include <algorithm>
 #include <array>
 #include <cstring>
+#include <mutex>
 #include <string>
 #include <utility>
 
@@ -22,17 +27,35 @@ namespace {
 constexpr uint32_t kSerialGracePeriodMs = 500;
 constexpr char kBackspaceChar = 0x08;
 constexpr char kDeleteChar = 0x7F;
+// Console output is queued and drained a little per tick so a full or
+// unattended serial port never stalls command handling. Half the ring is kept
+// for ACK/ERR/WARN/DONE lines, which may also evict queued INFO/DATA lines.
+constexpr size_t kSerialOutputBytes = 4096;
+constexpr size_t kSerialHighReserveBytes = 2048;
+constexpr size_t kSerialDrainBudgetBytes = 512;
 
 struct SerialConsoleState {
   MotorCommandProcessor* command_processor = nullptr;
+  // Set when built with USE_MOTION_TASK: the processor then lives on the motion task.
+  motor::MotionTask* motion_task = nullptr;
+  motor::SnapshotMotorController* motion_view = nullptr;
   std::array<char, 256> input_buffer{};
   size_t input_length = 0;
   uint32_t ignore_until_ms = 0;  // grace period to ignore deploy-time noise
   mqtt::AsyncMqttPresenceClient* presence_client = nullptr;
   mqtt::MqttStatusPublisher* status_publisher = nullptr;
+  uint32_t status_connect_count = 0;
+  bool status_resync_bound = false;
+  uint32_t status_config_revision = 0;
   mqtt::MqttCommandServer* command_server = nullptr;
   bool command_server_bound = false;
   transport::response::ResponseDispatcher::SinkToken serial_sink_token = 0;
+  // Network callbacks log from other tasks, so the ring is guarded.
+  std::mutex output_mutex;
+  transport::LineRing output{kSerialOutputBytes, kSerialHighReserveBytes};
+  uint32_t reported_output_drops = 0;
+  uint32_t reported_output_rejects = 0;
+  std::string status_frame;
 };
 
 SerialConsoleState& ConsoleState() {
@@ -41,6 +64,12 @@ SerialConsoleState& ConsoleState() {
 }
 
 bool HandleGracePeriod(SerialConsoleState& state, uint32_t now_ms);
+void WriteConsoleLine(SerialConsoleState& state,
+                      const std::string& line,
+                      transport::LineRing::Priority priority);
+void DrainConsoleOutput(SerialConsoleState& state);
+void ExecuteLine(SerialConsoleState& state, const std::string& line, uint32_t now_ms);
+const MotorController& ControllerView(SerialConsoleState& state);
 void ProcessSerialInput(SerialConsoleState& state);
 void TickBackends(SerialConsoleState& state, uint32_t now_ms);
 
@@ -73,7 +102,8 @@ bool HandleGracePeriod(SerialConsoleState& state, uint32_t now_ms) {
   }
   if ((state.ignore_until_ms != 0) && (now_ms >= state.ignore_until_ms)) {
     state.ignore_until_ms = 0;
-    Serial.println("CTRL:READY Serial v1 — send HELP");
+    WriteConsoleLine(
+        state, "CTRL:READY Serial v1 — send HELP", transport::LineRing::Priority::kHigh);
   }
   return false;
 }
@@ -91,7 +121,7 @@ void ProcessSerialInput(SerialConsoleState& state) {
       if (state.command_processor == nullptr) {
         return;
       }
-      (void)state.command_processor->execute(std::string(state.input_buffer.data()), millis());
+      ExecuteLine(state, std::string(state.input_buffer.data()), millis());
       state.input_length = 0;
       continue;
     }
@@ -111,16 +141,109 @@ void ProcessSerialInput(SerialConsoleState& state) {
       Serial.write(input_char);
     } else {
       state.input_length = 0;
-      Serial.println("CTRL:ERR E03 BAD_PARAM buffer_overflow");
+      WriteConsoleLine(
+          state, "CTRL:ERR E03 BAD_PARAM buffer_overflow", transport::LineRing::Priority::kHigh);
     }
   }
 }
 
+size_t WriteSerial(const char* data, size_t len) {
+  return Serial.write(reinterpret_cast<const uint8_t*>(data), len);
+}
+
+// INFO/DATA may be dropped under pressure; ACK/ERR/DONE and warnings never are.
+transport::LineRing::Priority PriorityFor(transport::response::EventType type) {
+  using transport::response::EventType;
+  if (type == EventType::kInfo || type == EventType::kData) {
+    return transport::LineRing::Priority::kLow;
+  }
+  return transport::LineRing::Priority::kHigh;
+}
+
+transport::LineRing::Priority PriorityFor(const std::string& line) {
+  if (line.rfind("CTRL:", 0) == 0 && line.rfind("CTRL:INFO", 0) != 0) {
+    return transport::LineRing::Priority::kHigh;
+  }
+  return transport::LineRing::Priority::kLow;
+}
+
+void WriteConsoleLine(SerialConsoleState& state,
+                      const std::string& line,
+                      transport::LineRing::Priority priority) {
+  // Never waits on the port: a line that does not fit is counted and reported later.
+  std::lock_guard<std::mutex> lock(state.output_mutex);
+  (void)state.output.push(line, priority);
+}
+
+void DrainConsoleOutput(SerialConsoleState& state) {
+  std::unique_lock<std::mutex> lock(state.output_mutex);
+  if (!state.output.empty()) {
+    const int room = Serial.availableForWrite();
+    if (room > 0) {
+      state.output.drain(WriteSerial, std::min(static_cast<size_t>(room), kSerialDrainBudgetBytes));
+    }
+  }
+  const auto stats = state.output.stats();
+  const uint32_t low = stats.dropped_low - state.reported_output_drops;
+  const uint32_t high = stats.rejected_high - state.reported_output_rejects;
+  if ((low == 0 && high == 0) || !state.output.empty()) {
+    return;
+  }
+  std::string warning = "CTRL:WARN SERIAL_DROPPED lines=" + std::to_string(low + high);
+  if (high > 0) {
+    warning += " high=" + std::to_string(high);
+  }
+  state.reported_output_drops = stats.dropped_low;
+  state.reported_output_rejects = stats.rejected_high;
+  lock.unlock();
+  WriteConsoleLine(state, warning, transport::LineRing::Priority::kHigh);
+}
+
+void ExecuteLine(SerialConsoleState& state, const std::string& line, uint32_t now_ms) {
+  if (state.motion_task != nullptr) {
+    (void)state.motion_task->execute(line, now_ms);
+    return;
+  }
+  (void)state.command_processor->execute(line, now_ms);
+}
+
+// Motor state as seen from this task: the latest motion-task snapshot when the
+// processor runs there, otherwise the controller itself.
+const MotorController& ControllerView(SerialConsoleState& state) {
+  if (state.motion_task != nullptr) {
+    // Room for every motor a mask can address; kept off this task's stack.
+    static motor::MotionSnapshot snapshot;
+    if (state.motion_task->snapshot(snapshot)) {
+      state.motion_view->update(snapshot);
+    }
+    return *state.motion_view;
+  }
+  return state.command_processor->controller();
+}
+
+// SUB STATUS frames are telemetry: low priority, so they are the first to go
+// when the port cannot keep up.
+void PushStatusFrame(SerialConsoleState& state, uint32_t now_ms) {
+  if (state.command_processor == nullptr) {
+    return;
+  }
+  auto& subscription = state.command_processor->statusSubscription();
+  if (subscription.active() &&
+      subscription.poll(ControllerView(state), now_ms, state.status_frame)) {
+    WriteConsoleLine(state, state.status_frame, transport::LineRing::Priority::kLow);
+  }
+}
+
 void TickBackends(SerialConsoleState& state, uint32_t now_ms) {
-  if (state.command_processor != nullptr) {
-    state.command_processor->tick(now_ms);
+  if (state.motion_task != nullptr) {
+    state.motion_task->pumpEvents();
+  } else {
+    if (state.command_processor != nullptr) {
+      state.command_processor->tick(now_ms);
+    }
+    transport::response::CompletionTracker::Instance().Tick(now_ms);
   }
-  transport::response::CompletionTracker::Instance().Tick(now_ms);
+  PushStatusFrame(state, now_ms);
 
   if (state.presence_client == nullptr || state.command_processor == nullptr) {
     return;
@@ -138,7 +261,7 @@ void TickBackends(SerialConsoleState& state, uint32_t now_ms) {
 
   bool any_moving = false;
   bool any_awake = false;
-  MotorController& controller = state.command_processor->controller();
+  const MotorController& controller = ControllerView(state);
   size_t motor_count = controller.motorCount();  // NOLINT(cppcoreguidelines-init-variables)
   for (size_t motor_index = 0; motor_index < motor_count;
        ++motor_index)  // NOLINT(cppcoreguidelines-init-variables)
@@ -159,7 +282,32 @@ void TickBackends(SerialConsoleState& state, uint32_t now_ms) {
   state.presence_client->loop(now_ms);
 
   if (state.status_publisher != nullptr) {
-    state.status_publisher->setTopic(state.presence_client->statusTopic());
+    const std::string& status_topic = state.presence_client->statusTopic();
+    state.status_publisher->setTopic(status_topic);
+    // Every broker session starts delta consumers off with a keyframe.
+    const uint32_t connects = state.presence_client->connectCount();
+    if (connects != state.status_connect_count) {
+      state.status_connect_count = connects;
+      state.status_publisher->forceImmediate();
+    }
+    // Consumers that see a gap in "seq" publish anything to status/resync.
+    if (!state.status_resync_bound && StatusTopicHasDeviceId(status_topic)) {
+      mqtt::MqttStatusPublisher* publisher = state.status_publisher;
+      state.status_resync_bound = state.presence_client->subscribe(
+          status_topic + "/resync", 0, [publisher](const std::string&, const std::string&) {
+            publisher->requestKeyframe();
+          });
+    }
+    // status_max_hz and status_topics are tunable over MQTT:SET_CONFIG.
+    auto& config_store = mqtt::ConfigStore::Instance();
+    const uint32_t config_revision = config_store.Revision();
+    if (config_revision != state.status_config_revision) {
+      state.status_config_revision = config_revision;
+      const mqtt::BrokerConfig cfg = config_store.Current();
+      state.status_publisher->setMaxRateHz(cfg.status_max_hz);
+      state.status_publisher->setTopicModes(cfg.status_topics != mqtt::kStatusTopicsMotors,
+                                            cfg.status_topics != mqtt::kStatusTopicsAggregate);
+    }
     state.status_publisher->loop(controller, now_ms);
   }
 }
@@ -177,6 +325,19 @@ void serial_console_setup() {
     state.command_processor = new MotorCommandProcessor();
   }
 
+#if defined(USE_MOTION_TASK) && USE_MOTION_TASK
+  if (state.motion_task == nullptr) {
+    state.motion_view = new motor::SnapshotMotorController();
+    state.motion_task = new motor::MotionTask(*state.command_processor);
+    if (!state.motion_task->start()) {
+      WriteConsoleLine(
+          state, "CTRL:WARN MOTION_TASK_START_FAILED", transport::LineRing::Priority::kHigh);
+      delete state.motion_task;
+      state.motion_task = nullptr;
+    }
+  }
+#endif
+
   if (state.presence_client == nullptr) {
     state.presence_client = new mqtt::AsyncMqttPresenceClient(net_onboarding::Net());
     state.presence_client->begin();
@@ -192,20 +353,23 @@ void serial_console_setup() {
     state.status_publisher = new mqtt::MqttStatusPublisher(publish_fn, net_onboarding::Net());
     state.status_publisher->setTopic(
         state.presence_client != nullptr ? state.presence_client->statusTopic() : std::string());
+    state.status_publisher->setQueueDepthFn([&state]() -> size_t {
+      return state.presence_client != nullptr ? state.presence_client->queuedPublishes() : 0;
+    });
     state.status_publisher->forceImmediate();
   }
 
   if (state.serial_sink_token == 0) {
     state.serial_sink_token = transport::response::ResponseDispatcher::Instance().RegisterSink(
-        [](const transport::response::Event& evt) {
-          auto line = transport::response::EventToLine(evt);
-          std::string text = line.raw.empty()
-                                 ? transport::command::SerializeLine(line)
-                                 : line.raw;  // NOLINT(cppcoreguidelines-init-variables)
+        [&state](const transport::response::Event& evt,
+                 const transport::command::ResponseLine* line) {
+          std::string text = transport::response::SerializeEvent(evt, line);
           if (!text.empty()) {
-            Serial.println(text.c_str());
+            WriteConsoleLine(state, text, PriorityFor(evt.type));
           }
         });
+    net_onboarding::SetCtrlLineWriter(
+        [&state](const std::string& line) { WriteConsoleLine(state, line, PriorityFor(line)); });
   }
 
   if (state.command_server == nullptr && state.command_processor != nullptr &&
@@ -225,6 +389,15 @@ void serial_console_setup() {
     auto clock_fn = []() -> uint32_t { return millis(); };
     state.command_server = new mqtt::MqttCommandServer(
         *state.command_processor, publish_fn, subscribe_fn, log_fn, clock_fn);
+    if (state.motion_task != nullptr) {
+      state.command_server->setExecutor(
+          [&state](const std::string& line, uint32_t now_ms) {
+            auto result = state.motion_task->execute(line, now_ms);
+            (void)ControllerView(state);
+            return result;
+          },
+          state.motion_view);
+    }
     auto status_topic = state.presence_client->statusTopic();
     if (StatusTopicHasDeviceId(status_topic)) {
       state.command_server_bound = state.command_server->begin(status_topic);
@@ -239,6 +412,7 @@ void serial_console_setup() {
 void serial_console_tick() {
   auto& state = ConsoleState();
   const uint32_t now_ms = millis();  // NOLINT(cppcoreguidelines-init-variables)
+  DrainConsoleOutput(state);
   if (HandleGracePeriod(state, now_ms)) {
     return;
   }
@@ -18,8 +18,7 @@
 
 using net_onboarding::Net;
 using net_onboarding::State;
-using ResponseAttribute = std::pair<const char*, std::string>;
-using ResponseAttributeList = std::initializer_list<ResponseAttribute>;
+using ResponseAttributeList = std::initializer_list<transport::command::Field>;
 
 namespace {
 State& LastKnownNetState() {
@@ -31,7 +30,7 @@ constexpr uint32_t kResetHoldMs = 5000;
 constexpr uint32_t kConnectTimeoutMs = 8000;
 
 static void EmitNetEvent(transport::response::EventType type,
-                         const std::string& cmd_id,
+                         const transport::message_id::Id& cmd_id,
                          const char* code,
                          const char* reason,
                          ResponseAttributeList attributes) {
@@ -45,14 +44,15 @@ static void EmitNetEvent(transport::response::EventType type,
   if (reason != nullptr) {
     evt.reason = reason;
   }
-  for (const auto& kv : attributes) {
-    evt.attributes[kv.first] = kv.second;
+  for (const auto& field : attributes) {
+    transport::response::SetAttribute(evt, field);
   }
   transport::response::ResponseDispatcher::Instance().Emit(evt);
 }
 
-static void
-EmitNetDone(const std::string& cmd_id, const char* status, ResponseAttributeList attributes) {
+static void EmitNetDone(const transport::message_id::Id& cmd_id,
+                        const char* status,
+                        ResponseAttributeList attributes) {
   if (cmd_id.empty()) {
     return;
   }
@@ -60,9 +60,9 @@ EmitNetDone(const std::string& cmd_id, const char* status, ResponseAttributeList
   evt.type = transport::response::EventType::kDone;
   evt.action = "NET";
   evt.cmd_id = cmd_id;
-  evt.attributes["status"] = (status != nullptr) ? status : "done";
-  for (const auto& kv : attributes) {
-    evt.attributes[kv.first] = kv.second;
+  transport::response::SetAttribute(evt, "status", (status != nullptr) ? status : "done");
+  for (const auto& field : attributes) {
+    transport::response::SetAttribute(evt, field);
   }
   transport::response::ResponseDispatcher::Instance().Emit(evt);
 }
@@ -147,8 +147,7 @@ void setup() {
     std::string ip_address = std::to_string(soft_ap_ip[0]) + "." + std::to_string(soft_ap_ip[1]) +
                              "." + std::to_string(soft_ap_ip[2]) + "." +
                              std::to_string(soft_ap_ip[3]);
-    std::string active_request_id =
-        transport::message_id::HasActive() ? transport::message_id::Active() : std::string();
+    const transport::message_id::Id active_request_id = transport::message_id::Active();
     EmitNetEvent(transport::response::EventType::kInfo,
                  active_request_id,
                  "NET:AP_ACTIVE",
@@ -161,8 +160,7 @@ void setup() {
       transport::message_id::ClearActive();
     }
   } else if (last_state == State::CONNECTING) {
-    std::string active_request_id =
-        transport::message_id::HasActive() ? transport::message_id::Active() : std::string();
+    const transport::message_id::Id active_request_id = transport::message_id::Active();
     EmitNetEvent(transport::response::EventType::kInfo,
                  active_request_id,
                  "NET:CONNECTING",
@@ -172,7 +170,7 @@ void setup() {
 #endif
 }
 
-void loop() {
+static void NetworkTick() {
   serial_console_tick();
   Net().loop();
   ResetButtonTick(millis());
@@ -185,8 +183,7 @@ void loop() {
 #if defined(ARDUINO) && (defined(ESP32) || defined(ARDUINO_ARCH_ESP32))
     if (status_snapshot.state == State::AP_ACTIVE) {
       if (previous_state == State::CONNECTING) {
-        std::string active_error =
-            transport::message_id::HasActive() ? transport::message_id::Active() : std::string();
+        const transport::message_id::Id active_error = transport::message_id::Active();
         EmitNetEvent(
             transport::response::EventType::kError, active_error, "NET_CONNECT_FAILED", "", {});
       }
@@ -196,8 +193,7 @@ void loop() {
       std::string ip_address = std::to_string(soft_ap_ip[0]) + "." + std::to_string(soft_ap_ip[1]) +
                                "." + std::to_string(soft_ap_ip[2]) + "." +
                                std::to_string(soft_ap_ip[3]);
-      std::string active_request_id =
-          transport::message_id::HasActive() ? transport::message_id::Active() : std::string();
+      const transport::message_id::Id active_request_id = transport::message_id::Active();
       EmitNetEvent(transport::response::EventType::kInfo,
                    active_request_id,
                    "NET:AP_ACTIVE",
@@ -210,8 +206,7 @@ void loop() {
         transport::message_id::ClearActive();
       }
     } else if (status_snapshot.state == State::CONNECTING) {
-      std::string active_request_id =
-          transport::message_id::HasActive() ? transport::message_id::Active() : std::string();
+      const transport::message_id::Id active_request_id = transport::message_id::Active();
       EmitNetEvent(transport::response::EventType::kInfo,
                    active_request_id,
                    "NET:CONNECTING",
@@ -221,9 +216,8 @@ void loop() {
       String quoted_ssid = QuoteString(status_snapshot.ssid.data());
       std::string ssid = std::string(quoted_ssid.c_str());
       std::string ip_address = std::string(status_snapshot.ip.data());
-      std::string rssi_dbm = std::to_string(status_snapshot.rssi_dbm);
-      std::string active_request_id =
-          transport::message_id::HasActive() ? transport::message_id::Active() : std::string();
+      const int rssi_dbm = status_snapshot.rssi_dbm;
+      const transport::message_id::Id active_request_id = transport::message_id::Active();
       EmitNetEvent(
           transport::response::EventType::kInfo,
           active_request_id,
@@ -242,6 +236,27 @@ void loop() {
   }
 }
 
+#if defined(USE_MOTION_TASK) && USE_MOTION_TASK
+// Networking and telemetry run next to the Wi-Fi stack on core 0, leaving core 1
+// to the motion task started by serial_console_setup().
+static void NetworkTaskMain(void* /*arg*/) {
+  for (;;) {
+    NetworkTick();
+    vTaskDelay(1);
+  }
+}
+#endif
+
+void loop() {
+#if defined(USE_MOTION_TASK) && USE_MOTION_TASK
+  // Runs once: hand the loop body to a core-0 task and retire the Arduino loop task.
+  xTaskCreatePinnedToCore(NetworkTaskMain, "net", 8192, nullptr, 1, nullptr, 0);
+  vTaskDelete(nullptr);
+#else
+  NetworkTick();
+#endif
+}
+
 #elif !defined(ARDUINO) && !defined(UNIT_TEST)
 int main(int argc, char** argv) {
   (void)argc;
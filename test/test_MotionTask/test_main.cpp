@@ -0,0 +1,323 @@
+#include "MotorControl/MotionTask.h"
+#include "MotorControl/MotorCommandProcessor.h"
+#include "transport/CompletionTracker.h"
+#include "transport/ResponseDispatcher.h"
+#include "transport/SeqLock.h"
+#include "transport/SpscRing.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <unity.h>
+#include <vector>
+
+namespace {
+
+using transport::command::ResponseLine;
+using transport::response::Event;
+using transport::response::EventType;
+using transport::response::ResponseDispatcher;
+
+struct Sample {
+  uint32_t seq = 0;
+  std::array<uint32_t, 15> copies{};
+};
+
+struct RecordedEvent {
+  EventType type;
+  std::string cmd_id;
+  std::thread::id thread;
+};
+
+// Collects dispatcher events for the lifetime of the fixture.
+struct EventRecorder {
+  std::vector<RecordedEvent> events;
+  ResponseDispatcher::SinkToken token = 0;
+
+  EventRecorder() {
+    token = ResponseDispatcher::Instance().RegisterSink([this](const Event& evt,
+                                                               const ResponseLine*) {
+      events.push_back({evt.type, evt.cmd_id.str(), std::this_thread::get_id()});
+    });
+  }
+  ~EventRecorder() {
+    ResponseDispatcher::Instance().UnregisterSink(token);
+  }
+
+  size_t count(EventType type) const {
+    size_t n = 0;
+    for (const auto& evt : events) {
+      if (evt.type == type) {
+        ++n;
+      }
+    }
+    return n;
+  }
+};
+
+double ElapsedSeconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+}  // namespace
+
+void setUp() {
+  transport::response::CompletionTracker::Instance().Clear();
+}
+
+void tearDown() {}
+
+void test_spsc_ring_preserves_order_across_threads() {
+  constexpr uint32_t kCount = 200000;
+  transport::SpscRing<uint32_t> ring(64);
+  std::thread producer([&ring]() {
+    for (uint32_t i = 0; i < kCount; ++i) {
+      uint32_t value = i;
+      while (!ring.push(std::move(value))) {
+        std::this_thread::yield();
+      }
+    }
+  });
+  uint32_t expected = 0;
+  uint32_t out_of_order = 0;
+  while (expected < kCount) {
+    uint32_t value = 0;
+    if (!ring.pop(value)) {
+      std::this_thread::yield();
+      continue;
+    }
+    if (value != expected) {
+      ++out_of_order;
+    }
+    ++expected;
+  }
+  producer.join();
+  TEST_ASSERT_EQUAL_UINT32(0, out_of_order);
+  TEST_ASSERT_TRUE(ring.empty());
+}
+
+void test_spsc_ring_rejects_when_full() {
+  transport::SpscRing<std::string> ring(2);
+  TEST_ASSERT_TRUE(ring.push(std::string("a")));
+  TEST_ASSERT_TRUE(ring.push(std::string("b")));
+  std::string extra = "c";
+  TEST_ASSERT_FALSE(ring.push(std::move(extra)));
+  TEST_ASSERT_EQUAL_STRING("c", extra.c_str());
+  std::string out;
+  TEST_ASSERT_TRUE(ring.pop(out));
+  TEST_ASSERT_EQUAL_STRING("a", out.c_str());
+  TEST_ASSERT_EQUAL_UINT32(1, ring.size());
+}
+
+void test_seqlock_readers_never_see_torn_values() {
+  transport::SeqLock<Sample> lock;
+  Sample first;
+  TEST_ASSERT_FALSE(lock.load(first));
+
+  std::atomic<bool> stop{false};
+  std::thread writer([&]() {
+    Sample sample;
+    for (uint32_t i = 1; !stop.load(std::memory_order_relaxed); ++i) {
+      sample.seq = i;
+      sample.copies.fill(i);
+      lock.store(sample);
+    }
+  });
+  uint32_t torn = 0;
+  uint32_t went_back = 0;
+  uint32_t last = 0;
+  for (int i = 0; i < 100000; ++i) {
+    Sample sample;
+    if (!lock.load(sample)) {
+      continue;
+    }
+    for (uint32_t copy : sample.copies) {
+      if (copy != sample.seq) {
+        ++torn;
+        break;
+      }
+    }
+    if (sample.seq < last) {
+      ++went_back;
+    }
+    last = sample.seq;
+  }
+  stop.store(true);
+  writer.join();
+  TEST_ASSERT_EQUAL_UINT32(0, torn);
+  TEST_ASSERT_EQUAL_UINT32(0, went_back);
+}
+
+void test_motion_task_runs_inline_until_started() {
+  EventRecorder recorder;
+  MotorCommandProcessor processor;
+  motor::MotionTask task(processor);
+  auto result = task.execute("#inline WAKE:0", 0);
+  TEST_ASSERT_FALSE(result.is_error);
+  TEST_ASSERT_TRUE(recorder.count(EventType::kDone) >= 1);
+  TEST_ASSERT_TRUE(recorder.events.back().thread == std::this_thread::get_id());
+  TEST_ASSERT_EQUAL_UINT32(0, task.pumpEvents());
+}
+
+void test_motion_task_delivers_events_on_caller_thread() {
+  EventRecorder recorder;
+  MotorCommandProcessor processor;
+  motor::MotionTask task(processor);
+  TEST_ASSERT_TRUE(task.start());
+
+  auto result = task.execute("#threaded MOVE:0,100", 0);
+  TEST_ASSERT_FALSE(result.is_error);
+  // The ACK raised on the motion task is already delivered when execute returns.
+  TEST_ASSERT_EQUAL_UINT32(1, recorder.count(EventType::kAck));
+  motor::MotionSnapshot snapshot;
+  TEST_ASSERT_TRUE(task.snapshot(snapshot));
+  TEST_ASSERT_TRUE(snapshot.motors[0].moving);
+
+  const auto start = std::chrono::steady_clock::now();
+  while (recorder.count(EventType::kDone) == 0 && ElapsedSeconds(start) < 5.0) {
+    task.pumpEvents();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  task.stop();
+
+  TEST_ASSERT_EQUAL_UINT32(1, recorder.count(EventType::kDone));
+  for (const auto& evt : recorder.events) {
+    TEST_ASSERT_TRUE(evt.thread == std::this_thread::get_id());
+    TEST_ASSERT_EQUAL_STRING("threaded", evt.cmd_id.c_str());
+  }
+  TEST_ASSERT_TRUE(task.snapshot(snapshot));
+  TEST_ASSERT_FALSE(snapshot.motors[0].moving);
+  TEST_ASSERT_EQUAL_INT(100, snapshot.motors[0].position);
+  TEST_ASSERT_EQUAL_UINT32(0, task.stats().events_dropped);
+}
+
+void test_motion_task_runs_net_commands_on_caller() {
+  EventRecorder recorder;
+  MotorCommandProcessor processor;
+  motor::MotionTask task(processor);
+  TEST_ASSERT_TRUE(task.start());
+  // NET commands touch Wi-Fi state owned by the caller's task, so they never hop.
+  (void)task.execute("#net NET:STATUS", 0);
+  TEST_ASSERT_FALSE(recorder.events.empty());
+  task.stop();
+  TEST_ASSERT_TRUE(recorder.events.front().thread == std::this_thread::get_id());
+}
+
+void test_motion_task_never_drops_control_events() {
+  EventRecorder recorder;
+  MotorCommandProcessor processor;
+  motor::MotionTask::Config cfg;
+  cfg.event_depth = 2;
+  motor::MotionTask task(processor, cfg);
+  TEST_ASSERT_TRUE(task.start());
+
+  // Far more events than the queue holds, raised by one job on the motion task.
+  task.call([](uint32_t) {
+    auto& dispatcher = ResponseDispatcher::Instance();
+    for (int i = 0; i < 20; ++i) {
+      dispatcher.Emit(transport::command::MakeAckLine("burst", {}), std::string());
+      transport::command::ResponseLine info;
+      info.type = transport::command::ResponseLineType::kInfo;
+      info.msg_id = "burst";
+      dispatcher.Emit(info, std::string());
+    }
+  });
+  task.stop();
+
+  TEST_ASSERT_EQUAL_UINT32(20, recorder.count(EventType::kAck));
+  TEST_ASSERT_EQUAL_UINT32(20 - recorder.count(EventType::kInfo), task.stats().events_dropped);
+}
+
+void test_snapshot_view_bounds_checks() {
+  motor::MotionSnapshot snapshot;
+  snapshot.motor_count = 2;
+  snapshot.motors[1].position = 42;
+  motor::SnapshotMotorController view;
+  view.update(snapshot);
+  TEST_ASSERT_EQUAL_INT(42, view.state(1).position);
+  TEST_ASSERT_EQUAL_INT(0, view.state(5).position);
+  TEST_ASSERT_EQUAL_UINT32(0, view.motorChangeSeq(5));
+  TEST_ASSERT_TRUE(motor::kMaxSnapshotMotors >= 32);
+}
+
+// Not a pass/fail check: prints queue and snapshot throughput under two-thread
+// contention so regressions are visible when run with `pio test -e native -v`.
+void test_queue_contention_benchmark() {
+  constexpr uint32_t kMessages = 500000;
+  transport::SpscRing<uint32_t> ring(32);
+  uint64_t producer_spins = 0;
+  const auto start = std::chrono::steady_clock::now();
+  std::thread producer([&]() {
+    for (uint32_t i = 0; i < kMessages; ++i) {
+      uint32_t value = i;
+      while (!ring.push(std::move(value))) {
+        ++producer_spins;
+        std::this_thread::yield();
+      }
+    }
+  });
+  uint64_t sum = 0;
+  for (uint32_t received = 0; received < kMessages;) {
+    uint32_t value = 0;
+    if (ring.pop(value)) {
+      sum += value;
+      ++received;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+  const double ring_s = ElapsedSeconds(start);
+  TEST_ASSERT_EQUAL_UINT64(static_cast<uint64_t>(kMessages) * (kMessages - 1) / 2, sum);
+
+  transport::SeqLock<motor::MotionSnapshot> lock;
+  std::atomic<bool> stop{false};
+  uint32_t writes = 0;
+  std::thread writer([&]() {
+    motor::MotionSnapshot snapshot;
+    while (!stop.load(std::memory_order_relaxed)) {
+      snapshot.taken_ms = ++writes;
+      lock.store(snapshot);
+    }
+  });
+  const auto read_start = std::chrono::steady_clock::now();
+  uint32_t reads = 0;
+  motor::MotionSnapshot out;
+  while (ElapsedSeconds(read_start) < 0.2) {
+    if (lock.load(out)) {
+      ++reads;
+    }
+  }
+  stop.store(true);
+  writer.join();
+  const double read_s = ElapsedSeconds(read_start);
+
+  char line[160];
+  std::snprintf(line,
+                sizeof(line),
+                "ring: %.0f msg/s (%llu producer spins); seqlock: %.0f reads/s, %.0f writes/s",
+                kMessages / ring_s,
+                static_cast<unsigned long long>(producer_spins),
+                reads / read_s,
+                writes / read_s);
+  TEST_MESSAGE(line);
+  TEST_ASSERT_TRUE(reads > 0);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_spsc_ring_preserves_order_across_threads);
+  RUN_TEST(test_spsc_ring_rejects_when_full);
+  RUN_TEST(test_seqlock_readers_never_see_torn_values);
+  RUN_TEST(test_motion_task_runs_inline_until_started);
+  RUN_TEST(test_motion_task_delivers_events_on_caller_thread);
+  RUN_TEST(test_motion_task_runs_net_commands_on_caller);
+  RUN_TEST(test_motion_task_never_drops_control_events);
+  RUN_TEST(test_snapshot_view_bounds_checks);
+  RUN_TEST(test_queue_contention_benchmark);
+  return UNITY_END();
+}
@@ -7,13 +7,18 @@
 #include "MotorControl/command/CommandUtils.h"
 #include "MotorControl/command/ResponseFormatter.h"
 #include "transport/CommandSchema.h"
+#include "transport/CompletionTracker.h"
 #include "transport/MessageId.h"
+#include "transport/ResponseDispatcher.h"
+#include "transport/ResponseModel.h"
 
 #include <cctype>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <string>
 #include <unity.h>
+#include <vector>
 
 using motor::command::CommandParser;
 using motor::command::ParseCsvQuoted;
@@ -84,17 +89,17 @@ void test_execute_reports_errors_structurally() {
 static std::string msg_id_from(const std::string& line) {
   auto pos = line.find("msg_id=");
   TEST_ASSERT_TRUE(pos != std::string::npos);
-  pos += 6;  // skip past 'msg_id='
+  pos += std::strlen("msg_id=");  // +6 would keep the '=' in the id
   size_t end = pos;
   while (end < line.size() && !isspace(static_cast<unsigned char>(line[end]))) {
     ++end;
   }
   auto id = line.substr(pos, end - pos);
-  TEST_ASSERT_TRUE(id.size() == 36);
-  TEST_ASSERT_EQUAL_CHAR('-', id[8]);
-  TEST_ASSERT_EQUAL_CHAR('-', id[13]);
-  TEST_ASSERT_EQUAL_CHAR('-', id[18]);
-  TEST_ASSERT_EQUAL_CHAR('-', id[23]);
+  // Default rendering is hex16 (see transport::message_id::Format).
+  TEST_ASSERT_TRUE(id.size() == 16);
+  for (char c : id) {
+    TEST_ASSERT_TRUE(isxdigit(static_cast<unsigned char>(c)));
+  }
   return id;
 }
 
@@ -135,3 +140,262 @@ void test_execute_cid_increments() {
       ("duplicate msg_id first=" + first_text + " second=" + second_text).c_str());
   transport::message_id::ResetGenerator();
 }
+
+void test_parser_splits_cmd_id_prefix() {
+  CommandParser parser;
+  std::string cmd_id;
+  std::string rest;
+  TEST_ASSERT_TRUE(parser.splitCmdIdPrefix("  #host-7 MOVE:0,100", cmd_id, rest));
+  TEST_ASSERT_EQUAL_STRING("host-7", cmd_id.c_str());
+  TEST_ASSERT_EQUAL_STRING("MOVE:0,100", rest.c_str());
+
+  TEST_ASSERT_TRUE(parser.splitCmdIdPrefix("STATUS", cmd_id, rest));
+  TEST_ASSERT_TRUE(cmd_id.empty());
+  TEST_ASSERT_EQUAL_STRING("STATUS", rest.c_str());
+
+  TEST_ASSERT_FALSE(parser.splitCmdIdPrefix("# MOVE:0,100", cmd_id, rest));
+  TEST_ASSERT_FALSE(parser.splitCmdIdPrefix("#a=b MOVE:0,100", cmd_id, rest));
+  std::string too_long = "#" + std::string(motor::command::kMaxCmdIdLength + 1, 'x') + " STATUS";
+  TEST_ASSERT_FALSE(parser.splitCmdIdPrefix(too_long, cmd_id, rest));
+
+  auto parsed = parser.parseLine("#job MOVE:0,100;SLEEP:1");
+  TEST_ASSERT_TRUE(parsed.cmd_id_valid);
+  TEST_ASSERT_EQUAL_STRING("job", parsed.cmd_id.c_str());
+  TEST_ASSERT_EQUAL_UINT(2, parsed.commands.size());
+  TEST_ASSERT_EQUAL_STRING("SLEEP", parsed.commands[1].action.c_str());
+  parsed = parser.parseLine("#bad!id MOVE:0,100");
+  TEST_ASSERT_FALSE(parsed.cmd_id_valid);
+  TEST_ASSERT_TRUE(parsed.commands.empty());
+}
+
+void test_cmd_id_prefix_echoed_on_ack_done_err() {
+  using transport::response::ResponseDispatcher;
+  transport::response::CompletionTracker::Instance().Clear();
+  std::vector<std::string> printed;
+  auto token = ResponseDispatcher::Instance().RegisterSink(
+      [&printed](const transport::response::Event& evt,
+                 const transport::command::ResponseLine* line) {
+        printed.push_back(transport::response::SerializeEvent(evt, line));
+      });
+
+  MotorCommandProcessor proc;
+  (void)proc.execute("#m0 MOVE:0,100", 0);
+  (void)proc.execute("#m1 MOVE:1,200", 0);
+  (void)proc.execute("#bad MOVE:9,10", 0);
+  for (uint32_t now = 0; now <= 5000; now += 100) {
+    proc.tick(now);
+    transport::response::CompletionTracker::Instance().Tick(now);
+  }
+  ResponseDispatcher::Instance().UnregisterSink(token);
+
+  auto count = [&printed](const char* prefix) {
+    size_t n = 0;
+    for (const auto& ln : printed) {
+      if (ln.rfind(prefix, 0) == 0) {
+        ++n;
+      }
+    }
+    return n;
+  };
+  TEST_ASSERT_EQUAL_UINT(1, count("CTRL:ACK msg_id=m0 "));
+  TEST_ASSERT_EQUAL_UINT(1, count("CTRL:ACK msg_id=m1 "));
+  TEST_ASSERT_EQUAL_UINT(1, count("CTRL:DONE cmd_id=m0 action=MOVE"));
+  TEST_ASSERT_EQUAL_UINT(1, count("CTRL:DONE cmd_id=m1 action=MOVE"));
+  TEST_ASSERT_EQUAL_UINT(1, count("CTRL:ERR msg_id=bad E02 BAD_ID"));
+}
+
+void test_cmd_id_prefix_batch_single_done() {
+  using transport::response::ResponseDispatcher;
+  transport::response::CompletionTracker::Instance().Clear();
+  size_t done_count = 0;
+  auto token = ResponseDispatcher::Instance().RegisterSink(
+      [&done_count](const transport::response::Event& evt,
+                    const transport::command::ResponseLine*) {
+        if (evt.type == transport::response::EventType::kDone && evt.cmd_id == "pair") {
+          ++done_count;
+        }
+      });
+
+  MotorCommandProcessor proc;
+  auto result = proc.execute("#pair MOVE:0,100;MOVE:1,400", 0);
+  TEST_ASSERT_FALSE(result.is_error);
+  std::string ack = transport::command::SerializeLine(result.structuredResponse().lines.back());
+  TEST_ASSERT_TRUE(ack.rfind("CTRL:ACK msg_id=pair ", 0) == 0);
+  for (uint32_t now = 0; now <= 5000; now += 100) {
+    proc.tick(now);
+    transport::response::CompletionTracker::Instance().Tick(now);
+  }
+  ResponseDispatcher::Instance().UnregisterSink(token);
+  TEST_ASSERT_EQUAL_UINT(1, done_count);
+}
+
+void test_cmd_id_reuse_supersedes_open_operation() {
+  using transport::response::ResponseDispatcher;
+  transport::response::CompletionTracker::Instance().Clear();
+  std::vector<uint32_t> done_at;
+  uint32_t now = 0;
+  auto token = ResponseDispatcher::Instance().RegisterSink(
+      [&done_at, &now](const transport::response::Event& evt,
+                       const transport::command::ResponseLine*) {
+        if (evt.type == transport::response::EventType::kDone && evt.cmd_id == "again") {
+          done_at.push_back(now);
+        }
+      });
+
+  MotorCommandProcessor proc;
+  (void)proc.execute("#again MOVE:0,1000", 0);
+  // Reused while still open: the DONE follows this line's motor only.
+  (void)proc.execute("#again MOVE:1,10", 0);
+  bool long_move_running_at_done = false;
+  for (now = 0; now <= 10000 && done_at.empty(); now += 100) {
+    proc.tick(now);
+    transport::response::CompletionTracker::Instance().Tick(now);
+    long_move_running_at_done = proc.controller().state(0).moving;
+  }
+  for (; now <= 10000; now += 100) {
+    proc.tick(now);
+    transport::response::CompletionTracker::Instance().Tick(now);
+  }
+  ResponseDispatcher::Instance().UnregisterSink(token);
+  TEST_ASSERT_EQUAL_UINT(1, done_at.size());
+  TEST_ASSERT_TRUE(long_move_running_at_done);
+}
+
+void test_restarted_motor_keeps_earlier_operation_waiting() {
+  using transport::response::ResponseDispatcher;
+  auto& tracker = transport::response::CompletionTracker::Instance();
+  tracker.Clear();
+  MotorCommandProcessor proc;
+  std::vector<std::string> done;
+  bool first_done_while_moving = false;
+  bool first_done_has_actual_ms = false;
+  auto token = ResponseDispatcher::Instance().RegisterSink(
+      [&](const transport::response::Event& evt, const transport::command::ResponseLine*) {
+        if (evt.type != transport::response::EventType::kDone) {
+          return;
+        }
+        done.push_back(evt.cmd_id.str());
+        if (evt.cmd_id == "first") {
+          first_done_while_moving = proc.controller().state(0).moving;
+          first_done_has_actual_ms =
+              transport::response::FindAttribute(evt, "actual_ms") != nullptr;
+        }
+      });
+
+  (void)proc.execute("#first MOVE:0,1000", 0);
+  // A backend that retargets a running motor hands it to the new operation.
+  tracker.BeginCommandLine();
+  tracker.RegisterOperation("second", "MOVE", 1u, proc.controller());
+  tracker.Tick(0);
+  TEST_ASSERT_TRUE(done.empty());
+  for (uint32_t now = 0; now <= 10000; now += 100) {
+    proc.tick(now);
+    tracker.Tick(now);
+  }
+  ResponseDispatcher::Instance().UnregisterSink(token);
+
+  TEST_ASSERT_EQUAL_UINT(2, done.size());
+  TEST_ASSERT_EQUAL_STRING("first", done[0].c_str());
+  TEST_ASSERT_EQUAL_STRING("second", done[1].c_str());
+  TEST_ASSERT_FALSE(first_done_while_moving);
+  TEST_ASSERT_TRUE(first_done_has_actual_ms);
+}
+
+void test_cmd_id_prefix_malformed_rejected() {
+  MotorCommandProcessor proc;
+  auto result = proc.execute("#bad!id STATUS", 0);
+  TEST_ASSERT_TRUE(result.is_error);
+  std::string text = transport::command::SerializeLine(result.structuredResponse().lines[0]);
+  TEST_ASSERT_TRUE(text.find("E03 BAD_PARAM CMD_ID") != std::string::npos);
+  // Lines without a prefix keep generating fresh ids.
+  auto plain = proc.execute("STATUS", 0);
+  TEST_ASSERT_FALSE(plain.is_error);
+  (void)msg_id_from(transport::command::SerializeLine(plain.structuredResponse().lines[0]));
+}
+
+void test_parser_types_motion_args() {
+  CommandParser parser;
+  auto cmds = parser.parse("M:3,-120,900,4000;HOME:ALL;SLEEP:1;GET LAST_OP_TIMING");
+  TEST_ASSERT_EQUAL_UINT32(4, cmds.size());
+  TEST_ASSERT_TRUE(cmds[0].motion_kind == motor::command::MotionKind::kMove);
+  TEST_ASSERT_TRUE(cmds[0].valid());
+  TEST_ASSERT_EQUAL_UINT32(1u << 3, cmds[0].motion.mask);
+  TEST_ASSERT_EQUAL_INT32(-120, cmds[0].motion.target);
+#if !(USE_SHARED_STEP)
+  TEST_ASSERT_EQUAL_INT(900, cmds[0].motion.speed);
+  TEST_ASSERT_EQUAL_INT(4000, cmds[0].motion.accel);
+#endif
+  TEST_ASSERT_TRUE(cmds[1].motion_kind == motor::command::MotionKind::kHome);
+  TEST_ASSERT_EQUAL_UINT32(0xFF, cmds[1].motion.mask);
+  TEST_ASSERT_TRUE(cmds[2].motion_kind == motor::command::MotionKind::kSleep);
+  TEST_ASSERT_EQUAL_UINT32(1u << 1, cmds[2].motion.mask);
+  TEST_ASSERT_FALSE(cmds[3].isMotion());
+
+  auto bad = parser.parse("MOVE:9,10;MOVE:0,999999;MOVE:0");
+  TEST_ASSERT_EQUAL_STRING("E02", bad[0].error_code.c_str());
+  TEST_ASSERT_EQUAL_STRING("E07", bad[1].error_code.c_str());
+  TEST_ASSERT_EQUAL_STRING("POS_OUT_OF_RANGE", bad[1].error_reason.c_str());
+  TEST_ASSERT_EQUAL_STRING("E03", bad[2].error_code.c_str());
+  TEST_ASSERT_EQUAL_UINT32(0, bad[2].motion.mask);
+}
+
+void test_batch_reports_all_validation_errors() {
+  MotorCommandProcessor proc;
+  auto result = proc.execute("MOVE:0,10;MOVE:9,5;FOO;HOME:0", 0);
+  TEST_ASSERT_TRUE(result.is_error);
+  const auto& lines = result.structuredResponse().lines;
+  TEST_ASSERT_EQUAL_UINT32(3, lines.size());
+  std::string first = transport::command::SerializeLine(lines[0]);
+  std::string second = transport::command::SerializeLine(lines[1]);
+  std::string third = transport::command::SerializeLine(lines[2]);
+  TEST_ASSERT_TRUE(first.find("E02 BAD_ID") != std::string::npos);
+  TEST_ASSERT_TRUE(first.find("index=1") != std::string::npos);
+  TEST_ASSERT_TRUE(second.find("E01 BAD_CMD") != std::string::npos);
+  TEST_ASSERT_TRUE(third.find("E03 BAD_PARAM MULTI_CMD_CONFLICT") != std::string::npos);
+  TEST_ASSERT_TRUE(third.find("index=3") != std::string::npos);
+  // All errors share one msg_id, and the valid MOVE was never started.
+  TEST_ASSERT_EQUAL_STRING(msg_id_from(first).c_str(), msg_id_from(third).c_str());
+  for (uint32_t now = 0; now <= 2000; now += 100) {
+    proc.tick(now);
+  }
+  std::string status = proc.processLine("STATUS", 2000);
+  size_t at = status.find("id=0 ");
+  TEST_ASSERT_TRUE(at != std::string::npos);
+  TEST_ASSERT_TRUE(status.find(" pos=0", at) < status.find('\n', at));
+}
+
+void test_completion_done_emitted_on_stop_tick() {
+  using transport::response::ResponseDispatcher;
+  transport::response::CompletionTracker::Instance().Clear();
+  std::vector<std::string> done_ids;
+  auto token = ResponseDispatcher::Instance().RegisterSink(
+      [&done_ids](const transport::response::Event& evt,
+                  const transport::command::ResponseLine*) {
+        if (evt.type == transport::response::EventType::kDone) {
+          done_ids.push_back(evt.cmd_id.str());
+        }
+      });
+
+  MotorCommandProcessor proc;
+  auto started = proc.execute("#pair MOVE:0,100;MOVE:1,1200", 0);
+  TEST_ASSERT_FALSE(started.is_error);
+  const uint32_t short_ms = proc.controller().state(0).last_op_est_ms;
+  const uint32_t long_ms = proc.controller().state(1).last_op_est_ms;
+  TEST_ASSERT_TRUE(short_ms < long_ms);
+
+  // Motor 0 stopping alone must not resolve the shared operation.
+  proc.tick(short_ms);
+  transport::response::CompletionTracker::Instance().Tick(short_ms);
+  TEST_ASSERT_EQUAL_UINT32(0, done_ids.size());
+
+  proc.tick(long_ms - 1);
+  transport::response::CompletionTracker::Instance().Tick(long_ms - 1);
+  TEST_ASSERT_EQUAL_UINT32(0, done_ids.size());
+
+  // The DONE goes out on the same tick the last motor stops.
+  proc.tick(long_ms);
+  transport::response::CompletionTracker::Instance().Tick(long_ms);
+  ResponseDispatcher::Instance().UnregisterSink(token);
+  TEST_ASSERT_EQUAL_UINT32(1, done_ids.size());
+  TEST_ASSERT_EQUAL_STRING("pair", done_ids[0].c_str());
+}
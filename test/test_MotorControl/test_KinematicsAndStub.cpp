@@ -28,6 +28,22 @@ void test_estimator_triangular_above_naive_bound() {
   TEST_ASSERT_TRUE(est >= naive);
 }
 
+void test_profile_speed_and_remaining_time() {
+  int v = 1000, a = 1000;
+  TEST_ASSERT_EQUAL_UINT32(0, MotionKinematics::profileSpeedSps(0, 3000, v, a));
+  TEST_ASSERT_EQUAL_UINT32(v, MotionKinematics::profileSpeedSps(1500, 1500, v, a));
+  TEST_ASSERT_EQUAL_UINT32(MotionKinematics::profileSpeedSps(200, 2800, v, a),
+                           MotionKinematics::profileSpeedSps(2800, 200, v, a));
+  // From rest the remaining time is the full estimate, for both profile shapes.
+  TEST_ASSERT_EQUAL_UINT32(MotionKinematics::estimateMoveTimeMs(3000, v, a),
+                           MotionKinematics::remainingMoveTimeMs(3000, 0, v, a));
+  TEST_ASSERT_EQUAL_UINT32(MotionKinematics::estimateMoveTimeMs(800, 4000, 16000),
+                           MotionKinematics::remainingMoveTimeMs(-800, 0, 4000, 16000));
+  // Cruising at full speed: 1000 steps of cruise, then a 500-step, 1 s brake.
+  TEST_ASSERT_EQUAL_UINT32(2000, MotionKinematics::remainingMoveTimeMs(1500, v, v, a));
+  TEST_ASSERT_EQUAL_UINT32(0, MotionKinematics::remainingMoveTimeMs(0, v, v, a));
+}
+
 void test_stub_move_uses_estimator_duration() {
   MotorCommandProcessor p;
   int d = 500, v = 1200, a = 8000;
@@ -45,6 +61,8 @@ void test_stub_move_uses_estimator_duration() {
   TEST_ASSERT_TRUE(st_pre.find(" moving=1") != std::string::npos);
   auto st_post = status_for(p, t);
   TEST_ASSERT_TRUE(st_post.find(" moving=0") != std::string::npos);
+  TEST_ASSERT_EQUAL_INT(0, p.controller().state(0).last_op_start_pos);
+  TEST_ASSERT_EQUAL_INT(d, p.controller().state(0).last_op_target);
 }
 
 void test_stub_home_uses_estimator_duration() {
@@ -11,7 +11,7 @@ namespace {
 std::string FieldValue(const transport::command::ResponseLine& line, const std::string& key) {
   for (const auto& field : line.fields) {
     if (field.key == key) {
-      return field.value;
+      return transport::command::FieldText(field);
     }
   }
   return std::string();
@@ -93,3 +93,112 @@ void test_mqtt_reset_to_defaults() {
   TEST_ASSERT_EQUAL_STRING(defaults.user.c_str(), cfg.user.c_str());
   TEST_ASSERT_EQUAL_STRING(defaults.pass.c_str(), cfg.pass.c_str());
 }
+
+void test_mqtt_set_config_groups() {
+  mqtt::ConfigStore::Instance().ResetForTests();
+  transport::message_id::ResetGenerator();
+  transport::message_id::ClearActive();
+  MotorCommandProcessor proc;
+  auto apply = proc.execute("MQTT:SET_CONFIG groups=\" wall , row-2,\"", 0);
+  TEST_ASSERT_FALSE(apply.is_error);
+  auto cfg = mqtt::ConfigStore::Instance().Current();
+  TEST_ASSERT_EQUAL_STRING("wall,row-2", cfg.groups.c_str());
+  TEST_ASSERT_TRUE(cfg.groups_overridden);
+
+  mqtt::ConfigStore::Instance().Reload();
+  auto verify = proc.execute("MQTT:GET_CONFIG", 0);
+  TEST_ASSERT_EQUAL_STRING(motor::command::QuoteString("wall,row-2").c_str(),
+                           FieldValue(verify.structuredResponse().lines[0], "groups").c_str());
+
+  // Names end up in topics, so wildcards and separators are refused.
+  auto bad = proc.execute("MQTT:SET_CONFIG groups=wall/+", 0);
+  TEST_ASSERT_EQUAL_STRING("MQTT_CONFIG_SAVE_FAILED",
+                           bad.structuredResponse().lines[0].code.c_str());
+  TEST_ASSERT_EQUAL_STRING("wall,row-2", mqtt::ConfigStore::Instance().Current().groups.c_str());
+
+  auto clear = proc.execute("MQTT:SET_CONFIG groups=\"\"", 0);
+  TEST_ASSERT_FALSE(clear.is_error);
+  TEST_ASSERT_TRUE(mqtt::ConfigStore::Instance().Current().groups.empty());
+}
+
+void test_mqtt_live_settings_keep_connection() {
+  mqtt::ConfigStore::Instance().ResetForTests();
+  transport::message_id::ResetGenerator();
+  transport::message_id::ClearActive();
+  MotorCommandProcessor proc;
+  auto applied = mqtt::ConfigStore::Instance().Current();
+  uint32_t revision = mqtt::ConfigStore::Instance().Revision();
+
+  // Groups bump the revision the client polls, but must not drop the broker session.
+  TEST_ASSERT_FALSE(proc.execute("MQTT:SET_CONFIG groups=wall", 0).is_error);
+  TEST_ASSERT_NOT_EQUAL(revision, mqtt::ConfigStore::Instance().Revision());
+  TEST_ASSERT_FALSE(
+      mqtt::ConnectionSettingsChanged(applied, mqtt::ConfigStore::Instance().Current()));
+
+  // Status settings are applied to the publisher directly.
+  TEST_ASSERT_FALSE(proc.execute("MQTT:SET_CONFIG status_max_hz=5", 0).is_error);
+  TEST_ASSERT_FALSE(
+      mqtt::ConnectionSettingsChanged(applied, mqtt::ConfigStore::Instance().Current()));
+
+  TEST_ASSERT_FALSE(proc.execute("MQTT:SET_CONFIG status_topics=both", 0).is_error);
+  TEST_ASSERT_FALSE(
+      mqtt::ConnectionSettingsChanged(applied, mqtt::ConfigStore::Instance().Current()));
+
+  TEST_ASSERT_FALSE(proc.execute("MQTT:SET_CONFIG host=10.0.0.9", 0).is_error);
+  TEST_ASSERT_TRUE(
+      mqtt::ConnectionSettingsChanged(applied, mqtt::ConfigStore::Instance().Current()));
+}
+
+void test_mqtt_set_config_status_max_hz() {
+  mqtt::ConfigStore::Instance().ResetForTests();
+  transport::message_id::ResetGenerator();
+  transport::message_id::ClearActive();
+  MotorCommandProcessor proc;
+  auto defaults = mqtt::ConfigStore::Instance().Defaults();
+  TEST_ASSERT_EQUAL_UINT16(20, defaults.status_max_hz);
+
+  auto apply = proc.execute("MQTT:SET_CONFIG status_max_hz=40", 0);
+  TEST_ASSERT_FALSE(apply.is_error);
+  TEST_ASSERT_EQUAL_STRING(
+      "40", FieldValue(apply.structuredResponse().lines[0], "status_max_hz").c_str());
+  mqtt::ConfigStore::Instance().Reload();
+  auto cfg = mqtt::ConfigStore::Instance().Current();
+  TEST_ASSERT_EQUAL_UINT16(40, cfg.status_max_hz);
+  TEST_ASSERT_TRUE(cfg.status_max_hz_overridden);
+
+  auto bad = proc.execute("MQTT:SET_CONFIG status_max_hz=51", 0);
+  TEST_ASSERT_EQUAL_STRING("INVALID_STATUS_MAX_HZ",
+                           bad.structuredResponse().lines[0].reason.c_str());
+  TEST_ASSERT_EQUAL_UINT16(40, mqtt::ConfigStore::Instance().Current().status_max_hz);
+
+  auto reset = proc.execute("MQTT:SET_CONFIG RESET", 0);
+  TEST_ASSERT_FALSE(reset.is_error);
+  TEST_ASSERT_EQUAL_UINT16(20, mqtt::ConfigStore::Instance().Current().status_max_hz);
+  TEST_ASSERT_FALSE(mqtt::ConfigStore::Instance().Current().status_max_hz_overridden);
+}
+
+void test_mqtt_set_config_status_topics() {
+  mqtt::ConfigStore::Instance().ResetForTests();
+  transport::message_id::ResetGenerator();
+  transport::message_id::ClearActive();
+  MotorCommandProcessor proc;
+  TEST_ASSERT_EQUAL_STRING("aggregate",
+                           mqtt::ConfigStore::Instance().Defaults().status_topics.c_str());
+
+  auto apply = proc.execute("MQTT:SET_CONFIG status_topics=Motors", 0);
+  TEST_ASSERT_FALSE(apply.is_error);
+  TEST_ASSERT_EQUAL_STRING(
+      "motors", FieldValue(apply.structuredResponse().lines[0], "status_topics").c_str());
+  mqtt::ConfigStore::Instance().Reload();
+  TEST_ASSERT_EQUAL_STRING("motors",
+                           mqtt::ConfigStore::Instance().Current().status_topics.c_str());
+
+  auto bad = proc.execute("MQTT:SET_CONFIG status_topics=each", 0);
+  TEST_ASSERT_EQUAL_STRING("INVALID_STATUS_TOPICS",
+                           bad.structuredResponse().lines[0].reason.c_str());
+
+  auto reset = proc.execute("MQTT:SET_CONFIG RESET", 0);
+  TEST_ASSERT_FALSE(reset.is_error);
+  TEST_ASSERT_EQUAL_STRING("aggregate",
+                           mqtt::ConfigStore::Instance().Current().status_topics.c_str());
+}
@@ -41,6 +41,27 @@ void test_get_set_decel_ok() {
   TEST_ASSERT_TRUE(r3.find("DECEL=9000") != std::string::npos);
 }
 
+void test_set_msg_id_format_switches_rendering() {
+  MotorCommandProcessor proto;
+  auto cmd_id_of = [](const std::string& line) {
+    size_t start = line.find("cmd_id=") + 7;
+    return line.substr(start, line.find(' ', start) - start);
+  };
+  auto r1 = proto.processLine("GET MSG_ID_FORMAT", 0);
+  TEST_ASSERT_TRUE(r1.find("MSG_ID_FORMAT=HEX") != std::string::npos);
+  TEST_ASSERT_EQUAL_UINT32(16, static_cast<uint32_t>(cmd_id_of(r1).size()));
+  auto r2 = proto.processLine("SET MSG_ID_FORMAT=UUID", 0);
+  TEST_ASSERT_TRUE(r2.rfind("CTRL:DONE", 0) == 0);
+  auto r3 = proto.processLine("GET ALL", 0);
+  TEST_ASSERT_TRUE(r3.find("MSG_ID_FORMAT=UUID") != std::string::npos);
+  TEST_ASSERT_EQUAL_UINT32(36, static_cast<uint32_t>(cmd_id_of(r3).size()));
+  auto r4 = proto.processLine("SET MSG_ID_FORMAT=DEC", 0);
+  TEST_ASSERT_TRUE(r4.find(" E03 BAD_PARAM") != std::string::npos);
+  TEST_ASSERT_TRUE(proto.processLine("SET MSG_ID_FORMAT=HEX", 0).rfind("CTRL:DONE", 0) == 0);
+  auto r5 = proto.processLine("GET MSG_ID_FORMAT", 0);
+  TEST_ASSERT_EQUAL_UINT32(16, static_cast<uint32_t>(cmd_id_of(r5).size()));
+}
+
 void test_set_decel_busy_reject() {
   MotorCommandProcessor proto;
   TEST_ASSERT_TRUE(proto.processLine("SET SPEED=4000", 0).rfind("CTRL:DONE", 0) == 0);
@@ -208,3 +208,97 @@ void test_steps_since_home_resets_after_second_home() {
   TEST_ASSERT_TRUE(find_line_for_id(lines2, 0, L0));
   TEST_ASSERT_TRUE(L0.find("steps_since_home=0") != std::string::npos);
 }
+
+static size_t count_frame_motors(const std::string& frame) {
+  size_t n = 0;
+  for (char c : frame) {
+    if (c == ' ') {
+      ++n;
+    }
+  }
+  return n == 0 ? 0 : n - 1;  // first space separates "ST" from t=
+}
+
+void test_sub_status_pushes_frames_on_cadence() {
+  MotorCommandProcessor p;
+  auto r = p.processLine("SUB STATUS,100", 0);
+  TEST_ASSERT_TRUE(r.rfind("CTRL:DONE", 0) == 0);
+  TEST_ASSERT_TRUE(r.find("interval_ms=100") != std::string::npos);
+  auto& sub = p.statusSubscription();
+  std::string frame;
+  TEST_ASSERT_TRUE(sub.poll(p.controller(), 0, frame));
+  TEST_ASSERT_EQUAL_STRING("ST t=0 0:0:0:0:900:0:4000:16000:0:0:0",
+                           frame.substr(0, frame.find(" 1:")).c_str());
+  TEST_ASSERT_EQUAL_UINT32(8, count_frame_motors(frame));
+  // Idle and unchanged: next frame is the 1 s heartbeat.
+  TEST_ASSERT_FALSE(sub.poll(p.controller(), 500, frame));
+  TEST_ASSERT_TRUE(sub.poll(p.controller(), 1000, frame));
+
+  TEST_ASSERT_TRUE(p.processLine("MOVE:0,100", 1000).rfind("CTRL:ACK", 0) == 0);
+  TEST_ASSERT_FALSE(sub.poll(p.controller(), 1050, frame));
+  p.tick(1100);
+  TEST_ASSERT_TRUE(sub.poll(p.controller(), 1100, frame));
+  TEST_ASSERT_TRUE(frame.find(" 0:") != std::string::npos);
+  TEST_ASSERT_TRUE(frame.rfind("ST t=1100 ", 0) == 0);
+
+  TEST_ASSERT_TRUE(p.processLine("UNSUB", 1200).rfind("CTRL:DONE", 0) == 0);
+  TEST_ASSERT_FALSE(sub.active());
+  TEST_ASSERT_FALSE(sub.poll(p.controller(), 5000, frame));
+}
+
+void test_sub_status_changes_only_lists_changed_motors() {
+  MotorCommandProcessor p;
+  auto r = p.processLine("SUB STATUS,50,changes_only", 0);
+  TEST_ASSERT_TRUE(r.find("changes_only=1") != std::string::npos);
+  auto& sub = p.statusSubscription();
+  std::string frame;
+  TEST_ASSERT_TRUE(sub.poll(p.controller(), 0, frame));
+  TEST_ASSERT_EQUAL_UINT32(8, count_frame_motors(frame));
+  // No heartbeat while nothing changes.
+  TEST_ASSERT_FALSE(sub.poll(p.controller(), 5000, frame));
+
+  TEST_ASSERT_TRUE(p.processLine("WAKE:3", 5000).rfind("CTRL:DONE", 0) == 0);
+  TEST_ASSERT_TRUE(sub.poll(p.controller(), 5000, frame));
+  TEST_ASSERT_EQUAL_UINT32(1, count_frame_motors(frame));
+  TEST_ASSERT_TRUE(frame.rfind("ST t=5000 3:0:2:", 0) == 0);
+}
+
+void test_sub_status_rejects_bad_params() {
+  MotorCommandProcessor p;
+  TEST_ASSERT_TRUE(p.processLine("SUB STATUS", 0).find("E03") != std::string::npos);
+  TEST_ASSERT_TRUE(p.processLine("SUB STATUS,5", 0).find("E03") != std::string::npos);
+  TEST_ASSERT_TRUE(p.processLine("SUB NET,100", 0).find("E03") != std::string::npos);
+  TEST_ASSERT_TRUE(p.processLine("SUB STATUS,100,bogus", 0).find("E03") != std::string::npos);
+  TEST_ASSERT_TRUE(p.processLine("UNSUB NET", 0).find("E03") != std::string::npos);
+  TEST_ASSERT_FALSE(p.statusSubscription().active());
+}
+
+static uint32_t ack_seq(const std::string& out) {
+  size_t pos = out.find("seq=");
+  TEST_ASSERT_TRUE(pos != std::string::npos);
+  return static_cast<uint32_t>(std::stoul(out.substr(pos + 4)));
+}
+
+void test_status_since_returns_only_changed_motors() {
+  MotorCommandProcessor p;
+  auto full = p.processLine("STATUS", 0);
+  const uint32_t seq0 = ack_seq(full);
+  TEST_ASSERT_TRUE(seq0 > 0);
+  TEST_ASSERT_EQUAL_UINT32(9, split_lines_sb(full).size());
+
+  // Nothing changed: only the ACK comes back, with the same sequence.
+  auto idle = p.processLine("STATUS:SINCE=" + std::to_string(seq0), 1000);
+  TEST_ASSERT_EQUAL_UINT32(1, split_lines_sb(idle).size());
+  TEST_ASSERT_EQUAL_UINT32(seq0, ack_seq(idle));
+
+  TEST_ASSERT_TRUE(p.processLine("MOVE:2,100", 1000).rfind("CTRL:ACK", 0) == 0);
+  auto delta = p.processLine("STATUS:SINCE=" + std::to_string(seq0), 1001);
+  auto lines = split_lines_sb(delta);
+  TEST_ASSERT_EQUAL_UINT32(2, lines.size());
+  TEST_ASSERT_TRUE(lines[1].rfind("id=2 ", 0) == 0);
+  TEST_ASSERT_TRUE(ack_seq(delta) > seq0);
+
+  // SINCE=0 is a full listing.
+  TEST_ASSERT_EQUAL_UINT32(9, split_lines_sb(p.processLine("STATUS:SINCE=0", 1002)).size());
+  TEST_ASSERT_TRUE(p.processLine("STATUS:SINCE=x", 1002).find("E03") != std::string::npos);
+}
@@ -30,6 +30,10 @@ void test_budget_clamps_and_ttfc_non_negative();
 void test_ttfc_clamp_and_recovery();
 void test_homed_resets_on_reboot();
 void test_steps_since_home_resets_after_second_home();
+void test_sub_status_pushes_frames_on_cadence();
+void test_sub_status_changes_only_lists_changed_motors();
+void test_sub_status_rejects_bad_params();
+void test_status_since_returns_only_changed_motors();
 
 // Thermal
 void test_help_includes_thermal_get_set();
@@ -52,6 +56,7 @@ void test_flow_set_on_move_exceeds_max_err();
 // KinematicsAndStub
 void test_estimator_trapezoidal_matches_simple_formula();
 void test_estimator_triangular_above_naive_bound();
+void test_profile_speed_and_remaining_time();
 void test_stub_move_uses_estimator_duration();
 void test_stub_home_uses_estimator_duration();
 
@@ -90,6 +95,7 @@ void test_get_set_accel_ok();
 void test_get_set_decel_ok();
 void test_set_speed_busy_reject();
 void test_set_decel_busy_reject();
+void test_set_msg_id_format_switches_rendering();
 void test_home_uses_speed_accel_globals();
 
 // Multi-command
@@ -107,9 +113,22 @@ void test_execute_matches_serial_output();
 void test_execute_reports_errors_structurally();
 void test_batch_aggregates_estimate();
 void test_execute_cid_increments();
+void test_parser_splits_cmd_id_prefix();
+void test_cmd_id_prefix_echoed_on_ack_done_err();
+void test_cmd_id_prefix_batch_single_done();
+void test_cmd_id_reuse_supersedes_open_operation();
+void test_restarted_motor_keeps_earlier_operation_waiting();
+void test_cmd_id_prefix_malformed_rejected();
+void test_parser_types_motion_args();
+void test_batch_reports_all_validation_errors();
+void test_completion_done_emitted_on_stop_tick();
 void test_mqtt_get_config_defaults();
 void test_mqtt_set_config_persist();
 void test_mqtt_reset_to_defaults();
+void test_mqtt_set_config_groups();
+void test_mqtt_live_settings_keep_connection();
+void test_mqtt_set_config_status_max_hz();
+void test_mqtt_set_config_status_topics();
 
 extern void setUp();
 extern void tearDown();
@@ -172,6 +191,14 @@ int main(int, char**) {
   RUN_TEST(test_homed_resets_on_reboot);
   setUp();
   RUN_TEST(test_steps_since_home_resets_after_second_home);
+  setUp();
+  RUN_TEST(test_sub_status_pushes_frames_on_cadence);
+  setUp();
+  RUN_TEST(test_sub_status_changes_only_lists_changed_motors);
+  setUp();
+  RUN_TEST(test_sub_status_rejects_bad_params);
+  setUp();
+  RUN_TEST(test_status_since_returns_only_changed_motors);
 
   // Thermal flag GET/SET (preflight/enforcement)
   setUp();
@@ -211,6 +238,8 @@ int main(int, char**) {
   setUp();
   RUN_TEST(test_estimator_triangular_above_naive_bound);
   setUp();
+  RUN_TEST(test_profile_speed_and_remaining_time);
+  setUp();
   RUN_TEST(test_stub_move_uses_estimator_duration);
   setUp();
   RUN_TEST(test_stub_home_uses_estimator_duration);
@@ -276,6 +305,7 @@ int main(int, char**) {
   RUN_TEST(test_set_speed_busy_reject);
   setUp();
   RUN_TEST(test_set_decel_busy_reject);
+  RUN_TEST(test_set_msg_id_format_switches_rendering);
   setUp();
   RUN_TEST(test_home_uses_speed_accel_globals);
 
@@ -297,11 +327,31 @@ int main(int, char**) {
   setUp();
   RUN_TEST(test_execute_cid_increments);
   setUp();
+  RUN_TEST(test_parser_splits_cmd_id_prefix);
+  setUp();
+  RUN_TEST(test_cmd_id_prefix_echoed_on_ack_done_err);
+  setUp();
+  RUN_TEST(test_cmd_id_prefix_batch_single_done);
+  RUN_TEST(test_cmd_id_reuse_supersedes_open_operation);
+  RUN_TEST(test_restarted_motor_keeps_earlier_operation_waiting);
+  setUp();
+  RUN_TEST(test_cmd_id_prefix_malformed_rejected);
+  setUp();
+  RUN_TEST(test_parser_types_motion_args);
+  setUp();
+  RUN_TEST(test_batch_reports_all_validation_errors);
+  setUp();
+  RUN_TEST(test_completion_done_emitted_on_stop_tick);
+  setUp();
   RUN_TEST(test_mqtt_get_config_defaults);
   setUp();
   RUN_TEST(test_mqtt_set_config_persist);
   setUp();
   RUN_TEST(test_mqtt_reset_to_defaults);
+  RUN_TEST(test_mqtt_set_config_groups);
+  RUN_TEST(test_mqtt_live_settings_keep_connection);
+  RUN_TEST(test_mqtt_set_config_status_max_hz);
+  RUN_TEST(test_mqtt_set_config_status_topics);
 
   // Multi-command parsing
   setUp();
@@ -23,6 +23,10 @@ void connectNet(net_onboarding::NetOnboarding& net) {
 
 }  // namespace
 
+void test_publish_queue_orders_by_priority();
+void test_publish_queue_responses_survive_burst();
+void test_publish_queue_keeps_sequenced_statuses();
+
 void test_presence_payload_formatting() {
   net_onboarding::NetOnboarding net;
   connectNet(net);
@@ -127,5 +131,8 @@ int main(int, char**) {
   RUN_TEST(test_presence_republish_on_force);
   RUN_TEST(test_presence_logs_failure_once);
   RUN_TEST(test_presence_failure_log_resets_after_connect);
+  RUN_TEST(test_publish_queue_orders_by_priority);
+  RUN_TEST(test_publish_queue_responses_survive_burst);
+  RUN_TEST(test_publish_queue_keeps_sequenced_statuses);
   return UNITY_END();
 }
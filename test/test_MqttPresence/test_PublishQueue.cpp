@@ -0,0 +1,105 @@
+#include "mqtt/PublishQueue.h"
+
+#include <string>
+#include <unity.h>
+#include <vector>
+
+using mqtt::PublishMessage;
+using mqtt::PublishPriority;
+
+namespace {
+
+PublishMessage makeMessage(PublishPriority priority,
+                           const std::string& topic,
+                           const std::string& payload) {
+  PublishMessage msg;
+  msg.topic = topic;
+  msg.payload = payload;
+  msg.priority = priority;
+  return msg;
+}
+
+std::vector<std::string> drain(mqtt::PublishQueue& queue) {
+  std::vector<std::string> out;
+  while (const PublishMessage* msg = queue.front()) {
+    out.push_back(msg->payload);
+    queue.pop();
+  }
+  return out;
+}
+
+}  // namespace
+
+void test_publish_queue_orders_by_priority() {
+  mqtt::PublishQueue queue(8, 32);
+  TEST_ASSERT_TRUE(queue.push(makeMessage(PublishPriority::kInfo, "devices/x/stats", "i1")));
+  TEST_ASSERT_TRUE(queue.push(makeMessage(PublishPriority::kStatus, "devices/x/status", "s1")));
+  TEST_ASSERT_TRUE(queue.push(makeMessage(PublishPriority::kResponse, "devices/x/cmd/resp", "a")));
+  TEST_ASSERT_TRUE(queue.push(makeMessage(PublishPriority::kResponse, "devices/x/cmd/resp", "d")));
+  // Latest wins per status topic, keeping its place in the queue.
+  TEST_ASSERT_TRUE(queue.push(makeMessage(PublishPriority::kStatus, "devices/x/status", "s2")));
+  TEST_ASSERT_TRUE(
+      queue.push(makeMessage(PublishPriority::kStatus, "devices/x/motors/0/status", "m0")));
+  TEST_ASSERT_EQUAL_UINT32(5, queue.size());
+
+  const std::vector<std::string> sent = drain(queue);
+  const std::vector<std::string> expected = {"a", "d", "s2", "m0", "i1"};
+  TEST_ASSERT_EQUAL_UINT32(expected.size(), sent.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    TEST_ASSERT_EQUAL_STRING(expected[i].c_str(), sent[i].c_str());
+  }
+  TEST_ASSERT_EQUAL_UINT32(1, queue.stats().status_superseded);
+  TEST_ASSERT_EQUAL_UINT32(5, queue.stats().high_water);
+  TEST_ASSERT_TRUE(queue.empty());
+}
+
+void test_publish_queue_responses_survive_burst() {
+  mqtt::PublishQueue queue(4, 32);
+  TEST_ASSERT_TRUE(queue.push(makeMessage(PublishPriority::kInfo, "devices/x/stats", "i")));
+  TEST_ASSERT_TRUE(queue.push(makeMessage(PublishPriority::kStatus, "devices/x/status", "s")));
+  TEST_ASSERT_TRUE(queue.push(makeMessage(PublishPriority::kResponse, "r", "done-1")));
+  TEST_ASSERT_TRUE(queue.push(makeMessage(PublishPriority::kResponse, "r", "done-2")));
+
+  // A full queue makes room for responses by dropping info, then status.
+  TEST_ASSERT_TRUE(queue.push(makeMessage(PublishPriority::kResponse, "r", "done-3")));
+  TEST_ASSERT_TRUE(queue.push(makeMessage(PublishPriority::kResponse, "r", "done-4")));
+  TEST_ASSERT_EQUAL_UINT32(1, queue.stats().info_dropped);
+  TEST_ASSERT_EQUAL_UINT32(1, queue.stats().status_dropped);
+
+  // Once it holds only responses, new ones are refused instead of evicting.
+  TEST_ASSERT_FALSE(queue.push(makeMessage(PublishPriority::kResponse, "r", "done-5")));
+  TEST_ASSERT_FALSE(queue.push(makeMessage(PublishPriority::kStatus, "devices/x/status", "s")));
+  TEST_ASSERT_FALSE(queue.push(makeMessage(PublishPriority::kInfo, "devices/x/stats", "i")));
+  TEST_ASSERT_EQUAL_UINT32(1, queue.stats().responses_refused);
+  TEST_ASSERT_EQUAL_UINT32(2, queue.stats().status_dropped);
+  TEST_ASSERT_EQUAL_UINT32(2, queue.stats().info_dropped);
+
+  const std::vector<std::string> sent = drain(queue);
+  TEST_ASSERT_EQUAL_UINT32(4, sent.size());
+  TEST_ASSERT_EQUAL_STRING("done-1", sent[0].c_str());
+  TEST_ASSERT_EQUAL_STRING("done-4", sent[3].c_str());
+  TEST_ASSERT_EQUAL_UINT32(4, queue.stats().high_water);
+}
+
+void test_publish_queue_keeps_sequenced_statuses() {
+  mqtt::PublishQueue queue(8, 32);
+  TEST_ASSERT_TRUE(queue.push(makeMessage(PublishPriority::kSequenced, "devices/x/status", "k0")));
+  // A later delta on the same topic queues behind the one it builds on.
+  TEST_ASSERT_TRUE(queue.push(makeMessage(PublishPriority::kSequenced, "devices/x/status", "d1")));
+  TEST_ASSERT_EQUAL_UINT32(0, queue.stats().status_superseded);
+  // A quarter of the slots is the most they may hold; the rest stay for responses.
+  TEST_ASSERT_FALSE(queue.push(makeMessage(PublishPriority::kSequenced, "devices/x/status", "d2")));
+  TEST_ASSERT_EQUAL_UINT32(1, queue.stats().sequenced_refused);
+
+  for (int i = 0; i < 6; ++i) {
+    TEST_ASSERT_TRUE(queue.push(makeMessage(PublishPriority::kResponse, "r", "done")));
+  }
+  // Responses cannot evict them either.
+  TEST_ASSERT_FALSE(queue.push(makeMessage(PublishPriority::kResponse, "r", "late")));
+  TEST_ASSERT_EQUAL_UINT32(1, queue.stats().responses_refused);
+
+  const std::vector<std::string> sent = drain(queue);
+  TEST_ASSERT_EQUAL_UINT32(8, sent.size());
+  TEST_ASSERT_EQUAL_STRING("k0", sent[6].c_str());
+  TEST_ASSERT_EQUAL_STRING("d1", sent[7].c_str());
+}
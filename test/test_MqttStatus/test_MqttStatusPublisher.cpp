@@ -1,7 +1,9 @@
 #include "MotorControl/MotorControlConstants.h"
 #include "mqtt/MqttStatusPublisher.h"
+#include "mqtt/PublishQueue.h"
 #include "net_onboarding/NetOnboarding.h"
 
+#include <ArduinoJson.h>
 #include <algorithm>
 #include <cstdint>
 #include <string>
@@ -59,6 +61,10 @@ public:
   std::vector<MotorState>& data() {
     return motors_;
   }
+  // Stands in for the end of a real tick(): bumps the change sequence.
+  void commitChanges() {
+    recordVisibleChanges();
+  }
 
 private:
   std::vector<MotorState> motors_;
@@ -176,9 +182,389 @@ void test_status_publisher_cadence_and_changes() {
   TEST_ASSERT_EQUAL_INT(2, countOccurrences(latest, "\"actual_ms\":"));
 }
 
+void test_status_publisher_msgpack_snapshot() {
+  net_onboarding::NetOnboarding net;
+  connectNet(net);
+
+  StubController controller({makeMotor(0), makeMotor(1)});
+
+  std::vector<PublishMessage> published;
+  auto publish_fn = [&](const PublishMessage& msg) {
+    published.push_back(msg);
+    return true;
+  };
+
+  mqtt::MqttStatusPublisher json_publisher(publish_fn, net);
+  json_publisher.setTopic("devices/02123456789a/status");
+  json_publisher.loop(controller, 0);
+  mqtt::MqttStatusPublisher::Config cfg;
+  cfg.encoding = transport::PayloadEncoding::kMsgPack;
+  mqtt::MqttStatusPublisher publisher(publish_fn, net, cfg);
+  publisher.setTopic("devices/02123456789a/status");
+  publisher.loop(controller, 0);
+
+  TEST_ASSERT_EQUAL_INT(2, static_cast<int>(published.size()));
+  TEST_ASSERT_EQUAL_STRING("devices/02123456789a/status.mp", published[1].topic.c_str());
+  TEST_ASSERT_TRUE(published[1].payload.size() < published[0].payload.size());
+
+  ArduinoJson::JsonDocument doc;
+  TEST_ASSERT_FALSE(ArduinoJson::deserializeMsgPack(doc, published[1].payload));
+  TEST_ASSERT_EQUAL_STRING("ready", doc["node_state"].as<const char*>());
+  TEST_ASSERT_EQUAL_STRING("10.0.0.2", doc["ip"].as<const char*>());
+  TEST_ASSERT_EQUAL_INT(120, doc["motors"]["1"]["position"].as<int>());
+  TEST_ASSERT_TRUE(doc["motors"]["1"]["moving"].as<bool>());
+  TEST_ASSERT_EQUAL_INT(800000, doc["motors"]["0"]["started_ms"].as<int>());
+  TEST_ASSERT_TRUE(doc["motors"]["0"]["budget_s"].as<double>() > 89.9);
+  TEST_ASSERT_TRUE(doc["motors"]["1"]["actual_ms"].isNull());
+}
+
+void test_status_publisher_delta_mode() {
+  net_onboarding::NetOnboarding net;
+  connectNet(net);
+
+  std::vector<MotorState> motors;
+  for (uint8_t id = 0; id < 8; ++id) {
+    MotorState motor = makeMotor(id);
+    motor.moving = (id == 3);
+    motor.last_op_ongoing = (id == 3);
+    motor.last_op_start_pos = 0;
+    motor.last_op_target = (id == 3) ? 1000 : motor.position;
+    motors.push_back(motor);
+  }
+  StubController controller(motors);
+
+  std::vector<PublishMessage> published;
+  auto publish_fn = [&](const PublishMessage& msg) {
+    published.push_back(msg);
+    return true;
+  };
+
+  mqtt::MqttStatusPublisher::Config cfg;
+  cfg.delta = true;
+  mqtt::MqttStatusPublisher publisher(publish_fn, net, cfg);
+  publisher.setTopic("devices/02123456789a/status");
+  publisher.loop(controller, 0);
+  TEST_ASSERT_EQUAL_INT(1, static_cast<int>(published.size()));
+  const std::string& keyframe = published[0].payload;
+  TEST_ASSERT_NOT_EQUAL(-1, static_cast<int>(keyframe.find("\"seq\":0,\"key\":true")));
+  TEST_ASSERT_EQUAL_INT(8, countOccurrences(keyframe, "\"steps_since_home\":"));
+
+  // One motor moving: only its position and prediction go out.
+  controller.data()[3].position += 40;
+  publisher.loop(controller, 200);
+  TEST_ASSERT_EQUAL_INT(2, static_cast<int>(published.size()));
+  TEST_ASSERT_EQUAL_STRING("{\"seq\":1,\"ts_ms\":200,\"motors\":{\"3\":{\"position\":400,"
+                           "\"velocity\":3578,\"eta_ms\":278}}}",
+                           published[1].payload.c_str());
+  TEST_ASSERT_TRUE(published[1].payload.size() < 100);
+
+  // Heartbeats carry just the sequence number.
+  publisher.loop(controller, 400);
+  TEST_ASSERT_EQUAL_STRING("{\"seq\":2}", published[2].payload.c_str());
+
+  controller.data()[3].moving = false;
+  controller.data()[3].last_op_ongoing = false;
+  controller.data()[5].last_op_ongoing = true;
+  publisher.loop(controller, 450);
+  TEST_ASSERT_EQUAL_STRING("{\"seq\":3,\"ts_ms\":450,\"motors\":{\"3\":{\"moving\":false,"
+                           "\"target\":400,\"velocity\":0,\"eta_ms\":0,\"actual_ms\":280},"
+                           "\"5\":{\"actual_ms\":null}}}",
+                           published[3].payload.c_str());
+
+  // A consumer that noticed a gap asks for a keyframe; they also recur on a timer.
+  publisher.requestKeyframe();
+  publisher.loop(controller, 460);
+  TEST_ASSERT_EQUAL_INT(5, static_cast<int>(published.size()));
+  TEST_ASSERT_NOT_EQUAL(-1, static_cast<int>(published[4].payload.find("\"seq\":4,\"key\":true")));
+  publisher.loop(controller, 1460);
+  TEST_ASSERT_EQUAL_STRING("{\"seq\":5}", published[5].payload.c_str());
+  publisher.loop(controller, 10460);
+  TEST_ASSERT_NOT_EQUAL(-1, static_cast<int>(published[6].payload.find("\"seq\":6,\"key\":true")));
+}
+
+void test_status_publisher_delta_survives_full_queue() {
+  net_onboarding::NetOnboarding net;
+  connectNet(net);
+
+  MotorState motor = makeMotor(0);
+  motor.moving = false;
+  StubController controller({motor});
+  controller.commitChanges();
+
+  // Four slots leave room for one queued delta-mode status.
+  mqtt::PublishQueue queue(4, 64);
+  auto publish_fn = [&](const PublishMessage& msg) { return queue.push(msg); };
+  auto drain = [&]() {
+    std::vector<std::string> out;
+    while (const PublishMessage* msg = queue.front()) {
+      out.push_back(msg->payload);
+      queue.pop();
+    }
+    return out;
+  };
+
+  mqtt::MqttStatusPublisher::Config cfg;
+  cfg.encoding = transport::PayloadEncoding::kJson;
+  cfg.delta = true;
+  mqtt::MqttStatusPublisher publisher(publish_fn, net, cfg);
+  publisher.setTopic("devices/02123456789a/status");
+  publisher.loop(controller, 0);
+  TEST_ASSERT_EQUAL_UINT32(1, publisher.nextSeq());
+
+  // The keyframe is still waiting, so the delta is refused instead of
+  // replacing it, and "seq" does not move.
+  controller.data()[0].position = 777;
+  controller.commitChanges();
+  publisher.loop(controller, 200);
+  TEST_ASSERT_EQUAL_UINT32(1, publisher.nextSeq());
+  std::vector<std::string> sent = drain();
+  TEST_ASSERT_EQUAL_UINT32(1, sent.size());
+  TEST_ASSERT_NOT_EQUAL(-1, static_cast<int>(sent[0].find("\"seq\":0,\"key\":true")));
+
+  // Once it went out, the retried delta builds on that keyframe.
+  publisher.loop(controller, 300);
+  TEST_ASSERT_EQUAL_UINT32(2, publisher.nextSeq());
+  sent = drain();
+  TEST_ASSERT_EQUAL_UINT32(1, sent.size());
+  TEST_ASSERT_EQUAL_INT(0, static_cast<int>(sent[0].find("{\"seq\":1,")));
+  TEST_ASSERT_NOT_EQUAL(-1, static_cast<int>(sent[0].find("\"position\":777")));
+}
+
+void test_status_publisher_rebuilds_only_on_change_seq() {
+  net_onboarding::NetOnboarding net;
+  connectNet(net);
+
+  StubController controller({makeMotor(0), makeMotor(1)});
+  controller.commitChanges();
+
+  std::vector<PublishMessage> published;
+  auto publish_fn = [&](const PublishMessage& msg) {
+    published.push_back(msg);
+    return true;
+  };
+
+  mqtt::MqttStatusPublisher publisher(publish_fn, net);
+  publisher.setTopic("devices/02123456789a/status");
+  publisher.loop(controller, 0);
+  TEST_ASSERT_EQUAL_INT(1, static_cast<int>(published.size()));
+  const std::string first = published[0].payload;
+
+  // Without a new change sequence the cached snapshot is reused as is.
+  controller.data()[0].position = 999;
+  publisher.loop(controller, 50);
+  TEST_ASSERT_EQUAL_INT(1, static_cast<int>(published.size()));
+  publisher.loop(controller, 200);
+  TEST_ASSERT_EQUAL_INT(2, static_cast<int>(published.size()));
+  TEST_ASSERT_EQUAL_STRING(first.c_str(), published[1].payload.c_str());
+
+  // Idle changes are still spaced by the 20 Hz ceiling.
+  controller.commitChanges();
+  publisher.loop(controller, 210);
+  TEST_ASSERT_EQUAL_INT(2, static_cast<int>(published.size()));
+  publisher.loop(controller, 250);
+  TEST_ASSERT_EQUAL_INT(3, static_cast<int>(published.size()));
+  const std::string& changed = published[2].payload;
+  TEST_ASSERT_NOT_EQUAL(-1, static_cast<int>(changed.find("\"0\":{\"id\":0,\"position\":999")));
+  TEST_ASSERT_NOT_EQUAL(-1, static_cast<int>(changed.find("\"1\":{\"id\":1,\"position\":120")));
+  TEST_ASSERT_EQUAL_INT(2, countOccurrences(changed, "\"speed\":4000"));
+
+  // A network transition is picked up even while the motors stay put.
+  net.resetCredentials();
+  publisher.loop(controller, 300);
+  TEST_ASSERT_EQUAL_INT(4, static_cast<int>(published.size()));
+  TEST_ASSERT_EQUAL_INT(-1, static_cast<int>(published[3].payload.find("10.0.0.2")));
+}
+
+void test_status_publisher_adaptive_rate() {
+  net_onboarding::NetOnboarding net;
+  connectNet(net);
+
+  MotorState motor = makeMotor(0);
+  motor.last_op_target = 4000;
+  StubController controller({motor});
+  controller.commitChanges();
+
+  std::vector<PublishMessage> published;
+  auto publish_fn = [&](const PublishMessage& msg) {
+    published.push_back(msg);
+    return true;
+  };
+  size_t queue_depth = 0;
+
+  mqtt::MqttStatusPublisher publisher(publish_fn, net);
+  publisher.setQueueDepthFn([&]() { return queue_depth; });
+  publisher.setTopic("devices/02123456789a/status");
+  publisher.loop(controller, 0);
+  TEST_ASSERT_EQUAL_INT(1, static_cast<int>(published.size()));
+  TEST_ASSERT_NOT_EQUAL(-1, static_cast<int>(published[0].payload.find("\"rate_hz\":20")));
+
+  auto step = [&](uint32_t now_ms) {
+    controller.data()[0].position += 10;
+    controller.commitChanges();
+    publisher.loop(controller, now_ms);
+  };
+
+  // Starting a move boosts to the 20 Hz ceiling: changes go out 50 ms apart.
+  controller.data()[0].moving = true;
+  step(100);
+  TEST_ASSERT_EQUAL_INT(2, static_cast<int>(published.size()));
+  step(130);
+  TEST_ASSERT_EQUAL_INT(2, static_cast<int>(published.size()));
+  step(150);
+  TEST_ASSERT_EQUAL_INT(3, static_cast<int>(published.size()));
+
+  // Once the boost window closes, steady motion settles at the 5 Hz motion rate.
+  step(1100);
+  TEST_ASSERT_EQUAL_INT(4, static_cast<int>(published.size()));
+  TEST_ASSERT_EQUAL_UINT32(5, publisher.rateHz());
+  TEST_ASSERT_NOT_EQUAL(-1, static_cast<int>(published[3].payload.find("\"rate_hz\":5")));
+  step(1200);
+  TEST_ASSERT_EQUAL_INT(4, static_cast<int>(published.size()));
+  step(1300);
+  TEST_ASSERT_EQUAL_INT(5, static_cast<int>(published.size()));
+
+  // A backed-up publish queue halves the rate, once per interval.
+  queue_depth = 3;
+  step(1350);
+  TEST_ASSERT_EQUAL_UINT32(2, publisher.rateHz());
+  step(1400);
+  TEST_ASSERT_EQUAL_UINT32(2, publisher.rateHz());
+  step(1800);
+  TEST_ASSERT_EQUAL_UINT32(2, publisher.rateHz());
+  TEST_ASSERT_EQUAL_INT(6, static_cast<int>(published.size()));
+  step(1900);
+  TEST_ASSERT_EQUAL_UINT32(1, publisher.rateHz());
+
+  // A drained queue lets the rate climb back, doubling each quiet second.
+  queue_depth = 0;
+  step(2900);
+  TEST_ASSERT_EQUAL_UINT32(2, publisher.rateHz());
+  step(3900);
+  TEST_ASSERT_EQUAL_UINT32(4, publisher.rateHz());
+  step(4900);
+  TEST_ASSERT_EQUAL_UINT32(5, publisher.rateHz());
+
+  // Stopping boosts again, up to a ceiling lowered over MQTT:SET_CONFIG.
+  publisher.setMaxRateHz(10);
+  controller.data()[0].moving = false;
+  step(5000);
+  TEST_ASSERT_EQUAL_UINT32(10, publisher.rateHz());
+}
+
+void test_status_publisher_motor_topics() {
+  net_onboarding::NetOnboarding net;
+  connectNet(net);
+
+  StubController controller({makeMotor(0), makeMotor(1), makeMotor(2)});
+  controller.commitChanges();
+
+  std::vector<PublishMessage> published;
+  auto publish_fn = [&](const PublishMessage& msg) {
+    published.push_back(msg);
+    return true;
+  };
+
+  mqtt::MqttStatusPublisher::Config cfg;
+  cfg.encoding = transport::PayloadEncoding::kJson;
+  cfg.aggregate_topic = false;
+  cfg.motor_topics = true;
+  mqtt::MqttStatusPublisher publisher(publish_fn, net, cfg);
+  publisher.setTopic("devices/02123456789a/status");
+  publisher.loop(controller, 0);
+  TEST_ASSERT_EQUAL_INT(3, static_cast<int>(published.size()));
+  TEST_ASSERT_EQUAL_STRING("devices/02123456789a/motors/2/status", published[2].topic.c_str());
+  TEST_ASSERT_TRUE(published[2].retain);
+  TEST_ASSERT_NOT_EQUAL(-1,
+                        static_cast<int>(published[2].payload.find("{\"ts_ms\":0,\"id\":2,")));
+  TEST_ASSERT_EQUAL_INT(-1, static_cast<int>(published[2].payload.find("\"motors\"")));
+
+  // Only the motor that changed goes out; heartbeats send nothing.
+  controller.data()[1].position += 25;
+  controller.commitChanges();
+  publisher.loop(controller, 100);
+  TEST_ASSERT_EQUAL_INT(4, static_cast<int>(published.size()));
+  TEST_ASSERT_EQUAL_STRING("devices/02123456789a/motors/1/status", published[3].topic.c_str());
+  TEST_ASSERT_NOT_EQUAL(-1, static_cast<int>(published[3].payload.find("\"position\":145")));
+  publisher.loop(controller, 2000);
+  TEST_ASSERT_EQUAL_INT(4, static_cast<int>(published.size()));
+
+  // Enabling both modes republishes every motor alongside the aggregate.
+  publisher.setTopicModes(true, true);
+  publisher.loop(controller, 2100);
+  TEST_ASSERT_EQUAL_INT(8, static_cast<int>(published.size()));
+  TEST_ASSERT_EQUAL_STRING("devices/02123456789a/status", published[7].topic.c_str());
+  TEST_ASSERT_FALSE(published[7].retain);
+}
+
+void test_status_publisher_motor_topics_paced() {
+  net_onboarding::NetOnboarding net;
+  connectNet(net);
+
+  std::vector<MotorState> motors;
+  for (uint8_t id = 0; id < 12; ++id) {
+    MotorState motor = makeMotor(id);
+    motor.moving = false;
+    motors.push_back(motor);
+  }
+  StubController controller(motors);
+  controller.commitChanges();
+
+  std::vector<PublishMessage> published;
+  auto publish_fn = [&](const PublishMessage& msg) {
+    published.push_back(msg);
+    return true;
+  };
+  size_t queue_depth = 0;
+
+  mqtt::MqttStatusPublisher::Config cfg;
+  cfg.encoding = transport::PayloadEncoding::kJson;
+  cfg.aggregate_topic = false;
+  cfg.motor_topics = true;
+  cfg.motor_topics_per_pass = 4;
+  mqtt::MqttStatusPublisher publisher(publish_fn, net, cfg);
+  publisher.setQueueDepthFn([&]() { return queue_depth; });
+  publisher.setTopic("devices/02123456789a/status");
+
+  // The initial burst goes out four motors at a time, one pass per interval,
+  // and what the pass itself just queued does not count as backlog.
+  publisher.loop(controller, 0);
+  TEST_ASSERT_EQUAL_INT(4, static_cast<int>(published.size()));
+  queue_depth = 4;
+  publisher.loop(controller, 10);
+  TEST_ASSERT_EQUAL_INT(4, static_cast<int>(published.size()));
+  TEST_ASSERT_EQUAL_UINT32(20, publisher.rateHz());
+  queue_depth = 0;
+  publisher.loop(controller, 50);
+  publisher.loop(controller, 100);
+  TEST_ASSERT_EQUAL_INT(12, static_cast<int>(published.size()));
+  TEST_ASSERT_EQUAL_STRING("devices/02123456789a/motors/11/status",
+                           published[11].topic.c_str());
+  publisher.loop(controller, 150);
+  publisher.loop(controller, 5000);
+  TEST_ASSERT_EQUAL_INT(12, static_cast<int>(published.size()));
+
+  // Idle motors are refreshed, so a retained status lost in the queue heals.
+  publisher.loop(controller, 10000);
+  TEST_ASSERT_EQUAL_INT(16, static_cast<int>(published.size()));
+  TEST_ASSERT_EQUAL_STRING("devices/02123456789a/motors/0/status", published[12].topic.c_str());
+  TEST_ASSERT_TRUE(published[12].retain);
+  // The rest come due on the next heartbeat and are paced the same way.
+  publisher.loop(controller, 11000);
+  TEST_ASSERT_EQUAL_INT(20, static_cast<int>(published.size()));
+  publisher.loop(controller, 11050);
+  TEST_ASSERT_EQUAL_INT(24, static_cast<int>(published.size()));
+}
+
 int main(int, char**) {
   UNITY_BEGIN();
   RUN_TEST(test_status_publisher_serializes_snapshot);
   RUN_TEST(test_status_publisher_cadence_and_changes);
+  RUN_TEST(test_status_publisher_msgpack_snapshot);
+  RUN_TEST(test_status_publisher_delta_mode);
+  RUN_TEST(test_status_publisher_delta_survives_full_queue);
+  RUN_TEST(test_status_publisher_rebuilds_only_on_change_seq);
+  RUN_TEST(test_status_publisher_adaptive_rate);
+  RUN_TEST(test_status_publisher_motor_topics);
+  RUN_TEST(test_status_publisher_motor_topics_paced);
   return UNITY_END();
 }
@@ -0,0 +1,244 @@
+#include "MotorControl/MotorCommandProcessor.h"
+#include "MotorControl/MotorControlConstants.h"
+#include "MotorControl/command/CommandExecutionContext.h"
+#include "MotorControl/command/CommandHandlers.h"
+#include "MotorControl/command/CommandParser.h"
+#include "MotorControl/command/CommandResult.h"
+#include "transport/CommandSchema.h"
+#include "transport/JsonWriter.h"
+#include "transport/ResponseDispatcher.h"
+
+#include <ArduinoJson.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <unity.h>
+
+// Counts global heap allocations while armed so the tests can pin the number
+// of allocations needed to build a response.
+namespace {
+bool g_counting = false;
+size_t g_allocations = 0;
+}  // namespace
+
+void* operator new(size_t size) {
+  if (g_counting) {
+    ++g_allocations;
+  }
+  void* p = std::malloc(size == 0 ? 1 : size);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+  std::free(p);
+}
+
+namespace {
+
+void StartCounting() {
+  g_allocations = 0;
+  g_counting = true;
+}
+
+size_t StopCounting() {
+  g_counting = false;
+  return g_allocations;
+}
+
+// Routes JsonDocument's pool through the same counter; ArduinoJson's default
+// allocator uses malloc and would otherwise go unseen.
+class CountingJsonAllocator : public ArduinoJson::Allocator {
+public:
+  void* allocate(size_t size) override {
+    if (g_counting) {
+      ++g_allocations;
+    }
+    return std::malloc(size);
+  }
+  void deallocate(void* ptr) override {
+    std::free(ptr);
+  }
+  void* reallocate(void* ptr, size_t new_size) override {
+    if (g_counting) {
+      ++g_allocations;
+    }
+    return std::realloc(ptr, new_size);
+  }
+};
+
+// A representative MOVE completion: id, status, result object and one warning.
+// The JsonDocument version mirrors the old path where every field value was a
+// string and numbers were recovered with strtol before serializing.
+void BuildCompletionWithDocument(ArduinoJson::Allocator* allocator, std::string& out) {
+  JsonDocument doc(allocator);
+  doc["id"] = "0123abcd00000005";
+  doc["status"] = "done";
+  JsonObject result = doc["result"].to<JsonObject>();
+  result["actual_ms"] = std::strtol("1234", nullptr, 10);
+  result["started_ms"] = std::strtol("98000", nullptr, 10);
+  JsonArray warnings = doc["warnings"].to<JsonArray>();
+  JsonObject warning = warnings.add<JsonObject>();
+  warning["code"] = "THERMAL_NO_BUDGET";
+  warning["reason"] = "motor 2 needs 4.5 s to cool";
+  doc["errors"].to<JsonArray>();
+  out.clear();
+  serializeJson(doc, out);
+}
+
+void BuildCompletionWithWriter(std::string& out) {
+  out.clear();
+  transport::JsonWriter json(out);
+  json.beginObject();
+  json.field("id", "0123abcd00000005");
+  json.field("status", "done");
+  json.beginObject("result");
+  json.field("actual_ms", 1234);
+  json.field("started_ms", 98000);
+  json.endObject();
+  json.beginArray("warnings");
+  json.beginObject();
+  json.field("code", "THERMAL_NO_BUDGET");
+  json.field("reason", "motor 2 needs 4.5 s to cool");
+  json.endObject();
+  json.endArray();
+  json.beginArray("errors");
+  json.endArray();
+  json.endObject();
+}
+
+}  // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_status_response_allocates_once_per_motor_row() {
+  using motor::command::CommandExecutionContext;
+  MotorCommandProcessor proc;
+  bool thermal = true;
+  int speed = MotorControlConstants::DEFAULT_SPEED_SPS;
+  int accel = MotorControlConstants::DEFAULT_ACCEL_SPS2;
+  int decel = 0;
+  bool in_batch = false;
+  bool initially_idle = false;
+  transport::message_id::Id cmd_id = "s1";
+  CommandExecutionContext context(proc.controller(),
+                                  thermal,
+                                  speed,
+                                  accel,
+                                  decel,
+                                  in_batch,
+                                  initially_idle,
+                                  cmd_id,
+                                  proc.statusSubscription());
+  motor::command::QueryCommandHandler handler;
+  auto commands = motor::command::CommandParser().parse("STATUS");
+  // A listener keeps the dispatcher path live, as the serial and MQTT sinks do.
+  auto& dispatcher = transport::response::ResponseDispatcher::Instance();
+  size_t events = 0;
+  auto token = dispatcher.RegisterSink(
+      [&](const transport::response::Event&, const transport::command::ResponseLine*) {
+        ++events;
+      });
+  // Warm up once so lazily constructed singletons are not counted.
+  (void)handler.execute(commands[0], context, 0);
+
+  events = 0;
+  StartCounting();
+  auto result = handler.execute(commands[0], context, 0);
+  size_t allocations = StopCounting();
+  dispatcher.UnregisterSink(token);
+
+  TEST_ASSERT_FALSE(result.is_error);
+  TEST_ASSERT_EQUAL_UINT32(9, result.structuredResponse().lines.size());
+  TEST_ASSERT_EQUAL_UINT32(9, events);
+  // The line list grows once; each motor row's fields spill to the heap once.
+  TEST_ASSERT_EQUAL_UINT32(1 + proc.controller().motorCount(), allocations);
+}
+
+void test_single_line_results_stay_inline() {
+  StartCounting();
+  motor::command::CommandResult res = motor::command::CommandResult::SingleLine(
+      transport::command::MakeAckLine("42", {{"est_ms", "1200"}}));
+  motor::command::CommandResult merged;
+  merged.mergeFrom(std::move(res));
+  size_t allocations = StopCounting();
+
+  TEST_ASSERT_EQUAL_UINT32(1, merged.structuredResponse().lines.size());
+  TEST_ASSERT_EQUAL_UINT32(0, allocations);
+}
+
+void test_json_writer_payload_allocates_nothing_once_warm() {
+  std::string buffer;
+  BuildCompletionWithWriter(buffer);
+
+  StartCounting();
+  BuildCompletionWithWriter(buffer);
+  size_t allocations = StopCounting();
+
+  TEST_ASSERT_EQUAL_UINT32(0, allocations);
+  TEST_ASSERT_EQUAL_STRING("{\"id\":\"0123abcd00000005\",\"status\":\"done\",\"result\":{"
+                           "\"actual_ms\":1234,\"started_ms\":98000},\"warnings\":[{\"code\":"
+                           "\"THERMAL_NO_BUDGET\",\"reason\":\"motor 2 needs 4.5 s to cool\"}],"
+                           "\"errors\":[]}",
+                           buffer.c_str());
+}
+
+// Not a pass/fail check beyond matching output: prints build time and heap
+// allocations per MQTT completion payload for JsonDocument vs JsonWriter.
+void test_mqtt_payload_build_benchmark() {
+  constexpr int kIterations = 20000;
+  CountingJsonAllocator allocator;
+  std::string doc_out;
+  std::string writer_out;
+  BuildCompletionWithDocument(&allocator, doc_out);
+  BuildCompletionWithWriter(writer_out);
+  TEST_ASSERT_EQUAL_STRING(doc_out.c_str(), writer_out.c_str());
+
+  StartCounting();
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kIterations; ++i) {
+    BuildCompletionWithDocument(&allocator, doc_out);
+  }
+  const double doc_s =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  const size_t doc_allocations = StopCounting();
+
+  StartCounting();
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kIterations; ++i) {
+    BuildCompletionWithWriter(writer_out);
+  }
+  const double writer_s =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  const size_t writer_allocations = StopCounting();
+
+  char line[160];
+  std::snprintf(line,
+                sizeof(line),
+                "completion payload: JsonDocument %.2f us, %.1f allocs; "
+                "JsonWriter %.2f us, %.1f allocs",
+                doc_s * 1e6 / kIterations,
+                static_cast<double>(doc_allocations) / kIterations,
+                writer_s * 1e6 / kIterations,
+                static_cast<double>(writer_allocations) / kIterations);
+  TEST_MESSAGE(line);
+  TEST_ASSERT_EQUAL_UINT32(0, writer_allocations);
+}
+
+int main(int, char**) {
+  UNITY_BEGIN();
+  RUN_TEST(test_status_response_allocates_once_per_motor_row);
+  RUN_TEST(test_single_line_results_stay_inline);
+  RUN_TEST(test_json_writer_payload_allocates_nothing_once_warm);
+  RUN_TEST(test_mqtt_payload_build_benchmark);
+  return UNITY_END();
+}
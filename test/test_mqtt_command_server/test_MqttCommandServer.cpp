@@ -1,16 +1,21 @@
 #include "MotorControl/MotorCommandProcessor.h"
 #include "MotorControl/command/HelpText.h"
+#include "mqtt/JsonArena.h"
 #include "mqtt/MqttCommandServer.h"
 #include "mqtt/MqttConfigStore.h"
 #include "mqtt/MqttStatusPublisher.h"
-#include "mqtt/PublishQueuePolicy.h"
+#include "mqtt/PublishQueue.h"
+#include "mqtt/ResponseCache.h"
 #include "net_onboarding/NetOnboarding.h"
+#include "transport/CompletionTracker.h"
 #include "transport/MessageId.h"
+#include "transport/ResponseDispatcher.h"
 
 #include <ArduinoJson.h>
+#include <algorithm>
 #include <cmath>
 #include <cstdlib>
-#include <deque>
+#include <cstring>
 #include <functional>
 #include <map>
 #include <string>
@@ -29,38 +34,62 @@ struct Harness {
   MotorCommandProcessor processor;
   std::vector<PublishedMessage> messages;
   std::vector<std::string> logs;
+  std::vector<std::string> subscriptions;
   mqtt::MqttCommandServer::SubscribeCallback callback;
   uint32_t now_ms = 0;
   mqtt::MqttCommandServer server;
 
-  Harness()
+  explicit Harness(mqtt::MqttCommandServer::Config cfg = mqtt::MqttCommandServer::Config())
       : server(
             processor,
             [this](const mqtt::PublishMessage& msg) {
               messages.push_back({msg.topic, msg.payload});
               return true;
             },
-            [this](const std::string& /*topic*/,
+            [this](const std::string& topic,
                    uint8_t /*qos*/,
                    mqtt::MqttCommandServer::SubscribeCallback cb) {
+              subscriptions.push_back(topic);
               callback = std::move(cb);
               return true;
             },
             [this](const std::string& line) { logs.push_back(line); },
-            [this]() -> uint32_t { return now_ms; }) {
+            [this]() -> uint32_t { return now_ms; },
+            cfg) {
     bool bound = server.begin("devices/test/status");
     (void)bound;
   }
 
   void send(const std::string& payload) {
+    sendOn("devices/test/cmd", payload);
+  }
+
+  void sendOn(const std::string& topic, const std::string& payload) {
     TEST_ASSERT_TRUE_MESSAGE(static_cast<bool>(callback), "Server not subscribed");
-    callback("devices/test/cmd", payload);
+    callback(topic, payload);
+    server.loop(now_ms);
+  }
+
+  bool subscribedTo(const std::string& topic) const {
+    return std::find(subscriptions.begin(), subscriptions.end(), topic) != subscriptions.end();
+  }
+
+  // Re-encodes a JSON command as MessagePack and sends it on cmd.mp.
+  void sendMsgPack(const std::string& json_payload) {
+    TEST_ASSERT_TRUE_MESSAGE(static_cast<bool>(callback), "Server not subscribed");
+    ArduinoJson::JsonDocument doc;
+    TEST_ASSERT_FALSE(deserializeJson(doc, json_payload));
+    std::string packed;
+    serializeMsgPack(doc, packed);
+    callback("devices/test/cmd.mp", packed);
+    server.loop(now_ms);
   }
 
   void advance(uint32_t delta) {
     now_ms += delta;
     processor.tick(now_ms);
     server.loop(now_ms);
+    transport::response::CompletionTracker::Instance().Tick(now_ms);
   }
 
   void clearMessages() {
@@ -70,44 +99,45 @@ struct Harness {
   ArduinoJson::JsonDocument parse(size_t idx) const {
     ArduinoJson::JsonDocument doc;
     TEST_ASSERT_TRUE_MESSAGE(idx < messages.size(), "Message index out of range");
-    auto err = deserializeJson(doc, messages[idx].payload);
+    const auto& msg = messages[idx];
+    auto err = transport::TopicEncoding(msg.topic) == transport::PayloadEncoding::kMsgPack
+                   ? deserializeMsgPack(doc, msg.payload)
+                   : deserializeJson(doc, msg.payload);
     TEST_ASSERT_FALSE_MESSAGE(err, err.c_str());
     return doc;
   }
 };
 
-struct DropTailPublishQueue {
-  explicit DropTailPublishQueue(std::size_t capacity) : capacity(capacity) {}
+struct SlabPublishQueue {
+  explicit SlabPublishQueue(std::size_t capacity) : queue(capacity, 64) {}
 
   bool publish(const mqtt::PublishMessage& msg) {
-    mqtt::EnqueuePublishMessage(queue, capacity, msg);
-    return true;
+    return queue.push(msg);
   }
 
-  void enqueueStatus(const std::string& label) {
+  void enqueueStatus(const std::string& label, const std::string& topic) {
     mqtt::PublishMessage msg;
-    msg.topic = "devices/test/status";
+    msg.topic = topic;
     msg.payload = label;
-    msg.is_status = true;
-    mqtt::EnqueuePublishMessage(queue, capacity, msg);
+    msg.priority = mqtt::PublishPriority::kStatus;
+    queue.push(msg);
   }
 
   std::vector<std::string> flush() {
     std::vector<std::string> out;
-    while (!queue.empty()) {
-      out.push_back(queue.front().payload);
-      queue.pop_front();
+    while (const mqtt::PublishMessage* msg = queue.front()) {
+      out.push_back(msg->payload);
+      queue.pop();
     }
     return out;
   }
 
-  std::size_t capacity;
-  std::deque<mqtt::PublishMessage> queue;
+  mqtt::PublishQueue queue;
 };
 
 struct SaturatedQueueHarness {
   MotorCommandProcessor processor;
-  DropTailPublishQueue queue;
+  SlabPublishQueue queue;
   mqtt::MqttCommandServer::SubscribeCallback callback;
   uint32_t now_ms = 0;
   mqtt::MqttCommandServer server;
@@ -133,12 +163,14 @@ struct SaturatedQueueHarness {
   void send(const std::string& payload) {
     TEST_ASSERT_TRUE_MESSAGE(static_cast<bool>(callback), "Server not subscribed");
     callback("devices/test/cmd", payload);
+    server.loop(now_ms);
   }
 
   void advance(uint32_t delta) {
     now_ms += delta;
     processor.tick(now_ms);
     server.loop(now_ms);
+    transport::response::CompletionTracker::Instance().Tick(now_ms);
   }
 };
 
@@ -153,6 +185,23 @@ std::string makeMovePayload(const std::string& cmd_id, int target, int position)
   return out;
 }
 
+// entries: (target, position) pairs, all MOVE.
+std::string makeMoveBatchPayload(const std::string& cmd_id,
+                                 const std::vector<std::pair<int, int>>& entries) {
+  ArduinoJson::JsonDocument doc;
+  doc["cmd_id"] = cmd_id;
+  auto batch = doc["batch"].to<ArduinoJson::JsonArray>();
+  for (const auto& entry : entries) {
+    auto item = batch.add<ArduinoJson::JsonObject>();
+    item["action"] = "MOVE";
+    item["params"]["target_ids"] = entry.first;
+    item["params"]["position_steps"] = entry.second;
+  }
+  std::string out;
+  serializeJson(doc, out);
+  return out;
+}
+
 std::string makeMovePayloadWithoutId(int target, int position) {
   ArduinoJson::JsonDocument doc;
   doc["action"] = "MOVE";
@@ -386,6 +435,92 @@ void test_move_command_success() {
   TEST_ASSERT_TRUE(completion["result"]["actual_ms"].is<long>());
 }
 
+void test_executor_move_completes_on_tracker_done() {
+  Harness h;
+  auto& dispatcher = transport::response::ResponseDispatcher::Instance();
+  // Keeps the command's events from the server, like a motion task that has
+  // not handed them over yet, so only the ACK line of the result is seen.
+  h.server.setExecutor(
+      [&h, &dispatcher](const std::string& line, uint32_t now_ms) {
+        dispatcher.SetEmitHook(
+            [](const transport::response::Event&, const transport::command::ResponseLine*) {
+              return true;
+            });
+        auto result = h.processor.execute(line, now_ms);
+        dispatcher.SetEmitHook(nullptr);
+        return result;
+      },
+      nullptr);
+  h.send(makeMovePayload("cmd-exec", 0, 100));
+  TEST_ASSERT_EQUAL_UINT(1, h.messages.size());
+  TEST_ASSERT_EQUAL_STRING("ack", h.parse(0)["status"]);
+
+  // Stopped motors alone publish nothing; the tracker's DONE does.
+  h.now_ms += 2000;
+  h.processor.tick(h.now_ms);
+  h.server.loop(h.now_ms);
+  TEST_ASSERT_EQUAL_UINT(1, h.messages.size());
+  transport::response::CompletionTracker::Instance().Tick(h.now_ms);
+  TEST_ASSERT_EQUAL_UINT(2, h.messages.size());
+  auto done = h.parse(1);
+  TEST_ASSERT_EQUAL_STRING("cmd-exec", done["cmd_id"]);
+  TEST_ASSERT_EQUAL_STRING("done", done["status"]);
+  TEST_ASSERT_TRUE(done["result"]["actual_ms"].is<long>());
+}
+
+void test_batch_moves_answer_with_one_ack_and_one_done() {
+  long single_est_ms = 0;
+  {
+    Harness single;
+    single.send(makeMovePayload("single", 1, 400));
+    single_est_ms = single.parse(0)["result"]["est_ms"].as<long>();
+  }
+
+  Harness h;
+  h.send(makeMoveBatchPayload("frame-1", {{0, 100}, {1, 400}, {2, 50}}));
+
+  TEST_ASSERT_EQUAL_UINT(1, h.messages.size());
+  auto ack = h.parse(0);
+  TEST_ASSERT_EQUAL_STRING("frame-1", ack["cmd_id"]);
+  TEST_ASSERT_EQUAL_STRING("BATCH", ack["action"]);
+  TEST_ASSERT_EQUAL_STRING("ack", ack["status"]);
+  TEST_ASSERT_EQUAL_INT(single_est_ms, ack["result"]["est_ms"].as<long>());
+  TEST_ASSERT_TRUE(h.processor.controller().state(0).moving);
+  TEST_ASSERT_TRUE(h.processor.controller().state(2).moving);
+
+  h.advance(2000);
+  TEST_ASSERT_EQUAL_UINT(2, h.messages.size());
+  auto done = h.parse(1);
+  TEST_ASSERT_EQUAL_STRING("frame-1", done["cmd_id"]);
+  TEST_ASSERT_EQUAL_STRING("done", done["status"]);
+  TEST_ASSERT_FALSE(h.processor.controller().isAnyMovingForMask(0x7));
+
+  h.advance(2000);
+  TEST_ASSERT_EQUAL_UINT(2, h.messages.size());
+}
+
+void test_batch_rejected_in_full_before_motion() {
+  Harness h;
+  h.send(makeMoveBatchPayload("frame-overlap", {{0, 100}, {0, 200}}));
+  TEST_ASSERT_EQUAL_UINT(1, h.messages.size());
+  auto overlap = h.parse(0);
+  TEST_ASSERT_EQUAL_STRING("error", overlap["status"]);
+  TEST_ASSERT_EQUAL_STRING("E03", overlap["errors"][0]["code"]);
+  TEST_ASSERT_FALSE(h.processor.controller().isAnyMovingForMask(0xFF));
+
+  h.clearMessages();
+  std::string payload = makeMoveBatchPayload("frame-wake", {{0, 100}});
+  payload.insert(payload.size() - 2, ",{\"action\":\"WAKE\",\"params\":{\"target_ids\":1}}");
+  h.send(payload);
+  TEST_ASSERT_EQUAL_UINT(1, h.messages.size());
+  auto unsupported = h.parse(0);
+  TEST_ASSERT_EQUAL_STRING("error", unsupported["status"]);
+  TEST_ASSERT_EQUAL_STRING("MQTT_BAD_PAYLOAD", unsupported["errors"][0]["code"]);
+  std::string message = unsupported["errors"][0]["message"].as<const char*>();
+  TEST_ASSERT_NOT_EQUAL(-1, message.find("batch[1]"));
+  TEST_ASSERT_FALSE(h.processor.controller().isAnyMovingForMask(0xFF));
+}
+
 void test_home_command_success() {
   Harness h;
   h.send(makeHomePayload("home-1"));
@@ -428,6 +563,212 @@ void test_get_last_op_single_command_success() {
   TEST_ASSERT_FALSE(completion["result"]["id"].isNull());
 }
 
+void test_coalesce_folds_ack_into_done() {
+  std::string payload = makeGetPayload("cmd-coalesce", "last_op_timing");
+  {
+    Harness h;
+    h.send(payload);
+    TEST_ASSERT_EQUAL_UINT(2, h.messages.size());
+    TEST_ASSERT_EQUAL_STRING("ack", h.parse(0)["status"]);
+    TEST_ASSERT_EQUAL_STRING("done", h.parse(1)["status"]);
+  }
+
+  Harness h;
+  payload.insert(1, "\"coalesce\":true,");
+  h.send(payload);
+  TEST_ASSERT_EQUAL_UINT(1, h.messages.size());
+  TEST_ASSERT_EQUAL_STRING("cmd-coalesce", h.parse(0)["cmd_id"]);
+  TEST_ASSERT_EQUAL_STRING("done", h.parse(0)["status"]);
+
+  // A redelivery replays the single completion only.
+  h.clearMessages();
+  h.send(payload);
+  TEST_ASSERT_EQUAL_UINT(1, h.messages.size());
+  TEST_ASSERT_EQUAL_STRING("done", h.parse(0)["status"]);
+
+  // A move still running at dispatch keeps its separate ACK with est_ms.
+  h.clearMessages();
+  std::string move = makeMovePayload("move-coalesce", 0, 100);
+  move.insert(1, "\"coalesce\":true,");
+  h.send(move);
+  TEST_ASSERT_EQUAL_UINT(1, h.messages.size());
+  TEST_ASSERT_EQUAL_STRING("ack", h.parse(0)["status"]);
+  TEST_ASSERT_TRUE(h.parse(0)["result"]["est_ms"].is<long>());
+  h.advance(2000);
+  TEST_ASSERT_EQUAL_UINT(2, h.messages.size());
+  TEST_ASSERT_EQUAL_STRING("done", h.parse(1)["status"]);
+}
+
+void test_coalesce_config_default_overridden_per_request() {
+  mqtt::MqttCommandServer::Config cfg;
+  cfg.coalesce_responses = true;
+  Harness h(cfg);
+  h.send(makeGetPayload("cmd-default", "last_op_timing"));
+  TEST_ASSERT_EQUAL_UINT(1, h.messages.size());
+  TEST_ASSERT_EQUAL_STRING("done", h.parse(0)["status"]);
+
+  h.clearMessages();
+  std::string payload = makeGetPayload("cmd-opt-out", "last_op_timing");
+  payload.insert(1, "\"coalesce\":false,");
+  h.send(payload);
+  TEST_ASSERT_EQUAL_UINT(2, h.messages.size());
+  TEST_ASSERT_EQUAL_STRING("ack", h.parse(0)["status"]);
+}
+
+void test_msgpack_command_answered_in_msgpack() {
+  Harness h;
+  h.sendMsgPack(makeMovePayload("cmd-mp", 0, 100));
+  TEST_ASSERT_EQUAL_UINT(1, h.messages.size());
+  TEST_ASSERT_EQUAL_STRING("devices/test/cmd/resp.mp", h.messages[0].topic.c_str());
+  auto ack = h.parse(0);
+  TEST_ASSERT_EQUAL_STRING("cmd-mp", ack["cmd_id"]);
+  TEST_ASSERT_EQUAL_STRING("ack", ack["status"]);
+  TEST_ASSERT_TRUE(ack["result"]["est_ms"].is<long>());
+
+  h.advance(2000);
+  TEST_ASSERT_EQUAL_UINT(2, h.messages.size());
+  TEST_ASSERT_EQUAL_STRING("devices/test/cmd/resp.mp", h.messages[1].topic.c_str());
+  TEST_ASSERT_EQUAL_STRING("done", h.parse(1)["status"]);
+  TEST_ASSERT_TRUE(h.parse(1)["result"]["actual_ms"].is<long>());
+
+  // JSON commands on the same server still get JSON, and replays keep the
+  // encoding the command was first answered in.
+  h.clearMessages();
+  h.send(makeGetPayload("cmd-json", "all"));
+  h.send(makeMovePayload("cmd-mp", 0, 100));
+  TEST_ASSERT_EQUAL_UINT(3, h.messages.size());
+  TEST_ASSERT_EQUAL_STRING("devices/test/cmd/resp", h.messages[0].topic.c_str());
+  TEST_ASSERT_EQUAL_STRING("devices/test/cmd/resp.mp", h.messages[1].topic.c_str());
+  TEST_ASSERT_EQUAL_STRING("devices/test/cmd/resp.mp", h.messages[2].topic.c_str());
+  TEST_ASSERT_EQUAL_STRING("done", h.parse(2)["status"]);
+}
+
+void test_group_command_runs_this_nodes_slice() {
+  mqtt::ConfigStore::Instance().ResetForTests();
+  Harness h;
+  TEST_ASSERT_FALSE(h.subscribedTo("groups/wall/cmd"));
+
+  mqtt::ConfigUpdate update;
+  update.groups_set = true;
+  update.groups = "wall, left";
+  TEST_ASSERT_TRUE(mqtt::ConfigStore::Instance().ApplyUpdate(update));
+  h.advance(0);
+  TEST_ASSERT_TRUE(h.subscribedTo("groups/wall/cmd"));
+  TEST_ASSERT_TRUE(h.subscribedTo("groups/wall/cmd.mp"));
+  TEST_ASSERT_TRUE(h.subscribedTo("groups/left/cmd"));
+
+  h.sendOn("groups/wall/cmd",
+           R"({"cmd_id":"wall-1","action":"MOVE","nodes":{)"
+           R"("other":{"target_ids":0,"position_steps":900},)"
+           R"("test":{"target_ids":2,"position_steps":120}}})");
+  TEST_ASSERT_EQUAL_UINT(1, h.messages.size());
+  TEST_ASSERT_EQUAL_STRING("devices/test/cmd/resp", h.messages[0].topic.c_str());
+  auto ack = h.parse(0);
+  TEST_ASSERT_EQUAL_STRING("wall-1", ack["cmd_id"]);
+  TEST_ASSERT_EQUAL_STRING("ack", ack["status"]);
+  h.advance(2000);
+  TEST_ASSERT_EQUAL_INT(120, h.processor.controller().state(2).position);
+  TEST_ASSERT_EQUAL_INT(0, h.processor.controller().state(0).position);
+
+  // Nodes the payload does not list stay silent, as do groups no longer configured.
+  h.clearMessages();
+  h.sendOn("groups/wall/cmd",
+           R"({"cmd_id":"wall-2","action":"HOME","nodes":{"other":{"target_ids":"ALL"}}})");
+  update.groups = "left";
+  TEST_ASSERT_TRUE(mqtt::ConfigStore::Instance().ApplyUpdate(update));
+  h.advance(0);
+  h.sendOn("groups/wall/cmd", R"({"cmd_id":"wall-3","action":"STATUS"})");
+  TEST_ASSERT_EQUAL_UINT(0, h.messages.size());
+
+  // Without a node map the whole payload applies to every member.
+  h.sendOn("groups/left/cmd", R"({"cmd_id":"left-1","action":"STATUS"})");
+  TEST_ASSERT_TRUE(h.messages.size() >= 1);
+  TEST_ASSERT_EQUAL_STRING("left-1", h.parse(0)["cmd_id"]);
+  mqtt::ConfigStore::Instance().ResetForTests();
+}
+
+void test_group_slice_with_target_list_beyond_single_node_limit() {
+  mqtt::ConfigStore::Instance().ResetForTests();
+  Harness h;
+  mqtt::ConfigUpdate update;
+  update.groups_set = true;
+  update.groups = "wall";
+  TEST_ASSERT_TRUE(mqtt::ConfigStore::Instance().ApplyUpdate(update));
+  h.advance(0);
+
+  // A wall-sized payload: well past max_payload_bytes, within the group limit.
+  std::string payload = R"({"cmd_id":"wall-list","action":"MOVE","nodes":{)";
+  for (int node = 0; node < 40; ++node) {
+    payload += "\"node" + std::to_string(node) +
+               R"(":{"target_ids":[0,1,2],"position_steps":900},)";
+  }
+  payload += R"("test":{"target_ids":[0,1],"position_steps":150}}})";
+  TEST_ASSERT_TRUE(payload.size() > 1024);
+  h.sendOn("groups/wall/cmd", payload);
+
+  TEST_ASSERT_EQUAL_UINT(1, h.messages.size());
+  auto ack = h.parse(0);
+  TEST_ASSERT_EQUAL_STRING("wall-list", ack["cmd_id"]);
+  TEST_ASSERT_EQUAL_STRING("ack", ack["status"]);
+  h.advance(2000);
+  TEST_ASSERT_EQUAL_UINT(2, h.messages.size());
+  TEST_ASSERT_EQUAL_STRING("done", h.parse(1)["status"]);
+  TEST_ASSERT_EQUAL_INT(150, h.processor.controller().state(0).position);
+  TEST_ASSERT_EQUAL_INT(150, h.processor.controller().state(1).position);
+  TEST_ASSERT_EQUAL_INT(0, h.processor.controller().state(2).position);
+
+  h.clearMessages();
+  h.send(R"({"cmd_id":"dup-list","action":"MOVE","params":{"target_ids":[3,3],)"
+         R"("position_steps":10}})");
+  TEST_ASSERT_EQUAL_UINT(1, h.messages.size());
+  TEST_ASSERT_EQUAL_STRING("error", h.parse(0)["status"]);
+  mqtt::ConfigStore::Instance().ResetForTests();
+}
+
+void test_fast_frames_skip_stale_and_publish_counters() {
+  Harness h;
+  TEST_ASSERT_TRUE(h.subscribedTo("devices/test/cmd/fast"));
+  const std::string fast = "devices/test/cmd/fast";
+  h.sendOn(fast, R"({"seq":1,"action":"MOVE","params":{"target_ids":0,"position_steps":50}})");
+  h.sendOn(fast, R"({"seq":4,"action":"MOVE","params":{"target_ids":1,"position_steps":80}})");
+  // Older than seq 4, so it must not run.
+  h.sendOn(fast, R"({"seq":3,"action":"MOVE","params":{"target_ids":2,"position_steps":99}})");
+  TEST_ASSERT_EQUAL_UINT(0, h.messages.size());
+
+  // Errors are the only responses.
+  h.sendOn(fast, R"({"seq":5,"action":"STATUS"})");
+  TEST_ASSERT_EQUAL_UINT(1, h.messages.size());
+  TEST_ASSERT_EQUAL_STRING("devices/test/cmd/resp", h.messages[0].topic.c_str());
+  auto error = h.parse(0);
+  TEST_ASSERT_EQUAL_STRING("fast-5", error["cmd_id"]);
+  TEST_ASSERT_EQUAL_STRING("error", error["status"]);
+  TEST_ASSERT_EQUAL_STRING("MQTT_UNSUPPORTED_ACTION", error["errors"][0]["code"]);
+
+  h.clearMessages();
+  h.advance(2000);
+  TEST_ASSERT_EQUAL_INT(50, h.processor.controller().state(0).position);
+  TEST_ASSERT_EQUAL_INT(80, h.processor.controller().state(1).position);
+  TEST_ASSERT_EQUAL_INT(0, h.processor.controller().state(2).position);
+
+  TEST_ASSERT_EQUAL_UINT(1, h.messages.size());
+  TEST_ASSERT_EQUAL_STRING("devices/test/cmd/fast/stats", h.messages[0].topic.c_str());
+  auto stats = h.parse(0);
+  TEST_ASSERT_EQUAL_INT(4, stats["received"].as<int>());
+  TEST_ASSERT_EQUAL_INT(2, stats["dropped"].as<int>());
+  TEST_ASSERT_EQUAL_INT(1, stats["late"].as<int>());
+  TEST_ASSERT_EQUAL_INT(1, stats["errors"].as<int>());
+  TEST_ASSERT_EQUAL_INT(5, stats["last_seq"].as<int>());
+
+  // Unchanged counters are not republished; seq 0 restarts the sequence.
+  h.clearMessages();
+  h.advance(2000);
+  TEST_ASSERT_EQUAL_UINT(0, h.messages.size());
+  h.sendOn(fast, R"({"seq":0,"action":"SLEEP","params":{"target_ids":"ALL"}})");
+  TEST_ASSERT_EQUAL_UINT(1, h.messages.size());
+  TEST_ASSERT_EQUAL_INT(0, h.parse(0)["last_seq"].as<int>());
+  TEST_ASSERT_EQUAL_UINT32(1, h.server.fastFrameStats().late);
+}
+
 void test_help_command_success() {
   Harness h;
   h.send(makeHelpPayload("cmd-help"));
@@ -606,6 +947,170 @@ void test_busy_rejection() {
   TEST_ASSERT_EQUAL_STRING("E04", errors[0]["code"]);
 }
 
+void test_inbound_queue_full_rejects_busy() {
+  Harness h;
+  // Deliver without draining, as the MQTT client task would between two loop() calls.
+  for (int i = 0; i < 9; ++i) {
+    h.callback("devices/test/cmd", makeMovePayload("cmd-q" + std::to_string(i), i % 8, 10));
+  }
+  auto stats = h.server.inboundQueueStats();
+  TEST_ASSERT_EQUAL_UINT(8, stats.depth);
+  TEST_ASSERT_EQUAL_UINT(8, stats.high_water);
+  TEST_ASSERT_EQUAL_UINT32(8, stats.accepted);
+  TEST_ASSERT_EQUAL_UINT32(1, stats.rejected);
+  TEST_ASSERT_TRUE(h.messages.empty());
+
+  h.server.loop(h.now_ms);
+  auto busy = h.parse(0);
+  TEST_ASSERT_EQUAL_STRING("cmd-q8", busy["cmd_id"]);
+  TEST_ASSERT_EQUAL_STRING("error", busy["status"]);
+  TEST_ASSERT_EQUAL_STRING("MQTT_BUSY", busy["errors"][0]["code"]);
+  TEST_ASSERT_EQUAL_STRING("QUEUE_FULL", busy["errors"][0]["reason"]);
+  TEST_ASSERT_EQUAL_UINT(0, h.server.inboundQueueStats().depth);
+  TEST_ASSERT_EQUAL_STRING("cmd-q0", h.parse(1)["cmd_id"]);
+  TEST_ASSERT_EQUAL_STRING("ack", h.parse(1)["status"]);
+}
+
+void test_inbound_rejections_scan_ids_and_count_overflow() {
+  Harness h;
+  for (int i = 0; i < 8; ++i) {
+    h.callback("devices/test/cmd", makeMovePayload("cmd-q" + std::to_string(i), i % 8, 10));
+  }
+  // The busy answer names the command without parsing it; an escaped id is
+  // not unescaped on the client task, so that sender gets a generated id.
+  h.callback("devices/test/cmd", R"({ "action" : "home", "cmd_id" : "cmd-scan" })");
+  h.callback("devices/test/cmd", R"({"cmd_id":"cmd-\"q\"","action":"MOVE"})");
+  ArduinoJson::JsonDocument doc;
+  doc["cmd_id"] = "cmd-mp";
+  doc["action"] = "wake";
+  std::string packed;
+  serializeMsgPack(doc, packed);
+  h.callback("devices/test/cmd.mp", packed);
+  for (int i = 0; i < 6; ++i) {
+    h.callback("devices/test/cmd", makeMovePayload("cmd-r" + std::to_string(i), 0, 10));
+  }
+  // Every busy answer slot is taken, so the last rejection goes unanswered.
+  TEST_ASSERT_EQUAL_UINT32(1, h.server.inboundQueueStats().unanswered);
+  h.callback("devices/test/cmd", makeMovePayload("cmd-lost", 0, 10));
+  TEST_ASSERT_EQUAL_UINT32(2, h.server.inboundQueueStats().unanswered);
+
+  h.server.loop(h.now_ms);
+  auto scanned = h.parse(0);
+  TEST_ASSERT_EQUAL_STRING("cmd-scan", scanned["cmd_id"]);
+  TEST_ASSERT_EQUAL_STRING("HOME", scanned["action"]);
+  TEST_ASSERT_EQUAL_STRING("MQTT_BUSY", scanned["errors"][0]["code"]);
+  std::string escaped = h.parse(1)["cmd_id"].as<const char*>();
+  TEST_ASSERT_TRUE(escaped.find("cmd-") != 0);
+  TEST_ASSERT_EQUAL_STRING("devices/test/cmd/resp.mp", h.messages[2].topic.c_str());
+  TEST_ASSERT_EQUAL_STRING("cmd-mp", h.parse(2)["cmd_id"]);
+  TEST_ASSERT_EQUAL_STRING("WAKE", h.parse(2)["action"]);
+  TEST_ASSERT_EQUAL_STRING("cmd-r4", h.parse(7)["cmd_id"]);
+  TEST_ASSERT_EQUAL_STRING("cmd-q0", h.parse(8)["cmd_id"]);
+  bool warned = false;
+  for (const auto& line : h.logs) {
+    warned = warned || line == "CTRL:WARN MQTT_CMD_UNANSWERED dropped=2";
+  }
+  TEST_ASSERT_TRUE(warned);
+}
+
+void test_oversized_payload_rejected_unparsed() {
+  Harness h;
+  std::string payload = makeMovePayload("cmd-big", 0, 10);
+  payload.insert(payload.size() - 1, ",\"meta\":\"" + std::string(1100, 'x') + "\"");
+  h.send(payload);
+
+  TEST_ASSERT_EQUAL_UINT(1, h.messages.size());
+  auto completion = h.parse(0);
+  TEST_ASSERT_EQUAL_STRING("error", completion["status"]);
+  TEST_ASSERT_NOT_EQUAL(0, std::string(completion["cmd_id"].as<const char*>()).size());
+  TEST_ASSERT_EQUAL_STRING("MQTT_PAYLOAD_TOO_LARGE", completion["errors"][0]["code"]);
+  TEST_ASSERT_EQUAL_STRING("TOO_LARGE", completion["errors"][0]["reason"]);
+  std::string message = completion["errors"][0]["message"].as<const char*>();
+  TEST_ASSERT_NOT_EQUAL(-1, message.find("exceeds limit of 1024"));
+  auto stats = h.server.inboundQueueStats();
+  TEST_ASSERT_EQUAL_UINT32(1, stats.oversized);
+  TEST_ASSERT_EQUAL_UINT32(0, stats.accepted);
+
+  // The next command parses normally into the same pool.
+  h.clearMessages();
+  h.send(makeMovePayload("cmd-after", 0, 10));
+  TEST_ASSERT_EQUAL_STRING("cmd-after", h.parse(0)["cmd_id"]);
+  TEST_ASSERT_EQUAL_STRING("ack", h.parse(0)["status"]);
+}
+
+void test_json_arena_grows_last_block_in_place_and_resets() {
+  mqtt::JsonArena arena(256);
+  void* first = arena.allocate(16);
+  void* second = arena.allocate(16);
+  TEST_ASSERT_NOT_NULL(first);
+  TEST_ASSERT_NOT_NULL(second);
+  std::memcpy(second, "abc", 4);
+  TEST_ASSERT_EQUAL_PTR(second, arena.reallocate(second, 48));
+  TEST_ASSERT_EQUAL_STRING("abc", static_cast<char*>(second));
+
+  // A block that is not the last one moves and keeps its contents.
+  std::memcpy(first, "xyz", 4);
+  void* moved = arena.reallocate(first, 24);
+  TEST_ASSERT_NOT_NULL(moved);
+  TEST_ASSERT_NOT_EQUAL(first, moved);
+  TEST_ASSERT_EQUAL_STRING("xyz", static_cast<char*>(moved));
+
+  TEST_ASSERT_NULL(arena.allocate(512));
+  const size_t used = arena.used();
+  arena.deallocate(moved);
+  TEST_ASSERT_TRUE(arena.used() < used);
+  arena.reset();
+  TEST_ASSERT_EQUAL_UINT(0, arena.used());
+  TEST_ASSERT_EQUAL_PTR(first, arena.allocate(8));
+}
+
+void test_response_cache_evicts_least_recently_used() {
+  using transport::message_id::Hash;
+  mqtt::ResponseCache cache(3, 4096);
+  for (const char* id : {"a", "b", "c"}) {
+    TEST_ASSERT_TRUE(cache.put(Hash(id), id, std::string("ack-") + id, std::string("done-") + id));
+  }
+  mqtt::ResponseCache::View view;
+  TEST_ASSERT_TRUE(cache.find(Hash("a"), "a", view));
+  TEST_ASSERT_TRUE(cache.put(Hash("d"), "d", "", "done-d"));
+
+  TEST_ASSERT_EQUAL_UINT(3, cache.size());
+  TEST_ASSERT_FALSE(cache.contains(Hash("b"), "b"));
+  TEST_ASSERT_TRUE(cache.find(Hash("a"), "a", view));
+  TEST_ASSERT_EQUAL_STRING("ack-a", std::string(view.ack, view.ack_len).c_str());
+  TEST_ASSERT_EQUAL_STRING("done-a", std::string(view.completion, view.completion_len).c_str());
+  TEST_ASSERT_TRUE(cache.find(Hash("d"), "d", view));
+  TEST_ASSERT_EQUAL_UINT(0, view.ack_len);
+}
+
+void test_response_cache_wraps_within_byte_budget() {
+  mqtt::ResponseCache cache(16, 256);
+  // Same hash for every id: probe chains and backward-shift deletion must
+  // still resolve each id by its text.
+  const uint64_t kHash = 42;
+  for (int i = 0; i < 200; ++i) {
+    const std::string id = "cmd-" + std::to_string(i);
+    const std::string completion(static_cast<size_t>(10 + (i * 7) % 50),
+                                 static_cast<char>('a' + i % 26));
+    TEST_ASSERT_TRUE(cache.put(kHash, id, "", completion));
+    TEST_ASSERT_TRUE(cache.bytesUsed() <= 256);
+    mqtt::ResponseCache::View view;
+    TEST_ASSERT_TRUE(cache.find(kHash, id, view));
+    TEST_ASSERT_EQUAL_STRING(completion.c_str(),
+                             std::string(view.completion, view.completion_len).c_str());
+    if (i > 0) {
+      const std::string prev = "cmd-" + std::to_string(i - 1);
+      if (cache.find(kHash, prev, view)) {
+        const size_t len = static_cast<size_t>(10 + ((i - 1) * 7) % 50);
+        TEST_ASSERT_EQUAL_UINT(len, view.completion_len);
+        TEST_ASSERT_EQUAL_CHAR('a' + (i - 1) % 26, view.completion[0]);
+      }
+    }
+  }
+  TEST_ASSERT_FALSE(cache.contains(kHash, "cmd-0"));
+  TEST_ASSERT_FALSE(cache.put(kHash, "huge", "", std::string(300, 'x')));
+}
+
 void test_status_parity_matches_status_publisher() {
   transport::message_id::ResetGenerator();
   transport::message_id::ClearActive();
@@ -629,15 +1134,15 @@ void test_status_parity_matches_status_publisher() {
     }
     int id = -1;
     for (const auto& field : line.fields) {
-      if (field.key == "id") {
-        id = std::stoi(field.value);
+      if (transport::command::KeyEquals(field, "id")) {
+        id = static_cast<int>(field.number);
         break;
       }
     }
     TEST_ASSERT_TRUE_MESSAGE(id >= 0, "STATUS data missing id field");
     auto& entry = serial_fields[id];
     for (const auto& field : line.fields) {
-      entry[field.key] = field.value;
+      entry[field.key] = transport::command::FieldText(field);
     }
   }
   TEST_ASSERT_FALSE_MESSAGE(serial_fields.empty(), "STATUS command produced no motor data");
@@ -718,14 +1223,17 @@ void test_status_parity_matches_status_publisher() {
 
 void test_ack_survives_publish_queue_burst() {
   SaturatedQueueHarness h(4, "devices/test/status");
+  // Per-motor statuses fill every slot before and after the command.
   for (int idx = 0; idx < 4; ++idx) {
-    h.queue.enqueueStatus("prefill-" + std::to_string(idx));
+    h.queue.enqueueStatus("prefill-" + std::to_string(idx),
+                          "devices/test/motors/" + std::to_string(idx) + "/status");
   }
 
   h.send(makeMovePayload("cmd-saturated", 0, 120));
 
   for (int idx = 0; idx < 4; ++idx) {
-    h.queue.enqueueStatus("burst-" + std::to_string(idx));
+    h.queue.enqueueStatus("burst-" + std::to_string(idx),
+                          "devices/test/motors/" + std::to_string(4 + idx) + "/status");
   }
 
   h.advance(2000);
@@ -783,15 +1291,41 @@ void test_mqtt_config_json_persists() {
   TEST_ASSERT_EQUAL_STRING("secret", result["pass"].as<const char*>());
 }
 
+void test_numeric_text_fields_stay_strings() {
+  mqtt::ConfigStore::Instance().ResetForTests();
+  Harness h;
+  h.send(makeMqttSetConfigPayload("cfg-digits", "10.0.0.2", 1884, "1234", "0042"));
+  h.clearMessages();
+  h.send(makeMqttGetConfigPayload("cfg-digits-get"));
+  TEST_ASSERT_EQUAL_UINT(1, h.messages.size());
+  auto completion = h.parse(0);
+  auto result = completion["result"];
+  // Text that happens to be all digits is not turned into a number.
+  TEST_ASSERT_TRUE(result["user"].is<const char*>());
+  TEST_ASSERT_EQUAL_STRING("1234", result["user"].as<const char*>());
+  TEST_ASSERT_EQUAL_STRING("0042", result["pass"].as<const char*>());
+  TEST_ASSERT_TRUE(result["port"].is<long>());
+  mqtt::ConfigStore::Instance().ResetForTests();
+}
+
 int main(int, char**) {
   UNITY_BEGIN();
   RUN_TEST(test_begin_requires_device_id);
   RUN_TEST(test_invalid_payload_rejected);
   RUN_TEST(test_move_missing_param_reports_bad_payload);
   RUN_TEST(test_move_command_success);
+  RUN_TEST(test_executor_move_completes_on_tracker_done);
+  RUN_TEST(test_batch_moves_answer_with_one_ack_and_one_done);
+  RUN_TEST(test_batch_rejected_in_full_before_motion);
   RUN_TEST(test_home_command_success);
   RUN_TEST(test_get_all_command_success);
   RUN_TEST(test_get_last_op_single_command_success);
+  RUN_TEST(test_coalesce_folds_ack_into_done);
+  RUN_TEST(test_coalesce_config_default_overridden_per_request);
+  RUN_TEST(test_msgpack_command_answered_in_msgpack);
+  RUN_TEST(test_group_command_runs_this_nodes_slice);
+  RUN_TEST(test_group_slice_with_target_list_beyond_single_node_limit);
+  RUN_TEST(test_fast_frames_skip_stale_and_publish_counters);
   RUN_TEST(test_help_command_success);
   RUN_TEST(test_set_speed_command_success);
   RUN_TEST(test_missing_cmd_id_generates_uuid);
@@ -802,8 +1336,15 @@ int main(int, char**) {
   RUN_TEST(test_net_set_command_success);
   RUN_TEST(test_duplicate_command_logs);
   RUN_TEST(test_busy_rejection);
+  RUN_TEST(test_inbound_queue_full_rejects_busy);
+  RUN_TEST(test_inbound_rejections_scan_ids_and_count_overflow);
+  RUN_TEST(test_oversized_payload_rejected_unparsed);
+  RUN_TEST(test_json_arena_grows_last_block_in_place_and_resets);
+  RUN_TEST(test_response_cache_evicts_least_recently_used);
+  RUN_TEST(test_response_cache_wraps_within_byte_budget);
   RUN_TEST(test_status_parity_matches_status_publisher);
   RUN_TEST(test_ack_survives_publish_queue_burst);
   RUN_TEST(test_mqtt_config_json_persists);
+  RUN_TEST(test_numeric_text_fields_stay_strings);
   return UNITY_END();
 }
@@ -15,12 +15,12 @@ static bool starts_with(const std::string& s, const char* prefix) {
 }
 
 void test_dispatcher_round_trip_help_has_payload() {
-  // Simulate SerialConsole sink: Event -> Line, prefer raw if set.
+  // Simulate SerialConsole sink: print the line when there is one, else the event.
   std::vector<std::string> printed;
   auto token = ResponseDispatcher::Instance().RegisterSink(
-      [&printed](const transport::response::Event& evt) {
-        auto line = transport::response::EventToLine(evt);
-        std::string text = line.raw.empty() ? transport::command::SerializeLine(line) : line.raw;
+      [&printed](const transport::response::Event& evt,
+                 const transport::command::ResponseLine* line) {
+        std::string text = transport::response::SerializeEvent(evt, line);
         if (!text.empty()) {
           printed.push_back(text);
         }
@@ -51,3 +51,55 @@ void test_event_raw_preserved() {
   auto out = transport::response::EventToLine(evt);
   TEST_ASSERT_EQUAL_STRING("HELPTEXT", out.raw.c_str());
 }
+
+void test_sink_sees_source_line_in_field_order() {
+  std::vector<std::string> printed;
+  const transport::command::ResponseLine* seen = nullptr;
+  size_t attributes = 0;
+  auto token = ResponseDispatcher::Instance().RegisterSink(
+      [&](const transport::response::Event& evt, const transport::command::ResponseLine* line) {
+        seen = line;
+        attributes = evt.attributes.size();
+        printed.push_back(transport::response::SerializeEvent(evt, line));
+      });
+
+  auto line = transport::command::MakeAckLine("7", {{"zeta", "1"}, {"alpha", "2"}});
+  ResponseDispatcher::Instance().Emit(line, "MOVE");
+  ResponseDispatcher::Instance().UnregisterSink(token);
+
+  // Sinks read the emitted line itself; its fields are not copied into the event.
+  TEST_ASSERT_TRUE(seen == &line);
+  TEST_ASSERT_EQUAL_UINT32(0, attributes);
+  TEST_ASSERT_EQUAL_UINT32(1, printed.size());
+  TEST_ASSERT_EQUAL_STRING("CTRL:ACK msg_id=7 zeta=1 alpha=2", printed[0].c_str());
+}
+
+void test_event_attribute_helpers() {
+  transport::response::Event evt;
+  transport::response::SetAttribute(evt, "status", "done");
+  transport::response::SetAttribute(evt, "actual_ms", "120");
+  transport::response::SetAttribute(evt, "status", "error");
+  TEST_ASSERT_EQUAL_UINT32(2, evt.attributes.size());
+  TEST_ASSERT_EQUAL_STRING("status", evt.attributes[0].key);
+  const transport::command::Field* status = transport::response::FindAttribute(evt, "status");
+  TEST_ASSERT_TRUE(status != nullptr);
+  TEST_ASSERT_EQUAL_STRING("error", status->value.c_str());
+  TEST_ASSERT_TRUE(transport::response::FindAttribute(evt, "est_ms") == nullptr);
+}
+
+void test_integer_fields_keep_the_number() {
+  transport::response::Event evt;
+  transport::response::SetAttribute(evt, {"actual_ms", 4200000000LL});
+  transport::response::SetAttribute(evt, "est_ms", "120");
+  const transport::command::Field* actual = transport::response::FindAttribute(evt, "actual_ms");
+  TEST_ASSERT_TRUE(actual != nullptr);
+  TEST_ASSERT_TRUE(actual->kind == transport::command::FieldKind::kInteger);
+  TEST_ASSERT_TRUE(actual->value.empty());
+  TEST_ASSERT_EQUAL_STRING("4200000000", transport::command::FieldText(*actual).c_str());
+  int32_t est_ms = 0;
+  TEST_ASSERT_FALSE(transport::response::ExtractInt(evt, "est_ms", est_ms));
+
+  auto line = transport::command::MakeDataLine({{"id", 2}, {"pos", -15}, {"homed", "1"}});
+  TEST_ASSERT_EQUAL_STRING("id=2 pos=-15 homed=1",
+                           transport::command::SerializeLine(line).c_str());
+}
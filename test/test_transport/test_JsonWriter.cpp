@@ -0,0 +1,109 @@
+#include "transport/JsonWriter.h"
+
+#include <ArduinoJson.h>
+#include <climits>
+#include <cstdint>
+#include <string>
+#include <unity.h>
+
+using transport::JsonWriter;
+
+void test_json_writer_nests_and_types_fields() {
+  std::string out;
+  JsonWriter json(out);
+  json.beginObject();
+  json.field("id", "abc");
+  json.field("ok", true);
+  json.field("n", static_cast<int32_t>(-42));
+  json.field("big", LLONG_MIN);
+  json.field("u", static_cast<uint32_t>(4000000000u));
+  json.fieldTenths("budget", -5);
+  json.beginArray("list");
+  json.value(std::string("x"));
+  json.value(7);
+  json.beginObject();
+  json.endObject();
+  json.endArray();
+  json.beginObject("empty");
+  json.endObject();
+  json.endObject();
+
+  TEST_ASSERT_TRUE(json.ok());
+  TEST_ASSERT_EQUAL_UINT32(0, json.depth());
+  TEST_ASSERT_EQUAL_STRING("{\"id\":\"abc\",\"ok\":true,\"n\":-42,\"big\":-9223372036854775808,"
+                           "\"u\":4000000000,\"budget\":-0.5,\"list\":[\"x\",7,{}],\"empty\":{}}",
+                           out.c_str());
+}
+
+void test_json_writer_escapes_string_values() {
+  std::string out;
+  JsonWriter json(out);
+  const char raw[] = {'a', '"', '\\', '\n', '\t', '\x01', 'z'};
+  json.beginObject();
+  json.field("s", raw, sizeof(raw));
+  json.endObject();
+  TEST_ASSERT_EQUAL_STRING("{\"s\":\"a\\\"\\\\\\n\\t\\u0001z\"}", out.c_str());
+}
+
+void test_json_writer_flags_unbalanced_nesting() {
+  std::string out;
+  JsonWriter json(out);
+  json.endObject();
+  TEST_ASSERT_FALSE(json.ok());
+
+  std::string deep;
+  JsonWriter nested(deep);
+  for (size_t i = 0; i <= JsonWriter::kMaxDepth; ++i) {
+    nested.beginArray();
+  }
+  TEST_ASSERT_FALSE(nested.ok());
+}
+
+void test_json_writer_msgpack_encodes_same_document() {
+  auto build = [](JsonWriter& json) {
+    json.beginObject();
+    json.field("id", "abc");
+    json.field("ok", false);
+    json.field("n", static_cast<int32_t>(-300));
+    json.field("u", static_cast<uint32_t>(4000000000u));
+    json.fieldTenths("budget", 905);
+    json.beginArray("list");
+    json.value(std::string(40, 'x'));
+    json.value(-7);
+    json.endArray();
+    json.beginObject("empty");
+    json.endObject();
+    json.endObject();
+  };
+  std::string text;
+  JsonWriter json(text);
+  build(json);
+  std::string packed;
+  JsonWriter msgpack(packed, transport::PayloadEncoding::kMsgPack);
+  build(msgpack);
+  TEST_ASSERT_TRUE(msgpack.ok());
+  TEST_ASSERT_TRUE(packed.size() < text.size());
+
+  ArduinoJson::JsonDocument doc;
+  TEST_ASSERT_FALSE(ArduinoJson::deserializeMsgPack(doc, packed));
+  std::string decoded;
+  ArduinoJson::serializeJson(doc, decoded);
+  TEST_ASSERT_EQUAL_STRING(text.c_str(), decoded.c_str());
+
+  std::string small;
+  JsonWriter tiny(small, transport::PayloadEncoding::kMsgPack);
+  tiny.beginObject().field("a", 1).endObject();
+  const char expected[] = {'\xde', '\x00', '\x01', '\xa1', 'a', '\x01'};
+  TEST_ASSERT_TRUE(small == std::string(expected, sizeof(expected)));
+}
+
+void test_payload_encoding_follows_topic_suffix() {
+  using transport::PayloadEncoding;
+  TEST_ASSERT_TRUE(transport::TopicEncoding("devices/ab/status") == PayloadEncoding::kJson);
+  TEST_ASSERT_TRUE(transport::TopicEncoding("devices/ab/status.mp") == PayloadEncoding::kMsgPack);
+  TEST_ASSERT_EQUAL_STRING(
+      "devices/ab/cmd/resp.mp",
+      transport::EncodedTopic("devices/ab/cmd/resp", PayloadEncoding::kMsgPack).c_str());
+  TEST_ASSERT_TRUE(transport::PayloadEncodingOf("{}") == PayloadEncoding::kJson);
+  TEST_ASSERT_TRUE(transport::PayloadEncodingOf("\xde\x00\x00") == PayloadEncoding::kMsgPack);
+}
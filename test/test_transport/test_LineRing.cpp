@@ -0,0 +1,89 @@
+#include "transport/LineRing.h"
+
+#include <algorithm>
+#include <string>
+#include <unity.h>
+
+using transport::LineRing;
+
+namespace {
+
+// Accepts at most `limit` bytes per call, like a nearly full UART FIFO.
+struct ChokedWriter {
+  std::string out;
+  size_t limit;
+
+  size_t operator()(const char* data, size_t len) {
+    const size_t accepted = std::min(len, limit);
+    out.append(data, accepted);
+    return accepted;
+  }
+};
+
+}  // namespace
+
+void test_line_ring_keeps_reserve_for_high_priority() {
+  LineRing ring(32, 12);
+  TEST_ASSERT_TRUE(ring.push("CTRL:INFO a", LineRing::Priority::kLow));   // 13 bytes
+  TEST_ASSERT_FALSE(ring.push("CTRL:INFO b", LineRing::Priority::kLow));  // would pass 20
+  TEST_ASSERT_TRUE(ring.push("CTRL:ACK 1", LineRing::Priority::kHigh));   // 25 bytes
+  auto stats = ring.stats();
+  TEST_ASSERT_EQUAL_UINT32(1, stats.dropped_low);
+  TEST_ASSERT_EQUAL_UINT32(0, stats.rejected_high);
+  TEST_ASSERT_EQUAL_UINT32(25, stats.high_water);
+}
+
+void test_line_ring_high_priority_evicts_low_lines() {
+  LineRing ring(40, 20);
+  std::string out;
+  auto write = [&out](const char* data, size_t len) {
+    out.append(data, len);
+    return len;
+  };
+
+  TEST_ASSERT_TRUE(ring.push("CTRL:ACK 1", LineRing::Priority::kHigh));  // 12 bytes
+  TEST_ASSERT_TRUE(ring.push("info a", LineRing::Priority::kLow));       // 20 bytes
+  TEST_ASSERT_TRUE(ring.push("CTRL:ACK 2", LineRing::Priority::kHigh));  // 32 bytes
+  // No room left: the queued low line makes way, order is kept.
+  TEST_ASSERT_TRUE(ring.push("CTRL:DONE 1", LineRing::Priority::kHigh));
+  TEST_ASSERT_EQUAL_UINT32(37, ring.size());
+  // Nothing low is left to evict.
+  TEST_ASSERT_FALSE(ring.push("CTRL:DONE 2", LineRing::Priority::kHigh));
+  auto stats = ring.stats();
+  TEST_ASSERT_EQUAL_UINT32(1, stats.dropped_low);
+  TEST_ASSERT_EQUAL_UINT32(1, stats.rejected_high);
+
+  ring.drain(write, 100);
+  TEST_ASSERT_EQUAL_STRING("CTRL:ACK 1\r\nCTRL:ACK 2\r\nCTRL:DONE 1\r\n", out.c_str());
+}
+
+void test_line_ring_keeps_partly_drained_line() {
+  LineRing ring(24, 0);
+  ChokedWriter writer{std::string(), 3};
+  auto write = [&writer](const char* data, size_t len) { return writer(data, len); };
+
+  TEST_ASSERT_TRUE(ring.push("low one", LineRing::Priority::kLow));  // 9 bytes
+  TEST_ASSERT_TRUE(ring.push("low two", LineRing::Priority::kLow));  // 18 bytes
+  TEST_ASSERT_EQUAL_UINT32(3, ring.drain(write, 100));               // "low one" is on the wire
+  TEST_ASSERT_TRUE(ring.push("CTRL:ACK", LineRing::Priority::kHigh));
+  writer.limit = 64;
+  ring.drain(write, 100);
+  TEST_ASSERT_TRUE(ring.empty());
+  TEST_ASSERT_EQUAL_STRING("low one\r\nCTRL:ACK\r\n", writer.out.c_str());
+}
+
+void test_line_ring_drains_within_budget_and_wraps() {
+  LineRing ring(16, 0);
+  ChokedWriter writer{std::string(), 4};
+  auto write = [&writer](const char* data, size_t len) { return writer(data, len); };
+
+  TEST_ASSERT_TRUE(ring.push("abcdefghij", LineRing::Priority::kLow));
+  TEST_ASSERT_EQUAL_UINT32(4, ring.drain(write, 100));  // stops once the writer chokes
+  TEST_ASSERT_EQUAL_UINT32(4, ring.drain(write, 100));
+  TEST_ASSERT_TRUE(ring.push("012345", LineRing::Priority::kLow));  // wraps the end
+  writer.limit = 64;
+  TEST_ASSERT_EQUAL_UINT32(5, ring.drain(write, 5));  // byte budget
+  ring.drain(write, 100);
+  TEST_ASSERT_TRUE(ring.empty());
+  TEST_ASSERT_EQUAL_STRING("abcdefghij\r\n012345\r\n", writer.out.c_str());
+}
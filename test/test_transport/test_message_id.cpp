@@ -67,20 +67,98 @@ void test_active_roundtrip() {
   const auto expected = makeId(99);
   transport::message_id::SetActive(expected);
   TEST_ASSERT_TRUE(transport::message_id::HasActive());
-  TEST_ASSERT_EQUAL_STRING(expected.c_str(), transport::message_id::Active().c_str());
+  TEST_ASSERT_EQUAL_STRING(expected.c_str(), transport::message_id::Active().str().c_str());
   transport::message_id::ClearActive();
   TEST_ASSERT_FALSE(transport::message_id::HasActive());
 }
 
+void test_default_ids_are_hex16_and_sequential() {
+  auto first = transport::message_id::NextValue();
+  auto second = transport::message_id::NextValue();
+  TEST_ASSERT_TRUE(second == first + 1);
+  TEST_ASSERT_TRUE((first >> 32) == (second >> 32));
+
+  auto text = transport::message_id::Next();
+  TEST_ASSERT_EQUAL_UINT32(16, static_cast<uint32_t>(text.size()));
+  TEST_ASSERT_EQUAL_STRING("00000000deadbeef",
+                           transport::message_id::Render(0xdeadbeefULL).c_str());
+}
+
+void test_uuid_format_renders_nonce_and_counter() {
+  transport::message_id::SetFormat(transport::message_id::Format::kUuid);
+  auto text = transport::message_id::Render(0x0123abcd00000005ULL);
+  transport::message_id::SetFormat(transport::message_id::Format::kHex16);
+  TEST_ASSERT_EQUAL_STRING("0123abcd-0000-4000-8000-000000000005", text.c_str());
+}
+
+void test_cmd_id_hash_matches_text() {
+  transport::message_id::CmdId id("host-42");
+  TEST_ASSERT_TRUE(id.hash == transport::message_id::Hash("host-42"));
+  TEST_ASSERT_TRUE(id.matches(transport::message_id::Hash("host-42"), "host-42"));
+  TEST_ASSERT_FALSE(id.matches(transport::message_id::Hash("host-43"), "host-43"));
+}
+
+void test_generated_id_renders_in_format_at_the_edge() {
+  const transport::message_id::Id id = transport::message_id::NextId();
+  TEST_ASSERT_TRUE(id.generated());
+  TEST_ASSERT_EQUAL_UINT32(16, static_cast<uint32_t>(id.str().size()));
+  transport::message_id::SetFormat(transport::message_id::Format::kUuid);
+  const std::string uuid = id.str();
+  transport::message_id::SetFormat(transport::message_id::Format::kHex16);
+  TEST_ASSERT_EQUAL_STRING(transport::message_id::Render(id.key()).c_str(), id.str().c_str());
+  TEST_ASSERT_EQUAL_UINT32(36, static_cast<uint32_t>(uuid.size()));
+  TEST_ASSERT_TRUE(id == transport::message_id::Id(id.str()));
+}
+
+void test_host_id_keys_by_hash() {
+  const transport::message_id::Id id("host-42");
+  TEST_ASSERT_FALSE(id.generated());
+  TEST_ASSERT_TRUE(id.key() == transport::message_id::Hash("host-42"));
+  TEST_ASSERT_TRUE(id == transport::message_id::Id("host-42"));
+  TEST_ASSERT_FALSE(id == transport::message_id::Id("host-43"));
+  TEST_ASSERT_TRUE(transport::message_id::Id().empty());
+}
+
 int main(int, char**) {
   UNITY_BEGIN();
   RUN_TEST(test_next_skips_active_id);
   RUN_TEST(test_next_avoids_consecutive_duplicates);
   RUN_TEST(test_active_roundtrip);
+  RUN_TEST(test_default_ids_are_hex16_and_sequential);
+  RUN_TEST(test_uuid_format_renders_nonce_and_counter);
+  RUN_TEST(test_cmd_id_hash_matches_text);
+  RUN_TEST(test_generated_id_renders_in_format_at_the_edge);
+  RUN_TEST(test_host_id_keys_by_hash);
   // Dispatcher/HELP round-trip regressions
   void test_dispatcher_round_trip_help_has_payload();
   void test_event_raw_preserved();
+  void test_sink_sees_source_line_in_field_order();
+  void test_event_attribute_helpers();
+  void test_integer_fields_keep_the_number();
   RUN_TEST(test_dispatcher_round_trip_help_has_payload);
   RUN_TEST(test_event_raw_preserved);
+  RUN_TEST(test_sink_sees_source_line_in_field_order);
+  RUN_TEST(test_event_attribute_helpers);
+  RUN_TEST(test_integer_fields_keep_the_number);
+  // Buffered serial output
+  void test_line_ring_keeps_reserve_for_high_priority();
+  void test_line_ring_high_priority_evicts_low_lines();
+  void test_line_ring_keeps_partly_drained_line();
+  void test_line_ring_drains_within_budget_and_wraps();
+  RUN_TEST(test_line_ring_keeps_reserve_for_high_priority);
+  RUN_TEST(test_line_ring_high_priority_evicts_low_lines);
+  RUN_TEST(test_line_ring_keeps_partly_drained_line);
+  RUN_TEST(test_line_ring_drains_within_budget_and_wraps);
+  // Streaming JSON writer
+  void test_json_writer_nests_and_types_fields();
+  void test_json_writer_escapes_string_values();
+  void test_json_writer_flags_unbalanced_nesting();
+  RUN_TEST(test_json_writer_nests_and_types_fields);
+  RUN_TEST(test_json_writer_escapes_string_values);
+  RUN_TEST(test_json_writer_flags_unbalanced_nesting);
+  void test_json_writer_msgpack_encodes_same_document();
+  void test_payload_encoding_follows_topic_suffix();
+  RUN_TEST(test_json_writer_msgpack_encodes_same_document);
+  RUN_TEST(test_payload_encoding_follows_topic_suffix);
   return UNITY_END();
 }
@@ -145,6 +145,12 @@ def _add_common(sub):
         help="Transport to use (serial or mqtt). Default mqtt.",
     )
     sub.add_argument("--node", help="Target node id (MQTT transport)")
+    sub.add_argument(
+        "--encoding",
+        choices=("json", "msgpack"),
+        default="json",
+        help="MQTT command encoding; msgpack publishes to cmd.mp. Default json.",
+    )
     return sub
 
 
@@ -340,7 +346,9 @@ def _make_mqtt_worker(
 def _run_status_mqtt(ns) -> int:
     wait_seconds = max(0.5, float(getattr(ns, "timeout", 1.0)))
     try:
-        worker = _make_mqtt_worker(node=getattr(ns, "node", None))
+        worker = _make_mqtt_worker(
+            node=getattr(ns, "node", None), encoding=getattr(ns, "encoding", "json")
+        )
     except RuntimeError as exc:
         print(exc, file=sys.stderr)
         return 2
@@ -421,7 +429,9 @@ def main(argv=None) -> int:
         return run_interactive(ns)
     if ns.transport == "mqtt":
         try:
-            worker = _make_mqtt_worker(node=getattr(ns, "node", None))
+            worker = _make_mqtt_worker(
+                node=getattr(ns, "node", None), encoding=getattr(ns, "encoding", "json")
+            )
         except RuntimeError as exc:
             print(exc, file=sys.stderr)
             return 2
@@ -565,7 +575,7 @@ def run_interactive(ns: argparse.Namespace) -> int:
     if ns.transport == "mqtt":
         node_id = getattr(ns, "node", None)
         try:
-            worker = _make_mqtt_worker(node=node_id)
+            worker = _make_mqtt_worker(node=node_id, encoding=getattr(ns, "encoding", "json"))
         except RuntimeError as exc:
             print(exc, file=sys.stderr)
             return 2
@@ -124,6 +124,9 @@ def parse_serial_command(command: str) -> CommandRequest:
     if upper in {"STATUS", "ST"}:
         raise UnsupportedCommandError("STATUS not supported over MQTT")
 
+    if upper.split(" ", 1)[0] in {"SUB", "UNSUB"}:
+        raise UnsupportedCommandError("SUB/UNSUB are serial only; MQTT publishes status itself")
+
     if raw.upper().startswith("NET:"):
         prefix, rest = raw.split(":", 1)
         prefix = prefix.strip().upper()
@@ -222,6 +225,21 @@ def parse_serial_command(command: str) -> CommandRequest:
                     params["user"] = value
                 elif key in ("pass", "password"):
                     params["pass"] = value
+                elif key == "groups":
+                    params["groups"] = value
+                elif key == "status_max_hz":
+                    if not re.fullmatch(r"\d+", value):
+                        raise CommandParseError("status_max_hz must be integer")
+                    iv = int(value)
+                    if iv < 1 or iv > 50:
+                        raise CommandParseError("status_max_hz out of range")
+                    params["status_max_hz"] = iv
+                elif key == "status_topics":
+                    if value.lower() not in ("aggregate", "motors", "both"):
+                        raise CommandParseError(
+                            "status_topics must be aggregate, motors or both"
+                        )
+                    params["status_topics"] = value.lower()
                 else:
                     raise UnsupportedCommandError(f"unsupported MQTT field '{key}'")
             return CommandRequest(action=action, params=params, raw=raw)
@@ -311,6 +329,10 @@ def parse_serial_command(command: str) -> CommandRequest:
     raise UnsupportedCommandError(f"unsupported command '{action}'")
 
 
+# Actions the firmware accepts inside an MQTT {"batch": [...]} payload.
+BATCHABLE_ACTIONS = frozenset({"MOVE", "HOME"})
+
+
 def build_requests(serial_command: str) -> List[CommandRequest]:
     batches = split_batches(serial_command)
     requests = []
@@ -319,10 +341,26 @@ def build_requests(serial_command: str) -> List[CommandRequest]:
     return requests
 
 
+def combine_batch(requests: Sequence[CommandRequest]) -> List[CommandRequest]:
+    """Fold a `;` line of MOVE/HOME commands into one BATCH request.
+
+    The firmware validates the whole batch before any motion starts and answers
+    it with a single ack and done. Lines mixing in other actions are returned
+    unchanged and sent one message per command.
+    """
+    if len(requests) < 2 or any(req.action not in BATCHABLE_ACTIONS for req in requests):
+        return list(requests)
+    entries = [{"action": req.action, "params": req.params} for req in requests]
+    raw = ";".join(req.raw for req in requests)
+    return [CommandRequest(action="BATCH", params={"batch": entries}, raw=raw)]
+
+
 __all__ = [
     "CommandParseError",
     "CommandRequest",
     "UnsupportedCommandError",
+    "BATCHABLE_ACTIONS",
     "build_requests",
+    "combine_batch",
     "split_batches",
 ]
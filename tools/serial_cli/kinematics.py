@@ -0,0 +1,68 @@
+"""Host-side mirror of the firmware's MotionKinematics move profile.
+
+Status samples carry ``position``, ``target``, ``velocity``, ``speed`` and
+``accel`` for moving motors. ``extrapolate_position`` plays the symmetric
+trapezoidal profile forward from such a sample, so displays can move smoothly
+between the device's 5 Hz publishes.
+"""
+
+from __future__ import annotations
+
+import math
+
+
+def advance_along_profile(
+    remaining: float, velocity: float, speed: float, accel: float, dt: float
+) -> float:
+    """Steps covered within ``dt`` seconds, starting ``remaining`` steps from
+    the target at ``velocity`` (steps/s, toward the target)."""
+    if remaining <= 0.0 or dt <= 0.0:
+        return 0.0
+    if speed <= 0.0 or accel <= 0.0:
+        return min(remaining, max(velocity, 0.0) * dt)
+    v = min(max(velocity, 0.0), speed)
+    covered = 0.0
+
+    # Ramp toward the peak speed the remaining distance allows.
+    peak = min(speed, math.sqrt((v * v + 2.0 * accel * remaining) / 2.0))
+    if peak > v:
+        t_ramp = (peak - v) / accel
+        if dt <= t_ramp:
+            return v * dt + 0.5 * accel * dt * dt
+        ramp = (peak * peak - v * v) / (2.0 * accel)
+        covered += ramp
+        remaining -= ramp
+        dt -= t_ramp
+        v = peak
+
+    # Cruise until the braking distance is all that is left.
+    if v <= 0.0:
+        return covered
+    cruise = max(0.0, remaining - v * v / (2.0 * accel))
+    t_cruise = cruise / v
+    if dt <= t_cruise:
+        return covered + v * dt
+    covered += cruise
+    remaining -= cruise
+    dt -= t_cruise
+
+    # Brake so the motor stops on the target.
+    decel = v * v / (2.0 * remaining) if remaining > 0.0 else accel
+    t_stop = v / decel
+    if dt >= t_stop:
+        return covered + remaining
+    return covered + v * dt - 0.5 * decel * dt * dt
+
+
+def extrapolate_position(
+    position: int, target: int, velocity: float, speed: float, accel: float, dt: float
+) -> int:
+    """Predicted position ``dt`` seconds after a sample, never past ``target``."""
+    distance = target - position
+    if distance == 0:
+        return position
+    direction = 1 if distance > 0 else -1
+    travelled = advance_along_profile(
+        abs(distance), abs(velocity), speed, accel, dt
+    )
+    return position + direction * int(round(min(travelled, abs(distance))))
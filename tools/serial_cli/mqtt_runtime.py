@@ -8,7 +8,7 @@ import time
 import uuid
 from dataclasses import dataclass, field
 from pathlib import Path
-from typing import Callable, Dict, List, Optional, Sequence, Tuple
+from typing import Callable, Dict, List, Optional, Sequence, Tuple, Union
 
 try:
     import paho.mqtt.client as mqtt  # type: ignore
@@ -20,10 +20,26 @@ from .command_builder import (
     CommandRequest,
     UnsupportedCommandError,
     build_requests,
+    combine_batch,
 )
+from .kinematics import extrapolate_position
+from .msgpack_codec import MSGPACK_TOPIC_SUFFIX, MsgPackError, is_msgpack_topic, packb, unpackb
 from .response_events import EventType, ResponseEvent, format_event, parse_mqtt_payload
 
 
+ENCODINGS = ("json", "msgpack")
+
+
+def _decode_payload(topic: str, payload: Union[str, bytes]) -> object:
+    """Decode a payload by topic: MessagePack on ``.mp`` topics, JSON otherwise."""
+    if is_msgpack_topic(topic):
+        data = payload.encode("latin-1") if isinstance(payload, str) else payload
+        return unpackb(data)
+    if isinstance(payload, bytes):
+        payload = payload.decode(errors="ignore")
+    return json.loads(payload)
+
+
 def _default_cmd_id() -> str:
     """Generate a UUIDv4 string compatible with firmware transport IDs."""
     return str(uuid.uuid4())
@@ -65,6 +81,55 @@ def load_mqtt_defaults() -> Dict[str, str]:
     return defaults
 
 
+# Extrapolation stops this long after the last sample, so a silent device
+# does not appear to keep moving.
+_PREDICTION_HORIZON_S = 1.0
+# Offsets this much above the lowest seen mean the device clock restarted or
+# drifted; the estimate starts over.
+_CLOCK_RESYNC_S = 0.5
+
+
+def _prediction_from(motor: Dict[str, object]) -> Optional[Tuple[int, int, float, float, float]]:
+    """(position, target, velocity, speed, accel) for a moving motor sample."""
+    if not motor.get("moving") or "target" not in motor:
+        return None
+    try:
+        return (
+            int(motor["position"]),  # type: ignore[arg-type]
+            int(motor["target"]),  # type: ignore[arg-type]
+            float(motor.get("velocity", 0) or 0),  # type: ignore[arg-type]
+            float(motor.get("speed", 0) or 0),  # type: ignore[arg-type]
+            float(motor.get("accel", 0) or 0),  # type: ignore[arg-type]
+        )
+    except (KeyError, TypeError, ValueError):
+        return None
+
+
+def _sample_time(entry: Dict[str, object], ts_ms: object, received: float) -> float:
+    """Host time of a device sample stamped ``ts_ms``.
+
+    The smallest receive-minus-device-clock offset seen approximates the
+    device clock with the least delivery latency, so samples delayed in the
+    broker or network are still placed where the device took them.
+    """
+    if not isinstance(ts_ms, int) or isinstance(ts_ms, bool):
+        return received
+    raw_offset = received - ts_ms / 1000.0
+    offset = entry.get("clock_offset")
+    if not isinstance(offset, float) or not 0.0 <= raw_offset - offset <= _CLOCK_RESYNC_S:
+        offset = raw_offset
+    entry["clock_offset"] = offset
+    return ts_ms / 1000.0 + offset
+
+
+def _predict_position(
+    prediction: Tuple[int, int, float, float, float, float], now: float
+) -> int:
+    position, target, velocity, speed, accel, sample_ts = prediction
+    dt = min(max(0.0, now - sample_ts), _PREDICTION_HORIZON_S)
+    return extrapolate_position(position, target, velocity, speed, accel, dt)
+
+
 @dataclass
 class PendingCommand:
     local_id: int
@@ -94,8 +159,14 @@ class MqttWorker(threading.Thread):
         client_factory: Optional[Callable[[], mqtt.Client]] = None,
         node_id: Optional[str] = None,
         cmd_id_factory: Optional[Callable[[], str]] = None,
+        encoding: str = "json",
     ) -> None:
         super().__init__(daemon=True)
+        if encoding not in ENCODINGS:
+            raise ValueError(f"unsupported encoding {encoding!r}; expected one of {ENCODINGS}")
+        # Commands go out in this encoding; responses and telemetry are
+        # accepted in either, told apart by topic.
+        self._encoding = encoding
         self._broker = dict(broker or load_mqtt_defaults())
         self._lock = threading.Lock()
         self._stop_event = threading.Event()
@@ -109,6 +180,9 @@ class MqttWorker(threading.Thread):
         self._reconnect_backoff = 1.0
         self._next_connect_ts = 0.0
         self._node_id = node_id
+        # Moving rows are extrapolated between publishes, so the TUI can
+        # redraw far faster than the device's status cadence.
+        self.period = 1.0 / 60
         self._condition = threading.Condition(self._lock)
         self._columns = (
             ("id", "id", 4),
@@ -235,7 +309,7 @@ class MqttWorker(threading.Thread):
             return []
 
         try:
-            requests = build_requests(stripped)
+            requests = combine_batch(build_requests(stripped))
         except UnsupportedCommandError as exc:
             if not silent:
                 self._append_log(f"> {stripped}")
@@ -266,19 +340,26 @@ class MqttWorker(threading.Thread):
                     self._append_log("error: mqtt broker not connected")
                 continue
 
-            payload = {
-                "action": request.action,
-                "params": request.params if request.params else {},
-            }
+            if request.action == "BATCH":
+                payload = {"batch": request.params["batch"]}
+            else:
+                payload = {
+                    "action": request.action,
+                    "params": request.params if request.params else {},
+                }
             payload["cmd_id"] = cmd_id
+            topic = f"devices/{node_id}/cmd"
             try:
-                data = json.dumps(payload, separators=(",", ":"), sort_keys=False)
+                if self._encoding == "msgpack":
+                    data: Union[str, bytes] = packb(payload)
+                    topic += MSGPACK_TOPIC_SUFFIX
+                else:
+                    data = json.dumps(payload, separators=(",", ":"), sort_keys=False)
             except (TypeError, ValueError) as exc:
                 if not silent:
                     self._append_log(f"error: unable to encode payload: {exc}")
                 continue
 
-            topic = f"devices/{node_id}/cmd"
             publish_ok = False
             try:
                 info = self._client.publish(topic, data, qos=1)  # type: ignore[union-attr]
@@ -313,16 +394,20 @@ class MqttWorker(threading.Thread):
                 self._pending_by_cmd[cmd_id] = pending
         return handles
 
-    def get_state(self) -> tuple:
+    def get_state(self, now: Optional[float] = None) -> tuple:
         with self._lock:
-            now = time.time()
+            now = time.time() if now is None else now
             rows = []
             for device, data in self._devices.items():
                 last_seen = float(data.get("last_seen", 0.0))
                 age_s = max(0.0, now - last_seen) if last_seen else 0.0
                 motors = data.get("motors", {})
-                for _motor_id, motor in motors.items():
+                predictions = data.get("predictions", {})
+                for motor_id, motor in motors.items():
                     row = dict(motor)
+                    prediction = predictions.get(motor_id)
+                    if prediction is not None:
+                        row["pos"] = str(_predict_position(prediction, now))
                     row["device"] = device
                     row["node_state"] = data.get("node_state", "")
                     row["ip"] = data.get("ip", "")
@@ -429,7 +514,12 @@ class MqttWorker(threading.Thread):
     # MQTT callbacks
     # ------------------------------------------------------------------
     def _on_connect(self, client, userdata, flags, rc):
-        topics = [("devices/+/status", 0), ("devices/+/cmd/resp", 1)]
+        topics = [
+            ("devices/+/status", 0),
+            ("devices/+/status" + MSGPACK_TOPIC_SUFFIX, 0),
+            ("devices/+/cmd/resp", 1),
+            ("devices/+/cmd/resp" + MSGPACK_TOPIC_SUFFIX, 1),
+        ]
         for topic, qos in topics:
             client.subscribe(topic, qos=qos)
         with self._lock:
@@ -437,7 +527,9 @@ class MqttWorker(threading.Thread):
             self._reconnect_backoff = 1.0
             self._next_connect_ts = float("inf")
             self._condition.notify_all()
-        self._append_log("[mqtt] connected; subscribed to devices/+/status, devices/+/cmd/resp")
+        self._append_log(
+            "[mqtt] connected; subscribed to devices/+/status, devices/+/cmd/resp (json and .mp)"
+        )
 
     def _on_disconnect(self, client, userdata, rc):
         with self._lock:
@@ -452,27 +544,28 @@ class MqttWorker(threading.Thread):
             self._append_log(f"[mqtt] reconnect in {delay:.1f}s")
 
     def _on_message(self, client, userdata, msg):
-        payload_text = (
-            msg.payload.decode(errors="ignore")
-            if isinstance(msg.payload, bytes)
-            else str(msg.payload)
-        )
-        if msg.topic.endswith("/status"):
-            self.ingest_message(msg.topic, payload_text)
+        payload = msg.payload if isinstance(msg.payload, bytes) else str(msg.payload)
+        topic = msg.topic
+        if is_msgpack_topic(topic):
+            topic = topic[: -len(MSGPACK_TOPIC_SUFFIX)]
+        if topic.endswith("/status"):
+            self.ingest_message(msg.topic, payload)
             return
-        if msg.topic.endswith("/cmd/resp"):
-            self.ingest_response(msg.topic, payload_text)
+        if topic.endswith("/cmd/resp"):
+            self.ingest_response(msg.topic, payload)
             return
         self._append_log(f"[mqtt] ignored topic {msg.topic}")
 
     # ------------------------------------------------------------------
-    def ingest_message(self, topic: str, payload: str, timestamp: Optional[float] = None) -> None:
+    def ingest_message(
+        self, topic: str, payload: Union[str, bytes], timestamp: Optional[float] = None
+    ) -> None:
         mac = topic.split("/")[1] if topic.startswith("devices/") else topic
         ts = timestamp if timestamp is not None else time.time()
 
         try:
-            obj = json.loads(payload)
-        except (ValueError, TypeError, json.JSONDecodeError):
+            obj = _decode_payload(topic, payload)
+        except (ValueError, TypeError, MsgPackError):
             self._append_log(f"[mqtt] unable to parse status payload from {topic}")
             return
 
@@ -493,6 +586,7 @@ class MqttWorker(threading.Thread):
                 return ""
 
         motors: Dict[str, Dict[str, str]] = {}
+        predictions: Dict[str, Tuple[int, int, float, float, float, float]] = {}
         for key, motor in motors_obj.items():
             if not isinstance(motor, dict):
                 continue
@@ -514,11 +608,16 @@ class MqttWorker(threading.Thread):
             motor_row["accel"] = str(motor.get("accel", ""))
             motor_row["est_ms"] = str(motor.get("est_ms", ""))
             motor_row["started_ms"] = str(motor.get("started_ms", ""))
+            motor_row["target"] = str(motor.get("target", ""))
+            motor_row["eta_ms"] = str(motor.get("eta_ms", ""))
             if "actual_ms" in motor and motor.get("actual_ms") is not None:
                 motor_row["actual_ms"] = str(motor.get("actual_ms"))
             else:
                 motor_row["actual_ms"] = ""
             motors[motor_row["id"]] = motor_row
+            prediction = _prediction_from(motor)
+            if prediction is not None:
+                predictions[motor_row["id"]] = prediction
 
         should_request_net = False
         should_request_thermal = False
@@ -528,6 +627,11 @@ class MqttWorker(threading.Thread):
             entry["ip"] = str(obj.get("ip", ""))
             entry["motors"] = motors
             entry["last_seen"] = ts
+            sample_ts = _sample_time(entry, obj.get("ts_ms"), ts)
+            entry["predictions"] = {
+                motor_id: prediction + (sample_ts,)
+                for motor_id, prediction in predictions.items()
+            }
             self._devices[mac] = entry
             self._last_update_ts = ts
             if not self._node_id:
@@ -552,11 +656,11 @@ class MqttWorker(threading.Thread):
                 with self._lock:
                     self._need_thermal_refresh = False
 
-    def ingest_response(self, topic: str, payload: str) -> None:
+    def ingest_response(self, topic: str, payload: Union[str, bytes]) -> None:
         node_id = topic.split("/")[1] if topic.startswith("devices/") else ""
         try:
-            obj = json.loads(payload)
-        except (ValueError, TypeError, json.JSONDecodeError):
+            obj = _decode_payload(topic, payload)
+        except (ValueError, TypeError, MsgPackError):
             self._append_log(f"[mqtt] unable to parse command response from {topic}")
             return
 
@@ -564,7 +668,7 @@ class MqttWorker(threading.Thread):
         if event is None:
             self._append_log(f"[mqtt] unrecognized response payload from {topic}")
             return
-        event.raw = payload
+        event.raw = payload if isinstance(payload, str) else json.dumps(obj)
         if not event.action:
             event.action = obj.get("action") or None
         self._handle_event(node_id, event)
@@ -0,0 +1,191 @@
+"""Minimal MessagePack codec for the firmware's binary MQTT topics.
+
+Covers the types the firmware payload schema uses (nil, bool, int, float,
+str, array, map) so the CLI needs no extra dependency. Topics ending in
+``MSGPACK_TOPIC_SUFFIX`` carry MessagePack; all others carry JSON text.
+"""
+
+from __future__ import annotations
+
+import struct
+from typing import Any, Tuple
+
+MSGPACK_TOPIC_SUFFIX = ".mp"
+
+
+class MsgPackError(ValueError):
+    """Raised when a payload is not valid MessagePack."""
+
+
+def is_msgpack_topic(topic: str) -> bool:
+    return topic.endswith(MSGPACK_TOPIC_SUFFIX)
+
+
+def packb(obj: Any) -> bytes:
+    out = bytearray()
+    _pack(obj, out)
+    return bytes(out)
+
+
+def _pack(obj: Any, out: bytearray) -> None:
+    if obj is None:
+        out.append(0xC0)
+    elif obj is True:
+        out.append(0xC3)
+    elif obj is False:
+        out.append(0xC2)
+    elif isinstance(obj, int):
+        _pack_int(obj, out)
+    elif isinstance(obj, float):
+        out.append(0xCB)
+        out += struct.pack(">d", obj)
+    elif isinstance(obj, str):
+        data = obj.encode("utf-8")
+        size = len(data)
+        if size < 32:
+            out.append(0xA0 | size)
+        elif size <= 0xFF:
+            out += struct.pack(">BB", 0xD9, size)
+        elif size <= 0xFFFF:
+            out += struct.pack(">BH", 0xDA, size)
+        else:
+            out += struct.pack(">BI", 0xDB, size)
+        out += data
+    elif isinstance(obj, (list, tuple)):
+        _pack_header(len(obj), 0x90, 0xDC, out)
+        for item in obj:
+            _pack(item, out)
+    elif isinstance(obj, dict):
+        _pack_header(len(obj), 0x80, 0xDE, out)
+        for key, value in obj.items():
+            _pack(str(key), out)
+            _pack(value, out)
+    else:
+        raise TypeError(f"cannot encode {type(obj).__name__} as MessagePack")
+
+
+def _pack_header(size: int, fix: int, tag16: int, out: bytearray) -> None:
+    if size < 16:
+        out.append(fix | size)
+    elif size <= 0xFFFF:
+        out += struct.pack(">BH", tag16, size)
+    else:
+        out += struct.pack(">BI", tag16 + 1, size)
+
+
+_UNSIGNED = ((0xCC, ">B", 0xFF), (0xCD, ">H", 0xFFFF), (0xCE, ">I", 0xFFFFFFFF))
+_SIGNED = ((0xD0, ">b", -0x80), (0xD1, ">h", -0x8000), (0xD2, ">i", -0x80000000))
+
+
+def _pack_int(value: int, out: bytearray) -> None:
+    if 0 <= value <= 0x7F:
+        out.append(value)
+    elif -32 <= value < 0:
+        out += struct.pack(">b", value)
+    elif value > 0:
+        for tag, fmt, limit in _UNSIGNED:
+            if value <= limit:
+                out.append(tag)
+                out += struct.pack(fmt, value)
+                return
+        out.append(0xCF)
+        out += struct.pack(">Q", value)
+    else:
+        for tag, fmt, limit in _SIGNED:
+            if value >= limit:
+                out.append(tag)
+                out += struct.pack(fmt, value)
+                return
+        out.append(0xD3)
+        out += struct.pack(">q", value)
+
+
+def unpackb(data: bytes) -> Any:
+    value, offset = _unpack(memoryview(data), 0)
+    if offset != len(data):
+        raise MsgPackError("trailing bytes after MessagePack value")
+    return value
+
+
+_FIXED = {
+    0xCC: ">B",
+    0xCD: ">H",
+    0xCE: ">I",
+    0xCF: ">Q",
+    0xD0: ">b",
+    0xD1: ">h",
+    0xD2: ">i",
+    0xD3: ">q",
+    0xCA: ">f",
+    0xCB: ">d",
+}
+_STR_LEN = {0xD9: ">B", 0xDA: ">H", 0xDB: ">I"}
+_ARRAY_LEN = {0xDC: ">H", 0xDD: ">I"}
+_MAP_LEN = {0xDE: ">H", 0xDF: ">I"}
+
+
+def _read(view: memoryview, offset: int, fmt: str) -> Tuple[Any, int]:
+    size = struct.calcsize(fmt)
+    if offset + size > len(view):
+        raise MsgPackError("truncated MessagePack payload")
+    return struct.unpack_from(fmt, view, offset)[0], offset + size
+
+
+def _unpack(view: memoryview, offset: int) -> Tuple[Any, int]:
+    if offset >= len(view):
+        raise MsgPackError("truncated MessagePack payload")
+    tag = view[offset]
+    offset += 1
+    if tag <= 0x7F:
+        return tag, offset
+    if tag >= 0xE0:
+        return tag - 0x100, offset
+    if 0xA0 <= tag <= 0xBF:
+        return _unpack_str(view, offset, tag & 0x1F)
+    if 0x90 <= tag <= 0x9F:
+        return _unpack_array(view, offset, tag & 0x0F)
+    if 0x80 <= tag <= 0x8F:
+        return _unpack_map(view, offset, tag & 0x0F)
+    if tag == 0xC0:
+        return None, offset
+    if tag in (0xC2, 0xC3):
+        return tag == 0xC3, offset
+    if tag in _FIXED:
+        return _read(view, offset, _FIXED[tag])
+    if tag in _STR_LEN:
+        size, offset = _read(view, offset, _STR_LEN[tag])
+        return _unpack_str(view, offset, size)
+    if tag in _ARRAY_LEN:
+        size, offset = _read(view, offset, _ARRAY_LEN[tag])
+        return _unpack_array(view, offset, size)
+    if tag in _MAP_LEN:
+        size, offset = _read(view, offset, _MAP_LEN[tag])
+        return _unpack_map(view, offset, size)
+    raise MsgPackError(f"unsupported MessagePack type 0x{tag:02x}")
+
+
+def _unpack_str(view: memoryview, offset: int, size: int) -> Tuple[str, int]:
+    end = offset + size
+    if end > len(view):
+        raise MsgPackError("truncated MessagePack payload")
+    try:
+        return bytes(view[offset:end]).decode("utf-8"), end
+    except UnicodeDecodeError as exc:
+        raise MsgPackError(str(exc)) from exc
+
+
+def _unpack_array(view: memoryview, offset: int, size: int) -> Tuple[list, int]:
+    items = []
+    for _ in range(size):
+        item, offset = _unpack(view, offset)
+        items.append(item)
+    return items, offset
+
+
+def _unpack_map(view: memoryview, offset: int, size: int) -> Tuple[dict, int]:
+    result = {}
+    for _ in range(size):
+        key, offset = _unpack(view, offset)
+        value, offset = _unpack(view, offset)
+        result[key] = value
+    return result, offset
@@ -16,6 +16,50 @@ ParseStatusFn = Callable[[str], List[Dict[str, str]]]
 ParseKvFn = Callable[[str], Dict[str, str]]
 ParseThermalFn = Callable[[str], Optional[tuple]]
 
+# Push frames sent by the node after SUB STATUS (see StatusSubscription.h).
+STATUS_FRAME_PREFIX = "ST t="
+
+
+def _format_tenths(value: int) -> str:
+    sign = "-" if value < 0 else ""
+    value = abs(value)
+    return f"{sign}{value // 10}.{value % 10}"
+
+
+def parse_status_frame(line: str) -> Optional[List[Dict[str, str]]]:
+    """Parse a SUB STATUS push frame into STATUS-style rows; None if not a frame."""
+    if not line.startswith(STATUS_FRAME_PREFIX):
+        return None
+    rows: List[Dict[str, str]] = []
+    for token in line.split()[2:]:
+        parts = token.split(":")
+        if len(parts) < 10:
+            continue
+        try:
+            flags = int(parts[2])
+            budget = _format_tenths(int(parts[4]))
+            ttfc = _format_tenths(int(parts[5]))
+        except ValueError:
+            continue
+        row = {
+            "id": parts[0],
+            "pos": parts[1],
+            "moving": "1" if flags & 1 else "0",
+            "awake": "1" if flags & 2 else "0",
+            "homed": "1" if flags & 4 else "0",
+            "steps_since_home": parts[3],
+            "budget_s": budget,
+            "ttfc_s": ttfc,
+            "speed": parts[6],
+            "accel": parts[7],
+            "est_ms": parts[8],
+            "started_ms": parts[9],
+        }
+        if len(parts) > 10:
+            row["actual_ms"] = parts[10]
+        rows.append(row)
+    return rows
+
 
 @dataclass
 class PendingCommand:
@@ -78,6 +122,11 @@ class SerialWorker(threading.Thread):
         self._reconnect_dots: int = 0
         self._net_status_interval = 10.0
         self._last_net_status_poll = 0.0
+        # Push-mode status: ask once per connection, fall back to polling while
+        # no frames arrive (older firmware answers SUB with an error).
+        self._subscribe_requested: bool = False
+        self._last_frame_ts: float = 0.0
+        self._frame_stale_s = 3.0
 
         self._parse_status = parse_status
         self._parse_kv = parse_kv
@@ -169,6 +218,8 @@ class SerialWorker(threading.Thread):
             self._reconnect_dots = 0
             self._need_net_status_refresh = True
             self._initial_net_status_requested = False
+            self._subscribe_requested = False
+            self._last_frame_ts = 0.0
         return True
 
     def _close(self) -> None:
@@ -225,6 +276,13 @@ class SerialWorker(threading.Thread):
                 self._last_net_status_poll = now
                 return
             return
+        if not self._subscribe_requested:
+            interval_ms = min(60000, max(20, int(self.poll_interval * 1000)))
+            self._send_poll(f"SUB STATUS,{interval_ms}\n")
+            self._subscribe_requested = True
+            return
+        if now - self._last_frame_ts < self._frame_stale_s:
+            return
         if now < self._next_poll_ts:
             return
         # Poll STATUS followed by NET:STATUS on alternating cycles
@@ -278,6 +336,10 @@ class SerialWorker(threading.Thread):
         return True
 
     def _handle_line(self, line: str) -> None:
+        frame_rows = parse_status_frame(line)
+        if frame_rows is not None:
+            self._apply_status_frame(frame_rows)
+            return
         pending = self._pending
         if pending is None:
             self._log_async(line)
@@ -412,6 +474,20 @@ class SerialWorker(threading.Thread):
 
         self._pending = None
 
+    def _apply_status_frame(self, rows: List[Dict[str, str]]) -> None:
+        now = time.monotonic()
+        self._last_frame_ts = now
+        if now - self._last_net_status_poll >= self._net_status_interval:
+            self._need_net_status_refresh = True
+        with self._lock:
+            merged = {row.get("id"): row for row in self._last_status_rows}
+            for row in rows:
+                merged[row["id"]] = {**merged.get(row["id"], {}), **row}
+            self._last_status_rows = sorted(
+                merged.values(), key=lambda row: int(row.get("id") or 0)
+            )
+            self._last_update_ts = time.time()
+
     def _update_status_cache(self, text: str) -> None:
         raw_lines = [ln.strip() for ln in text.splitlines() if ln.strip()]
         payload_lines = [ln for ln in raw_lines if not ln.upper().startswith("CTRL:")]
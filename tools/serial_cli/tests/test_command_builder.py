@@ -4,6 +4,7 @@ from tools.serial_cli.command_builder import (
     CommandParseError,
     UnsupportedCommandError,
     build_requests,
+    combine_batch,
     split_batches,
 )
 
@@ -33,10 +34,44 @@ class CommandBuilderTests(unittest.TestCase):
         self.assertEqual(req.params["ssid"], "MyNet")
         self.assertEqual(req.params["pass"], "pass")
 
+    def test_mqtt_set_config_groups(self):
+        req = build_requests("MQTT:SET_CONFIG groups=wall,row-2")[0]
+        self.assertEqual(req.action, "MQTT:SET_CONFIG")
+        self.assertEqual(req.params, {"groups": "wall,row-2"})
+
+    def test_mqtt_set_config_status_max_hz(self):
+        req = build_requests("MQTT:SET_CONFIG status_max_hz=30")[0]
+        self.assertEqual(req.params, {"status_max_hz": 30})
+        with self.assertRaises(CommandParseError):
+            build_requests("MQTT:SET_CONFIG status_max_hz=51")
+
+    def test_mqtt_set_config_status_topics(self):
+        req = build_requests("MQTT:SET_CONFIG status_topics=Both")[0]
+        self.assertEqual(req.params, {"status_topics": "both"})
+        with self.assertRaises(CommandParseError):
+            build_requests("MQTT:SET_CONFIG status_topics=each")
+
     def test_split_batches(self):
         parts = split_batches("MOVE:0,100;MOVE:1,200;SET SPEED=4000")
         self.assertEqual(parts, ["MOVE:0,100", "MOVE:1,200", "SET SPEED=4000"])
 
+    def test_combine_batch_folds_motion_commands(self):
+        reqs = combine_batch(build_requests("MOVE:0,100;HOME:1"))
+        self.assertEqual(len(reqs), 1)
+        self.assertEqual(reqs[0].action, "BATCH")
+        self.assertEqual(reqs[0].raw, "MOVE:0,100;HOME:1")
+        self.assertEqual(
+            reqs[0].params["batch"],
+            [
+                {"action": "MOVE", "params": {"target_ids": 0, "position_steps": 100}},
+                {"action": "HOME", "params": {"target_ids": 1}},
+            ],
+        )
+
+    def test_combine_batch_keeps_mixed_lines_separate(self):
+        reqs = combine_batch(build_requests("MOVE:0,100;SET SPEED=4000"))
+        self.assertEqual([req.action for req in reqs], ["MOVE", "SET"])
+
     def test_unsupported_command(self):
         with self.assertRaises(UnsupportedCommandError):
             build_requests("STATUS")
@@ -4,6 +4,7 @@ from typing import List, Tuple
 
 from tools.serial_cli import render_table
 from tools.serial_cli.mqtt_runtime import MqttWorker
+from tools.serial_cli.msgpack_codec import packb, unpackb
 
 
 class _NoOpClient:
@@ -111,6 +112,92 @@ class MqttRuntimeTests(unittest.TestCase):
         devices: List[str] = [row["device"] for row in rows]
         self.assertEqual(sorted(devices), devices)
 
+    def test_msgpack_status_matches_json_rows(self) -> None:
+        payload = self._sample_payload()
+        self.worker.ingest_message("devices/02123456789a/status", payload, timestamp=100.0)
+        json_rows, _, _, _, _ = self.worker.get_state()
+        packed = packb(json.loads(payload))
+        self.assertLess(len(packed), len(payload))
+        self.assertEqual(json.loads(payload), unpackb(packed))
+        self.worker.ingest_message("devices/02123456789a/status.mp", packed, timestamp=100.0)
+        rows, _, err, _, _ = self.worker.get_state()
+        self.assertIsNone(err)
+        for row in (*rows, *json_rows):
+            row.pop("age_s", None)
+        self.assertEqual(json_rows, rows)
+
+    def test_moving_rows_extrapolate_between_samples(self) -> None:
+        def sample(ts_ms: int, position: int, velocity: int) -> str:
+            motor = {
+                "id": 0,
+                "position": position,
+                "moving": True,
+                "speed": 1000,
+                "accel": 1000,
+                "target": 1000,
+                "velocity": velocity,
+                "eta_ms": 2000,
+            }
+            return json.dumps({"node_state": "ready", "ts_ms": ts_ms, "motors": {"0": motor}})
+
+        topic = "devices/02123456789a/status"
+        self.worker.ingest_message(topic, sample(5000, 0, 0), timestamp=100.0)
+        self.assertEqual("0", self.worker.get_state(now=100.0)[0][0]["pos"])
+        # From rest at 1000 steps/s^2: 125 steps after half a second.
+        self.assertEqual("125", self.worker.get_state(now=100.5)[0][0]["pos"])
+        # Extrapolation stops a second after the sample.
+        self.assertEqual("500", self.worker.get_state(now=130.0)[0][0]["pos"])
+
+        # A late delivery is placed at the device's sample time, not arrival.
+        self.worker.ingest_message(topic, sample(5200, 20, 200), timestamp=100.3)
+        rows = self.worker.get_state(now=100.4)[0]
+        self.assertEqual("80", rows[0]["pos"])
+        self.assertEqual("1000", rows[0]["target"])
+
+        stopped = json.loads(sample(6000, 1000, 0))
+        stopped["motors"]["0"]["moving"] = False
+        self.worker.ingest_message(topic, json.dumps(stopped), timestamp=101.0)
+        self.assertEqual("1000", self.worker.get_state(now=105.0)[0][0]["pos"])
+
+    def test_msgpack_encoding_uses_mp_topics(self) -> None:
+        class StubClient:
+            def __init__(self) -> None:
+                self.published = []
+
+            def publish(self, topic, payload, qos=1):
+                self.published.append((topic, payload, qos))
+
+                class _Info:
+                    rc = 0
+
+                return _Info()
+
+        worker = MqttWorker(
+            client_factory=lambda: _NoOpClient(),
+            node_id="aa",
+            cmd_id_factory=lambda: "cli-mp",
+            encoding="msgpack",
+        )
+        client = StubClient()
+        worker._client = client
+        with worker._lock:
+            worker._connected = True
+
+        handles = worker.queue_cmd("MOVE:0,100")
+        self.assertTrue(handles)
+        topic, payload, _ = client.published[0]
+        self.assertEqual(topic, "devices/aa/cmd.mp")
+        request = unpackb(payload)
+        self.assertEqual(request["action"], "MOVE")
+        self.assertEqual(request["cmd_id"], "cli-mp")
+
+        done = {"cmd_id": "cli-mp", "action": "MOVE", "status": "done", "result": {"est_ms": 0}}
+        worker.ingest_response("devices/aa/cmd/resp.mp", packb(done))
+        pending = worker.wait_for_completion(handles, timeout=0.1).get(handles[0])
+        self.assertIsNotNone(pending)
+        self.assertTrue(pending.completed)  # type: ignore[union-attr]
+        worker.stop()
+
     def test_ingest_response_updates_pending(self) -> None:
         class StubClient:
             def __init__(self) -> None:
@@ -0,0 +1,29 @@
+import unittest
+
+from tools.serial_cli.runtime import parse_status_frame
+
+
+class StatusFrameTests(unittest.TestCase):
+    def test_frame_expands_to_status_rows(self):
+        rows = parse_status_frame(
+            "ST t=1200 0:150:3:150:-12:905:4000:16000:75:1100 1:0:4:0:900:0:4000:16000:0:0:0"
+        )
+        self.assertEqual(len(rows), 2)
+        self.assertEqual(rows[0]["pos"], "150")
+        self.assertEqual(rows[0]["moving"], "1")
+        self.assertEqual(rows[0]["awake"], "1")
+        self.assertEqual(rows[0]["homed"], "0")
+        self.assertEqual(rows[0]["budget_s"], "-1.2")
+        self.assertEqual(rows[0]["ttfc_s"], "90.5")
+        self.assertNotIn("actual_ms", rows[0])
+        self.assertEqual(rows[1]["homed"], "1")
+        self.assertEqual(rows[1]["actual_ms"], "0")
+
+    def test_non_frame_lines_are_ignored(self):
+        self.assertIsNone(parse_status_frame("CTRL:DONE cmd_id=abc action=SUB status=done"))
+        self.assertIsNone(parse_status_frame("id=0 pos=0 moving=0"))
+        self.assertEqual(parse_status_frame("ST t=5"), [])
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -399,7 +399,7 @@ class TextualUI(BaseUI):
                 # Focus input and set refresh interval based on worker polling
                 try:
                     period = getattr(worker, "period", 0.5) or 0.5
-                    hz = max(0.5, 1.0 / max(0.05, float(period)))
+                    hz = max(0.5, 1.0 / max(1.0 / 60, float(period)))
                 except Exception:
                     hz = 2.0
                 self.set_interval(1.0 / hz, self._refresh)